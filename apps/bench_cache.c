@@ -0,0 +1,282 @@
+/**
+ * \file apps/bench_cache.c
+ *
+ * \brief An application to compare the concurrent cache with CLOCK eviction
+ *  against the LRU cache.
+ *
+ * First, both caches replay the same single-threaded trace of Zipf-distributed
+ * lookups interleaved with scans of keys used only once, storing the missed
+ * keys, and their hit ratios on Zipf-distributed lookups (scans always miss)
+ * are printed.
+ * Then, several threads look up keys in each cache (the LRU cache being
+ * protected by a mutex, since its lookups relink nodes), and the throughput
+ * is printed.
+ *
+ * Usage: bench_cache [lookups [keys [capacity [threads]]]]
+ *
+ * \copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ * This file is part of UPOalglib.
+ *
+ * UPOalglib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * UPOalglib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <upo/cache.h>
+#include <upo/error.h>
+#include <upo/hires_timer.h>
+#include <upo/lru.h>
+#include <upo/random.h>
+
+
+/** \brief Length of each scan, as a multiple of the capacity. */
+#define SCAN_FACTOR 2
+
+/** \brief Number of Zipf lookups between two scans. */
+#define SCAN_PERIOD 20000
+
+
+/** \brief Data of each thread of the throughput benchmark. */
+struct worker_s
+{
+    upo_cache_t cache; /**< The concurrent cache, or `NULL`. */
+    upo_lru_t lru; /**< The LRU cache, used if `cache` is `NULL`. */
+    pthread_mutex_t *lock; /**< The lock of the LRU cache. */
+    int *keys; /**< The keys. */
+    const size_t *trace; /**< The positions of the keys to look up. */
+    size_t num_lookups; /**< The number of lookups. */
+    size_t hits; /**< The number of hits. */
+};
+
+
+static int int_compare(const void *a, const void *b);
+
+static size_t zipf_sample(const double *cdf, size_t n);
+
+static void* worker(void *arg);
+
+
+int main(int argc, char *argv[])
+{
+    size_t num_lookups = 2000000;
+    size_t n = 100000;
+    size_t m = 5000;
+    size_t max_threads = 8;
+    int *keys = NULL;
+    size_t *trace = NULL;
+    double *cdf = NULL;
+    double sum = 0;
+    size_t num_scan_keys = 0;
+    size_t next_scan_key = 0;
+    size_t i = 0;
+    size_t j = 0;
+    size_t t = 0;
+    size_t lru_hits = 0;
+    size_t cache_hits = 0;
+    upo_lru_t lru = NULL;
+    upo_cache_t cache = NULL;
+
+    if (argc > 1)
+        num_lookups = strtoul(argv[1], NULL, 10);
+    if (argc > 2)
+        n = strtoul(argv[2], NULL, 10);
+    if (argc > 3)
+        m = strtoul(argv[3], NULL, 10);
+    if (argc > 4)
+        max_threads = strtoul(argv[4], NULL, 10);
+
+    if (num_lookups == 0 || n == 0 || m == 0 || max_threads == 0)
+    {
+        fprintf(stderr, "Usage: %s [lookups [keys [capacity [threads]]]]\n", argv[0]);
+        return 1;
+    }
+
+    /* Keys used by scans follow the Zipf-distributed keys */
+    num_scan_keys = (num_lookups/SCAN_PERIOD + 1)*SCAN_FACTOR*m;
+    keys = malloc((n + num_scan_keys)*sizeof(int));
+    cdf = malloc(n*sizeof(double));
+    trace = malloc((num_lookups + num_scan_keys)*sizeof(size_t));
+    if (keys == NULL || cdf == NULL || trace == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for the benchmark");
+    }
+
+    srand(42);
+
+    for (i = 0; i < n + num_scan_keys; ++i)
+    {
+        keys[i] = (int) i;
+    }
+    for (i = 0; i < n; ++i)
+    {
+        sum += 1.0/(i+1);
+        cdf[i] = sum;
+    }
+    for (i = 0; i < n; ++i)
+    {
+        cdf[i] /= sum;
+    }
+
+    /* Build the trace, with a scan every SCAN_PERIOD lookups */
+    for (i = 0, j = 0; i < num_lookups; ++i)
+    {
+        if (i % SCAN_PERIOD == SCAN_PERIOD-1)
+        {
+            for (t = 0; t < SCAN_FACTOR*m; ++t)
+                trace[j++] = n + next_scan_key++;
+        }
+        trace[j++] = zipf_sample(cdf, n);
+    }
+
+    /* Hit ratio */
+    lru = upo_lru_create(m, upo_ht_hash_int_div, int_compare);
+    cache = upo_cache_create(m, upo_ht_hash_int_div, int_compare);
+    for (i = 0; i < j; ++i)
+    {
+        int *key = &keys[trace[i]];
+
+        if (upo_lru_get(lru, key) != NULL)
+            lru_hits += (trace[i] < n);
+        else
+            upo_lru_put(lru, key, key, 0);
+
+        if (upo_cache_get(cache, key) != NULL)
+            cache_hits += (trace[i] < n);
+        else
+            upo_cache_put(cache, key, key);
+    }
+
+    printf("lookups: %zu, keys: %zu, capacity: %zu, scans of %zu keys every %d lookups\n", j, n, m, (size_t) SCAN_FACTOR*m, SCAN_PERIOD);
+    printf("%-8s %10s\n", "cache", "hit ratio");
+    printf("%-8s %10.4f\n", "lru", lru_hits/(double) num_lookups);
+    printf("%-8s %10.4f\n", "clock", cache_hits/(double) num_lookups);
+
+    /* Throughput of lookups of parts of the same trace */
+    printf("\n%-8s %8s %14s %14s\n", "cache", "threads", "time (s)", "lookups/s");
+    for (t = 1; t <= max_threads; t *= 2)
+    {
+        size_t k = 0;
+
+        for (k = 0; k < 2; ++k)
+        {
+            pthread_t *threads = malloc(t*sizeof(pthread_t));
+            struct worker_s *workers = malloc(t*sizeof(struct worker_s));
+            pthread_mutex_t lock;
+            upo_hires_timer_t timer = upo_hires_timer_create();
+            double elapsed = 0;
+
+            if (threads == NULL || workers == NULL)
+            {
+                upo_throw_sys_error("Unable to allocate memory for the benchmark");
+            }
+            pthread_mutex_init(&lock, NULL);
+
+            upo_hires_timer_start(timer);
+            for (i = 0; i < t; ++i)
+            {
+                workers[i].cache = (k == 0) ? NULL : cache;
+                workers[i].lru = lru;
+                workers[i].lock = &lock;
+                workers[i].keys = keys;
+                workers[i].trace = trace + (i*num_lookups/max_threads) % num_lookups;
+                workers[i].num_lookups = num_lookups/max_threads;
+                workers[i].hits = 0;
+                if (pthread_create(&threads[i], NULL, worker, &workers[i]) != 0)
+                {
+                    upo_throw_sys_error("Unable to create a thread for the benchmark");
+                }
+            }
+            for (i = 0; i < t; ++i)
+            {
+                pthread_join(threads[i], NULL);
+            }
+            upo_hires_timer_stop(timer);
+            elapsed = upo_hires_timer_elapsed(timer);
+
+            printf("%-8s %8zu %14.6f %14.0f\n", (k == 0) ? "lru" : "clock", t, elapsed, t*(num_lookups/max_threads)/elapsed);
+
+            upo_hires_timer_destroy(timer);
+            pthread_mutex_destroy(&lock);
+            free(workers);
+            free(threads);
+        }
+    }
+
+    upo_cache_destroy(cache, 0);
+    upo_lru_destroy(lru, 0);
+    free(trace);
+    free(cdf);
+    free(keys);
+
+    return 0;
+}
+
+
+int int_compare(const void *a, const void *b)
+{
+    const int *aa = a;
+    const int *bb = b;
+
+    return (*aa > *bb) - (*aa < *bb);
+}
+
+// Returns a rank in [0,n) distributed according to the given CDF
+size_t zipf_sample(const double *cdf, size_t n)
+{
+    double u = upo_random_uniform_real(0, 1);
+    size_t lo = 0;
+    size_t hi = n-1;
+
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo)/2;
+
+        if (cdf[mid] < u)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+// Looks up the keys of its part of the trace
+void* worker(void *arg)
+{
+    struct worker_s *w = arg;
+    size_t i = 0;
+
+    for (i = 0; i < w->num_lookups; ++i)
+    {
+        int *key = &w->keys[w->trace[i]];
+
+        if (w->cache != NULL)
+        {
+            if (upo_cache_get(w->cache, key) != NULL)
+                w->hits++;
+        }
+        else
+        {
+            pthread_mutex_lock(w->lock);
+            if (upo_lru_get(w->lru, key) != NULL)
+                w->hits++;
+            pthread_mutex_unlock(w->lock);
+        }
+    }
+
+    return NULL;
+}
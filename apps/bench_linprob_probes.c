@@ -0,0 +1,192 @@
+/**
+ * \file apps/bench_linprob_probes.c
+ *
+ * \brief An application to compare the probe sequences of hash tables with
+ *  open addressing under different distributions of integer keys.
+ *
+ * For each distribution, the same keys are inserted in a hash table with each
+ * probe sequence, and then looked up (all successful searches first, and all
+ * unsuccessful searches then).
+ * Keys are hashed by division, so close keys have close home slots.
+ *
+ * Usage: bench_linprob_probes [keys [rounds]]
+ *
+ * \copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ * This file is part of UPOalglib.
+ *
+ * UPOalglib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * UPOalglib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <upo/error.h>
+#include <upo/hashtable.h>
+#include <upo/hires_timer.h>
+#include <upo/random.h>
+
+
+static int int_compare(const void *a, const void *b);
+
+static void make_keys(int *keys, size_t n, size_t dist);
+
+
+int main(int argc, char *argv[])
+{
+    upo_ht_linprob_probe_t probes[] = {UPO_HT_LINPROB_PROBE_LINEAR,
+                                       UPO_HT_LINPROB_PROBE_QUADRATIC,
+                                       UPO_HT_LINPROB_PROBE_DOUBLE};
+    const char *probe_names[] = {"linear", "quadratic", "double"};
+    const char *dist_names[] = {"uniform", "sequential", "clustered", "strided"};
+    size_t n = 100000;
+    size_t rounds = 10;
+    int *keys = NULL;
+    size_t d = 0;
+    size_t j = 0;
+    size_t i = 0;
+    size_t r = 0;
+
+    if (argc > 1)
+        n = strtoul(argv[1], NULL, 10);
+    if (argc > 2)
+        rounds = strtoul(argv[2], NULL, 10);
+
+    if (n == 0 || rounds == 0)
+    {
+        fprintf(stderr, "Usage: %s [keys [rounds]]\n", argv[0]);
+        return 1;
+    }
+
+    /* The first half of keys is inserted, the second half is only searched */
+    keys = malloc(2*n*sizeof(int));
+    if (keys == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for the benchmark");
+    }
+
+    srand(42);
+
+    printf("keys: %zu, lookup rounds: %zu\n", n, rounds);
+    printf("%-11s %-10s %10s %10s %10s %10s %10s %8s\n", "keys", "probe", "insert (s)", "hit (s)", "miss (s)", "cmp/hit", "cmp/miss", "cluster");
+
+    for (d = 0; d < sizeof dist_names/sizeof dist_names[0]; ++d)
+    {
+        make_keys(keys, 2*n, d);
+
+        for (j = 0; j < sizeof probes/sizeof probes[0]; ++j)
+        {
+            upo_ht_linprob_t ht = upo_ht_linprob_create(UPO_HT_LINPROB_DEFAULT_CAPACITY, upo_ht_hash_int_div, int_compare);
+            upo_hires_timer_t timer = upo_hires_timer_create();
+            upo_ht_stats_t stats;
+            double insert_time = 0;
+            double hit_time = 0;
+            double miss_time = 0;
+            size_t hit_cmps = 0;
+
+            upo_ht_linprob_set_probe(ht, probes[j]);
+
+            upo_hires_timer_start(timer);
+            for (i = 0; i < n; ++i)
+            {
+                upo_ht_linprob_insert(ht, &keys[i], &keys[i]);
+            }
+            upo_hires_timer_stop(timer);
+            insert_time = upo_hires_timer_elapsed(timer);
+
+            upo_ht_linprob_enable_stats(ht);
+
+            upo_hires_timer_start(timer);
+            for (r = 0; r < rounds; ++r)
+            {
+                for (i = 0; i < n; ++i)
+                {
+                    if (upo_ht_linprob_get(ht, &keys[i]) == NULL)
+                        upo_throw_sys_error("Key not found");
+                }
+            }
+            upo_hires_timer_stop(timer);
+            hit_time = upo_hires_timer_elapsed(timer);
+
+            upo_ht_linprob_stats(ht, &stats);
+            hit_cmps = stats.cmp_calls;
+
+            upo_hires_timer_start(timer);
+            for (r = 0; r < rounds; ++r)
+            {
+                for (i = n; i < 2*n; ++i)
+                {
+                    if (upo_ht_linprob_get(ht, &keys[i]) != NULL)
+                        upo_throw_sys_error("Key found");
+                }
+            }
+            upo_hires_timer_stop(timer);
+            miss_time = upo_hires_timer_elapsed(timer);
+
+            upo_ht_linprob_stats(ht, &stats);
+
+            printf("%-11s %-10s %10.6f %10.6f %10.6f %10.3f %10.3f %8zu\n",
+                   dist_names[d],
+                   probe_names[j],
+                   insert_time,
+                   hit_time,
+                   miss_time,
+                   hit_cmps/(double) (rounds*n),
+                   (stats.cmp_calls - hit_cmps)/(double) (rounds*n),
+                   stats.longest_cluster);
+
+            upo_hires_timer_destroy(timer);
+            upo_ht_linprob_destroy(ht, 0);
+        }
+    }
+
+    free(keys);
+
+    return 0;
+}
+
+
+int int_compare(const void *a, const void *b)
+{
+    const int *aa = a;
+    const int *bb = b;
+
+    return (*aa > *bb) - (*aa < *bb);
+}
+
+// Fills keys with n distinct keys of the given distribution, in random order
+void make_keys(int *keys, size_t n, size_t dist)
+{
+    size_t i = 0;
+
+    for (i = 0; i < n; ++i)
+    {
+        switch (dist)
+        {
+            case 0: // Uniform: sparse keys spread over a range of 8n values
+                keys[i] = (int) (8*i + (size_t) upo_random_uniform_int(0, 8));
+                break;
+            case 1: // Sequential: consecutive keys
+                keys[i] = (int) i;
+                break;
+            case 2: // Clustered: runs of 16 consecutive keys far from each other
+                keys[i] = (int) (1021*(i/16) + i%16);
+                break;
+            default: // Strided: multiples of 64
+                keys[i] = (int) (64*i);
+                break;
+        }
+    }
+
+    upo_random_shuffle(keys, n, sizeof keys[0]);
+}
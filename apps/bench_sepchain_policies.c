@@ -0,0 +1,211 @@
+/**
+ * \file apps/bench_sepchain_policies.c
+ *
+ * \brief An application to compare the policies for organizing the lists of
+ *  collisions of hash tables with separate chaining under skewed workloads.
+ *
+ * Keys are looked up according to a Zipf distribution (with a small fraction
+ * of unsuccessful searches) in a hash table whose lists of collisions hold
+ * several keys each.
+ *
+ * Usage: bench_sepchain_policies [lookups [keys [exponent [load]]]]
+ *
+ * \copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ * This file is part of UPOalglib.
+ *
+ * UPOalglib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * UPOalglib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <upo/error.h>
+#include <upo/hashtable.h>
+#include <upo/hires_timer.h>
+#include <upo/random.h>
+
+
+static int int_compare(const void *a, const void *b);
+
+static size_t zipf_sample(const double *cdf, size_t n);
+
+
+int main(int argc, char *argv[])
+{
+    upo_ht_sepchain_policy_t policies[] = {UPO_HT_SEPCHAIN_POLICY_HEAD,
+                                           UPO_HT_SEPCHAIN_POLICY_MOVE_TO_FRONT,
+                                           UPO_HT_SEPCHAIN_POLICY_TRANSPOSE,
+                                           UPO_HT_SEPCHAIN_POLICY_SORTED};
+    const char *names[] = {"head", "move-to-front", "transpose", "sorted"};
+    size_t num_lookups = 2000000;
+    size_t n = 10000;
+    double s = 1.0;
+    size_t load = 8;
+    int *keys = NULL;
+    int *misses = NULL;
+    size_t *order = NULL;
+    size_t *lookups = NULL;
+    double *cdf = NULL;
+    double sum = 0;
+    size_t i = 0;
+    size_t j = 0;
+
+    if (argc > 1)
+        num_lookups = strtoul(argv[1], NULL, 10);
+    if (argc > 2)
+        n = strtoul(argv[2], NULL, 10);
+    if (argc > 3)
+        s = atof(argv[3]);
+    if (argc > 4)
+        load = strtoul(argv[4], NULL, 10);
+
+    if (n == 0 || load == 0)
+    {
+        fprintf(stderr, "Usage: %s [lookups [keys [exponent [load]]]]\n", argv[0]);
+        return 1;
+    }
+
+    keys = malloc(n*sizeof(int));
+    misses = malloc(n*sizeof(int));
+    order = malloc(n*sizeof(size_t));
+    cdf = malloc(n*sizeof(double));
+    lookups = malloc(num_lookups*sizeof(size_t));
+    if (keys == NULL || misses == NULL || order == NULL || cdf == NULL || lookups == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for the benchmark");
+    }
+
+    srand(42);
+
+    /* The i-th key has rank i: ranks are assigned to keys at random, so hot
+     * keys are spread over the slots */
+    for (i = 0; i < n; ++i)
+    {
+        keys[i] = (int) (2*i);
+        misses[i] = (int) (2*i + 1);
+        order[i] = i;
+    }
+    for (i = n-1; i > 0; --i)
+    {
+        size_t r = upo_random_uniform_int(0, i+1);
+        int tmp = keys[i];
+
+        keys[i] = keys[r];
+        keys[r] = tmp;
+    }
+
+    /* Keys are inserted in an order independent of their rank, so hot keys
+     * are anywhere in lists (inserting them by rank would leave the hottest
+     * keys at the end of lists with insertion at the head, overstating the
+     * gains of the self-organizing policies) */
+    for (i = n-1; i > 0; --i)
+    {
+        size_t r = upo_random_uniform_int(0, i+1);
+        size_t tmp = order[i];
+
+        order[i] = order[r];
+        order[r] = tmp;
+    }
+
+    /* Cumulative distribution of ranks: the i-th key has weight 1/(i+1)^s */
+    for (i = 0; i < n; ++i)
+    {
+        sum += 1.0/pow(i+1, s);
+        cdf[i] = sum;
+    }
+    for (i = 0; i < n; ++i)
+    {
+        cdf[i] /= sum;
+    }
+
+    /* Same lookup sequence for every policy; about 5% of lookups miss */
+    for (i = 0; i < num_lookups; ++i)
+    {
+        size_t k = zipf_sample(cdf, n);
+
+        lookups[i] = (upo_random_uniform_real(0, 1) < 0.05) ? n + k : k;
+    }
+
+    printf("lookups: %zu, keys: %zu, exponent: %g, load factor: %zu\n", num_lookups, n, s, load);
+    printf("%-15s %12s %15s %12s\n", "policy", "time (s)", "comparisons", "cmp/lookup");
+
+    for (j = 0; j < sizeof policies/sizeof policies[0]; ++j)
+    {
+        upo_ht_sepchain_t ht = upo_ht_sepchain_create(n/load + 1, upo_ht_hash_int_div, int_compare);
+        upo_hires_timer_t timer = upo_hires_timer_create();
+        upo_ht_stats_t stats;
+
+        upo_ht_sepchain_set_policy(ht, policies[j]);
+        for (i = 0; i < n; ++i)
+        {
+            upo_ht_sepchain_put(ht, &keys[order[i]], &keys[order[i]]);
+        }
+
+        upo_ht_sepchain_enable_stats(ht);
+
+        upo_hires_timer_start(timer);
+        for (i = 0; i < num_lookups; ++i)
+        {
+            const int *key = (lookups[i] < n) ? &keys[lookups[i]] : &misses[lookups[i] - n];
+
+            upo_ht_sepchain_get(ht, key);
+        }
+        upo_hires_timer_stop(timer);
+
+        upo_ht_sepchain_stats(ht, &stats);
+
+        printf("%-15s %12.6f %15zu %12.3f\n", names[j], upo_hires_timer_elapsed(timer), stats.cmp_calls, stats.cmp_calls/(double) num_lookups);
+
+        upo_hires_timer_destroy(timer);
+        upo_ht_sepchain_destroy(ht, 0);
+    }
+
+    free(lookups);
+    free(cdf);
+    free(order);
+    free(misses);
+    free(keys);
+
+    return 0;
+}
+
+
+int int_compare(const void *a, const void *b)
+{
+    const int *aa = a;
+    const int *bb = b;
+
+    return (*aa > *bb) - (*aa < *bb);
+}
+
+// Returns a rank in [0,n) distributed according to the given CDF
+size_t zipf_sample(const double *cdf, size_t n)
+{
+    double u = upo_random_uniform_real(0, 1);
+    size_t lo = 0;
+    size_t hi = n-1;
+
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo)/2;
+
+        if (cdf[mid] < u)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
@@ -0,0 +1 @@
+apps_targets += bench_cache
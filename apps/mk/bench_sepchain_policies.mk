@@ -0,0 +1 @@
+apps_targets += bench_sepchain_policies
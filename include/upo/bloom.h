@@ -0,0 +1,215 @@
+/**
+ * \file upo/bloom.h
+ *
+ * \brief The Bloom Filter abstract data type.
+ *
+ * Bloom Filters are approximate sets: they tell whether a key may have been
+ * added (with a small probability of false positives) or surely has not
+ * been added, using a few bits per key whatever the size of keys.
+ *
+ * They are implemented as split block Bloom filters: the bit array is split
+ * into blocks of UPO_BLOOM_BLOCK_BITS bits, aligned so that a block never
+ * spans two cache lines, and each key sets UPO_BLOOM_BLOCK_WORDS bits of a
+ * single block (one in each 32-bit word of the block).
+ * Keys are hashed to 64 bits by means of upo_ht_hash_wide(): the upper 32 bits
+ * select the block, and the lower 32 bits are multiplied by a different odd
+ * constant for each word to select the bits.
+ * Therefore adding or looking up a key touches exactly one cache line; when
+ * compiled for AVX2 (e.g., with `-mavx2`), the 8 words of a block are
+ * handled at once by vector instructions, and otherwise by a portable loop
+ * computing the same bits.
+ * The price of blocking is a slightly higher false positive rate than a
+ * classic Bloom filter with the same number of bits, which is accounted for
+ * when sizing the filter.
+ *
+ * \copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ *  This file is part of UPOalglib.
+ *
+ *  UPOalglib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  UPOalglib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UPO_BLOOM_H
+#define UPO_BLOOM_H
+
+
+#include <stddef.h>
+#include <upo/hashtable.h>
+
+
+/** \brief Number of 32-bit words of each block of the filter. */
+#define UPO_BLOOM_BLOCK_WORDS 8U
+
+/** \brief Number of bits of each block of the filter. */
+#define UPO_BLOOM_BLOCK_BITS (32U*UPO_BLOOM_BLOCK_WORDS)
+
+/** \brief Type for Bloom filters. */
+typedef struct upo_bloom_s* upo_bloom_t;
+
+
+/**
+ * \brief Creates a new empty Bloom filter sized for the given number of keys
+ *  and false positive rate.
+ *
+ * \param n The expected number of keys.
+ * \param fpr The target false positive rate, in `(0, 1)`.
+ * \param key_hash A pointer to the function used to hash keys.
+ * \return An empty Bloom filter with the least number of blocks whose false
+ *  positive rate with `n` keys is at most `fpr`.
+ *
+ * Filters created with the same arguments have the same number of blocks, so
+ * they can be merged.
+ *
+ * Worst-case complexity: linear in the number of blocks of the filter.
+ */
+upo_bloom_t upo_bloom_create(size_t n, double fpr, upo_ht_hasher_t key_hash);
+
+/**
+ * \brief Destroys the given Bloom filter.
+ *
+ * \param bloom The Bloom filter to destroy.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+void upo_bloom_destroy(upo_bloom_t bloom);
+
+/**
+ * \brief Removes all keys from the given Bloom filter.
+ *
+ * \param bloom The Bloom filter.
+ *
+ * Worst-case complexity: linear in the number of blocks of the filter.
+ */
+void upo_bloom_clear(upo_bloom_t bloom);
+
+/**
+ * \brief Adds the given key to the given Bloom filter.
+ *
+ * \param bloom The Bloom filter.
+ * \param key The key.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+void upo_bloom_add(upo_bloom_t bloom, const void *key);
+
+/**
+ * \brief Tells if the given key may have been added to the given Bloom
+ *  filter.
+ *
+ * \param bloom The Bloom filter.
+ * \param key The key.
+ * \return `1` if the key may have been added, or `0` if it has surely not
+ *  been added (or the filter is `NULL`).
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+int upo_bloom_contains(const upo_bloom_t bloom, const void *key);
+
+/**
+ * \brief Adds the keys of a Bloom filter to another one.
+ *
+ * \param bloom The Bloom filter to update.
+ * \param other The Bloom filter whose keys are added.
+ * \return `1` if the filters have been merged, or `0` if they have
+ *  different numbers of blocks or key hash functions.
+ *
+ * The merged filter is the same as if all keys had been added to it.
+ *
+ * Worst-case complexity: linear in the number of blocks of the filters.
+ */
+int upo_bloom_merge(upo_bloom_t bloom, const upo_bloom_t other);
+
+/**
+ * \brief Returns the number of bytes needed to serialize the given Bloom
+ *  filter.
+ *
+ * \param bloom The Bloom filter.
+ * \return The number of bytes written by upo_bloom_serialize().
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+size_t upo_bloom_serialized_size(const upo_bloom_t bloom);
+
+/**
+ * \brief Serializes the given Bloom filter.
+ *
+ * \param bloom The Bloom filter.
+ * \param buf The buffer, of at least upo_bloom_serialized_size() bytes.
+ *
+ * The serialized form (a header followed by the blocks, in little-endian
+ * byte order) does not depend on the platform; the key hash function is not
+ * serialized.
+ *
+ * Worst-case complexity: linear in the number of blocks of the filter.
+ */
+void upo_bloom_serialize(const upo_bloom_t bloom, void *buf);
+
+/**
+ * \brief Creates a Bloom filter from its serialized form.
+ *
+ * \param buf The buffer written by upo_bloom_serialize().
+ * \param size The number of bytes of the buffer.
+ * \param key_hash A pointer to the function used to hash keys, which must be
+ *  the one of the serialized filter.
+ * \return The Bloom filter, or `NULL` if the buffer does not hold a
+ *  serialized Bloom filter of the given size.
+ *
+ * Worst-case complexity: linear in the number of blocks of the filter.
+ */
+upo_bloom_t upo_bloom_deserialize(const void *buf, size_t size, upo_ht_hasher_t key_hash);
+
+/**
+ * \brief Returns the number of keys added to the given Bloom filter.
+ *
+ * \param bloom The Bloom filter.
+ * \return The number of calls to upo_bloom_add() (including those adding the
+ *  same key again, and those of merged filters), or `0` if the filter is
+ *  `NULL`.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+size_t upo_bloom_count(const upo_bloom_t bloom);
+
+/**
+ * \brief Returns the number of bits of the given Bloom filter.
+ *
+ * \param bloom The Bloom filter.
+ * \return The number of bits, a multiple of UPO_BLOOM_BLOCK_BITS, or `0` if
+ *  the filter is `NULL`.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+size_t upo_bloom_bits(const upo_bloom_t bloom);
+
+/**
+ * \brief Returns the expected false positive rate of the given Bloom filter.
+ *
+ * \param bloom The Bloom filter.
+ * \return The probability that a key that has not been added is reported as
+ *  present, given the number of added keys.
+ *
+ * Worst-case complexity: linear in the number of keys per block.
+ */
+double upo_bloom_fpr(const upo_bloom_t bloom);
+
+/**
+ * \brief Returns the key hasher function.
+ *
+ * \param bloom The Bloom filter.
+ * \return The key hasher function.
+ */
+upo_ht_hasher_t upo_bloom_get_hasher(const upo_bloom_t bloom);
+
+
+#endif /* UPO_BLOOM_H */
@@ -113,6 +113,29 @@ upo_bst_t upo_bst_create(upo_bst_comparator_t key_cmp);
  */
 void upo_bst_destroy(upo_bst_t tree, int destroy_data);
 
+/**
+ * \brief Destroys the given binary search tree on the background reclaimer
+ *  thread.
+ *
+ * \param tree The binary search tree to destroy, which must not be accessed
+ *  anymore.
+ * \param destroy_data Tells whether the previously allocated memory for keys
+ *  and values stored in this binary search tree must be freed (value `1`) or
+ *  not (value `0`).
+ *
+ * The tree is handed to the reclaimer (see upo/reclaimer.h), which frees its
+ * nodes in bounded batches, so that the caller does not wait for them to be
+ * freed.
+ * Nodes are freed iteratively (by rotating left children up), so even a
+ * degenerate tree needs no recursion.
+ * Memory deallocation (if requested) is performed by means of the `free()`
+ * standard C function.
+ *
+ * Worst-case complexity: constant, `O(1)`, for the caller; linear in the
+ *  number `n` of elements, `O(n)`, for the reclaimer.
+ */
+void upo_bst_destroy_async(upo_bst_t tree, int destroy_data);
+
 /**
  * \brief Removes all elements from the given binary search tree and destroys
  *  all data stored on it.
@@ -361,6 +384,66 @@ upo_bst_key_list_t upo_bst_keys_range(const upo_bst_t tree, const void *low_key,
  */
 upo_bst_key_list_t upo_bst_keys(const upo_bst_t tree);
 
+/**
+ * \brief Returns the union of the given binary search trees.
+ *
+ * \param tree1 The first binary search tree.
+ * \param tree2 The second binary search tree, ordered by the same comparison
+ *  function as the first one.
+ * \return A new perfectly balanced binary search tree with the keys found in
+ *  either tree, or `NULL` if both trees are `NULL`.
+ *
+ * A `NULL` tree is treated as an empty one, and the result is ordered by the
+ * comparison function of the first tree that is not `NULL`.
+ * The nodes of both trees are visited in order at the same time, and the
+ * result is built directly from the merged sequence, so that the height of
+ * the result is \f$\lfloor \log_2 k \rfloor\f$, where \f$k\f$ is its size.
+ * The keys and values of the result are shared with the given trees rather
+ * than copied, and a key found in both trees takes the value associated to it
+ * in the first tree; thus, at most one of the three trees should be destroyed
+ * with `destroy_data` set to `1`.
+ *
+ * Worst-case complexity: linear in the number `n` of elements of the first
+ *  tree and in the number `m` of elements of the second one, `O(n+m)`.
+ */
+upo_bst_t upo_bst_union(const upo_bst_t tree1, const upo_bst_t tree2);
+
+/**
+ * \brief Returns the intersection of the given binary search trees.
+ *
+ * \param tree1 The first binary search tree.
+ * \param tree2 The second binary search tree, ordered by the same comparison
+ *  function as the first one.
+ * \return A new perfectly balanced binary search tree with the keys found in
+ *  both trees, with the values associated to them in the first tree, or
+ *  `NULL` if both trees are `NULL`.
+ *
+ * A `NULL` tree is treated as an empty one, as for upo_bst_union().
+ * Keys and values are shared as for upo_bst_union().
+ *
+ * Worst-case complexity: linear in the number `n` of elements of the first
+ *  tree and in the number `m` of elements of the second one, `O(n+m)`.
+ */
+upo_bst_t upo_bst_intersection(const upo_bst_t tree1, const upo_bst_t tree2);
+
+/**
+ * \brief Returns the difference of the given binary search trees.
+ *
+ * \param tree1 The first binary search tree.
+ * \param tree2 The second binary search tree, ordered by the same comparison
+ *  function as the first one.
+ * \return A new perfectly balanced binary search tree with the keys of the
+ *  first tree that are not found in the second one, or `NULL` if both trees
+ *  are `NULL`.
+ *
+ * A `NULL` tree is treated as an empty one, as for upo_bst_union().
+ * Keys and values are shared as for upo_bst_union().
+ *
+ * Worst-case complexity: linear in the number `n` of elements of the first
+ *  tree and in the number `m` of elements of the second one, `O(n+m)`.
+ */
+upo_bst_t upo_bst_difference(const upo_bst_t tree1, const upo_bst_t tree2);
+
 /**
  * \brief Checks if the given tree satisfies the binary search tree property.
  *
@@ -0,0 +1,262 @@
+/**
+ * \file upo/cache.h
+ *
+ * \brief The Concurrent Cache abstract data type.
+ *
+ * Concurrent Caches are hash tables (see upo/hashtable.h) with a fixed
+ * capacity that can be shared by many threads.
+ * When a new key is stored in a full cache, a key-value pair is evicted by
+ * means of the CLOCK algorithm with frequency counters (in the style of
+ * S3-FIFO): each hit increments a small saturating counter of its entry,
+ * and a clock hand sweeping the entries decrements counters and evicts the
+ * first entry whose counter is zero.
+ * Since new entries start with a zero counter, a scan of keys used only once
+ * evicts other keys used only once, while frequently used keys survive.
+ *
+ * Lookups take no lock: they scan the lists of collisions and validate each
+ * entry by means of a per-entry sequence lock, and hits only update the
+ * counter of their entry, without relinking any list.
+ * Updates (put and delete) are serialized by a mutex.
+ * Entries are allocated once on creation and reused, so lookups never access
+ * freed memory of the cache; keys and values, however, are owned by the user,
+ * and are not protected by any deferred reclamation.
+ * A lookup compares the searched key with the keys of a whole list of
+ * collisions, and returns a value that the caller keeps using after the
+ * call: thus, an evicted or removed key or value must not be freed (by the
+ * user, or by upo_cache_delete() and upo_cache_clear() with `destroy_data`
+ * equal to `1`) while any lookup may be running, nor while any thread may
+ * still use a value it has looked up.
+ *
+ * \copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ *  This file is part of UPOalglib.
+ *
+ *  UPOalglib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  UPOalglib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UPO_CACHE_H
+#define UPO_CACHE_H
+
+
+#include <stddef.h>
+#include <upo/hashtable.h>
+
+
+/** \brief Maximum value of the frequency counter of entries. */
+#define UPO_CACHE_MAX_FREQ 3U
+
+/** \brief Type for concurrent caches. */
+typedef struct upo_cache_s* upo_cache_t;
+
+/**
+ * \brief The type for eviction functions.
+ *
+ * Declares the type for functions that are called on each key-value pair
+ * evicted from a concurrent cache.
+ * An eviction function takes three parameters:
+ * - The first parameter is a pointer to the user-provided key being evicted.
+ * - The second parameter is a pointer to the value associated to the key.
+ * - The third parameter is a pointer to data that is used by the eviction
+ *   function to perform its operation.
+ * The eviction function is called while holding the lock of the cache, so it
+ * must not call functions of the same cache.
+ */
+typedef void (*upo_cache_evictor_t)(void*, void*, void*);
+
+
+/**
+ * \brief Creates a new empty concurrent cache.
+ *
+ * \param capacity The maximum number of key-value pairs of the cache (must be
+ *  greater than zero).
+ * \param key_hash A pointer to the function used to hash keys.
+ * \param key_cmp A pointer to the function used to compare keys.
+ * \return An empty concurrent cache.
+ *
+ * Keys are hashed by means of upo_ht_hash_wide().
+ *
+ * Worst-case complexity: linear in the capacity `m` of the cache, `O(m)`.
+ */
+upo_cache_t upo_cache_create(size_t capacity, upo_ht_hasher_t key_hash, upo_ht_comparator_t key_cmp);
+
+/**
+ * \brief Destroys the given concurrent cache.
+ *
+ * \param cache The cache to destroy.
+ * \param destroy_data Tells whether the previously allocated memory for data,
+ *  that is both keys and values, stored in the cache must be freed (value
+ *  `1`) or not (value `0`).
+ *
+ * No other thread may access the cache during or after this call.
+ * Memory deallocation (if requested) is performed by means of the `free()`
+ * standard C function.
+ *
+ * Worst-case complexity: linear in the capacity `m` of the cache, `O(m)`.
+ */
+void upo_cache_destroy(upo_cache_t cache, int destroy_data);
+
+/**
+ * \brief Removes all key-value pairs from the given concurrent cache.
+ *
+ * \param cache The cache to clear.
+ * \param destroy_data Tells whether the previously allocated memory for data,
+ *  that is both keys and values, stored in the cache must be freed (value
+ *  `1`) or not (value `0`).
+ *
+ * The eviction function is not called.
+ * If data is freed, no other thread may access the cache during this call,
+ * nor still use a value it has looked up.
+ * Memory deallocation (if requested) is performed by means of the `free()`
+ * standard C function.
+ *
+ * Worst-case complexity: linear in the capacity `m` of the cache, `O(m)`.
+ */
+void upo_cache_clear(upo_cache_t cache, int destroy_data);
+
+/**
+ * \brief Stores the given key-value pair into the given concurrent cache.
+ *
+ * \param cache The cache.
+ * \param key The key.
+ * \param value The value.
+ * \return The value previously associated to the given key, or `NULL` if the
+ *  key was not present.
+ *
+ * If the key is already present, its value is replaced (and the old value is
+ * returned rather than freed), while the stored key is kept: the given key
+ * is not stored, and may be freed by the caller.
+ * Otherwise, if the cache is full, a key-value pair is evicted first: the
+ * eviction function (if any) is called on it, but it is never freed.
+ * This function takes the lock of the cache.
+ *
+ * Average-case complexity: constant, `O(1)`.
+ */
+void* upo_cache_put(upo_cache_t cache, void *key, void *value);
+
+/**
+ * \brief Returns the value associated to the given key, and counts a use of
+ *  the key.
+ *
+ * \param cache The cache.
+ * \param key The key.
+ * \return The value associated to the key, or `NULL` if the key is not found.
+ *
+ * This function takes no lock and may run concurrently with any other
+ * function but upo_cache_destroy().
+ * A key that is being stored or removed concurrently may or may not be found.
+ * The returned value is not protected against concurrent removals: it stays
+ * valid only as long as no thread frees it after evicting or removing it
+ * (see upo_cache_delete()).
+ *
+ * Average-case complexity: constant, `O(1)`.
+ */
+void* upo_cache_get(const upo_cache_t cache, const void *key);
+
+/**
+ * \brief Tells if the given concurrent cache contains the given key, without
+ *  counting a use of the key.
+ *
+ * \param cache The cache.
+ * \param key The key.
+ * \return `1` if the cache contains the given key, or `0` otherwise.
+ *
+ * This function takes no lock (see upo_cache_get()).
+ *
+ * Average-case complexity: constant, `O(1)`.
+ */
+int upo_cache_contains(const upo_cache_t cache, const void *key);
+
+/**
+ * \brief Removes the given key from the given concurrent cache.
+ *
+ * \param cache The cache.
+ * \param key The key.
+ * \param destroy_data Tells whether the previously allocated memory for data,
+ *  that is both the key and its value, must be freed (value `1`) or not
+ *  (value `0`).
+ *
+ * The eviction function is not called.
+ * If data is freed, no lookup may run during this call (of any key, since
+ * lookups compare the keys of whole lists of collisions), and no thread may
+ * still use the value it has looked up.
+ * This function takes the lock of the cache.
+ * Memory deallocation (if requested) is performed by means of the `free()`
+ * standard C function.
+ *
+ * Average-case complexity: constant, `O(1)`.
+ */
+void upo_cache_delete(upo_cache_t cache, const void *key, int destroy_data);
+
+/**
+ * \brief Sets the function called on each key-value pair evicted from the
+ *  given concurrent cache.
+ *
+ * \param cache The cache.
+ * \param evict The eviction function, or `NULL` to call no function.
+ * \param evict_arg An additional parameter to pass to the eviction function.
+ *
+ * This function takes the lock of the cache.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+void upo_cache_set_evictor(upo_cache_t cache, upo_cache_evictor_t evict, void *evict_arg);
+
+/**
+ * \brief Returns the size of the given concurrent cache.
+ *
+ * \param cache The cache.
+ * \return The number of key-value pairs stored in the cache.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+size_t upo_cache_size(const upo_cache_t cache);
+
+/**
+ * \brief Tells if the given concurrent cache is empty.
+ *
+ * \param cache The cache.
+ * \return `1` if the cache is empty, or `0` otherwise.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+int upo_cache_is_empty(const upo_cache_t cache);
+
+/**
+ * \brief Returns the capacity of the given concurrent cache.
+ *
+ * \param cache The cache.
+ * \return The maximum number of key-value pairs of the cache.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+size_t upo_cache_capacity(const upo_cache_t cache);
+
+/**
+ * \brief Returns the key comparator function.
+ *
+ * \param cache The cache.
+ * \return The key comparator function.
+ */
+upo_ht_comparator_t upo_cache_get_comparator(const upo_cache_t cache);
+
+/**
+ * \brief Returns the key hasher function.
+ *
+ * \param cache The cache.
+ * \return The key hasher function.
+ */
+upo_ht_hasher_t upo_cache_get_hasher(const upo_cache_t cache);
+
+
+#endif /* UPO_CACHE_H */
@@ -0,0 +1,280 @@
+/**
+ * \file upo/cms.h
+ *
+ * \brief The Count-Min Sketch abstract data type.
+ *
+ * Count-Min Sketches (as described by Cormode and Muthukrishnan) estimate
+ * how many times each key of a stream has been counted, using a fixed amount
+ * of memory whatever the number of distinct keys.
+ * A sketch is a matrix of counters with `depth` rows of `width` counters;
+ * each key is mapped to one counter per row (by means of two hash values
+ * derived from upo_ht_hash_wide()), and its estimate is the least of its
+ * counters.
+ * Estimates never underestimate the true count and, with
+ * \f$width = \lceil e/\epsilon \rceil\f$ and
+ * \f$depth = \lceil \ln(1/\delta) \rceil\f$, overestimate it by more than
+ * \f$\epsilon N\f$ (where \f$N\f$ is the total count) with probability at most
+ * \f$\delta\f$.
+ *
+ * Counts are added with the conservative update rule, which raises only the
+ * counters that are below the new estimate of the key: this keeps the same
+ * guarantees while making overestimates much smaller in skewed streams.
+ *
+ * Sketches with the same size and key hash function can be merged by adding
+ * their counters, so a stream can be split among several threads, each one
+ * counting into its own sketch, and the sketches merged at the end; the
+ * merged estimates are still never below the true counts.
+ *
+ * Heavy hitters structures combine a sketch with a min-heap of the `k` keys
+ * with the largest estimates seen so far (indexed by a hash table with
+ * linear probing, see upo/hashtable.h), to track the most frequent keys of a
+ * stream in fixed memory.
+ *
+ * \copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ *  This file is part of UPOalglib.
+ *
+ *  UPOalglib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  UPOalglib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UPO_CMS_H
+#define UPO_CMS_H
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <upo/hashtable.h>
+
+
+/** \brief Type for count-min sketches. */
+typedef struct upo_cms_s* upo_cms_t;
+
+/** \brief Type for heavy hitters structures. */
+typedef struct upo_cms_topk_s* upo_cms_topk_t;
+
+
+/**
+ * \brief Creates a new count-min sketch with the given size.
+ *
+ * \param width The number of counters of each row.
+ * \param depth The number of rows.
+ * \param key_hash A pointer to the function used to hash keys.
+ * \return A sketch with all counters set to zero.
+ *
+ * Worst-case complexity: linear in the number of counters, `O(width*depth)`.
+ */
+upo_cms_t upo_cms_create(size_t width, size_t depth, upo_ht_hasher_t key_hash);
+
+/**
+ * \brief Creates a new count-min sketch with the given error bounds.
+ *
+ * \param epsilon The relative error, in `(0, 1)`.
+ * \param delta The probability of exceeding the error, in `(0, 1)`.
+ * \param key_hash A pointer to the function used to hash keys.
+ * \return A sketch with \f$\lceil e/\epsilon \rceil\f$ counters per row and
+ *  \f$\lceil \ln(1/\delta) \rceil\f$ rows, all set to zero.
+ *
+ * Worst-case complexity: linear in the number of counters,
+ *  \f$O(\frac{1}{\epsilon}\ln\frac{1}{\delta})\f$.
+ */
+upo_cms_t upo_cms_create_with_error(double epsilon, double delta, upo_ht_hasher_t key_hash);
+
+/**
+ * \brief Destroys the given count-min sketch.
+ *
+ * \param cms The sketch to destroy.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+void upo_cms_destroy(upo_cms_t cms);
+
+/**
+ * \brief Sets all counters of the given count-min sketch to zero.
+ *
+ * \param cms The sketch.
+ *
+ * Worst-case complexity: linear in the number of counters, `O(width*depth)`.
+ */
+void upo_cms_clear(upo_cms_t cms);
+
+/**
+ * \brief Adds the given count to the given key.
+ *
+ * \param cms The sketch.
+ * \param key The key.
+ * \param count The count to add.
+ * \return The new estimate of the count of the key.
+ *
+ * The counters of the key are raised to its previous estimate plus `count`,
+ * and those already above are left unchanged (conservative update).
+ *
+ * Worst-case complexity: linear in the number of rows, `O(depth)`.
+ */
+uint64_t upo_cms_add(upo_cms_t cms, const void *key, uint64_t count);
+
+/**
+ * \brief Returns the estimate of the count of the given key.
+ *
+ * \param cms The sketch.
+ * \param key The key.
+ * \return The least of the counters of the key, which is never below the
+ *  count of the key, or `0` if the sketch is `NULL`.
+ *
+ * Worst-case complexity: linear in the number of rows, `O(depth)`.
+ */
+uint64_t upo_cms_estimate(const upo_cms_t cms, const void *key);
+
+/**
+ * \brief Adds the counts of a count-min sketch to another one.
+ *
+ * \param cms The sketch to update.
+ * \param other The sketch whose counts are added.
+ * \return `1` if the sketches have been merged, or `0` if they have different
+ *  sizes or key hash functions.
+ *
+ * Worst-case complexity: linear in the number of counters, `O(width*depth)`.
+ */
+int upo_cms_merge(upo_cms_t cms, const upo_cms_t other);
+
+/**
+ * \brief Returns the total count added to the given count-min sketch.
+ *
+ * \param cms The sketch.
+ * \return The sum of the counts added (including those of merged sketches),
+ *  or `0` if the sketch is `NULL`.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+uint64_t upo_cms_total(const upo_cms_t cms);
+
+/**
+ * \brief Returns the number of counters of each row of the given count-min
+ *  sketch.
+ *
+ * \param cms The sketch.
+ * \return The width of the sketch, or `0` if the sketch is `NULL`.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+size_t upo_cms_width(const upo_cms_t cms);
+
+/**
+ * \brief Returns the number of rows of the given count-min sketch.
+ *
+ * \param cms The sketch.
+ * \return The depth of the sketch, or `0` if the sketch is `NULL`.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+size_t upo_cms_depth(const upo_cms_t cms);
+
+/**
+ * \brief Creates a new heavy hitters structure.
+ *
+ * \param k The number of tracked keys.
+ * \param width The number of counters of each row of the sketch.
+ * \param depth The number of rows of the sketch.
+ * \param key_hash A pointer to the function used to hash keys.
+ * \param key_cmp A pointer to the function used to compare keys.
+ * \return An empty heavy hitters structure.
+ *
+ * Worst-case complexity: linear in the number of counters and of tracked
+ *  keys, `O(width*depth+k)`.
+ */
+upo_cms_topk_t upo_cms_topk_create(size_t k, size_t width, size_t depth, upo_ht_hasher_t key_hash, upo_ht_comparator_t key_cmp);
+
+/**
+ * \brief Destroys the given heavy hitters structure.
+ *
+ * \param topk The heavy hitters structure to destroy.
+ *
+ * Tracked keys are not freed.
+ *
+ * Worst-case complexity: linear in the number of tracked keys, `O(k)`.
+ */
+void upo_cms_topk_destroy(upo_cms_topk_t topk);
+
+/**
+ * \brief Adds the given count to the given key, tracking the key if its
+ *  estimate is among the `k` largest ones.
+ *
+ * \param topk The heavy hitters structure.
+ * \param key The key, which is not copied: while tracked, it is referenced by
+ *  the structure and must not be freed.
+ * \param count The count to add.
+ * \return The new estimate of the count of the key.
+ *
+ * If `k` keys are already tracked, the key replaces the tracked key with the
+ * least estimate when its own estimate is larger.
+ *
+ * Average-case complexity: logarithmic in the number of tracked keys and
+ *  linear in the number of rows of the sketch, `O(log(k)+depth)`.
+ */
+uint64_t upo_cms_topk_add(upo_cms_topk_t topk, void *key, uint64_t count);
+
+/**
+ * \brief Returns the tracked keys of the given heavy hitters structure.
+ *
+ * \param topk The heavy hitters structure.
+ * \param keys The array to fill with the tracked keys (of at least `k`
+ *  elements), in order of decreasing estimate.
+ * \param counts The array to fill with the estimates of the keys (of at least
+ *  `k` elements), or `NULL`.
+ * \return The number of tracked keys.
+ *
+ * Worst-case complexity: quadratic in the number of tracked keys, `O(k^2)`.
+ */
+size_t upo_cms_topk_items(const upo_cms_topk_t topk, void **keys, uint64_t *counts);
+
+/**
+ * \brief Adds the counts and the tracked keys of a heavy hitters structure to
+ *  another one.
+ *
+ * \param topk The heavy hitters structure to update.
+ * \param other The heavy hitters structure whose counts and keys are added.
+ * \return `1` if the structures have been merged, or `0` if their sketches
+ *  cannot be merged (see upo_cms_merge()).
+ *
+ * The estimates of the tracked keys of both structures are recomputed from
+ * the merged sketch, and the `k` keys with the largest ones are kept.
+ * Keys tracked by `other` may become tracked by `topk` too, so they must not
+ * be freed while either structure tracks them.
+ *
+ * Worst-case complexity: linear in the number of counters and of tracked
+ *  keys, `O(width*depth+k*(log(k)+depth))`.
+ */
+int upo_cms_topk_merge(upo_cms_topk_t topk, const upo_cms_topk_t other);
+
+/**
+ * \brief Returns the sketch of the given heavy hitters structure.
+ *
+ * \param topk The heavy hitters structure.
+ * \return The sketch, which can be used to estimate the count of any key.
+ */
+upo_cms_t upo_cms_topk_sketch(const upo_cms_topk_t topk);
+
+/**
+ * \brief Returns the number of tracked keys of the given heavy hitters
+ *  structure.
+ *
+ * \param topk The heavy hitters structure.
+ * \return The number of tracked keys (at most `k`), or `0` if the structure
+ *  is `NULL`.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+size_t upo_cms_topk_size(const upo_cms_topk_t topk);
+
+
+#endif /* UPO_CMS_H */
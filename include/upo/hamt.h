@@ -0,0 +1,233 @@
+/**
+ * \file upo/hamt.h
+ *
+ * \brief The Hash Array Mapped Trie abstract data type.
+ *
+ * Hash Array Mapped Tries (as described by Bagwell) are persistent maps: a
+ * snapshot of a map is taken in constant time, and later updates of the map
+ * leave the snapshot unchanged (and vice versa).
+ *
+ * Keys are hashed to 64 bits by means of upo_ht_hash_wide(), and the trie
+ * consumes 5 bits of the hash value per level, so each node has up to 32
+ * children.
+ * A node stores only its present entries, packed in an array, together with
+ * a 32-bit bitmap telling which of the 32 entries are present: the position
+ * of an entry in the array is the number of bits set in the bitmap before
+ * its bit.
+ * Keys whose 64-bit hash values are equal end up in the same collision node,
+ * which is scanned linearly.
+ *
+ * Nodes are never modified once built: an update copies the nodes on the
+ * path from the root to the updated entry, that is
+ * \f$O(\log_{32} n)\f$ nodes, and shares all other nodes with the previous
+ * version.
+ * Nodes are reference counted (with atomic counters, so that different
+ * snapshots of a map may be used and destroyed by different threads), and
+ * are freed when the last version using them is destroyed.
+ * Since keys and values may be shared by several versions, they are never
+ * freed by the map.
+ *
+ * \copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ *  This file is part of UPOalglib.
+ *
+ *  UPOalglib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  UPOalglib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UPO_HAMT_H
+#define UPO_HAMT_H
+
+
+#include <stddef.h>
+#include <upo/hashtable.h>
+
+
+/** \brief Number of bits of the hash value consumed by each level of the trie. */
+#define UPO_HAMT_BITS 5U
+
+/** \brief Maximum number of children of a node of the trie. */
+#define UPO_HAMT_BRANCHING (1U << UPO_HAMT_BITS)
+
+/** \brief Type for hash array mapped tries. */
+typedef struct upo_hamt_s* upo_hamt_t;
+
+
+/**
+ * \brief Creates a new empty hash array mapped trie.
+ *
+ * \param key_hash A pointer to the function used to hash keys.
+ * \param key_cmp A pointer to the function used to compare keys.
+ * \return An empty map.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+upo_hamt_t upo_hamt_create(upo_ht_hasher_t key_hash, upo_ht_comparator_t key_cmp);
+
+/**
+ * \brief Destroys the given hash array mapped trie.
+ *
+ * \param hamt The map to destroy.
+ *
+ * Only the nodes that are not shared with other snapshots are freed; keys and
+ * values are never freed.
+ *
+ * Worst-case complexity: linear in the number of nodes that are not shared.
+ */
+void upo_hamt_destroy(upo_hamt_t hamt);
+
+/**
+ * \brief Takes a snapshot of the given hash array mapped trie.
+ *
+ * \param hamt The map.
+ * \return A new map holding the same key-value pairs, which is not affected
+ *  by later updates of the given map (and does not affect it when updated);
+ *  it must be destroyed by means of upo_hamt_destroy().
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+upo_hamt_t upo_hamt_snapshot(const upo_hamt_t hamt);
+
+/**
+ * \brief Stores the given key-value pair into the given hash array mapped
+ *  trie.
+ *
+ * \param hamt The map.
+ * \param key The key.
+ * \param value The value.
+ * \return The value previously associated to the given key, or `NULL` if
+ *  the key was not present.
+ *
+ * If the key is already present, its value is replaced.
+ * Snapshots of the map are not affected.
+ *
+ * Worst-case complexity: logarithmic in the size `n` of the map,
+ *  \f$O(\log_{32} n)\f$, for keys with distinct hash values.
+ */
+void* upo_hamt_put(upo_hamt_t hamt, void *key, void *value);
+
+/**
+ * \brief Returns the value associated to the given key.
+ *
+ * \param hamt The map.
+ * \param key The key.
+ * \return The value associated to the key, or `NULL` if the key is not
+ *  found.
+ *
+ * Worst-case complexity: logarithmic in the size `n` of the map,
+ *  \f$O(\log_{32} n)\f$, for keys with distinct hash values.
+ */
+void* upo_hamt_get(const upo_hamt_t hamt, const void *key);
+
+/**
+ * \brief Tells if the given hash array mapped trie contains the given key.
+ *
+ * \param hamt The map.
+ * \param key The key.
+ * \return `1` if the map contains the given key, or `0` otherwise.
+ *
+ * Worst-case complexity: logarithmic in the size `n` of the map,
+ *  \f$O(\log_{32} n)\f$, for keys with distinct hash values.
+ */
+int upo_hamt_contains(const upo_hamt_t hamt, const void *key);
+
+/**
+ * \brief Removes the given key from the given hash array mapped trie.
+ *
+ * \param hamt The map.
+ * \param key The key.
+ * \return `1` if the key has been removed, or `0` if it was not found.
+ *
+ * Nodes left with a single key-value pair are merged into their parent, so
+ * the shape of the trie only depends on the stored keys.
+ * Snapshots of the map are not affected.
+ *
+ * Worst-case complexity: logarithmic in the size `n` of the map,
+ *  \f$O(\log_{32} n)\f$, for keys with distinct hash values.
+ */
+int upo_hamt_delete(upo_hamt_t hamt, const void *key);
+
+/**
+ * \brief Returns the size of the given hash array mapped trie.
+ *
+ * \param hamt The map.
+ * \return The number of key-value pairs stored in the map, or `0` if the
+ *  map is `NULL`.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+size_t upo_hamt_size(const upo_hamt_t hamt);
+
+/**
+ * \brief Tells if the given hash array mapped trie is empty.
+ *
+ * \param hamt The map.
+ * \return `1` if the map is empty or `NULL`, or `0` otherwise.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+int upo_hamt_is_empty(const upo_hamt_t hamt);
+
+/**
+ * \brief Returns the depth of the given hash array mapped trie.
+ *
+ * \param hamt The map.
+ * \return The number of levels of nodes below the root (`0` if the map
+ *  holds at most one node).
+ *
+ * Worst-case complexity: linear in the number of nodes of the map.
+ */
+size_t upo_hamt_depth(const upo_hamt_t hamt);
+
+/**
+ * \brief Returns the list of all keys contained in the given hash array
+ *  mapped trie.
+ *
+ * \param hamt The map.
+ * \return The list of keys, in no particular order.
+ *
+ * Worst-case complexity: linear in the size `n` of the map, `O(n)`.
+ */
+upo_ht_key_list_t upo_hamt_keys(const upo_hamt_t hamt);
+
+/**
+ * \brief Traverses the given hash array mapped trie.
+ *
+ * \param hamt The map.
+ * \param visit The function to call on each key-value pair.
+ * \param visit_arg An additional parameter to pass to the visit function.
+ *
+ * Pairs are visited in no particular order.
+ *
+ * Worst-case complexity: linear in the size `n` of the map, `O(n)`.
+ */
+void upo_hamt_traverse(const upo_hamt_t hamt, upo_ht_visitor_t visit, void *visit_arg);
+
+/**
+ * \brief Returns the key comparator function.
+ *
+ * \param hamt The map.
+ * \return The key comparator function.
+ */
+upo_ht_comparator_t upo_hamt_get_comparator(const upo_hamt_t hamt);
+
+/**
+ * \brief Returns the key hasher function.
+ *
+ * \param hamt The map.
+ * \return The key hasher function.
+ */
+upo_ht_hasher_t upo_hamt_get_hasher(const upo_hamt_t hamt);
+
+
+#endif /* UPO_HAMT_H */
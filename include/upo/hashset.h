@@ -0,0 +1,270 @@
+/**
+ * \file upo/hashset.h
+ *
+ * \brief The Hash Set (HS) abstract data type.
+ *
+ * Hash Sets are containers composed of unique keys (containing at most one of
+ * each key value) with no associated value.
+ * They are implemented as hash tables with linear probing (see
+ * upo/hashtable.h) whose slots only store keys, and use the same hash and key
+ * comparison functions of hash tables.
+ *
+ * \copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ *  This file is part of UPOalglib.
+ *
+ *  UPOalglib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  UPOalglib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UPO_HASHSET_H
+#define UPO_HASHSET_H
+
+
+#include <stddef.h>
+#include <upo/hashtable.h>
+
+
+/** \brief Initial capacity of hash sets. */
+#define UPO_HS_DEFAULT_CAPACITY 16U
+
+/** \brief Type for hash sets. */
+typedef struct upo_hs_s* upo_hs_t;
+
+/**
+ * \brief The type for visit functions.
+ *
+ * Declares the type for visit functions that are used in hash set traversal.
+ * A visit function takes two parameters:
+ * - The first parameter is a pointer to the user-provided key that is being
+ *   visited.
+ * - The second parameter is a pointer to data that is used by the visit
+ *   function to perform its operation.
+ */
+typedef void (*upo_hs_visitor_t)(void*, void*);
+
+
+/**
+ * \brief Creates a new empty hash set.
+ *
+ * \param m The initial capacity of the hash set.
+ * \param key_hash A pointer to the function used to hash keys.
+ * \param key_cmp A pointer to the function used to compare keys.
+ * \return An empty hash set.
+ *
+ * Worst-case complexity: linear in the capacity `m` of the hash set, `O(m)`.
+ */
+upo_hs_t upo_hs_create(size_t m, upo_ht_hasher_t key_hash, upo_ht_comparator_t key_cmp);
+
+/**
+ * \brief Destroys the given hash set.
+ *
+ * \param hs The hash set to destroy.
+ * \param destroy_data Tells whether the previously allocated memory for keys
+ *  stored in the hash set must be freed (value `1`) or not (value `0`).
+ *
+ * Memory deallocation (if requested) is performed by means of the `free()`
+ * standard C function.
+ *
+ * Worst-case complexity: linear in the capacity `m` of the hash set, `O(m)`.
+ */
+void upo_hs_destroy(upo_hs_t hs, int destroy_data);
+
+/**
+ * \brief Removes all keys from the given hash set.
+ *
+ * \param hs The hash set to clear.
+ * \param destroy_data Tells whether the previously allocated memory for keys
+ *  stored in the hash set must be freed (value `1`) or not (value `0`).
+ *
+ * Memory deallocation (if requested) is performed by means of the `free()`
+ * standard C function.
+ *
+ * Worst-case complexity: linear in the capacity `m` of the hash set, `O(m)`.
+ */
+void upo_hs_clear(upo_hs_t hs, int destroy_data);
+
+/**
+ * \brief Inserts the given key in the given hash set.
+ *
+ * \param hs The hash set.
+ * \param key The key.
+ * \return `1` if the key has been inserted, or `0` if it was already present.
+ *
+ * If the key is already present in the hash set, no insertion takes place.
+ *
+ * Worst-case complexity: linear in the number `n` of keys, `O(n)`.
+ */
+int upo_hs_insert(upo_hs_t hs, void *key);
+
+/**
+ * \brief Tells if the given hash set contains the given key.
+ *
+ * \param hs The hash set.
+ * \param key The key.
+ * \return `1` if the hash set contains the given key, or `0` otherwise.
+ *
+ * Worst-case complexity: linear in the number `n` of keys, `O(n)`.
+ */
+int upo_hs_contains(const upo_hs_t hs, const void *key);
+
+/**
+ * \brief Removes the given key from the given hash set.
+ *
+ * \param hs The hash set.
+ * \param key The key.
+ * \param destroy_data Tells whether the previously allocated memory for the
+ *  stored key must be freed (value `1`) or not (value `0`).
+ *
+ * Memory deallocation (if requested) is performed by means of the `free()`
+ * standard C function.
+ *
+ * Worst-case complexity: linear in the number `n` of keys, `O(n)`.
+ */
+void upo_hs_delete(upo_hs_t hs, const void *key, int destroy_data);
+
+/**
+ * \brief Tells if the given hash set is empty.
+ *
+ * \param hs The hash set.
+ * \return `1` if the hash set is empty or `0` otherwise.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+int upo_hs_is_empty(const upo_hs_t hs);
+
+/**
+ * \brief Returns the capacity of the hash set.
+ *
+ * \param hs The hash set.
+ * \return The total number of slots of the hash set.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+size_t upo_hs_capacity(const upo_hs_t hs);
+
+/**
+ * \brief Returns the size of the hash set.
+ *
+ * \param hs The hash set.
+ * \return The number of keys stored in the hash set.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+size_t upo_hs_size(const upo_hs_t hs);
+
+/**
+ * \brief Returns the load factor of the hash set.
+ *
+ * \param hs The hash set.
+ * \return The ratio between the number of stored keys and the number of
+ *  slots.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+double upo_hs_load_factor(const upo_hs_t hs);
+
+/**
+ * \brief Returns the keys in the given hash set.
+ *
+ * \param hs The hash set.
+ * \return A singly-linked list of keys, or `NULL` if the hash set is empty.
+ *
+ * Worst-case complexity: linear in the number `m` of slots, `O(m)`.
+ */
+upo_ht_key_list_t upo_hs_keys(const upo_hs_t hs);
+
+/**
+ * \brief Performs a traversal of the hash set.
+ *
+ * \param hs The hash set to traverse.
+ * \param visit The visit function.
+ * \param visit_arg An additional parameter to pass to the visit function
+ *
+ * Worst-case complexity: linear in the number `m` of slots, `O(m)`.
+ */
+void upo_hs_traverse(const upo_hs_t hs, upo_hs_visitor_t visit, void *visit_arg);
+
+/**
+ * \brief Returns the union of the given hash sets.
+ *
+ * \param a The first hash set.
+ * \param b The second hash set.
+ * \return A new hash set containing the keys that are in \a a or in \a b.
+ *
+ * The two hash sets must use the same hash and key comparison functions, which
+ * are also used by the returned hash set.
+ * Keys are shared (not copied) with the input hash sets; when a key is in both
+ * sets, the one of \a a is kept.
+ * The array of slots of \a a is copied as a whole (or rehashed, if the union
+ * does not fit its capacity) and the keys of \a b are then inserted by scanning
+ * its array of slots.
+ *
+ * Average-case complexity: linear in the capacities and in the sizes of the
+ *  input hash sets.
+ */
+upo_hs_t upo_hs_union(const upo_hs_t a, const upo_hs_t b);
+
+/**
+ * \brief Returns the intersection of the given hash sets.
+ *
+ * \param a The first hash set.
+ * \param b The second hash set.
+ * \return A new hash set containing the keys that are both in \a a and in
+ *  \a b.
+ *
+ * The two hash sets must use the same hash and key comparison functions, which
+ * are also used by the returned hash set.
+ * Keys are shared (not copied) with \a a.
+ * The array of slots of the smaller set is scanned and each key is looked up in
+ * the other set.
+ *
+ * Average-case complexity: linear in the capacities and in the sizes of the
+ *  input hash sets.
+ */
+upo_hs_t upo_hs_intersection(const upo_hs_t a, const upo_hs_t b);
+
+/**
+ * \brief Returns the difference of the given hash sets.
+ *
+ * \param a The first hash set.
+ * \param b The second hash set.
+ * \return A new hash set containing the keys that are in \a a but not in
+ *  \a b.
+ *
+ * The two hash sets must use the same hash and key comparison functions, which
+ * are also used by the returned hash set.
+ * Keys are shared (not copied) with \a a.
+ *
+ * Average-case complexity: linear in the capacity of \a a.
+ */
+upo_hs_t upo_hs_difference(const upo_hs_t a, const upo_hs_t b);
+
+/**
+ * \brief Returns the key comparator function.
+ *
+ * \param hs The hash set.
+ * \return The key comparator function.
+ */
+upo_ht_comparator_t upo_hs_get_comparator(const upo_hs_t hs);
+
+/**
+ * \brief Returns the key hasher function.
+ *
+ * \param hs The hash set.
+ * \return The key hasher function.
+ */
+upo_ht_hasher_t upo_hs_get_hasher(const upo_hs_t hs);
+
+
+#endif /* UPO_HASHSET_H */
@@ -31,6 +31,8 @@
 
 
 #include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
 
 
 /*** BEGIN of COMMON TYPES ***/
@@ -80,6 +82,70 @@ typedef int (*upo_ht_comparator_t)(const void*, const void*);
  */
 typedef void (*upo_ht_visitor_t)(void*, void*, void*);
 
+/**
+ * \brief The type for update functions.
+ *
+ * Declares the type for update functions that are used to compute the value
+ * to associate with a key in a single lookup.
+ * An update function takes three parameters:
+ * - The first parameter is a pointer to the key whose value is computed.
+ * - The second parameter is a pointer to the value currently associated to the
+ *   key, or `NULL` if the key is not stored in the hash table.
+ * - The third parameter is a pointer to data that is used by the update
+ *   function to perform its operation.
+ * An update function returns the new value to associate with the key, or
+ * `NULL` if the key must not be stored in the hash table.
+ */
+typedef void* (*upo_ht_updater_t)(const void*, void*, void*);
+
+/**
+ * \brief The type for predicate functions.
+ *
+ * Declares the type for predicate functions that are used to select key-value
+ * pairs stored in the hash table.
+ * A predicate function takes three parameters:
+ * - The first parameter is a pointer to the key that is being tested.
+ * - The second parameter is a pointer to the value associated to the key that
+ *   is being tested.
+ * - The third parameter is a pointer to data that is used by the predicate
+ *   function to perform its operation.
+ * A predicate function returns a nonzero number if the key-value pair
+ * satisfies the predicate, or `0` otherwise.
+ */
+typedef int (*upo_ht_predicate_t)(const void*, const void*, void*);
+
+/**
+ * \brief The type for sizing functions.
+ *
+ * Declares the type for functions that report the memory used by the data of
+ * key-value pairs stored in a hash table with a memory budget.
+ * A sizing function takes three parameters:
+ * - The first parameter is a pointer to the key.
+ * - The second parameter is a pointer to the value associated to the key.
+ * - The third parameter is a pointer to data that is used by the sizing
+ *   function to perform its operation.
+ * A sizing function returns the number of bytes used by the key and the value
+ * (not including the memory of the hash table itself), and must return the
+ * same number each time it is called on the same key-value pair.
+ */
+typedef size_t (*upo_ht_sizer_t)(const void*, const void*, void*);
+
+/**
+ * \brief The type for ranking functions.
+ *
+ * Declares the type for functions that implement the eviction policy of a
+ * hash table with a memory budget.
+ * A ranking function takes three parameters:
+ * - The first parameter is a pointer to the key of a candidate for eviction.
+ * - The second parameter is a pointer to the value associated to the key.
+ * - The third parameter is a pointer to data that is used by the ranking
+ *   function to perform its operation.
+ * A ranking function returns the rank of the key-value pair: among the
+ * candidates, the pair with the lowest rank is evicted (e.g., the rank may be
+ * the time of last use for an approximated LRU policy).
+ */
+typedef unsigned long (*upo_ht_ranker_t)(const void*, const void*, void*);
+
 /** \brief The type for nodes of list of keys. */
 struct upo_ht_key_list_node_s {
     void *key; /**< Pointer to the key. */
@@ -91,6 +157,60 @@ typedef struct upo_ht_key_list_node_s upo_ht_key_list_node_t;
 /** \brief The type for list of keys. */
 typedef upo_ht_key_list_node_t *upo_ht_key_list_t;
 
+/** \brief Number of buckets of the histograms collected by hash table statistics. */
+#define UPO_HT_STATS_HISTOGRAM_SIZE 16U
+
+/**
+ * \brief The type for snapshots of hash table statistics.
+ *
+ * The structural fields (`capacity`, `size`, `tombstones`, `longest_cluster`
+ * and `histogram`) are computed when the snapshot is taken.
+ * The counters (`hash_calls`, `cmp_calls`, `resizes` and `resize_time`) are
+ * only updated while statistics are enabled on the hash table, and stay at
+ * zero otherwise.
+ */
+struct upo_ht_stats_s {
+    size_t capacity; /**< The capacity of the hash table. */
+    size_t size; /**< The number of stored keys. */
+    size_t tombstones; /**< The number of slots marked as deleted (linear probing only). */
+    size_t longest_cluster; /**< The longest run of consecutive non-empty slots (linear probing) or the longest list of collisions (separate chaining). */
+    size_t histogram[UPO_HT_STATS_HISTOGRAM_SIZE]; /**< For linear probing, the i-th bucket counts the keys stored i slots away from their home slot (i.e., found with i+1 probes); for separate chaining, it counts the slots whose list of collisions has length i. The last bucket also collects all larger values. */
+    size_t hash_calls; /**< The number of calls to the key hash function. */
+    size_t cmp_calls; /**< The number of calls to the key comparison function. */
+    size_t resizes; /**< The number of resize operations. */
+    double resize_time; /**< The time (in seconds) spent resizing the hash table. */
+};
+/** \brief Alias for the type for snapshots of hash table statistics. */
+typedef struct upo_ht_stats_s upo_ht_stats_t;
+
+/** \brief Default number of candidates ranked to choose each evicted pair. */
+#define UPO_HT_BUDGET_DEFAULT_SAMPLES 5U
+
+/**
+ * \brief The type for memory budgets of hash tables.
+ *
+ * The memory of a hash table is made of the hash table type, of its slots and
+ * nodes, and of the data of its key-value pairs as reported by the sizing
+ * function (if any).
+ * When storing a new key would take the memory beyond `max_bytes`, including
+ * when a hash table with linear probing should grow, key-value pairs are
+ * evicted first.
+ * Each evicted pair is chosen by ranking `samples` candidates taken from the
+ * slots following a random slot, so that the cost of an eviction does not
+ * depend on the size of the hash table.
+ */
+struct upo_ht_budget_s {
+    size_t max_bytes; /**< The maximum number of bytes of memory of the hash table. */
+    upo_ht_sizer_t data_size; /**< The sizing function, or `NULL` to only account the memory of the hash table itself. */
+    upo_ht_ranker_t rank; /**< The ranking function, or `NULL` to evict the first candidate (i.e., random eviction). */
+    size_t samples; /**< The number of candidates ranked to choose each evicted pair (`0` for UPO_HT_BUDGET_DEFAULT_SAMPLES). */
+    upo_ht_visitor_t evict; /**< The function called on each evicted pair before it is (possibly) freed, or `NULL`. */
+    void *arg; /**< The additional parameter passed to the sizing, ranking and eviction functions. */
+    int destroy_data; /**< Tells whether the keys and values of evicted pairs must be freed by means of the `free()` standard C function. */
+};
+/** \brief Alias for the type for memory budgets of hash tables. */
+typedef struct upo_ht_budget_s upo_ht_budget_t;
+
 
 /*** END of COMMON TYPES ***/
 
@@ -105,6 +225,17 @@ typedef upo_ht_key_list_node_t *upo_ht_key_list_t;
 /** \brief Type for hash tables with separate chaining. */
 typedef struct upo_ht_sepchain_s* upo_ht_sepchain_t;
 
+/** \brief Policies for organizing the lists of collisions of hash tables with separate chaining. */
+enum upo_ht_sepchain_policy_e
+{
+    UPO_HT_SEPCHAIN_POLICY_HEAD, /**< New keys are inserted at the head of lists, which are never reordered (default). */
+    UPO_HT_SEPCHAIN_POLICY_MOVE_TO_FRONT, /**< Like `UPO_HT_SEPCHAIN_POLICY_HEAD`, but found keys are moved to the head of their list. */
+    UPO_HT_SEPCHAIN_POLICY_TRANSPOSE, /**< Like `UPO_HT_SEPCHAIN_POLICY_HEAD`, but found keys are swapped with their predecessor. */
+    UPO_HT_SEPCHAIN_POLICY_SORTED /**< Lists are kept sorted in ascending order of keys, so that unsuccessful searches stop early. */
+};
+/** \brief Alias for the type for policies of lists of collisions. */
+typedef enum upo_ht_sepchain_policy_e upo_ht_sepchain_policy_t;
+
 
 /**
  * \brief Creates a new empty hash table.
@@ -132,6 +263,25 @@ upo_ht_sepchain_t upo_ht_sepchain_create(size_t m, upo_ht_hasher_t key_hash, upo
  */
 void upo_ht_sepchain_destroy(upo_ht_sepchain_t ht, int destroy_data);
 
+/**
+ * \brief Destroys the given hash table on the background reclaimer thread.
+ *
+ * \param ht The hash table to destroy, which must not be accessed anymore.
+ * \param destroy_data Tells whether the previously allocated memory for data
+ *  stored in the hash table must be freed (value `1`) or not (value `0`).
+ *
+ * The hash table is handed to the reclaimer (see upo/reclaimer.h), which
+ * frees its lists of collisions in bounded batches, so that the caller does
+ * not wait for millions of key-value pairs to be freed.
+ * Memory deallocation (if requested) is performed by means of the `free()`
+ * standard C function.
+ *
+ * Worst-case complexity: constant, `O(1)`, for the caller; linear in the
+ *  capacity `m` and in the size `n` of the hash table, `O(m+n)`, for the
+ *  reclaimer.
+ */
+void upo_ht_sepchain_destroy_async(upo_ht_sepchain_t ht, int destroy_data);
+
 /**
  * \brief Removes all key-value pairs from the given hash table.
  *
@@ -142,7 +292,9 @@ void upo_ht_sepchain_destroy(upo_ht_sepchain_t ht, int destroy_data);
  * Memory deallocation (if requested) is performed by means of the `free()`
  * standard C function.
  *
- * Worst-case complexity: linear in the capacity `m` of the hash table, `O(m)`.
+ * Worst-case complexity: linear in the capacity `m` of the hash table, `O(m)`,
+ *  or constant, `O(1)`, if generation stamps are enabled (see
+ *  upo_ht_sepchain_enable_generations()) and \a destroy_data is `0`.
  */
 void upo_ht_sepchain_clear(upo_ht_sepchain_t ht, int destroy_data);
 
@@ -219,6 +371,67 @@ int upo_ht_sepchain_contains(const upo_ht_sepchain_t ht, const void *key);
  */
 void upo_ht_sepchain_delete(upo_ht_sepchain_t ht, const void *key, int destroy_data);
 
+/**
+ * \brief Returns a pointer to the value associated to the given key, inserting
+ *  the key if it is not present.
+ *
+ * \param ht The hash table.
+ * \param key The key.
+ * \param value_ptr Set to a pointer to the value associated to \a key, through
+ *  which the value can be read and updated in place.
+ * \return `1` if the key has been inserted (with a `NULL` value), or `0` if
+ *  the key was already present.
+ *
+ * The key is hashed and looked up only once.
+ * The returned pointer is only valid until the next modification of the hash
+ * table, and a newly inserted key should be associated with a non-`NULL` value
+ * through it, since a `NULL` value reads as a missing key.
+ *
+ * Worst-case complexity: linear in the number `n` of elements, `O(n)`.
+ */
+int upo_ht_sepchain_get_or_insert(upo_ht_sepchain_t ht, void *key, void ***value_ptr);
+
+/**
+ * \brief Computes the value associated to the given key by means of the given
+ *  update function.
+ *
+ * \param ht The hash table.
+ * \param key The key.
+ * \param update The update function, which is called once with \a key, its
+ *  current value (or `NULL` if the key is not present) and \a update_arg.
+ * \param update_arg An additional parameter to pass to the update function.
+ * \return The value returned by the update function.
+ *
+ * The key is hashed and looked up only once.
+ * If the update function returns `NULL`, the key is removed (if present) or
+ * not inserted; otherwise the returned value is associated to the key (which
+ * is inserted if not present).
+ * No memory is deallocated: the update function can free the current value
+ * when replacing it.
+ *
+ * Worst-case complexity: linear in the number `n` of elements, `O(n)`.
+ */
+void* upo_ht_sepchain_compute(upo_ht_sepchain_t ht, void *key, upo_ht_updater_t update, void *update_arg);
+
+/**
+ * \brief Removes from the given hash table all the key-value pairs that do not
+ *  satisfy the given predicate.
+ *
+ * \param ht The hash table.
+ * \param pred The predicate, which must not modify the hash table.
+ * \param pred_arg An additional parameter to pass to the predicate.
+ * \param destroy_data Tells whether the previously allocated memory for data,
+ *  that is to be removed, must be freed (value `1`) or not (value `0`).
+ * \return The number of removed key-value pairs.
+ *
+ * The lists of collisions are swept once, calling the predicate on each key-value pair.
+ * Memory deallocation (if requested) is performed by means of the `free()`
+ * standard C function.
+ * Worst-case complexity: linear in the capacity `m` of the hash table and in
+ *  the number `n` of elements, `O(m+n)`.
+ */
+size_t upo_ht_sepchain_retain(upo_ht_sepchain_t ht, upo_ht_predicate_t pred, void *pred_arg, int destroy_data);
+
 /**
  * \brief Tells if the given hash table is empty.
  *
@@ -299,6 +512,68 @@ upo_ht_comparator_t upo_ht_sepchain_get_comparator(const upo_ht_sepchain_t ht);
  */
 upo_ht_hasher_t upo_ht_sepchain_get_hasher(const upo_ht_sepchain_t ht);
 
+/**
+ * \brief Enables generation stamps for the slots of the given hash table.
+ *
+ * \param ht The hash table.
+ *
+ * Each slot is stamped with the generation in which it has been last written,
+ * and slots stamped with a past generation are read as empty.
+ * This way, upo_ht_sepchain_clear() with `destroy_data` equal to `0` only
+ * advances the current generation, and the nodes of stale lists of collisions
+ * are freed when their slot is written again (or when the hash table is
+ * destroyed).
+ * This suits hash tables that are cleared and refilled many times.
+ * The stamps are kept in an array of their own, allocated only while
+ * generation stamps are enabled.
+ * If generation stamps are already enabled, this function has no effect.
+ *
+ * Worst-case complexity: linear in the capacity `m` of the hash table, `O(m)`.
+ */
+void upo_ht_sepchain_enable_generations(upo_ht_sepchain_t ht);
+
+/**
+ * \brief Changes the policy for organizing the lists of collisions of the
+ *  given hash table.
+ *
+ * \param ht The hash table.
+ * \param policy The new policy.
+ *
+ * The self-organizing policies (move-to-front and transpose) reorder a list
+ * each time one of its keys is found by get, put, get-or-insert or compute
+ * operations, so that frequently accessed keys migrate towards the head of
+ * lists; they suit skewed workloads where few keys are accessed most of the
+ * time.
+ * With the sorted policy, unsuccessful searches stop at the first key greater
+ * than the searched one.
+ * When switching to the sorted policy, the current lists are sorted.
+ *
+ * Worst-case complexity: constant, `O(1)`, or quadratic in the length of the
+ *  longest list when switching to the sorted policy.
+ */
+void upo_ht_sepchain_set_policy(upo_ht_sepchain_t ht, upo_ht_sepchain_policy_t policy);
+
+/**
+ * \brief Returns the policy for organizing the lists of collisions of the
+ *  given hash table.
+ *
+ * \param ht The hash table.
+ * \return The policy.
+ */
+upo_ht_sepchain_policy_t upo_ht_sepchain_get_policy(const upo_ht_sepchain_t ht);
+
+/**
+ * \brief Disables generation stamps for the slots of the given hash table.
+ *
+ * \param ht The hash table.
+ *
+ * The nodes of stale lists of collisions are freed.
+ *
+ * Worst-case complexity: linear in the capacity `m` of the hash table and in
+ *  the number of stale nodes.
+ */
+void upo_ht_sepchain_disable_generations(upo_ht_sepchain_t ht);
+
 
 /*** END of HASH TABLE with SEPARATE CHAINING ***/
 
@@ -309,9 +584,41 @@ upo_ht_hasher_t upo_ht_sepchain_get_hasher(const upo_ht_sepchain_t ht);
 /** \brief Initial capacity of hash tables with linear probing. */
 #define UPO_HT_LINPROB_DEFAULT_CAPACITY 16U
 
+/**
+ * \brief Maximum number of key-value pairs stored by hash tables with linear
+ *  probing in small mode (see upo_ht_linprob_create_small()).
+ */
+#define UPO_HT_LINPROB_SMALL_CAPACITY 8U
+
+/**
+ * \brief Minimum number of key-value pairs for hash tables with linear probing
+ *  to be rehashed in parallel (see upo_ht_linprob_set_rehash_threads()).
+ */
+#define UPO_HT_LINPROB_PARALLEL_REHASH_MIN_SIZE 65536U
+
 /** \brief Type for hash tables with linear probing. */
 typedef struct upo_ht_linprob_s* upo_ht_linprob_t;
 
+/** \brief Storage layouts of hash tables with linear probing. */
+enum upo_ht_linprob_layout_e
+{
+    UPO_HT_LINPROB_LAYOUT_AOS, /**< Array of slots, each one storing a key, a value and a tombstone flag (default). */
+    UPO_HT_LINPROB_LAYOUT_SOA_FP8, /**< Parallel arrays of 8-bit key fingerprints, of keys and of values. */
+    UPO_HT_LINPROB_LAYOUT_SOA_FP16 /**< Parallel arrays of 16-bit key fingerprints, of keys and of values. */
+};
+/** \brief Alias for the type for storage layouts of hash tables with linear probing. */
+typedef enum upo_ht_linprob_layout_e upo_ht_linprob_layout_t;
+
+/** \brief Probe sequences of hash tables with open addressing. */
+enum upo_ht_linprob_probe_e
+{
+    UPO_HT_LINPROB_PROBE_LINEAR, /**< Linear probing: `h, h+1, h+2, ...` (default). */
+    UPO_HT_LINPROB_PROBE_QUADRATIC, /**< Quadratic probing with triangular numbers: `h, h+1, h+3, h+6, ...`. */
+    UPO_HT_LINPROB_PROBE_DOUBLE /**< Double hashing: `h, h+s, h+2s, ...`, where the odd step `s` depends on the key. */
+};
+/** \brief Alias for the type for probe sequences of hash tables with open addressing. */
+typedef enum upo_ht_linprob_probe_e upo_ht_linprob_probe_t;
+
 
 /**
  * \brief Creates a new empty hash table.
@@ -325,6 +632,36 @@ typedef struct upo_ht_linprob_s* upo_ht_linprob_t;
  */
 upo_ht_linprob_t upo_ht_linprob_create(size_t m, upo_ht_hasher_t hasher, upo_ht_comparator_t key_cmp);
 
+/**
+ * \brief Creates a new empty hash table in small mode.
+ *
+ * \param key_hash A pointer to the function used to hash keys.
+ * \param key_cmp A pointer to the function used to compare keys.
+ * \return An empty hash table in small mode.
+ *
+ * In small mode, up to `UPO_HT_LINPROB_SMALL_CAPACITY` key-value pairs are
+ * stored in an array allocated together with the hash table (i.e., with a
+ * single memory allocation), and operations scan it linearly by comparing keys
+ * without hashing them.
+ * When a further key is inserted, the hash table transparently switches to
+ * hashed slots with linear probing, and never goes back to small mode.
+ * This saves memory and construction time for the many tiny hash tables of
+ * nested maps.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+upo_ht_linprob_t upo_ht_linprob_create_small(upo_ht_hasher_t key_hash, upo_ht_comparator_t key_cmp);
+
+/**
+ * \brief Tells if the given hash table is in small mode.
+ *
+ * \param ht The hash table.
+ * \return `1` if the hash table is in small mode, or `0` otherwise.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+int upo_ht_linprob_is_small(const upo_ht_linprob_t ht);
+
 /**
  * \brief Destroys the given hash table.
  *
@@ -339,6 +676,24 @@ upo_ht_linprob_t upo_ht_linprob_create(size_t m, upo_ht_hasher_t hasher, upo_ht_
  */
 void upo_ht_linprob_destroy(upo_ht_linprob_t ht, int destroy_data);
 
+/**
+ * \brief Destroys the given hash table on the background reclaimer thread.
+ *
+ * \param ht The hash table to destroy, which must not be accessed anymore.
+ * \param destroy_data Tells whether the previously allocated memory for data
+ *  stored in the hash table must be freed (value `1`) or not (value `0`).
+ *
+ * The hash table is handed to the reclaimer (see upo/reclaimer.h), which
+ * frees the keys and values of its slots in bounded batches, so that the
+ * caller does not wait for millions of key-value pairs to be freed.
+ * Memory deallocation (if requested) is performed by means of the `free()`
+ * standard C function.
+ *
+ * Worst-case complexity: constant, `O(1)`, for the caller; linear in the
+ *  capacity `m` of the hash table, `O(m)`, for the reclaimer.
+ */
+void upo_ht_linprob_destroy_async(upo_ht_linprob_t ht, int destroy_data);
+
 /**
  * \brief Removes all key-value pairs from the given hash table.
  *
@@ -349,7 +704,9 @@ void upo_ht_linprob_destroy(upo_ht_linprob_t ht, int destroy_data);
  * Memory deallocation (if requested) is performed by means of the `free()`
  * standard C function.
  *
- * Worst-case complexity: linear in the capacity `m` of the hash table, `O(m)`.
+ * Worst-case complexity: linear in the capacity `m` of the hash table, `O(m)`,
+ *  or constant, `O(1)`, if generation stamps are enabled (see
+ *  upo_ht_linprob_enable_generations()) and \a destroy_data is `0`.
  */
 void upo_ht_linprob_clear(upo_ht_linprob_t ht, int destroy_data);
 
@@ -422,10 +779,81 @@ int upo_ht_linprob_contains(const upo_ht_linprob_t ht, const void *key);
  * Memory deallocation (if requested) is performed by means of the `free()`
  * standard C function.
  *
+ * Deleted slots are marked with a tombstone, so that the keys that follow them
+ * can still be found.
+ * When tombstones exceed a quarter of the capacity, the hash table is rehashed
+ * in place (i.e., without allocating a new array of slots) to remove them.
+ *
  * Worst-case complexity: linear in the number `n` of elements, `O(n)`.
  */
 void upo_ht_linprob_delete(upo_ht_linprob_t ht, const void *key, int destroy_data);
 
+/**
+ * \brief Returns a pointer to the value associated to the given key, inserting
+ *  the key if it is not present.
+ *
+ * \param ht The hash table.
+ * \param key The key.
+ * \param value_ptr Set to a pointer to the value associated to \a key, through
+ *  which the value can be read and updated in place.
+ * \return `1` if the key has been inserted (with a `NULL` value), or `0` if
+ *  the key was already present.
+ *
+ * The key is hashed and looked up only once.
+ * The returned pointer is only valid until the next modification of the hash
+ * table, and a newly inserted key should be associated with a non-`NULL` value
+ * through it, since a `NULL` value reads as a missing key.
+ * If the insertion makes the load factor reach `0.5`, the hash table is
+ * resized before storing the key, so that hits never resize it.
+ *
+ * Worst-case complexity: linear in the number `n` of elements, `O(n)`.
+ */
+int upo_ht_linprob_get_or_insert(upo_ht_linprob_t ht, void *key, void ***value_ptr);
+
+/**
+ * \brief Computes the value associated to the given key by means of the given
+ *  update function.
+ *
+ * \param ht The hash table.
+ * \param key The key.
+ * \param update The update function, which is called once with \a key, its
+ *  current value (or `NULL` if the key is not present) and \a update_arg.
+ * \param update_arg An additional parameter to pass to the update function.
+ * \return The value returned by the update function.
+ *
+ * The key is hashed and looked up only once.
+ * If the update function returns `NULL`, the key is removed (if present) or
+ * not inserted; otherwise the returned value is associated to the key (which
+ * is inserted if not present).
+ * No memory is deallocated: the update function can free the current value
+ * when replacing it.
+ *
+ * Worst-case complexity: linear in the number `n` of elements, `O(n)`.
+ */
+void* upo_ht_linprob_compute(upo_ht_linprob_t ht, void *key, upo_ht_updater_t update, void *update_arg);
+
+/**
+ * \brief Removes from the given hash table all the key-value pairs that do not
+ *  satisfy the given predicate.
+ *
+ * \param ht The hash table.
+ * \param pred The predicate, which must not modify the hash table.
+ * \param pred_arg An additional parameter to pass to the predicate.
+ * \param destroy_data Tells whether the previously allocated memory for data,
+ *  that is to be removed, must be freed (value `1`) or not (value `0`).
+ * \return The number of removed key-value pairs.
+ *
+ * The slots are swept once, calling the predicate on each key-value pair.
+ * Memory deallocation (if requested) is performed by means of the `free()`
+ * standard C function.
+ * Removed key-value pairs leave tombstones, and the hash table is then shrunk
+ * or purged (see upo_ht_linprob_delete()) at most once, at the end of the
+ * sweep.
+ *
+ * Worst-case complexity: linear in the capacity `m` of the hash table, `O(m)`.
+ */
+size_t upo_ht_linprob_retain(upo_ht_linprob_t ht, upo_ht_predicate_t pred, void *pred_arg, int destroy_data);
+
 /**
  * \brief Tells if the given hash table is empty.
  *
@@ -490,6 +918,56 @@ upo_ht_key_list_t upo_ht_linprob_keys(const upo_ht_linprob_t ht);
  */
 void upo_ht_linprob_traverse(const upo_ht_linprob_t ht, upo_ht_visitor_t visit, void *visit_arg);
 
+/**
+ * \brief Visits a few slots of the hash table, resuming the scan from the
+ *  given cursor.
+ *
+ * \param ht The hash table to scan.
+ * \param cursor The cursor returned by the previous call, or `0` to start a
+ *  new scan.
+ * \param count The number of slots to visit (at least one slot is visited).
+ * \param visit The function to call on each key-value pair found.
+ * \param visit_arg An additional parameter to pass to the visit function.
+ * \return The cursor to pass to the next call, or `0` if the scan is over.
+ *
+ * Like the SCAN command of Redis, slots are visited in reverse binary order
+ * (i.e., by incrementing the cursor from its most significant bit), and each
+ * step visits the key-value pairs whose home slot is the current one.
+ * Since doubling or halving a table whose capacity is a power of two only
+ * changes the most significant bit of home slots, the slots already visited
+ * before a resize are exactly the ones skipped after it.
+ * Therefore, the key-value pairs may be updated between two calls (but not
+ * by the visit function) and every key stored from the beginning to the end
+ * of the scan is visited at least once, even if the hash table is resized
+ * or its tombstones are purged in between, provided that:
+ * - the capacity is a power of two (as it is with quadratic and double
+ *   probing, or when the hash table has been created with a power of two);
+ * - the hash function is consistent across capacities, that is the home slot
+ *   of a key for capacity `m` is the remainder modulo `m` of its home slot for
+ *   capacity `2m` (as it is for upo_ht_hash_int_div() and the string hash
+ *   functions, but not for the multiplication method).
+ * A key may be visited more than once if the hash table is resized, and keys
+ * stored or removed during the scan may or may not be visited.
+ * While the hash table is small enough to be scanned without hashing (see
+ * upo_ht_linprob_create_small()), or if its probe sequence is double hashing
+ * (which does not let keys be enumerated by home slot), the first call visits
+ * all its key-value pairs and ends the scan.
+ *
+ * To find the keys of a home slot, each step examines the slots of its probe
+ * sequence up to the first empty one, but no more than `p + 1` of them, where
+ * `p` is the largest distance (in probes) from its home slot at which a key
+ * has been stored since the slots were last rebuilt (by a resize or a purge
+ * of tombstones); the key in each examined slot is hashed.
+ *
+ * Worst-case complexity: linear in the number `count` of visited slots times
+ *  the largest distance `p`, `O(count*(p+1))`, or linear in the number `m`
+ *  of slots with double hashing, `O(m)`.
+ * Average-case complexity: linear in the number `count` of visited slots,
+ *  `O(count)`, since the load factor is bounded and so is the expected
+ *  length of the run of occupied slots that follows a slot.
+ */
+size_t upo_ht_linprob_scan(const upo_ht_linprob_t ht, size_t cursor, size_t count, upo_ht_visitor_t visit, void *visit_arg);
+
 /**
  * \brief Returns the key comparator function.
  *
@@ -506,13 +984,328 @@ upo_ht_comparator_t upo_ht_linprob_get_comparator(const upo_ht_linprob_t ht);
  */
 upo_ht_hasher_t upo_ht_linprob_get_hasher(const upo_ht_linprob_t ht);
 
+/**
+ * \brief Changes the storage layout of the given hash table.
+ *
+ * \param ht The hash table.
+ * \param layout The new storage layout.
+ *
+ * With the structure-of-arrays layouts, each slot is split into a small key
+ * fingerprint (computed by upo_ht_hash_wide()), a key and a value stored in
+ * three parallel arrays.
+ * Probe sequences are scanned in the dense array of fingerprints, and keys are
+ * compared only when their fingerprint matches the one of the searched key
+ * (with 8-bit fingerprints, a mismatching key passes this filter with a
+ * probability of about 1/253).
+ * The price is one more call to the key hash function per operation.
+ *
+ * Stored key-value pairs are kept in their slots, so the hash table can be
+ * converted at any time.
+ * Hash tables in small mode switch to hashed slots before changing to a
+ * structure-of-arrays layout.
+ *
+ * Worst-case complexity: linear in the capacity `m` of the hash table, `O(m)`.
+ */
+void upo_ht_linprob_set_layout(upo_ht_linprob_t ht, upo_ht_linprob_layout_t layout);
+
+/**
+ * \brief Returns the storage layout of the given hash table.
+ *
+ * \param ht The hash table.
+ * \return The storage layout.
+ */
+upo_ht_linprob_layout_t upo_ht_linprob_get_layout(const upo_ht_linprob_t ht);
+
+/**
+ * \brief Changes the probe sequence of the given hash table.
+ *
+ * \param ht The hash table.
+ * \param probe The new probe sequence.
+ *
+ * The probe sequence is meant to be chosen right after the creation of the
+ * hash table, but stored key-value pairs are rehashed if needed.
+ * Linear probing suffers from primary clustering: keys whose home slots are
+ * close (e.g., clustered integer keys hashed by division) end up in long runs
+ * of occupied slots.
+ * Quadratic probing avoids primary clustering, and double hashing also avoids
+ * secondary clustering (i.e., keys with the same home slot follow different
+ * probe sequences) at the price of one more call to the key hash function per
+ * operation (see upo_ht_hash_wide()).
+ * Both visit every slot only if the capacity is a power of two, so the
+ * capacity of the hash table is rounded up to a power of two.
+ * Insertion, search and removal keep the same semantics with every probe
+ * sequence.
+ * Hash tables in small mode keep scanning their slots linearly and use the
+ * given probe sequence once they switch to hashed slots.
+ *
+ * Worst-case complexity: linear in the capacity `m` of the hash table, `O(m)`.
+ */
+void upo_ht_linprob_set_probe(upo_ht_linprob_t ht, upo_ht_linprob_probe_t probe);
+
+/**
+ * \brief Returns the probe sequence of the given hash table.
+ *
+ * \param ht The hash table.
+ * \return The probe sequence.
+ */
+upo_ht_linprob_probe_t upo_ht_linprob_get_probe(const upo_ht_linprob_t ht);
+
+/**
+ * \brief Sets the number of threads that rehash the keys of the given hash
+ *  table when it is resized.
+ *
+ * \param ht The hash table.
+ * \param n The number of threads (`1`, the default, rehashes keys on the
+ *  calling thread only).
+ *
+ * Hash tables holding at least UPO_HT_LINPROB_PARALLEL_REHASH_MIN_SIZE
+ * key-value pairs are resized by `n` threads (the calling one included).
+ * Each thread hashes the keys of a chunk of the old slots, then the keys are
+ * partitioned by the region of the new slots their home slot falls in, and
+ * each thread inserts the keys of one region, claiming only slots of its own
+ * region; the few keys whose probe sequence leaves their region are inserted
+ * by the calling thread at the end.
+ * No synchronization is needed besides waiting for the threads of each
+ * phase, but the key hash function must be safe to call from several threads
+ * at once.
+ * If threads cannot be created, their work is done by the calling thread.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+void upo_ht_linprob_set_rehash_threads(upo_ht_linprob_t ht, size_t n);
+
+/**
+ * \brief Returns the number of threads that rehash the keys of the given
+ *  hash table when it is resized.
+ *
+ * \param ht The hash table.
+ * \return The number of threads, or `1` if the hash table is `NULL`.
+ */
+size_t upo_ht_linprob_get_rehash_threads(const upo_ht_linprob_t ht);
+
+/**
+ * \brief Enables generation stamps for the slots of the given hash table.
+ *
+ * \param ht The hash table.
+ *
+ * Each slot is stamped with the generation in which it has been last written,
+ * and slots stamped with a past generation are read as empty.
+ * This way, upo_ht_linprob_clear() with `destroy_data` equal to `0` only
+ * advances the current generation.
+ * This suits hash tables that are cleared and refilled many times.
+ * If generation stamps are already enabled, this function has no effect.
+ *
+ * Worst-case complexity: linear in the capacity `m` of the hash table, `O(m)`.
+ */
+void upo_ht_linprob_enable_generations(upo_ht_linprob_t ht);
+
+/**
+ * \brief Disables generation stamps for the slots of the given hash table.
+ *
+ * \param ht The hash table.
+ *
+ * Worst-case complexity: linear in the capacity `m` of the hash table, `O(m)`.
+ */
+void upo_ht_linprob_disable_generations(upo_ht_linprob_t ht);
+
 
 /*** END of HASH TABLE with OPEN ADDRESSING ***/
 
 
+/*** BEGIN of HASH TABLE STATISTICS ***/
+
+
+/**
+ * \brief Starts collecting operation counters for the given hash table.
+ *
+ * \param ht The hash table.
+ *
+ * Counters start from zero.
+ * If statistics are already enabled, this function has no effect.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+void upo_ht_sepchain_enable_stats(upo_ht_sepchain_t ht);
+
+/**
+ * \brief Stops collecting operation counters for the given hash table and
+ *  discards the collected ones.
+ *
+ * \param ht The hash table.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+void upo_ht_sepchain_disable_stats(upo_ht_sepchain_t ht);
+
+/**
+ * \brief Takes a snapshot of the statistics of the given hash table.
+ *
+ * \param ht The hash table.
+ * \param stats The snapshot to fill.\n[output]
+ *
+ * The chain-length distribution is stored in the `histogram` field and the
+ * length of the longest list of collisions in the `longest_cluster` field.
+ * Separate chaining never resizes, thus the resize counters stay at zero.
+ *
+ * Worst-case complexity: linear in the capacity `m` and in the number `n` of
+ *  elements of the hash table, `O(m+n)`.
+ */
+void upo_ht_sepchain_stats(const upo_ht_sepchain_t ht, upo_ht_stats_t *stats);
+
+/**
+ * \brief Starts collecting operation counters for the given hash table.
+ *
+ * \param ht The hash table.
+ *
+ * Counters start from zero.
+ * If statistics are already enabled, this function has no effect.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+void upo_ht_linprob_enable_stats(upo_ht_linprob_t ht);
+
+/**
+ * \brief Stops collecting operation counters for the given hash table and
+ *  discards the collected ones.
+ *
+ * \param ht The hash table.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+void upo_ht_linprob_disable_stats(upo_ht_linprob_t ht);
+
+/**
+ * \brief Takes a snapshot of the statistics of the given hash table.
+ *
+ * \param ht The hash table.
+ * \param stats The snapshot to fill.\n[output]
+ *
+ * The probe-length distribution is stored in the `histogram` field and the
+ * length of the longest run of consecutive non-empty slots (i.e., occupied or
+ * marked as deleted) in the `longest_cluster` field.
+ * Computing the probe lengths calls the key hash function once per stored key;
+ * these calls are not added to the counters.
+ *
+ * Worst-case complexity: linear in the capacity `m` of the hash table, `O(m)`.
+ */
+void upo_ht_linprob_stats(const upo_ht_linprob_t ht, upo_ht_stats_t *stats);
+
+/**
+ * \brief Prints the given snapshot of hash table statistics.
+ *
+ * \param stats The snapshot to print.
+ * \param stream The output stream.
+ */
+void upo_ht_stats_print(const upo_ht_stats_t *stats, FILE *stream);
+
+
+/*** END of HASH TABLE STATISTICS ***/
+
+
+/*** BEGIN of HASH TABLE MEMORY BUDGET ***/
+
+
+/**
+ * \brief Sets the memory budget of the given hash table.
+ *
+ * \param ht The hash table.
+ * \param budget The memory budget (which is copied), or `NULL` to remove it.
+ *
+ * Once a budget is set, storing a new key never allocates a node beyond it:
+ * key-value pairs are evicted first (see upo_ht_budget_t).
+ * If the new key alone does not fit, it is stored anyway after evicting all
+ * other pairs.
+ * Replacing a value whose data is larger only evicts other pairs.
+ * Values written through the pointer returned by
+ * upo_ht_sepchain_get_or_insert() are sized as `NULL` when stored, so the
+ * sizing function must not depend on them.
+ * Nodes of past generations (see upo_ht_sepchain_enable_generations()) are
+ * not accounted.
+ * If the hash table is already beyond the new budget, pairs are evicted
+ * immediately.
+ *
+ * Worst-case complexity: linear in the capacity `m` and in the number `n` of
+ *  elements of the hash table, `O(m+n)`.
+ */
+void upo_ht_sepchain_set_budget(upo_ht_sepchain_t ht, const upo_ht_budget_t *budget);
+
+/**
+ * \brief Returns the memory accounted for the given hash table.
+ *
+ * \param ht The hash table.
+ * \return The number of bytes of the hash table type, of its slots and of its
+ *  nodes, plus the bytes of data reported by the sizing function of the
+ *  memory budget (if any).
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+size_t upo_ht_sepchain_memory(const upo_ht_sepchain_t ht);
+
+/**
+ * \brief Sets the memory budget of the given hash table.
+ *
+ * \param ht The hash table.
+ * \param budget The memory budget (which is copied), or `NULL` to remove it.
+ *
+ * Once a budget is set, storing a new key never makes the hash table grow
+ * beyond it: key-value pairs are evicted first (see upo_ht_budget_t), until
+ * the new key fits in the current slots.
+ * If the new key alone does not fit, it is stored anyway after evicting all
+ * other pairs.
+ * Replacing a value whose data is larger only evicts other pairs.
+ * Values written through the pointer returned by
+ * upo_ht_linprob_get_or_insert() are sized as `NULL` when stored, so the
+ * sizing function must not depend on them.
+ * Changing the storage layout or enabling generation stamps may take the hash
+ * table beyond its budget until the next key is stored.
+ * If the hash table is already beyond the new budget, pairs are evicted
+ * immediately.
+ *
+ * Worst-case complexity: linear in the capacity `m` of the hash table, `O(m)`.
+ */
+void upo_ht_linprob_set_budget(upo_ht_linprob_t ht, const upo_ht_budget_t *budget);
+
+/**
+ * \brief Returns the memory accounted for the given hash table.
+ *
+ * \param ht The hash table.
+ * \return The number of bytes of the hash table type and of its slots, plus
+ *  the bytes of data reported by the sizing function of the memory budget (if
+ *  any).
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+size_t upo_ht_linprob_memory(const upo_ht_linprob_t ht);
+
+
+/*** END of HASH TABLE MEMORY BUDGET ***/
+
+
 /*** BEGIN of HASH FUNCTIONS ***/
 
 
+/**
+ * \brief The number of possible hash values requested to hash functions by
+ *  upo_ht_hash_wide() (the largest prime less than \f$2^{32}\f$).
+ */
+#define UPO_HT_HASH_WIDE_RANGE 4294967291U
+
+/**
+ * \brief Computes a 64-bit hash value of the given key by means of the given
+ *  hash function.
+ *
+ * \param key_hash The hash function.
+ * \param key The key to hash.
+ * \return The 64-bit hash value.
+ *
+ * The hash function is called with `UPO_HT_HASH_WIDE_RANGE` possible hash
+ * values, and the result is scrambled with the 64-bit finalizer of MurmurHash3
+ * so that every bit of the returned value depends on every bit of the result.
+ * This makes it suitable for deriving fingerprints and other values that must
+ * not be correlated with the position of the key in a hash table.
+ */
+uint64_t upo_ht_hash_wide(upo_ht_hasher_t key_hash, const void *key);
+
 /**
  * \brief Hash function for integers that uses the division method.
  *
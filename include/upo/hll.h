@@ -0,0 +1,233 @@
+/**
+ * \file upo/hll.h
+ *
+ * \brief The HyperLogLog abstract data type.
+ *
+ * HyperLogLogs (as described by Flajolet et al.) estimate the number of
+ * distinct keys of a stream using a few kilobytes of memory, with a relative
+ * standard error of about \f$1.04/\sqrt{m}\f$ for \f$m = 2^p\f$ registers,
+ * where \f$p\f$ is the precision.
+ * Each key is hashed to 64 bits (by means of upo_ht_hash_wide(), or by the
+ * caller): the first \f$p\f$ bits select a register, which keeps the largest
+ * position of the first 1 bit seen in the remaining bits.
+ * Keys hashed by means of upo_ht_hash_wide() take at most \f$2^{32}\f$
+ * distinct hash values (the range of the key hash function), so estimates
+ * drift below the true cardinality as it approaches that number (by about
+ * 11% at \f$10^9\f$ keys); callers counting billions of keys should compute
+ * a full 64-bit hash themselves and pass it to upo_hll_add_hash(), for which
+ * no correction for hash collisions is needed.
+ *
+ * The cardinality is computed by the estimator of Ertl ("New cardinality
+ * estimation algorithms for HyperLogLog sketches", 2017) from the histogram
+ * of register values, which is accurate over the whole range of cardinalities
+ * without empirical bias tables.
+ *
+ * Like HyperLogLog++ (as described by Heule et al.), a HyperLogLog starts
+ * with a sparse encoding, a sorted array of the nonzero registers, and
+ * switches to the dense encoding, an array of \f$m\f$ registers of one byte
+ * each, once the sparse array would take as much memory as the dense one.
+ * Small cardinalities thus need little memory.
+ *
+ * HyperLogLogs with the same precision can be merged, taking the maximum of
+ * each register; for dense ones, the registers are compared 32 (with AVX2) or
+ * 16 (with SSE2) at a time by vector instructions, or one at a time by a
+ * portable loop otherwise.
+ * Serialized HyperLogLogs keep their encoding, with dense registers packed in
+ * 6 bits each.
+ *
+ * \copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ *  This file is part of UPOalglib.
+ *
+ *  UPOalglib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  UPOalglib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UPO_HLL_H
+#define UPO_HLL_H
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <upo/hashtable.h>
+
+
+/** \brief Minimum precision (number of bits selecting a register). */
+#define UPO_HLL_MIN_PRECISION 4U
+
+/** \brief Maximum precision (number of bits selecting a register). */
+#define UPO_HLL_MAX_PRECISION 18U
+
+/** \brief Type for HyperLogLogs. */
+typedef struct upo_hll_s* upo_hll_t;
+
+
+/**
+ * \brief Creates a new empty HyperLogLog.
+ *
+ * \param precision The number \f$p\f$ of bits of hash values selecting a
+ *  register, between UPO_HLL_MIN_PRECISION and UPO_HLL_MAX_PRECISION.
+ * \param key_hash A pointer to the function used to hash keys, or `NULL` if
+ *  only upo_hll_add_hash() is used.
+ * \return An empty HyperLogLog, with the sparse encoding.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+upo_hll_t upo_hll_create(unsigned precision, upo_ht_hasher_t key_hash);
+
+/**
+ * \brief Destroys the given HyperLogLog.
+ *
+ * \param hll The HyperLogLog to destroy.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+void upo_hll_destroy(upo_hll_t hll);
+
+/**
+ * \brief Removes all keys from the given HyperLogLog.
+ *
+ * \param hll The HyperLogLog.
+ *
+ * The HyperLogLog goes back to the sparse encoding.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+void upo_hll_clear(upo_hll_t hll);
+
+/**
+ * \brief Adds the given key to the given HyperLogLog.
+ *
+ * \param hll The HyperLogLog, which must have a key hash function.
+ * \param key The key.
+ *
+ * The key is hashed by means of upo_ht_hash_wide(), so at most \f$2^{32}\f$
+ * distinct keys can be told apart; see upo_hll_add_hash() for larger
+ * cardinalities.
+ *
+ * Worst-case complexity: constant, `O(1)`, with the dense encoding; linear in
+ *  the number of nonzero registers with the sparse encoding.
+ */
+void upo_hll_add(upo_hll_t hll, const void *key);
+
+/**
+ * \brief Adds a key with the given 64-bit hash value to the given
+ *  HyperLogLog.
+ *
+ * \param hll The HyperLogLog.
+ * \param hash The hash value of the key, whose bits must be uniformly
+ *  distributed.
+ *
+ * Worst-case complexity: constant, `O(1)`, with the dense encoding; linear in
+ *  the number of nonzero registers with the sparse encoding.
+ */
+void upo_hll_add_hash(upo_hll_t hll, uint64_t hash);
+
+/**
+ * \brief Returns the estimated number of distinct keys added to the given
+ *  HyperLogLog.
+ *
+ * \param hll The HyperLogLog.
+ * \return The estimated cardinality, or `0` if the HyperLogLog is `NULL`.
+ *
+ * Worst-case complexity: linear in the number \f$m\f$ of registers.
+ */
+double upo_hll_estimate(const upo_hll_t hll);
+
+/**
+ * \brief Adds the keys of a HyperLogLog to another one.
+ *
+ * \param hll The HyperLogLog to update.
+ * \param other The HyperLogLog whose keys are added.
+ * \return `1` if the HyperLogLogs have been merged, or `0` if they have
+ *  different precisions or key hash functions.
+ *
+ * The merged HyperLogLog estimates the cardinality of the union of the sets
+ * of keys; it switches to the dense encoding if `other` is dense or if the
+ * nonzero registers no longer fit in the sparse encoding.
+ *
+ * Worst-case complexity: linear in the number \f$m\f$ of registers.
+ */
+int upo_hll_merge(upo_hll_t hll, const upo_hll_t other);
+
+/**
+ * \brief Returns the number of bytes needed to serialize the given
+ *  HyperLogLog.
+ *
+ * \param hll The HyperLogLog.
+ * \return The number of bytes written by upo_hll_serialize().
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+size_t upo_hll_serialized_size(const upo_hll_t hll);
+
+/**
+ * \brief Serializes the given HyperLogLog.
+ *
+ * \param hll The HyperLogLog.
+ * \param buf The buffer, of at least upo_hll_serialized_size() bytes.
+ *
+ * The serialized form (a header followed by the sparse entries or by the
+ * packed registers, in little-endian byte order) does not depend on the
+ * platform; the key hash function is not serialized.
+ *
+ * Worst-case complexity: linear in the number \f$m\f$ of registers.
+ */
+void upo_hll_serialize(const upo_hll_t hll, void *buf);
+
+/**
+ * \brief Creates a HyperLogLog from its serialized form.
+ *
+ * \param buf The buffer written by upo_hll_serialize().
+ * \param size The number of bytes of the buffer.
+ * \param key_hash A pointer to the function used to hash keys, which must be
+ *  the one of the serialized HyperLogLog, or `NULL`.
+ * \return The HyperLogLog, or `NULL` if the buffer does not hold a serialized
+ *  HyperLogLog of the given size.
+ *
+ * Worst-case complexity: linear in the number \f$m\f$ of registers.
+ */
+upo_hll_t upo_hll_deserialize(const void *buf, size_t size, upo_ht_hasher_t key_hash);
+
+/**
+ * \brief Tells if the given HyperLogLog uses the sparse encoding.
+ *
+ * \param hll The HyperLogLog.
+ * \return `1` if the registers are stored as a sorted array of the nonzero
+ *  ones, or `0` if they are stored as a dense array.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+int upo_hll_is_sparse(const upo_hll_t hll);
+
+/**
+ * \brief Returns the precision of the given HyperLogLog.
+ *
+ * \param hll The HyperLogLog.
+ * \return The number of bits selecting a register, or `0` if the HyperLogLog
+ *  is `NULL`.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+unsigned upo_hll_precision(const upo_hll_t hll);
+
+/**
+ * \brief Returns the key hasher function.
+ *
+ * \param hll The HyperLogLog.
+ * \return The key hasher function, or `NULL`.
+ */
+upo_ht_hasher_t upo_hll_get_hasher(const upo_hll_t hll);
+
+
+#endif /* UPO_HLL_H */
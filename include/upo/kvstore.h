@@ -0,0 +1,265 @@
+/**
+ * \file upo/kvstore.h
+ *
+ * \brief The Key-Value Store abstract data type.
+ *
+ * Key-Value Stores are persistent maps from byte strings to byte strings,
+ * kept in a single log file.
+ * Each update appends a record to the log (a key with its value, or a
+ * tombstone for removed keys), protected by a CRC-32 checksum, and an
+ * in-memory hash table with linear probing (see upo/hashtable.h) maps each
+ * key to the offset of its last record, so that a lookup reads exactly one
+ * record from the file.
+ *
+ * Opening a store replays its log to rebuild the index: a record that is
+ * incomplete or whose checksum does not match marks the end of the log (it
+ * is what a crash in the middle of an append leaves), and the log is
+ * truncated there.
+ * Records are durable once the log is synced: in synchronous mode, each
+ * update waits for a sync of the log, and concurrent updates share a single
+ * `fsync()` (group commit).
+ * Compaction rewrites the live records into a new log, which atomically
+ * replaces the old one; it can run on a background thread while the store is
+ * being used, since the store is locked only to copy the records appended in
+ * the meantime and to switch logs.
+ *
+ * All operations may be called from several threads at once.
+ * Input/output errors are reported by means of upo_throw_sys_error().
+ *
+ * \copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ *  This file is part of UPOalglib.
+ *
+ *  UPOalglib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  UPOalglib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UPO_KVSTORE_H
+#define UPO_KVSTORE_H
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+/** \brief Maximum number of bytes of keys and values. */
+#define UPO_KVSTORE_MAX_SIZE 0xFFFFFFFEU
+
+/** \brief Type for key-value stores. */
+typedef struct upo_kvstore_s* upo_kvstore_t;
+
+
+/**
+ * \brief Opens the key-value store kept in the given log file.
+ *
+ * \param path The path of the log file, which is created if it does not
+ *  exist.
+ * \return The key-value store, whose index holds the last value of each key
+ *  stored in the valid records of the log.
+ *
+ * A leftover of a compaction interrupted by a crash (the file `path`
+ * followed by `.compact`) is removed.
+ *
+ * Worst-case complexity: linear in the size of the log.
+ */
+upo_kvstore_t upo_kvstore_open(const char *path);
+
+/**
+ * \brief Syncs and closes the given key-value store.
+ *
+ * \param store The key-value store.
+ *
+ * A running background compaction is waited for.
+ *
+ * Worst-case complexity: linear in the number `n` of keys, `O(n)`.
+ */
+void upo_kvstore_close(upo_kvstore_t store);
+
+/**
+ * \brief Stores a copy of the given key-value pair into the given key-value
+ *  store.
+ *
+ * \param store The key-value store.
+ * \param key The bytes of the key.
+ * \param key_size The number of bytes of the key (at most
+ *  UPO_KVSTORE_MAX_SIZE).
+ * \param value The bytes of the value.
+ * \param value_size The number of bytes of the value (at most
+ *  UPO_KVSTORE_MAX_SIZE).
+ *
+ * If the key is already present, its value is replaced.
+ * In synchronous mode, the function returns once the record is durable.
+ *
+ * Average-case complexity: linear in the size of the key and of the value.
+ */
+void upo_kvstore_put(upo_kvstore_t store, const void *key, size_t key_size, const void *value, size_t value_size);
+
+/**
+ * \brief Copies the value associated to the given key.
+ *
+ * \param store The key-value store.
+ * \param key The bytes of the key.
+ * \param key_size The number of bytes of the key.
+ * \param value The buffer where to copy the value, or `NULL`.
+ * \param value_size On input, the size of the buffer; on output (if the key
+ *  is found), the size of the value, which is copied only up to the size of
+ *  the buffer.
+ *  May be `NULL` if `value` is `NULL`.
+ * \return `1` if the key is found, or `0` otherwise.
+ *
+ * Average-case complexity: linear in the size of the key and of the value.
+ */
+int upo_kvstore_get(const upo_kvstore_t store, const void *key, size_t key_size, void *value, size_t *value_size);
+
+/**
+ * \brief Tells if the given key-value store contains the given key.
+ *
+ * \param store The key-value store.
+ * \param key The bytes of the key.
+ * \param key_size The number of bytes of the key.
+ * \return `1` if the key is found, or `0` otherwise.
+ *
+ * The log is not read.
+ *
+ * Average-case complexity: linear in the size of the key.
+ */
+int upo_kvstore_contains(const upo_kvstore_t store, const void *key, size_t key_size);
+
+/**
+ * \brief Removes the given key from the given key-value store.
+ *
+ * \param store The key-value store.
+ * \param key The bytes of the key.
+ * \param key_size The number of bytes of the key.
+ * \return `1` if the key has been removed, or `0` if it was not found (in
+ *  which case nothing is appended to the log).
+ *
+ * In synchronous mode, the function returns once the removal is durable.
+ *
+ * Average-case complexity: linear in the size of the key.
+ */
+int upo_kvstore_delete(upo_kvstore_t store, const void *key, size_t key_size);
+
+/**
+ * \brief Makes all the records appended to the log of the given key-value
+ *  store durable.
+ *
+ * \param store The key-value store.
+ *
+ * If another thread is already syncing the log, the function waits for it
+ * and syncs again only if that sync did not cover every record appended
+ * before the call.
+ */
+void upo_kvstore_sync(upo_kvstore_t store);
+
+/**
+ * \brief Sets whether updates of the given key-value store wait for their
+ *  records to be durable.
+ *
+ * \param store The key-value store.
+ * \param sync `1` to make each update call upo_kvstore_sync() (the default
+ *  is `0`, where records are durable only after an explicit sync or after
+ *  closing the store).
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+void upo_kvstore_set_sync(upo_kvstore_t store, int sync);
+
+/**
+ * \brief Returns the number of times the log of the given key-value store
+ *  has been synced.
+ *
+ * \param store The key-value store.
+ * \return The number of calls to `fsync()` since the store was opened, or
+ *  `0` if the store is `NULL`.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+size_t upo_kvstore_syncs(const upo_kvstore_t store);
+
+/**
+ * \brief Rewrites the log of the given key-value store keeping only the
+ *  records of the current values.
+ *
+ * \param store The key-value store.
+ * \return `1` if the log has been compacted, or `0` if another compaction
+ *  was running.
+ *
+ * The live records are copied into a new log without locking the store; the
+ * store is then locked to copy the records appended in the meantime, to sync
+ * the new log and to rename it over the old one.
+ *
+ * Worst-case complexity: linear in the size of the log and in the number
+ *  `n` of keys.
+ */
+int upo_kvstore_compact(upo_kvstore_t store);
+
+/**
+ * \brief Starts compacting the log of the given key-value store on a
+ *  background thread.
+ *
+ * \param store The key-value store.
+ * \return `1` if the compaction has been started, or `0` if another
+ *  compaction was running (or the thread could not be created).
+ *
+ * The store can be used while the compaction runs (see
+ * upo_kvstore_compact()).
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+int upo_kvstore_compact_async(upo_kvstore_t store);
+
+/**
+ * \brief Returns the size of the given key-value store.
+ *
+ * \param store The key-value store.
+ * \return The number of stored keys, or `0` if the store is `NULL`.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+size_t upo_kvstore_size(const upo_kvstore_t store);
+
+/**
+ * \brief Tells if the given key-value store is empty.
+ *
+ * \param store The key-value store.
+ * \return `1` if the store is empty or `NULL`, or `0` otherwise.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+int upo_kvstore_is_empty(const upo_kvstore_t store);
+
+/**
+ * \brief Returns the size of the log of the given key-value store.
+ *
+ * \param store The key-value store.
+ * \return The number of bytes of the log, or `0` if the store is `NULL`.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+uint64_t upo_kvstore_log_size(const upo_kvstore_t store);
+
+/**
+ * \brief Returns the number of bytes of the log of the given key-value store
+ *  that hold the records of the current values.
+ *
+ * \param store The key-value store.
+ * \return The number of bytes that a compaction would keep, or `0` if the
+ *  store is `NULL`.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+uint64_t upo_kvstore_live_size(const upo_kvstore_t store);
+
+
+#endif /* UPO_KVSTORE_H */
@@ -0,0 +1,291 @@
+/**
+ * \file upo/lru.h
+ *
+ * \brief The Least Recently Used (LRU) cache abstract data type.
+ *
+ * LRU caches are hash tables (see upo/hashtable.h) with a fixed capacity: when
+ * a new key is stored in a full cache, the key-value pair that has been used
+ * least recently is evicted to make room for it.
+ * They are implemented as hash tables with separate chaining whose nodes also
+ * embed the links of a doubly-linked list ordered by recency of use, so that
+ * each key-value pair needs no further allocation nor indirection.
+ * All nodes are allocated at once on creation, and evicted nodes are reused.
+ *
+ * \copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ *  This file is part of UPOalglib.
+ *
+ *  UPOalglib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  UPOalglib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UPO_LRU_H
+#define UPO_LRU_H
+
+
+#include <stddef.h>
+#include <upo/hashtable.h>
+
+
+/** \brief Type for LRU caches. */
+typedef struct upo_lru_s* upo_lru_t;
+
+/**
+ * \brief The type for eviction functions.
+ *
+ * Declares the type for functions that are called on each key-value pair
+ * evicted from an LRU cache.
+ * An eviction function takes three parameters:
+ * - The first parameter is a pointer to the user-provided key being evicted.
+ * - The second parameter is a pointer to the value associated to the key.
+ * - The third parameter is a pointer to data that is used by the eviction
+ *   function to perform its operation.
+ * The key and the value are freed (if requested) after the call.
+ */
+typedef void (*upo_lru_evictor_t)(void*, void*, void*);
+
+
+/**
+ * \brief Creates a new empty LRU cache.
+ *
+ * \param capacity The maximum number of key-value pairs of the LRU cache
+ *  (must be greater than zero).
+ * \param key_hash A pointer to the function used to hash keys.
+ * \param key_cmp A pointer to the function used to compare keys.
+ * \return An empty LRU cache.
+ *
+ * Worst-case complexity: linear in the capacity `m` of the LRU cache, `O(m)`.
+ */
+upo_lru_t upo_lru_create(size_t capacity, upo_ht_hasher_t key_hash, upo_ht_comparator_t key_cmp);
+
+/**
+ * \brief Destroys the given LRU cache.
+ *
+ * \param lru The LRU cache to destroy.
+ * \param destroy_data Tells whether the previously allocated memory for data,
+ *  that is both keys and values, stored in the LRU cache must be freed
+ *  (value `1`) or not (value `0`).
+ *
+ * The eviction function is not called.
+ * Memory deallocation (if requested) is performed by means of the `free()`
+ * standard C function.
+ *
+ * Worst-case complexity: linear in the capacity `m` of the LRU cache, `O(m)`.
+ */
+void upo_lru_destroy(upo_lru_t lru, int destroy_data);
+
+/**
+ * \brief Removes all key-value pairs from the given LRU cache.
+ *
+ * \param lru The LRU cache to clear.
+ * \param destroy_data Tells whether the previously allocated memory for data,
+ *  that is both keys and values, stored in the LRU cache must be freed
+ *  (value `1`) or not (value `0`).
+ *
+ * The eviction function is not called.
+ * Memory deallocation (if requested) is performed by means of the `free()`
+ * standard C function.
+ *
+ * Worst-case complexity: linear in the capacity `m` of the LRU cache, `O(m)`.
+ */
+void upo_lru_clear(upo_lru_t lru, int destroy_data);
+
+/**
+ * \brief Stores the given key-value pair into the given LRU cache, and marks
+ *  the key as the most recently used one.
+ *
+ * \param lru The LRU cache.
+ * \param key The key.
+ * \param value The value.
+ * \param destroy_data Tells whether the previously allocated memory for data,
+ *  that is both the key and the value, of the evicted key-value pair (if any)
+ *  must be freed (value `1`) or not (value `0`).
+ * \return The value previously associated to the given key, or `NULL` if the
+ *  key was not present.
+ *
+ * If the key is already present, its value is replaced (and the old value is
+ * returned rather than freed).
+ * Otherwise, if the LRU cache is full, its least recently used key-value pair
+ * is first evicted as by upo_lru_evict().
+ *
+ * Average-case complexity: constant, `O(1)`.
+ */
+void* upo_lru_put(upo_lru_t lru, void *key, void *value, int destroy_data);
+
+/**
+ * \brief Returns the value associated to the given key, and marks the key as
+ *  the most recently used one.
+ *
+ * \param lru The LRU cache.
+ * \param key The key.
+ * \return The value associated to the key, or `NULL` if the key is not found.
+ *
+ * Average-case complexity: constant, `O(1)`.
+ */
+void* upo_lru_get(upo_lru_t lru, const void *key);
+
+/**
+ * \brief Returns the value associated to the given key, without changing the
+ *  recency of use of keys.
+ *
+ * \param lru The LRU cache.
+ * \param key The key.
+ * \return The value associated to the key, or `NULL` if the key is not found.
+ *
+ * Average-case complexity: constant, `O(1)`.
+ */
+void* upo_lru_peek(const upo_lru_t lru, const void *key);
+
+/**
+ * \brief Tells if the given LRU cache contains the given key, without
+ *  changing the recency of use of keys.
+ *
+ * \param lru The LRU cache.
+ * \param key The key.
+ * \return `1` if the LRU cache contains the given key, or `0` otherwise.
+ *
+ * Average-case complexity: constant, `O(1)`.
+ */
+int upo_lru_contains(const upo_lru_t lru, const void *key);
+
+/**
+ * \brief Removes the given key from the given LRU cache.
+ *
+ * \param lru The LRU cache.
+ * \param key The key.
+ * \param destroy_data Tells whether the previously allocated memory for data,
+ *  that is both the key and its value, must be freed (value `1`) or not
+ *  (value `0`).
+ *
+ * The eviction function is not called.
+ * Memory deallocation (if requested) is performed by means of the `free()`
+ * standard C function.
+ *
+ * Average-case complexity: constant, `O(1)`.
+ */
+void upo_lru_delete(upo_lru_t lru, const void *key, int destroy_data);
+
+/**
+ * \brief Evicts the least recently used key-value pair from the given LRU
+ *  cache.
+ *
+ * \param lru The LRU cache.
+ * \param destroy_data Tells whether the previously allocated memory for data,
+ *  that is both the key and its value, must be freed (value `1`) or not
+ *  (value `0`).
+ * \return `1` if a key-value pair has been evicted, or `0` if the LRU cache is
+ *  empty.
+ *
+ * The eviction function (if any) is called on the key-value pair before it is
+ * freed.
+ * Memory deallocation (if requested) is performed by means of the `free()`
+ * standard C function.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+int upo_lru_evict(upo_lru_t lru, int destroy_data);
+
+/**
+ * \brief Sets the function called on each key-value pair evicted from the
+ *  given LRU cache.
+ *
+ * \param lru The LRU cache.
+ * \param evict The eviction function, or `NULL` to call no function.
+ * \param evict_arg An additional parameter to pass to the eviction function.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+void upo_lru_set_evictor(upo_lru_t lru, upo_lru_evictor_t evict, void *evict_arg);
+
+/**
+ * \brief Returns the least recently used key of the given LRU cache.
+ *
+ * \param lru The LRU cache.
+ * \return The key that would be evicted next, or `NULL` if the LRU cache is
+ *  empty.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+void* upo_lru_oldest(const upo_lru_t lru);
+
+/**
+ * \brief Returns the size of the given LRU cache.
+ *
+ * \param lru The LRU cache.
+ * \return The number of key-value pairs stored in the LRU cache.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+size_t upo_lru_size(const upo_lru_t lru);
+
+/**
+ * \brief Tells if the given LRU cache is empty.
+ *
+ * \param lru The LRU cache.
+ * \return `1` if the LRU cache is empty, or `0` otherwise.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+int upo_lru_is_empty(const upo_lru_t lru);
+
+/**
+ * \brief Returns the capacity of the given LRU cache.
+ *
+ * \param lru The LRU cache.
+ * \return The maximum number of key-value pairs of the LRU cache.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+size_t upo_lru_capacity(const upo_lru_t lru);
+
+/**
+ * \brief Returns the keys of the given LRU cache.
+ *
+ * \param lru The LRU cache.
+ * \return A singly-linked list of keys from the most to the least recently
+ *  used one, or `NULL` if the LRU cache is empty.
+ *
+ * Worst-case complexity: linear in the number `n` of key-value pairs, `O(n)`.
+ */
+upo_ht_key_list_t upo_lru_keys(const upo_lru_t lru);
+
+/**
+ * \brief Performs a traversal of the given LRU cache from the most to the
+ *  least recently used key, without changing the recency of use of keys.
+ *
+ * \param lru The LRU cache.
+ * \param visit The visit function.
+ * \param visit_arg An additional parameter to pass to the visit function.
+ *
+ * Worst-case complexity: linear in the number `n` of key-value pairs, `O(n)`.
+ */
+void upo_lru_traverse(const upo_lru_t lru, upo_ht_visitor_t visit, void *visit_arg);
+
+/**
+ * \brief Returns the key comparator function.
+ *
+ * \param lru The LRU cache.
+ * \return The key comparator function.
+ */
+upo_ht_comparator_t upo_lru_get_comparator(const upo_lru_t lru);
+
+/**
+ * \brief Returns the key hasher function.
+ *
+ * \param lru The LRU cache.
+ * \return The key hasher function.
+ */
+upo_ht_hasher_t upo_lru_get_hasher(const upo_lru_t lru);
+
+
+#endif /* UPO_LRU_H */
@@ -0,0 +1,236 @@
+/**
+ * \file upo/ordmap.h
+ *
+ * \brief The Ordered Map (OM) abstract data type.
+ *
+ * Ordered Maps are hash tables (see upo/hashtable.h) that remember the order
+ * in which keys have been inserted.
+ * They are implemented as compact dictionaries, in the style of CPython:
+ * key-value pairs are appended to a dense array of entries, and an open
+ * addressing index of 8-bit, 16-bit, 32-bit or 64-bit integers (the smallest
+ * width that fits the capacity) maps hash values to positions in the array of
+ * entries.
+ * Iterations only touch the array of entries, in insertion order, and sparse
+ * slots only cost a few bytes of the index instead of a whole entry.
+ *
+ * \copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ *  This file is part of UPOalglib.
+ *
+ *  UPOalglib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  UPOalglib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UPO_ORDMAP_H
+#define UPO_ORDMAP_H
+
+
+#include <stddef.h>
+#include <upo/hashtable.h>
+
+
+/** \brief Type for ordered maps. */
+typedef struct upo_ordmap_s* upo_ordmap_t;
+
+
+/**
+ * \brief Creates a new empty ordered map.
+ *
+ * \param n The number of key-value pairs that the ordered map can store
+ *  without resizing.
+ * \param key_hash A pointer to the function used to hash keys.
+ * \param key_cmp A pointer to the function used to compare keys.
+ * \return An empty ordered map.
+ *
+ * Keys are hashed by means of upo_ht_hash_wide(), and their hash values are
+ * stored in the entries so that resizing never calls the key hash function.
+ *
+ * Worst-case complexity: linear in the capacity `n` of the ordered map, `O(n)`.
+ */
+upo_ordmap_t upo_ordmap_create(size_t n, upo_ht_hasher_t key_hash, upo_ht_comparator_t key_cmp);
+
+/**
+ * \brief Destroys the given ordered map.
+ *
+ * \param map The ordered map to destroy.
+ * \param destroy_data Tells whether the previously allocated memory for data,
+ *  that is both keys and values, stored in the ordered map must be freed
+ *  (value `1`) or not (value `0`).
+ *
+ * Memory deallocation (if requested) is performed by means of the `free()`
+ * standard C function.
+ *
+ * Worst-case complexity: linear in the capacity `n` of the ordered map, `O(n)`.
+ */
+void upo_ordmap_destroy(upo_ordmap_t map, int destroy_data);
+
+/**
+ * \brief Removes all key-value pairs from the given ordered map.
+ *
+ * \param map The ordered map to clear.
+ * \param destroy_data Tells whether the previously allocated memory for data,
+ *  that is both keys and values, stored in the ordered map must be freed
+ *  (value `1`) or not (value `0`).
+ *
+ * Memory deallocation (if requested) is performed by means of the `free()`
+ * standard C function.
+ *
+ * Worst-case complexity: linear in the capacity `n` of the ordered map, `O(n)`.
+ */
+void upo_ordmap_clear(upo_ordmap_t map, int destroy_data);
+
+/**
+ * \brief Stores the given key-value pair into the given ordered map.
+ *
+ * \param map The ordered map.
+ * \param key The key.
+ * \param value The value.
+ * \return The value previously associated to the given key, or `NULL` if the
+ *  key was not present.
+ *
+ * If the key is already present, its value is replaced but the key keeps its
+ * position in the insertion order.
+ * Otherwise, the key-value pair is appended to the array of entries.
+ *
+ * Worst-case complexity: linear in the number `n` of key-value pairs, `O(n)`.
+ */
+void* upo_ordmap_put(upo_ordmap_t map, void *key, void *value);
+
+/**
+ * \brief Inserts the given key-value pair into the given ordered map.
+ *
+ * \param map The ordered map.
+ * \param key The key.
+ * \param value The value.
+ *
+ * If the key is already present, no insertion takes place.
+ *
+ * Worst-case complexity: linear in the number `n` of key-value pairs, `O(n)`.
+ */
+void upo_ordmap_insert(upo_ordmap_t map, void *key, void *value);
+
+/**
+ * \brief Returns the value stored in the given ordered map and associated to
+ *  the given key.
+ *
+ * \param map The ordered map.
+ * \param key The key.
+ * \return The value associated to the key, or `NULL` if the key is not found.
+ *
+ * Worst-case complexity: linear in the number `n` of key-value pairs, `O(n)`.
+ */
+void* upo_ordmap_get(const upo_ordmap_t map, const void *key);
+
+/**
+ * \brief Tells if the given ordered map contains the given key.
+ *
+ * \param map The ordered map.
+ * \param key The key.
+ * \return `1` if the ordered map contains the given key, or `0` otherwise.
+ *
+ * Worst-case complexity: linear in the number `n` of key-value pairs, `O(n)`.
+ */
+int upo_ordmap_contains(const upo_ordmap_t map, const void *key);
+
+/**
+ * \brief Removes the given key from the given ordered map.
+ *
+ * \param map The ordered map.
+ * \param key The key.
+ * \param destroy_data Tells whether the previously allocated memory for data,
+ *  that is both the key and its value, must be freed (value `1`) or not
+ *  (value `0`).
+ *
+ * The entry of the key is left as a hole in the array of entries, which is
+ * compacted when it gets full.
+ * Memory deallocation (if requested) is performed by means of the `free()`
+ * standard C function.
+ *
+ * Worst-case complexity: linear in the number `n` of key-value pairs, `O(n)`.
+ */
+void upo_ordmap_delete(upo_ordmap_t map, const void *key, int destroy_data);
+
+/**
+ * \brief Returns the size of the given ordered map.
+ *
+ * \param map The ordered map.
+ * \return The number of key-value pairs stored in the ordered map.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+size_t upo_ordmap_size(const upo_ordmap_t map);
+
+/**
+ * \brief Tells if the given ordered map is empty.
+ *
+ * \param map The ordered map.
+ * \return `1` if the ordered map is empty, or `0` otherwise.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+int upo_ordmap_is_empty(const upo_ordmap_t map);
+
+/**
+ * \brief Returns the capacity of the given ordered map.
+ *
+ * \param map The ordered map.
+ * \return The number of entries of the ordered map, that is the number of
+ *  insertions it can perform (counting the entries of removed keys) before
+ *  resizing.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+size_t upo_ordmap_capacity(const upo_ordmap_t map);
+
+/**
+ * \brief Returns the keys of the given ordered map.
+ *
+ * \param map The ordered map.
+ * \return A singly-linked list of keys in insertion order, or `NULL` if the
+ *  ordered map is empty.
+ *
+ * Worst-case complexity: linear in the capacity `n` of the ordered map, `O(n)`.
+ */
+upo_ht_key_list_t upo_ordmap_keys(const upo_ordmap_t map);
+
+/**
+ * \brief Performs a traversal of the given ordered map in insertion order.
+ *
+ * \param map The ordered map.
+ * \param visit The visit function.
+ * \param visit_arg An additional parameter to pass to the visit function.
+ *
+ * Only the array of entries is scanned, not the index.
+ *
+ * Worst-case complexity: linear in the capacity `n` of the ordered map, `O(n)`.
+ */
+void upo_ordmap_traverse(const upo_ordmap_t map, upo_ht_visitor_t visit, void *visit_arg);
+
+/**
+ * \brief Returns the key comparator function.
+ *
+ * \param map The ordered map.
+ * \return The key comparator function.
+ */
+upo_ht_comparator_t upo_ordmap_get_comparator(const upo_ordmap_t map);
+
+/**
+ * \brief Returns the key hasher function.
+ *
+ * \param map The ordered map.
+ * \return The key hasher function.
+ */
+upo_ht_hasher_t upo_ordmap_get_hasher(const upo_ordmap_t map);
+
+
+#endif /* UPO_ORDMAP_H */
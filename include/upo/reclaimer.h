@@ -0,0 +1,105 @@
+/**
+ * \file upo/reclaimer.h
+ *
+ * \brief The background reclaimer of data structures.
+ *
+ * The reclaimer frees data structures on a background thread, so that the
+ * thread dropping a large data structure (e.g., by means of
+ * upo_ht_sepchain_destroy_async() or upo_bst_destroy_async()) does not wait
+ * for each of its elements to be freed.
+ * Each submitted data structure is released by a step function that frees a
+ * bounded batch of elements at a time: the reclaimer thread takes no lock
+ * while running a step, and interleaves the steps of the pending data
+ * structures in round robin, so that no data structure (and no allocator
+ * lock) is held for long.
+ * The thread is started on the first submission; if it cannot be started,
+ * data structures are freed by the submitting thread.
+ *
+ * \copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ *  This file is part of UPOalglib.
+ *
+ *  UPOalglib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  UPOalglib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UPO_RECLAIMER_H
+#define UPO_RECLAIMER_H
+
+
+#include <stddef.h>
+
+
+/** \brief Default number of elements freed by each step of the reclaimer. */
+#define UPO_RECLAIMER_DEFAULT_BATCH_SIZE 4096U
+
+/**
+ * \brief The type for reclaim step functions.
+ *
+ * Declares the type for functions that free a data structure incrementally.
+ * A reclaim step function takes four parameters:
+ * - The first parameter is a pointer to the data structure to free.
+ * - The second parameter tells whether the data (e.g., keys and values)
+ *   stored in the data structure must be freed (value `1`) or not (value
+ *   `0`).
+ * - The third parameter is a pointer to the progress of the reclaim, which
+ *   is `0` on the first call and is left to the step function to update.
+ * - The fourth parameter is the maximum number of elements to free.
+ * The function returns `1` once the data structure has been freed entirely,
+ * or `0` if it must be called again.
+ */
+typedef int (*upo_reclaimer_step_t)(void*, int, size_t*, size_t);
+
+
+/**
+ * \brief Hands the given data structure to the reclaimer.
+ *
+ * \param obj The data structure to free, which must not be accessed anymore.
+ * \param step The reclaim step function of the data structure.
+ * \param destroy_data Tells whether the previously allocated memory for data
+ *  stored in the data structure must be freed (value `1`) or not (value
+ *  `0`).
+ *
+ * Worst-case complexity: constant, `O(1)`, if the reclaimer thread is
+ *  running.
+ */
+void upo_reclaimer_submit(void *obj, upo_reclaimer_step_t step, int destroy_data);
+
+/**
+ * \brief Waits until all the data structures handed to the reclaimer have
+ *  been freed.
+ */
+void upo_reclaimer_drain(void);
+
+/**
+ * \brief Returns the number of data structures waiting to be freed.
+ *
+ * \return The number of data structures handed to the reclaimer and not yet
+ *  freed entirely.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+size_t upo_reclaimer_pending(void);
+
+/**
+ * \brief Sets the maximum number of elements freed by each step of the
+ *  reclaimer.
+ *
+ * \param n The batch size (must be greater than `0`).
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+void upo_reclaimer_set_batch_size(size_t n);
+
+
+#endif /* UPO_RECLAIMER_H */
@@ -0,0 +1,225 @@
+/**
+ * \file upo/shmht.h
+ *
+ * \brief The Shared-Memory Hash Table abstract data type.
+ *
+ * Shared-Memory Hash Tables are hash tables with linear probing (see
+ * upo/hashtable.h) stored entirely inside a named POSIX shared memory object
+ * (see `shm_open()`), so that several processes can map and use the same
+ * table: for instance, one process builds the table and many worker
+ * processes read it, rather than each of them building an identical copy.
+ *
+ * Since each process maps the table at a different address, the table holds
+ * no pointer: keys and values are byte strings copied into a heap at the end
+ * of the shared memory object, and slots refer to them by offset.
+ * Keys are hashed by means of the 64-bit FNV-1a function of their bytes, so
+ * every process finds them without sharing any function pointer.
+ * The capacity and the size of the heap are fixed on creation: the heap is
+ * only appended to (the space of replaced values and removed keys is not
+ * reused), which suits tables that are built once and then mostly read.
+ *
+ * Writers are serialized by a process-shared robust mutex, so that a writer
+ * dying while holding it does not block the others, and the next writer
+ * repairs whatever update the dead one left unfinished.
+ * Readers take no lock: the table is guarded by a sequence lock, which each
+ * writer makes odd while it updates slots, and readers retry their lookup if
+ * the sequence number was odd or changed meanwhile.
+ * A reader that finds the sequence number odd for a long time tries the lock:
+ * if the writer died while updating slots, the reader repairs the table like
+ * the next writer would, so readers do not spin forever on a dead writer.
+ *
+ * \copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ *  This file is part of UPOalglib.
+ *
+ *  UPOalglib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  UPOalglib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UPO_SHMHT_H
+#define UPO_SHMHT_H
+
+
+#include <stddef.h>
+
+
+/** \brief Type for shared-memory hash tables. */
+typedef struct upo_shmht_s* upo_shmht_t;
+
+
+/**
+ * \brief Creates a new empty shared-memory hash table.
+ *
+ * \param name The name of the shared memory object, which must begin with a
+ *  slash and contain no other slash (see `shm_open()`).
+ * \param capacity The number of slots (rounded up to a power of two); the
+ *  table stores at most `capacity-1` keys.
+ * \param heap_size The number of bytes available for keys and values.
+ * \return The new hash table, mapped in the calling process, or `NULL` if a
+ *  shared memory object with the given name already exists.
+ *
+ * Each key and each value takes its size plus 8 bytes of the heap, rounded up
+ * to a multiple of 8 bytes.
+ * The shared memory object persists until upo_shmht_unlink() is called.
+ *
+ * Worst-case complexity: linear in the capacity `m`, `O(m)`.
+ */
+upo_shmht_t upo_shmht_create(const char *name, size_t capacity, size_t heap_size);
+
+/**
+ * \brief Maps an existing shared-memory hash table.
+ *
+ * \param name The name of the shared memory object.
+ * \return The hash table, mapped in the calling process, or `NULL` if there
+ *  is no shared memory object with the given name or if it does not hold a
+ *  completely created hash table.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+upo_shmht_t upo_shmht_open(const char *name);
+
+/**
+ * \brief Unmaps the given shared-memory hash table from the calling process.
+ *
+ * \param ht The hash table.
+ *
+ * The table itself is left to the other processes.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+void upo_shmht_close(upo_shmht_t ht);
+
+/**
+ * \brief Removes the name of the given shared memory object.
+ *
+ * \param name The name of the shared memory object.
+ * \return `1` if the name has been removed, or `0` if it did not exist.
+ *
+ * Processes that have mapped the table keep using it, and its memory is
+ * released once all of them have closed it.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+int upo_shmht_unlink(const char *name);
+
+/**
+ * \brief Stores a copy of the given key-value pair into the given
+ *  shared-memory hash table.
+ *
+ * \param ht The hash table.
+ * \param key The bytes of the key.
+ * \param key_size The number of bytes of the key.
+ * \param value The bytes of the value.
+ * \param value_size The number of bytes of the value.
+ * \return `1` if the pair has been stored, or `0` if there is no room for
+ *  it in the slots or in the heap.
+ *
+ * If the key is already present, its value is replaced.
+ *
+ * Average-case complexity: linear in the size of the key and of the value.
+ */
+int upo_shmht_put(upo_shmht_t ht, const void *key, size_t key_size, const void *value, size_t value_size);
+
+/**
+ * \brief Copies the value associated to the given key.
+ *
+ * \param ht The hash table.
+ * \param key The bytes of the key.
+ * \param key_size The number of bytes of the key.
+ * \param value The buffer where to copy the value, or `NULL`.
+ * \param value_size On input, the size of the buffer; on output (if the key
+ *  is found), the size of the value, which is copied only up to the size of
+ *  the buffer.
+ *  May be `NULL` if `value` is `NULL`.
+ * \return `1` if the key is found, or `0` otherwise.
+ *
+ * No lock is taken, so lookups never wait for other readers, and only retry
+ * while a writer is updating the table (yielding to the writer after many
+ * retries, or repairing the table if the writer died while updating it).
+ *
+ * Average-case complexity: linear in the size of the key and of the value.
+ */
+int upo_shmht_get(const upo_shmht_t ht, const void *key, size_t key_size, void *value, size_t *value_size);
+
+/**
+ * \brief Tells if the given shared-memory hash table contains the given key.
+ *
+ * \param ht The hash table.
+ * \param key The bytes of the key.
+ * \param key_size The number of bytes of the key.
+ * \return `1` if the key is found, or `0` otherwise.
+ *
+ * Average-case complexity: linear in the size of the key.
+ */
+int upo_shmht_contains(const upo_shmht_t ht, const void *key, size_t key_size);
+
+/**
+ * \brief Removes the given key from the given shared-memory hash table.
+ *
+ * \param ht The hash table.
+ * \param key The bytes of the key.
+ * \param key_size The number of bytes of the key.
+ * \return `1` if the key has been removed, or `0` if it was not found.
+ *
+ * The slot of the key is marked as deleted, and is reused by later keys;
+ * deleted slots are purged when a new key would find no room otherwise.
+ *
+ * Average-case complexity: linear in the size of the key.
+ */
+int upo_shmht_delete(upo_shmht_t ht, const void *key, size_t key_size);
+
+/**
+ * \brief Returns the size of the given shared-memory hash table.
+ *
+ * \param ht The hash table.
+ * \return The number of stored key-value pairs, or `0` if the hash table is
+ *  `NULL`.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+size_t upo_shmht_size(const upo_shmht_t ht);
+
+/**
+ * \brief Tells if the given shared-memory hash table is empty.
+ *
+ * \param ht The hash table.
+ * \return `1` if the hash table is empty or `NULL`, or `0` otherwise.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+int upo_shmht_is_empty(const upo_shmht_t ht);
+
+/**
+ * \brief Returns the capacity of the given shared-memory hash table.
+ *
+ * \param ht The hash table.
+ * \return The number of slots, or `0` if the hash table is `NULL`.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+size_t upo_shmht_capacity(const upo_shmht_t ht);
+
+/**
+ * \brief Returns the number of bytes of the heap of the given shared-memory
+ *  hash table used so far.
+ *
+ * \param ht The hash table.
+ * \return The number of used bytes, including those of replaced values and
+ *  removed keys, or `0` if the hash table is `NULL`.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+size_t upo_shmht_heap_used(const upo_shmht_t ht);
+
+
+#endif /* UPO_SHMHT_H */
@@ -0,0 +1,316 @@
+/**
+ * \file upo/ttlmap.h
+ *
+ * \brief The TTL Map abstract data type.
+ *
+ * TTL Maps are hash tables (see upo/hashtable.h) whose key-value pairs may
+ * have a time-to-live: each pair expires, and is removed, once the clock of
+ * the map reaches its expiration time.
+ * The clock is a counter of ticks that is moved forward explicitly by means
+ * of upo_ttlmap_advance(), so the length of a tick is chosen by the user.
+ *
+ * They are implemented as hash tables with separate chaining whose nodes are
+ * also linked into a hierarchical timing wheel (as described by Varghese and
+ * Lauck), so that expiring pairs never requires to scan the table.
+ * The wheel has UPO_TTLMAP_LEVELS levels of UPO_TTLMAP_WHEEL_SIZE slots each:
+ * a slot of level `l` covers \f$64^l\f$ ticks, and the pairs of a slot are
+ * moved to the level below when the clock enters the range of the slot.
+ * Storing, rescheduling and removing a pair take constant time, and each tick
+ * takes constant time plus the time to expire or move the pairs of its slots.
+ *
+ * \copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ *  This file is part of UPOalglib.
+ *
+ *  UPOalglib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  UPOalglib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UPO_TTLMAP_H
+#define UPO_TTLMAP_H
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <upo/hashtable.h>
+
+
+/** \brief Number of levels of the timing wheel. */
+#define UPO_TTLMAP_LEVELS 4U
+
+/** \brief Number of slots of each level of the timing wheel. */
+#define UPO_TTLMAP_WHEEL_SIZE 64U
+
+/** \brief Time-to-live of key-value pairs that never expire. */
+#define UPO_TTLMAP_NO_TTL 0U
+
+/** \brief Type for TTL maps. */
+typedef struct upo_ttlmap_s* upo_ttlmap_t;
+
+/**
+ * \brief The type for expiration functions.
+ *
+ * Declares the type for functions that are called on each key-value pair
+ * expired from a TTL map.
+ * An expiration function takes three parameters:
+ * - The first parameter is a pointer to the user-provided key being expired.
+ * - The second parameter is a pointer to the value associated to the key.
+ * - The third parameter is a pointer to data that is used by the expiration
+ *   function to perform its operation.
+ * The key and the value are freed (if requested) after the call.
+ * The expiration function must not call functions of the same map.
+ */
+typedef void (*upo_ttlmap_expirer_t)(void*, void*, void*);
+
+
+/**
+ * \brief Creates a new empty TTL map.
+ *
+ * \param m The initial number of slots of the hash table (rounded up to a
+ *  power of two); the table doubles when it holds more pairs than slots.
+ * \param key_hash A pointer to the function used to hash keys.
+ * \param key_cmp A pointer to the function used to compare keys.
+ * \return An empty TTL map, whose clock is at tick `0`.
+ *
+ * Keys are hashed by means of upo_ht_hash_wide().
+ *
+ * Worst-case complexity: linear in the number of slots `m`, `O(m)`.
+ */
+upo_ttlmap_t upo_ttlmap_create(size_t m, upo_ht_hasher_t key_hash, upo_ht_comparator_t key_cmp);
+
+/**
+ * \brief Destroys the given TTL map.
+ *
+ * \param map The TTL map to destroy.
+ * \param destroy_data Tells whether the previously allocated memory for data,
+ *  that is both keys and values, stored in the map must be freed (value `1`)
+ *  or not (value `0`).
+ *
+ * The expiration function is not called.
+ * Memory deallocation (if requested) is performed by means of the `free()`
+ * standard C function.
+ *
+ * Worst-case complexity: linear in the number of slots `m` and in the size
+ *  `n` of the map, `O(m+n)`.
+ */
+void upo_ttlmap_destroy(upo_ttlmap_t map, int destroy_data);
+
+/**
+ * \brief Removes all key-value pairs from the given TTL map.
+ *
+ * \param map The TTL map to clear.
+ * \param destroy_data Tells whether the previously allocated memory for data,
+ *  that is both keys and values, stored in the map must be freed (value `1`)
+ *  or not (value `0`).
+ *
+ * The expiration function is not called, and the clock is left unchanged.
+ * Memory deallocation (if requested) is performed by means of the `free()`
+ * standard C function.
+ *
+ * Worst-case complexity: linear in the number of slots `m` and in the size
+ *  `n` of the map, `O(m+n)`.
+ */
+void upo_ttlmap_clear(upo_ttlmap_t map, int destroy_data);
+
+/**
+ * \brief Stores the given key-value pair into the given TTL map.
+ *
+ * \param map The TTL map.
+ * \param key The key.
+ * \param value The value.
+ * \param ttl The number of ticks after which the pair expires, or
+ *  UPO_TTLMAP_NO_TTL if the pair never expires.
+ * \return The value previously associated to the given key, or `NULL` if the
+ *  key was not present.
+ *
+ * If the key is already present, its value is replaced (and the old value is
+ * returned rather than freed) and its expiration time is reset to `ttl` ticks
+ * from now.
+ *
+ * Average-case complexity: constant, `O(1)`.
+ */
+void* upo_ttlmap_put(upo_ttlmap_t map, void *key, void *value, uint64_t ttl);
+
+/**
+ * \brief Returns the value associated to the given key.
+ *
+ * \param map The TTL map.
+ * \param key The key.
+ * \return The value associated to the key, or `NULL` if the key is not found
+ *  (or has expired).
+ *
+ * Average-case complexity: constant, `O(1)`.
+ */
+void* upo_ttlmap_get(const upo_ttlmap_t map, const void *key);
+
+/**
+ * \brief Tells if the given TTL map contains the given key.
+ *
+ * \param map The TTL map.
+ * \param key The key.
+ * \return `1` if the map contains the given key, or `0` otherwise.
+ *
+ * Average-case complexity: constant, `O(1)`.
+ */
+int upo_ttlmap_contains(const upo_ttlmap_t map, const void *key);
+
+/**
+ * \brief Removes the given key from the given TTL map.
+ *
+ * \param map The TTL map.
+ * \param key The key.
+ * \param destroy_data Tells whether the previously allocated memory for data,
+ *  that is both the key and its value, must be freed (value `1`) or not
+ *  (value `0`).
+ *
+ * The expiration function is not called.
+ * Memory deallocation (if requested) is performed by means of the `free()`
+ * standard C function.
+ *
+ * Average-case complexity: constant, `O(1)`.
+ */
+void upo_ttlmap_delete(upo_ttlmap_t map, const void *key, int destroy_data);
+
+/**
+ * \brief Changes the time-to-live of the given key.
+ *
+ * \param map The TTL map.
+ * \param key The key.
+ * \param ttl The number of ticks from now after which the pair expires, or
+ *  UPO_TTLMAP_NO_TTL if the pair must never expire.
+ * \return `1` if the key is found, or `0` otherwise.
+ *
+ * Average-case complexity: constant, `O(1)`.
+ */
+int upo_ttlmap_set_ttl(upo_ttlmap_t map, const void *key, uint64_t ttl);
+
+/**
+ * \brief Returns the remaining time-to-live of the given key.
+ *
+ * \param map The TTL map.
+ * \param key The key.
+ * \return The number of ticks after which the key expires, or
+ *  UPO_TTLMAP_NO_TTL if the key never expires or is not found.
+ *
+ * Average-case complexity: constant, `O(1)`.
+ */
+uint64_t upo_ttlmap_ttl(const upo_ttlmap_t map, const void *key);
+
+/**
+ * \brief Moves the clock of the given TTL map forward, expiring the key-value
+ *  pairs whose time-to-live has elapsed.
+ *
+ * \param map The TTL map.
+ * \param ticks The number of ticks to move the clock forward by.
+ * \param destroy_data Tells whether the previously allocated memory for data,
+ *  that is both keys and values, of expired pairs must be freed (value `1`)
+ *  or not (value `0`).
+ * \return The number of expired key-value pairs.
+ *
+ * The expiration function (if any) is called on each expired pair, in order
+ * of expiration time.
+ * If no stored pair has a time-to-live, the clock jumps forward at once.
+ * Memory deallocation (if requested) is performed by means of the `free()`
+ * standard C function.
+ *
+ * Worst-case complexity: linear in the number of ticks `t` and in the number
+ *  `k` of pairs that expire or are moved across levels, `O(t+k)`; each pair
+ *  is moved at most UPO_TTLMAP_LEVELS-1 times.
+ */
+size_t upo_ttlmap_advance(upo_ttlmap_t map, uint64_t ticks, int destroy_data);
+
+/**
+ * \brief Returns the current tick of the clock of the given TTL map.
+ *
+ * \param map The TTL map.
+ * \return The number of ticks the clock has moved forward since the map was
+ *  created, or `0` if the map is `NULL`.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+uint64_t upo_ttlmap_now(const upo_ttlmap_t map);
+
+/**
+ * \brief Sets the function called on each key-value pair expired from the
+ *  given TTL map.
+ *
+ * \param map The TTL map.
+ * \param expire The expiration function, or `NULL` to call no function.
+ * \param expire_arg An additional parameter to pass to the expiration
+ *  function.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+void upo_ttlmap_set_expirer(upo_ttlmap_t map, upo_ttlmap_expirer_t expire, void *expire_arg);
+
+/**
+ * \brief Returns the size of the given TTL map.
+ *
+ * \param map The TTL map.
+ * \return The number of key-value pairs stored in the map.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+size_t upo_ttlmap_size(const upo_ttlmap_t map);
+
+/**
+ * \brief Tells if the given TTL map is empty.
+ *
+ * \param map The TTL map.
+ * \return `1` if the map is empty, or `0` otherwise.
+ *
+ * Worst-case complexity: constant, `O(1)`.
+ */
+int upo_ttlmap_is_empty(const upo_ttlmap_t map);
+
+/**
+ * \brief Returns the list of all keys contained in the given TTL map.
+ *
+ * \param map The TTL map.
+ * \return The list of keys, in no particular order.
+ *
+ * Worst-case complexity: linear in the number of slots `m` and in the size
+ *  `n` of the map, `O(m+n)`.
+ */
+upo_ht_key_list_t upo_ttlmap_keys(const upo_ttlmap_t map);
+
+/**
+ * \brief Traverses the given TTL map.
+ *
+ * \param map The TTL map.
+ * \param visit The function to call on each key-value pair.
+ * \param visit_arg An additional parameter to pass to the visit function.
+ *
+ * Worst-case complexity: linear in the number of slots `m` and in the size
+ *  `n` of the map, `O(m+n)`.
+ */
+void upo_ttlmap_traverse(const upo_ttlmap_t map, upo_ht_visitor_t visit, void *visit_arg);
+
+/**
+ * \brief Returns the key comparator function.
+ *
+ * \param map The TTL map.
+ * \return The key comparator function.
+ */
+upo_ht_comparator_t upo_ttlmap_get_comparator(const upo_ttlmap_t map);
+
+/**
+ * \brief Returns the key hasher function.
+ *
+ * \param map The TTL map.
+ * \return The key hasher function.
+ */
+upo_ht_hasher_t upo_ttlmap_get_hasher(const upo_ttlmap_t map);
+
+
+#endif /* UPO_TTLMAP_H */
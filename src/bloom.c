@@ -0,0 +1,359 @@
+/*
+ * Copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ * This file is part of UPOalglib.
+ *
+ * UPOalglib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * UPOalglib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <upo/error.h>
+#include "bloom_private.h"
+
+
+/*** BEGIN of FUNDAMENTAL OPERATIONS ***/
+
+
+upo_bloom_t upo_bloom_create(size_t n, double fpr, upo_ht_hasher_t key_hash)
+{
+    size_t lo = 0;
+    size_t hi = 1;
+    size_t mid = 0;
+
+    /* preconditions */
+    assert( fpr > 0 && fpr < 1 );
+    assert( key_hash != NULL );
+
+    /* Find the least number of blocks by exponential and then binary search */
+    while (upo_bloom_expected_fpr(n, hi) > fpr)
+    {
+        lo = hi;
+        hi *= 2;
+    }
+    while (hi - lo > 1)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (upo_bloom_expected_fpr(n, mid) > fpr)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    return upo_bloom_alloc(hi, key_hash);
+}
+
+void upo_bloom_destroy(upo_bloom_t bloom)
+{
+    if (bloom != NULL)
+    {
+        free(bloom->blocks);
+        free(bloom);
+    }
+}
+
+void upo_bloom_clear(upo_bloom_t bloom)
+{
+    /* preconditions */
+    assert( bloom != NULL );
+
+    memset(bloom->blocks, 0, bloom->num_blocks*UPO_BLOOM_BLOCK_WORDS*sizeof(uint32_t));
+    bloom->count = 0;
+}
+
+void upo_bloom_add(upo_bloom_t bloom, const void *key)
+{
+    uint64_t hash = 0;
+    uint32_t *block = NULL;
+#ifndef __AVX2__
+    uint32_t mask[UPO_BLOOM_BLOCK_WORDS];
+    size_t i = 0;
+#endif
+
+    /* preconditions */
+    assert( bloom != NULL );
+
+    hash = upo_ht_hash_wide(bloom->key_hash, key);
+    block = upo_bloom_block(bloom, hash);
+
+#ifdef __AVX2__
+    _mm256_store_si256((__m256i*) block, _mm256_or_si256(_mm256_load_si256((const __m256i*) block), upo_bloom_mask((uint32_t) hash)));
+#else
+    upo_bloom_mask((uint32_t) hash, mask);
+    for (i = 0; i < UPO_BLOOM_BLOCK_WORDS; ++i)
+    {
+        block[i] |= mask[i];
+    }
+#endif
+
+    ++bloom->count;
+}
+
+int upo_bloom_contains(const upo_bloom_t bloom, const void *key)
+{
+    uint64_t hash = 0;
+    const uint32_t *block = NULL;
+#ifndef __AVX2__
+    uint32_t mask[UPO_BLOOM_BLOCK_WORDS];
+    size_t i = 0;
+#endif
+
+    if (bloom == NULL)
+        return 0;
+
+    hash = upo_ht_hash_wide(bloom->key_hash, key);
+    block = upo_bloom_block(bloom, hash);
+
+#ifdef __AVX2__
+    /* All the bits of the mask are set if the mask has no bit outside the block */
+    return _mm256_testc_si256(_mm256_load_si256((const __m256i*) block), upo_bloom_mask((uint32_t) hash));
+#else
+    upo_bloom_mask((uint32_t) hash, mask);
+    for (i = 0; i < UPO_BLOOM_BLOCK_WORDS; ++i)
+    {
+        if ((block[i] & mask[i]) != mask[i])
+            return 0;
+    }
+
+    return 1;
+#endif
+}
+
+int upo_bloom_merge(upo_bloom_t bloom, const upo_bloom_t other)
+{
+    size_t i = 0;
+
+    /* preconditions */
+    assert( bloom != NULL );
+    assert( other != NULL );
+
+    if (bloom->num_blocks != other->num_blocks || bloom->key_hash != other->key_hash)
+        return 0;
+
+    for (i = 0; i < bloom->num_blocks*UPO_BLOOM_BLOCK_WORDS; ++i)
+    {
+        bloom->blocks[i] |= other->blocks[i];
+    }
+    bloom->count += other->count;
+
+    return 1;
+}
+
+size_t upo_bloom_serialized_size(const upo_bloom_t bloom)
+{
+    /* preconditions */
+    assert( bloom != NULL );
+
+    return UPO_BLOOM_HEADER_SIZE + bloom->num_blocks*UPO_BLOOM_BLOCK_WORDS*4;
+}
+
+void upo_bloom_serialize(const upo_bloom_t bloom, void *buf)
+{
+    unsigned char *p = buf;
+    size_t i = 0;
+
+    /* preconditions */
+    assert( bloom != NULL );
+    assert( buf != NULL );
+
+    upo_bloom_store_u64(p, UPO_BLOOM_MAGIC);
+    upo_bloom_store_u64(p + 8, bloom->num_blocks);
+    upo_bloom_store_u64(p + 16, bloom->count);
+    p += UPO_BLOOM_HEADER_SIZE;
+    for (i = 0; i < bloom->num_blocks*UPO_BLOOM_BLOCK_WORDS; ++i, p += 4)
+    {
+        p[0] = (unsigned char) bloom->blocks[i];
+        p[1] = (unsigned char) (bloom->blocks[i] >> 8);
+        p[2] = (unsigned char) (bloom->blocks[i] >> 16);
+        p[3] = (unsigned char) (bloom->blocks[i] >> 24);
+    }
+}
+
+upo_bloom_t upo_bloom_deserialize(const void *buf, size_t size, upo_ht_hasher_t key_hash)
+{
+    upo_bloom_t bloom = NULL;
+    const unsigned char *p = buf;
+    uint64_t num_blocks = 0;
+    size_t i = 0;
+
+    /* preconditions */
+    assert( buf != NULL || size == 0 );
+    assert( key_hash != NULL );
+
+    if (size < UPO_BLOOM_HEADER_SIZE || upo_bloom_load_u64(p) != UPO_BLOOM_MAGIC)
+        return NULL;
+
+    num_blocks = upo_bloom_load_u64(p + 8);
+    if (num_blocks == 0 || num_blocks > (size - UPO_BLOOM_HEADER_SIZE) / (UPO_BLOOM_BLOCK_WORDS*4)
+        || size != UPO_BLOOM_HEADER_SIZE + num_blocks*UPO_BLOOM_BLOCK_WORDS*4)
+        return NULL;
+
+    bloom = upo_bloom_alloc((size_t) num_blocks, key_hash);
+    bloom->count = (size_t) upo_bloom_load_u64(p + 16);
+    p += UPO_BLOOM_HEADER_SIZE;
+    for (i = 0; i < bloom->num_blocks*UPO_BLOOM_BLOCK_WORDS; ++i, p += 4)
+    {
+        bloom->blocks[i] = (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+    }
+
+    return bloom;
+}
+
+upo_bloom_t upo_bloom_alloc(size_t num_blocks, upo_ht_hasher_t key_hash)
+{
+    upo_bloom_t bloom = NULL;
+    size_t bytes = num_blocks*UPO_BLOOM_BLOCK_WORDS*sizeof(uint32_t);
+
+    /* The upper 32 bits of hash values select the block */
+    assert( num_blocks > 0 && (uint64_t) num_blocks <= UINT64_C(0x100000000) );
+
+    bloom = malloc(sizeof(struct upo_bloom_s));
+    if (bloom == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for Bloom Filter");
+    }
+
+    /* Note: aligned_alloc() needs a size that is a multiple of the alignment */
+    bloom->blocks = aligned_alloc(UPO_BLOOM_ALIGN, (bytes + UPO_BLOOM_ALIGN - 1) / UPO_BLOOM_ALIGN * UPO_BLOOM_ALIGN);
+    if (bloom->blocks == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for the blocks of the Bloom Filter");
+    }
+    memset(bloom->blocks, 0, bytes);
+    bloom->num_blocks = num_blocks;
+    bloom->count = 0;
+    bloom->key_hash = key_hash;
+
+    return bloom;
+}
+
+double upo_bloom_expected_fpr(size_t n, size_t num_blocks)
+{
+    double mean = (double) n / (double) num_blocks;
+    double spread = 10*sqrt(mean) + 10;
+    double fpr = 0;
+    double j = 0;
+
+    if (n == 0)
+        return 0;
+    if (mean > UPO_BLOOM_BLOCK_BITS)
+        return 1; // Blocks are saturated: the rate is above 0.99
+
+    /* Sum over the likely numbers of keys of a block, in log space to avoid underflows */
+    for (j = floor(mean > spread ? mean - spread : 0); j <= ceil(mean + spread); ++j)
+    {
+        double p = exp(-mean + j*log(mean) - lgamma(j + 1));
+
+        fpr += p * pow(1 - pow(1 - 1.0/32, j), UPO_BLOOM_BLOCK_WORDS);
+    }
+
+    return fpr < 1 ? fpr : 1;
+}
+
+uint32_t* upo_bloom_block(const upo_bloom_t bloom, uint64_t hash)
+{
+    /* Map the upper 32 bits to [0, num_blocks) by a multiplication rather than a division */
+    return bloom->blocks + ((hash >> 32) * bloom->num_blocks >> 32) * UPO_BLOOM_BLOCK_WORDS;
+}
+
+#ifdef __AVX2__
+
+__m256i upo_bloom_mask(uint32_t hash)
+{
+    const __m256i salts = _mm256_setr_epi32(UPO_BLOOM_SALTS);
+    __m256i bits = _mm256_mullo_epi32(_mm256_set1_epi32((int) hash), salts);
+
+    /* The top 5 bits of each product select the bit of its word */
+    bits = _mm256_srli_epi32(bits, 27);
+
+    return _mm256_sllv_epi32(_mm256_set1_epi32(1), bits);
+}
+
+#else
+
+void upo_bloom_mask(uint32_t hash, uint32_t mask[UPO_BLOOM_BLOCK_WORDS])
+{
+    static const uint32_t salts[UPO_BLOOM_BLOCK_WORDS] = { UPO_BLOOM_SALTS };
+    size_t i = 0;
+
+    /* The top 5 bits of each product select the bit of its word */
+    for (i = 0; i < UPO_BLOOM_BLOCK_WORDS; ++i)
+    {
+        mask[i] = ((uint32_t) 1) << ((uint32_t) (hash * salts[i]) >> 27);
+    }
+}
+
+#endif /* __AVX2__ */
+
+void upo_bloom_store_u64(unsigned char *p, uint64_t x)
+{
+    size_t i = 0;
+
+    for (i = 0; i < 8; ++i)
+    {
+        p[i] = (unsigned char) (x >> (8*i));
+    }
+}
+
+uint64_t upo_bloom_load_u64(const unsigned char *p)
+{
+    uint64_t x = 0;
+    size_t i = 0;
+
+    for (i = 0; i < 8; ++i)
+    {
+        x |= ((uint64_t) p[i]) << (8*i);
+    }
+
+    return x;
+}
+
+
+/*** END of FUNDAMENTAL OPERATIONS ***/
+
+
+/*** BEGIN of EXTRA OPERATIONS ***/
+
+
+size_t upo_bloom_count(const upo_bloom_t bloom)
+{
+    return (bloom != NULL) ? bloom->count : 0;
+}
+
+size_t upo_bloom_bits(const upo_bloom_t bloom)
+{
+    return (bloom != NULL) ? bloom->num_blocks*UPO_BLOOM_BLOCK_BITS : 0;
+}
+
+double upo_bloom_fpr(const upo_bloom_t bloom)
+{
+    /* preconditions */
+    assert( bloom != NULL );
+
+    return upo_bloom_expected_fpr(bloom->count, bloom->num_blocks);
+}
+
+upo_ht_hasher_t upo_bloom_get_hasher(const upo_bloom_t bloom)
+{
+    /* preconditions */
+    assert( bloom != NULL );
+
+    return bloom->key_hash;
+}
+
+
+/*** END of EXTRA OPERATIONS ***/
@@ -0,0 +1,136 @@
+/**
+ * \file src/bloom_private.h
+ *
+ * \brief Private header for the Bloom Filter abstract data type.
+ *
+ * \copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ *  This file is part of UPOalglib.
+ *
+ *  UPOalglib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  UPOalglib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UPO_BLOOM_PRIVATE_H
+#define UPO_BLOOM_PRIVATE_H
+
+
+#include <stdint.h>
+#include <upo/bloom.h>
+
+#ifdef __AVX2__
+# include <immintrin.h>
+#endif
+
+
+/** \brief Alignment (in bytes) of the array of blocks, the size of a cache line. */
+#define UPO_BLOOM_ALIGN 64U
+
+/** \brief Value identifying serialized Bloom filters ("UPOBLOOM" in little-endian byte order). */
+#define UPO_BLOOM_MAGIC UINT64_C(0x4d4f4f4c424f5055)
+
+/** \brief Number of bytes of the header of serialized Bloom filters. */
+#define UPO_BLOOM_HEADER_SIZE 24U
+
+/** \brief Odd constants selecting the bit of each word of a block. */
+#define UPO_BLOOM_SALTS 0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU, 0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+
+
+/**
+ * \brief Type for Bloom filters.
+ *
+ * Serialized Bloom filters are made of UPO_BLOOM_MAGIC, the number of blocks
+ * and the number of added keys (as 64-bit integers), followed by the words of
+ * the blocks (as 32-bit integers), all in little-endian byte order.
+ */
+struct upo_bloom_s
+{
+    uint32_t *blocks; /**< The words of the blocks, aligned to UPO_BLOOM_ALIGN bytes. */
+    size_t num_blocks; /**< The number of blocks. */
+    size_t count; /**< The number of added keys. */
+    upo_ht_hasher_t key_hash; /**< The key hash function. */
+};
+
+
+/**
+ * \brief Allocates an empty Bloom filter with the given number of blocks.
+ *
+ * \param num_blocks The number of blocks.
+ * \param key_hash A pointer to the function used to hash keys.
+ * \return The Bloom filter.
+ */
+static upo_bloom_t upo_bloom_alloc(size_t num_blocks, upo_ht_hasher_t key_hash);
+
+/**
+ * \brief Returns the expected false positive rate of a Bloom filter with the
+ *  given number of keys and blocks.
+ *
+ * \param n The number of keys.
+ * \param num_blocks The number of blocks.
+ * \return The false positive rate.
+ *
+ * The number of keys of a block follows a Poisson distribution with mean
+ * `n/num_blocks`, and a block with `j` keys gives a false positive with
+ * probability \f$(1-(1-1/32)^j)^8\f$.
+ */
+static double upo_bloom_expected_fpr(size_t n, size_t num_blocks);
+
+/**
+ * \brief Returns the first word of the block selected by the given hash value.
+ *
+ * \param bloom The Bloom filter.
+ * \param hash The hash value of the key.
+ * \return A pointer to the first word of the block.
+ */
+static uint32_t* upo_bloom_block(const upo_bloom_t bloom, uint64_t hash);
+
+#ifdef __AVX2__
+
+/**
+ * \brief Computes the bits set by a key in a block.
+ *
+ * \param hash The lower 32 bits of the hash value of the key.
+ * \return The mask of the block, with one bit set in each word.
+ */
+static __m256i upo_bloom_mask(uint32_t hash);
+
+#else
+
+/**
+ * \brief Computes the bits set by a key in a block.
+ *
+ * \param hash The lower 32 bits of the hash value of the key.
+ * \param mask Set to the mask of the block, with one bit set in each word.
+ */
+static void upo_bloom_mask(uint32_t hash, uint32_t mask[UPO_BLOOM_BLOCK_WORDS]);
+
+#endif /* __AVX2__ */
+
+/**
+ * \brief Stores the given 64-bit integer in little-endian byte order.
+ *
+ * \param p The destination, 8 bytes long.
+ * \param x The integer.
+ */
+static void upo_bloom_store_u64(unsigned char *p, uint64_t x);
+
+/**
+ * \brief Loads a 64-bit integer stored in little-endian byte order.
+ *
+ * \param p The source, 8 bytes long.
+ * \return The integer.
+ */
+static uint64_t upo_bloom_load_u64(const unsigned char *p);
+
+
+#endif /* UPO_BLOOM_PRIVATE_H */
@@ -23,6 +23,7 @@
 #include <stdlib.h>
 
 #include <upo/error.h>
+#include <upo/reclaimer.h>
 #include "bst_private.h"
 
 
@@ -68,6 +69,44 @@ void upo_bst_destroy(upo_bst_t tree, int destroy_data)
     }
 }
 
+void upo_bst_destroy_async(upo_bst_t tree, int destroy_data)
+{
+    upo_reclaimer_submit(tree, upo_bst_reclaim_step, destroy_data);
+}
+
+int upo_bst_reclaim_step(void *tree, int destroy_data, size_t *cursor, size_t batch)
+{
+    upo_bst_t t = tree;
+    size_t n = 0;
+
+    (void) cursor;
+
+    for (n = 0; n < batch && t->root != NULL; ++n)
+    {
+        upo_bst_node_t *node = t->root;
+
+        if (node->left != NULL)
+        {
+            /* Rotate right, so that the root loses its left subtree */
+            t->root = node->left;
+            node->left = t->root->right;
+            t->root->right = node;
+        }
+        else
+        {
+            t->root = node->right;
+            upo_bst_destroy_node(node, destroy_data);
+        }
+    }
+
+    if (t->root != NULL)
+        return 0;
+
+    free(t);
+
+    return 1;
+}
+
 void upo_bst_destroy_node(upo_bst_node_t *node, int destroy_data)
 {
     if (destroy_data != 0)
@@ -514,6 +553,159 @@ int upo_bst_is_bst_impl(upo_bst_node_t *node, const void *min_key, const void *m
     return upo_bst_is_bst_impl(node->left, min_key, node->key, key_cmp) && upo_bst_is_bst_impl(node->right, node->key, max_key, key_cmp);
 }
 
+upo_bst_t upo_bst_union(const upo_bst_t tree1, const upo_bst_t tree2)
+{
+    return upo_bst_set_op_impl(tree1, tree2, UPO_BST_SET_FIRST_ONLY | UPO_BST_SET_BOTH | UPO_BST_SET_SECOND_ONLY);
+}
+
+upo_bst_t upo_bst_intersection(const upo_bst_t tree1, const upo_bst_t tree2)
+{
+    return upo_bst_set_op_impl(tree1, tree2, UPO_BST_SET_BOTH);
+}
+
+upo_bst_t upo_bst_difference(const upo_bst_t tree1, const upo_bst_t tree2)
+{
+    return upo_bst_set_op_impl(tree1, tree2, UPO_BST_SET_FIRST_ONLY);
+}
+
+upo_bst_t upo_bst_set_op_impl(const upo_bst_t tree1, const upo_bst_t tree2, unsigned op)
+{
+    upo_bst_t result = NULL;
+    upo_bst_iterator_t it1;
+    upo_bst_iterator_t it2;
+    upo_bst_node_t **nodes = NULL;
+    upo_bst_node_t *node1 = NULL;
+    upo_bst_node_t *node2 = NULL;
+    size_t capacity = 0;
+    size_t n = 0;
+    int cmp = 0;
+
+    /* A NULL tree is read as an empty one */
+    if (tree1 == NULL && tree2 == NULL)
+        return NULL;
+    result = upo_bst_create((tree1 != NULL) ? tree1->key_cmp : tree2->key_cmp);
+
+    /* The result has at most as many keys as the kept trees */
+    capacity = upo_bst_size(tree1);
+    if (op & UPO_BST_SET_SECOND_ONLY)
+        capacity += upo_bst_size(tree2);
+    if (capacity == 0)
+        return result;
+
+    nodes = malloc(capacity*sizeof(upo_bst_node_t*));
+    if (nodes == NULL)
+        upo_throw_sys_error("Unable to allocate memory for the nodes of the set operation");
+
+    upo_bst_iterator_init(&it1, (tree1 != NULL) ? tree1->root : NULL);
+    upo_bst_iterator_init(&it2, (tree2 != NULL) ? tree2->root : NULL);
+    while (1)
+    {
+        node1 = upo_bst_iterator_peek(&it1);
+        node2 = upo_bst_iterator_peek(&it2);
+
+        /* Stop as soon as the remaining keys would all be discarded */
+        if (node1 == NULL && (node2 == NULL || !(op & UPO_BST_SET_SECOND_ONLY)))
+            break;
+        if (node2 == NULL && !(op & UPO_BST_SET_FIRST_ONLY))
+            break;
+
+        if (node1 == NULL)
+            cmp = 1;
+        else if (node2 == NULL)
+            cmp = -1;
+        else
+            cmp = result->key_cmp(node1->key, node2->key);
+
+        if (cmp < 0)
+        {
+            if (op & UPO_BST_SET_FIRST_ONLY)
+                nodes[n++] = node1;
+            upo_bst_iterator_next(&it1);
+        }
+        else if (cmp > 0)
+        {
+            if (op & UPO_BST_SET_SECOND_ONLY)
+                nodes[n++] = node2;
+            upo_bst_iterator_next(&it2);
+        }
+        else
+        {
+            if (op & UPO_BST_SET_BOTH)
+                nodes[n++] = node1;
+            upo_bst_iterator_next(&it1);
+            upo_bst_iterator_next(&it2);
+        }
+    }
+    upo_bst_iterator_destroy(&it1);
+    upo_bst_iterator_destroy(&it2);
+
+    result->root = upo_bst_build_balanced_impl(nodes, n);
+    free(nodes);
+
+    return result;
+}
+
+upo_bst_node_t* upo_bst_build_balanced_impl(upo_bst_node_t **nodes, size_t n)
+{
+    upo_bst_node_t *node = NULL;
+    size_t mid = n / 2;
+
+    if (n == 0)
+        return NULL;
+
+    node = upo_bst_node_create(nodes[mid]->key, nodes[mid]->value);
+    node->left = upo_bst_build_balanced_impl(nodes, mid);
+    node->right = upo_bst_build_balanced_impl(nodes + mid + 1, n - mid - 1);
+
+    return node;
+}
+
+void upo_bst_iterator_init(upo_bst_iterator_t *it, upo_bst_node_t *node)
+{
+    it->stack = NULL;
+    it->size = 0;
+    it->capacity = 0;
+    upo_bst_iterator_push_left(it, node);
+}
+
+void upo_bst_iterator_push_left(upo_bst_iterator_t *it, upo_bst_node_t *node)
+{
+    for (; node != NULL; node = node->left)
+    {
+        if (it->size == it->capacity)
+        {
+            upo_bst_node_t **stack = NULL;
+
+            it->capacity = (it->capacity > 0) ? 2*it->capacity : 16;
+            stack = realloc(it->stack, it->capacity*sizeof(upo_bst_node_t*));
+            if (stack == NULL)
+                upo_throw_sys_error("Unable to allocate memory for the stack of the iterator");
+            it->stack = stack;
+        }
+        it->stack[it->size++] = node;
+    }
+}
+
+upo_bst_node_t* upo_bst_iterator_peek(const upo_bst_iterator_t *it)
+{
+    return (it->size > 0) ? it->stack[it->size - 1] : NULL;
+}
+
+void upo_bst_iterator_next(upo_bst_iterator_t *it)
+{
+    upo_bst_node_t *node = it->stack[--it->size];
+
+    upo_bst_iterator_push_left(it, node->right);
+}
+
+void upo_bst_iterator_destroy(upo_bst_iterator_t *it)
+{
+    free(it->stack);
+    it->stack = NULL;
+    it->size = 0;
+    it->capacity = 0;
+}
+
 /**** END of EXTRA OPERATIONS ****/
 
 upo_bst_comparator_t upo_bst_get_comparator(const upo_bst_t tree)
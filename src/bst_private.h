@@ -47,6 +47,25 @@ struct upo_bst_s
     upo_bst_comparator_t key_cmp; /**< Pointer to the key comparison function. */
 };
 
+/** \brief Set operation flag keeping the keys found only in the first tree. */
+#define UPO_BST_SET_FIRST_ONLY 1U
+
+/** \brief Set operation flag keeping the keys found in both trees. */
+#define UPO_BST_SET_BOTH 2U
+
+/** \brief Set operation flag keeping the keys found only in the second tree. */
+#define UPO_BST_SET_SECOND_ONLY 4U
+
+/** \brief Type for in-order iterators over the nodes of a binary search tree. */
+struct upo_bst_iterator_s
+{
+    upo_bst_node_t **stack; /**< The nodes whose right subtree is still to be visited, the next one on top. */
+    size_t size; /**< The number of nodes in the stack. */
+    size_t capacity; /**< The number of nodes the stack can hold. */
+};
+/** \brief Alias for the type for in-order iterators. */
+typedef struct upo_bst_iterator_s upo_bst_iterator_t;
+
 
 /**
  * \brief Clears the subtree rooted at the given node.
@@ -60,6 +79,31 @@ struct upo_bst_s
  */
 static void upo_bst_clear_impl(upo_bst_node_t*, int destroy_data);
 
+/**
+ * \brief Frees a bounded number of nodes of the given binary search tree, and
+ *  the tree itself once it is empty.
+ *
+ * \param tree The binary search tree (see upo_reclaimer_step_t).
+ * \param destroy_data Tells whether the memory previously allocated for keys
+ *  and values must be freed (value `1`) or not (value `0`).
+ * \param cursor Unused, since the progress is kept in the tree itself.
+ * \param batch The maximum number of nodes to free or rotate.
+ * \return `1` if the tree has been freed, or `0` otherwise.
+ *
+ * While the root has a left child, the child is rotated up; otherwise the
+ * root is freed and replaced by its right child.
+ */
+static int upo_bst_reclaim_step(void *tree, int destroy_data, size_t *cursor, size_t batch);
+
+/**
+ * \brief Frees the given node.
+ *
+ * \param node The node to free.
+ * \param destroy_data Tells whether the memory previously allocated for the key
+ *  and the associated value must be freed (value `1`) or not (value `0`).
+ */
+void upo_bst_destroy_node(upo_bst_node_t *node, int destroy_data);
+
 upo_bst_node_t *upo_bst_get_impl(upo_bst_node_t *, const void *, upo_bst_comparator_t);
 
 upo_bst_node_t *upo_bst_put_impl(upo_bst_node_t *, void *, void *, void *, upo_bst_comparator_t);
@@ -96,4 +140,72 @@ upo_bst_key_list_t upo_bst_keys_range_impl(upo_bst_key_list_t , const void *, co
 
 int upo_bst_is_bst_impl(upo_bst_node_t *, const void *, const void *, upo_bst_comparator_t);
 
+/**
+ * \brief Computes a set operation between two binary search trees.
+ *
+ * \param tree1 The first binary search tree.
+ * \param tree2 The second binary search tree.
+ * \param op The keys to keep, as a combination of UPO_BST_SET_FIRST_ONLY,
+ *  UPO_BST_SET_BOTH and UPO_BST_SET_SECOND_ONLY.
+ * \return A new perfectly balanced binary search tree with the kept keys, or
+ *  `NULL` if both trees are `NULL`.
+ *
+ * A `NULL` tree is read as an empty one, and the result takes the comparison
+ * function of the first tree that is not `NULL`.
+ * Both trees are visited in order at the same time, as in the merge step of
+ * merge sort; a key found in both trees takes the value from the first one.
+ */
+static upo_bst_t upo_bst_set_op_impl(const upo_bst_t tree1, const upo_bst_t tree2, unsigned op);
+
+/**
+ * \brief Builds a perfectly balanced subtree from a sorted array of nodes.
+ *
+ * \param nodes The nodes whose keys and values are copied into new nodes.
+ * \param n The number of nodes.
+ * \return The root of the new subtree.
+ *
+ * The middle node becomes the root, and the two halves its subtrees, so that
+ * the sizes of the subtrees of every node differ by at most one.
+ */
+static upo_bst_node_t* upo_bst_build_balanced_impl(upo_bst_node_t **nodes, size_t n);
+
+/**
+ * \brief Starts an in-order iteration over the given subtree.
+ *
+ * \param it The iterator.
+ * \param node The root of the subtree.
+ */
+static void upo_bst_iterator_init(upo_bst_iterator_t *it, upo_bst_node_t *node);
+
+/**
+ * \brief Pushes the given node and its chain of left children onto the stack
+ *  of the given iterator.
+ *
+ * \param it The iterator.
+ * \param node The node, or `NULL`.
+ */
+static void upo_bst_iterator_push_left(upo_bst_iterator_t *it, upo_bst_node_t *node);
+
+/**
+ * \brief Returns the next node of an in-order iteration without advancing it.
+ *
+ * \param it The iterator.
+ * \return The next node, or `NULL` if the iteration is over.
+ */
+static upo_bst_node_t* upo_bst_iterator_peek(const upo_bst_iterator_t *it);
+
+/**
+ * \brief Advances an in-order iteration past its next node.
+ *
+ * \param it The iterator, whose iteration must not be over.
+ */
+static void upo_bst_iterator_next(upo_bst_iterator_t *it);
+
+/**
+ * \brief Frees the memory used by the given iterator.
+ *
+ * \param it The iterator.
+ */
+static void upo_bst_iterator_destroy(upo_bst_iterator_t *it);
+
 #endif /* UPO_BST_PRIVATE_H */
@@ -0,0 +1,406 @@
+/*
+ * Copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ * This file is part of UPOalglib.
+ *
+ * UPOalglib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * UPOalglib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include <upo/error.h>
+#include "cache_private.h"
+
+
+/*** BEGIN of FUNDAMENTAL OPERATIONS ***/
+
+
+upo_cache_t upo_cache_create(size_t capacity, upo_ht_hasher_t key_hash, upo_ht_comparator_t key_cmp)
+{
+    upo_cache_t cache = NULL;
+    size_t i = 0;
+
+    /* preconditions */
+    assert( capacity > 0 );
+    assert( key_hash != NULL );
+    assert( key_cmp != NULL );
+
+    cache = malloc(sizeof(struct upo_cache_s));
+    if (cache == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for Concurrent Cache");
+    }
+
+    cache->num_slots = 1;
+    while (cache->num_slots < capacity)
+        cache->num_slots *= 2;
+
+    cache->slots = malloc(cache->num_slots*sizeof(_Atomic(upo_cache_entry_t*)));
+    cache->entries = malloc(capacity*sizeof(upo_cache_entry_t));
+    if (cache->slots == NULL || cache->entries == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for entries of the Concurrent Cache");
+    }
+
+    for (i = 0; i < cache->num_slots; ++i)
+    {
+        atomic_init(&cache->slots[i], NULL);
+    }
+    for (i = 0; i < capacity; ++i)
+    {
+        atomic_init(&cache->entries[i].seq, 0);
+        atomic_init(&cache->entries[i].hash, 0);
+        atomic_init(&cache->entries[i].key, NULL);
+        atomic_init(&cache->entries[i].value, NULL);
+        atomic_init(&cache->entries[i].next, NULL);
+        atomic_init(&cache->entries[i].freq, 0);
+        cache->entries[i].slot = 0;
+        cache->entries[i].free_next = NULL;
+    }
+
+    if (pthread_mutex_init(&cache->lock, NULL) != 0)
+    {
+        upo_throw_sys_error("Unable to initialize the lock of the Concurrent Cache");
+    }
+
+    cache->capacity = capacity;
+    cache->used = 0;
+    cache->free = NULL;
+    cache->hand = 0;
+    atomic_init(&cache->size, 0);
+    cache->key_hash = key_hash;
+    cache->key_cmp = key_cmp;
+    cache->evict = NULL;
+    cache->evict_arg = NULL;
+
+    return cache;
+}
+
+void upo_cache_destroy(upo_cache_t cache, int destroy_data)
+{
+    if (cache != NULL)
+    {
+        upo_cache_clear(cache, destroy_data);
+        pthread_mutex_destroy(&cache->lock);
+        free(cache->entries);
+        free(cache->slots);
+        free(cache);
+    }
+}
+
+void upo_cache_clear(upo_cache_t cache, int destroy_data)
+{
+    if (cache != NULL)
+    {
+        size_t i = 0;
+
+        pthread_mutex_lock(&cache->lock);
+
+        /* Unlink all entries first, so that lookups stop finding them */
+        for (i = 0; i < cache->num_slots; ++i)
+        {
+            atomic_store_explicit(&cache->slots[i], NULL, memory_order_release);
+        }
+        for (i = 0; i < cache->used; ++i)
+        {
+            upo_cache_entry_t *entry = &cache->entries[i];
+
+            if (destroy_data && atomic_load_explicit(&entry->key, memory_order_relaxed) != NULL)
+            {
+                free(atomic_load_explicit(&entry->key, memory_order_relaxed));
+                free(atomic_load_explicit(&entry->value, memory_order_relaxed));
+            }
+            upo_cache_write(entry, 0, NULL, NULL);
+            atomic_store_explicit(&entry->freq, 0, memory_order_relaxed);
+            entry->free_next = NULL;
+        }
+
+        cache->used = 0;
+        cache->free = NULL;
+        cache->hand = 0;
+        atomic_store_explicit(&cache->size, 0, memory_order_relaxed);
+
+        pthread_mutex_unlock(&cache->lock);
+    }
+}
+
+void* upo_cache_put(upo_cache_t cache, void *key, void *value)
+{
+    uint64_t hash = 0;
+    size_t slot = 0;
+    upo_cache_entry_t *entry = NULL;
+    void *old_value = NULL;
+
+    /* preconditions */
+    assert( cache != NULL );
+    assert( key != NULL );
+
+    hash = upo_ht_hash_wide(cache->key_hash, key);
+    slot = (size_t) hash & (cache->num_slots - 1);
+
+    pthread_mutex_lock(&cache->lock);
+
+    entry = atomic_load_explicit(upo_cache_find(cache, slot, key, hash), memory_order_relaxed);
+    if (entry != NULL) // Change the value and put the old one in old_value
+    {
+        /* Note: the stored key is kept, as the given one may be freed */
+        old_value = atomic_load_explicit(&entry->value, memory_order_relaxed);
+        upo_cache_write(entry, hash, atomic_load_explicit(&entry->key, memory_order_relaxed), value);
+    }
+    else
+    {
+        /* Note: eviction may change the list of collisions, so the new entry
+         * goes to its head */
+        entry = upo_cache_acquire(cache);
+        upo_cache_write(entry, hash, key, value);
+        atomic_store_explicit(&entry->freq, 0, memory_order_relaxed);
+        entry->slot = slot;
+        atomic_store_explicit(&entry->next, atomic_load_explicit(&cache->slots[slot], memory_order_relaxed), memory_order_relaxed);
+
+        /* Publish the entry after it has been completely written */
+        atomic_store_explicit(&cache->slots[slot], entry, memory_order_release);
+        atomic_fetch_add_explicit(&cache->size, 1, memory_order_relaxed);
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+
+    return old_value;
+}
+
+void* upo_cache_get(const upo_cache_t cache, const void *key)
+{
+    void *value = NULL;
+
+    if (cache == NULL)
+        return NULL;
+
+    return upo_cache_lookup(cache, key, 1, &value) ? value : NULL;
+}
+
+int upo_cache_contains(const upo_cache_t cache, const void *key)
+{
+    void *value = NULL;
+
+    if (cache == NULL)
+        return 0;
+
+    return upo_cache_lookup(cache, key, 0, &value);
+}
+
+void upo_cache_delete(upo_cache_t cache, const void *key, int destroy_data)
+{
+    uint64_t hash = 0;
+    _Atomic(upo_cache_entry_t*) *link = NULL;
+    upo_cache_entry_t *entry = NULL;
+
+    if (cache == NULL)
+        return;
+
+    hash = upo_ht_hash_wide(cache->key_hash, key);
+
+    pthread_mutex_lock(&cache->lock);
+
+    link = upo_cache_find(cache, (size_t) hash & (cache->num_slots - 1), key, hash);
+    entry = atomic_load_explicit(link, memory_order_relaxed);
+    if (entry != NULL)
+    {
+        atomic_store_explicit(link, atomic_load_explicit(&entry->next, memory_order_relaxed), memory_order_release);
+
+        if (destroy_data)
+        {
+            free(atomic_load_explicit(&entry->key, memory_order_relaxed));
+            free(atomic_load_explicit(&entry->value, memory_order_relaxed));
+        }
+        upo_cache_write(entry, 0, NULL, NULL);
+
+        entry->free_next = cache->free;
+        cache->free = entry;
+        atomic_fetch_sub_explicit(&cache->size, 1, memory_order_relaxed);
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+}
+
+void upo_cache_set_evictor(upo_cache_t cache, upo_cache_evictor_t evict, void *evict_arg)
+{
+    if (cache != NULL)
+    {
+        pthread_mutex_lock(&cache->lock);
+        cache->evict = evict;
+        cache->evict_arg = evict_arg;
+        pthread_mutex_unlock(&cache->lock);
+    }
+}
+
+size_t upo_cache_size(const upo_cache_t cache)
+{
+    return (cache != NULL) ? atomic_load_explicit(&cache->size, memory_order_relaxed) : 0;
+}
+
+int upo_cache_is_empty(const upo_cache_t cache)
+{
+    return upo_cache_size(cache) == 0 ? 1 : 0;
+}
+
+size_t upo_cache_capacity(const upo_cache_t cache)
+{
+    return (cache != NULL) ? cache->capacity : 0;
+}
+
+upo_ht_comparator_t upo_cache_get_comparator(const upo_cache_t cache)
+{
+    return cache->key_cmp;
+}
+
+upo_ht_hasher_t upo_cache_get_hasher(const upo_cache_t cache)
+{
+    return cache->key_hash;
+}
+
+int upo_cache_lookup(const upo_cache_t cache, const void *key, int use, void **value)
+{
+    uint64_t hash = upo_ht_hash_wide(cache->key_hash, key);
+    _Atomic(upo_cache_entry_t*) *head = &cache->slots[(size_t) hash & (cache->num_slots - 1)];
+    upo_cache_entry_t *entry = NULL;
+    size_t steps = 0;
+
+retry:
+    steps = 0;
+    for (entry = atomic_load_explicit(head, memory_order_acquire);
+         entry != NULL;
+         entry = atomic_load_explicit(&entry->next, memory_order_acquire))
+    {
+        unsigned seq = atomic_load_explicit(&entry->seq, memory_order_acquire);
+        uint64_t entry_hash = 0;
+        void *entry_key = NULL;
+        void *entry_value = NULL;
+
+        /* Give up on scans that wandered through reused entries */
+        if (++steps > cache->capacity)
+            goto retry;
+
+        if (seq % 2 != 0) // Being written
+            goto retry;
+
+        entry_hash = atomic_load_explicit(&entry->hash, memory_order_relaxed);
+        entry_key = atomic_load_explicit(&entry->key, memory_order_relaxed);
+        entry_value = atomic_load_explicit(&entry->value, memory_order_relaxed);
+
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&entry->seq, memory_order_relaxed) != seq) // Changed while reading
+            goto retry;
+
+        if (entry_key != NULL && entry_hash == hash && cache->key_cmp(key, entry_key) == 0)
+        {
+            if (use)
+            {
+                unsigned freq = atomic_load_explicit(&entry->freq, memory_order_relaxed);
+
+                /* A single attempt: losing a concurrent increment is harmless */
+                if (freq < UPO_CACHE_MAX_FREQ)
+                    atomic_compare_exchange_weak_explicit(&entry->freq, &freq, freq + 1, memory_order_relaxed, memory_order_relaxed);
+            }
+
+            *value = entry_value;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+_Atomic(upo_cache_entry_t*)* upo_cache_find(const upo_cache_t cache, size_t slot, const void *key, uint64_t hash)
+{
+    _Atomic(upo_cache_entry_t*) *link = &cache->slots[slot];
+    upo_cache_entry_t *entry = NULL;
+
+    while ((entry = atomic_load_explicit(link, memory_order_relaxed)) != NULL)
+    {
+        if (atomic_load_explicit(&entry->hash, memory_order_relaxed) == hash
+            && cache->key_cmp(key, atomic_load_explicit(&entry->key, memory_order_relaxed)) == 0)
+            break;
+
+        link = &entry->next;
+    }
+
+    return link;
+}
+
+void upo_cache_unlink(upo_cache_t cache, upo_cache_entry_t *entry)
+{
+    _Atomic(upo_cache_entry_t*) *link = &cache->slots[entry->slot];
+
+    while (atomic_load_explicit(link, memory_order_relaxed) != entry)
+        link = &atomic_load_explicit(link, memory_order_relaxed)->next;
+
+    atomic_store_explicit(link, atomic_load_explicit(&entry->next, memory_order_relaxed), memory_order_release);
+}
+
+void upo_cache_write(upo_cache_entry_t *entry, uint64_t hash, void *key, void *value)
+{
+    unsigned seq = atomic_load_explicit(&entry->seq, memory_order_relaxed);
+
+    atomic_store_explicit(&entry->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    atomic_store_explicit(&entry->hash, hash, memory_order_relaxed);
+    atomic_store_explicit(&entry->key, key, memory_order_relaxed);
+    atomic_store_explicit(&entry->value, value, memory_order_relaxed);
+
+    atomic_store_explicit(&entry->seq, seq + 2, memory_order_release);
+}
+
+upo_cache_entry_t* upo_cache_acquire(upo_cache_t cache)
+{
+    upo_cache_entry_t *entry = NULL;
+    size_t steps = 0;
+
+    if (cache->free != NULL)
+    {
+        entry = cache->free;
+        cache->free = entry->free_next;
+        return entry;
+    }
+
+    if (cache->used < cache->capacity)
+        return &cache->entries[cache->used++];
+
+    /* All entries are in use: sweep them with the clock hand, sparing (and
+     * aging) the ones used since the last sweep.
+     * Since lookups keep incrementing counters, give up sparing entries after
+     * as many sweeps as needed to age the most used ones. */
+    for (;;)
+    {
+        entry = &cache->entries[cache->hand];
+        cache->hand = (cache->hand + 1) % cache->capacity;
+
+        if (atomic_load_explicit(&entry->freq, memory_order_relaxed) == 0 || ++steps > (UPO_CACHE_MAX_FREQ + 1)*cache->capacity)
+            break;
+
+        /* Note: lookups only increment counters, so this never underflows */
+        atomic_fetch_sub_explicit(&entry->freq, 1, memory_order_relaxed);
+    }
+
+    upo_cache_unlink(cache, entry);
+    if (cache->evict != NULL)
+        cache->evict(atomic_load_explicit(&entry->key, memory_order_relaxed), atomic_load_explicit(&entry->value, memory_order_relaxed), cache->evict_arg);
+    atomic_fetch_sub_explicit(&cache->size, 1, memory_order_relaxed);
+
+    return entry;
+}
+
+
+/*** END of FUNDAMENTAL OPERATIONS ***/
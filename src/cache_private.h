@@ -0,0 +1,131 @@
+/**
+ * \file src/cache_private.h
+ *
+ * \brief Private header for the Concurrent Cache abstract data type.
+ *
+ * \copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ *  This file is part of UPOalglib.
+ *
+ *  UPOalglib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  UPOalglib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UPO_CACHE_PRIVATE_H
+#define UPO_CACHE_PRIVATE_H
+
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <upo/cache.h>
+
+
+/** \brief Type for entries of concurrent caches. */
+struct upo_cache_entry_s
+{
+    atomic_uint seq; /**< The sequence number of the entry, which is odd while the entry is being written. */
+    _Atomic uint64_t hash; /**< The hash value of the key. */
+    _Atomic(void*) key; /**< Pointer to the user-provided key, or `NULL` for unused entries. */
+    _Atomic(void*) value; /**< Pointer to the value associated to the key. */
+    _Atomic(struct upo_cache_entry_s*) next; /**< Pointer to the next entry in the list of collisions. */
+    atomic_uint freq; /**< The frequency counter, from `0` to UPO_CACHE_MAX_FREQ. */
+    size_t slot; /**< The slot whose list of collisions holds this entry (only accessed with the lock held). */
+    struct upo_cache_entry_s *free_next; /**< Pointer to the next entry in the list of free entries (only accessed with the lock held). */
+};
+/** \brief Alias for the type for entries of concurrent caches. */
+typedef struct upo_cache_entry_s upo_cache_entry_t;
+
+/** \brief Type for concurrent caches. */
+struct upo_cache_s
+{
+    _Atomic(upo_cache_entry_t*) *slots; /**< The heads of the lists of collisions. */
+    size_t num_slots; /**< The number of slots (a power of two). */
+    upo_cache_entry_t *entries; /**< The array of all entries. */
+    size_t capacity; /**< The number of entries. */
+    size_t used; /**< The number of entries ever used (the other ones have never been linked). */
+    upo_cache_entry_t *free; /**< The list of entries of removed keys. */
+    size_t hand; /**< The position of the clock hand in the array of entries. */
+    atomic_size_t size; /**< The number of stored key-value pairs. */
+    pthread_mutex_t lock; /**< The lock serializing updates. */
+    upo_ht_hasher_t key_hash; /**< The key hash function. */
+    upo_ht_comparator_t key_cmp; /**< The key comparison function. */
+    upo_cache_evictor_t evict; /**< The eviction function, or `NULL`. */
+    void *evict_arg; /**< The additional parameter of the eviction function. */
+};
+
+
+/**
+ * \brief Searches for the given key without taking the lock.
+ *
+ * \param cache The cache.
+ * \param key The key to search for.
+ * \param use Tells whether to increment the frequency counter of the entry of
+ *  the key, if found.
+ * \param value Set to the value associated to the key, if found.
+ * \return `1` if the key is found, or `0` otherwise.
+ *
+ * Each entry is read between two loads of its sequence number, and the read
+ * is retried if the sequence number is odd or has changed in between.
+ * If an entry is reused while being scanned, the scan may continue in another
+ * list of collisions and end without finding the key.
+ */
+static int upo_cache_lookup(const upo_cache_t cache, const void *key, int use, void **value);
+
+/**
+ * \brief Searches for the given key with the lock held.
+ *
+ * \param cache The cache.
+ * \param slot The slot of the key.
+ * \param key The key to search for.
+ * \param hash The hash value of the key.
+ * \return The link (i.e., the head of the list of collisions or the `next`
+ *  field of an entry) pointing to the entry of the key, or to `NULL` if the
+ *  key is not found.
+ */
+static _Atomic(upo_cache_entry_t*)* upo_cache_find(const upo_cache_t cache, size_t slot, const void *key, uint64_t hash);
+
+/**
+ * \brief Unlinks the given entry from its list of collisions, with the lock
+ *  held.
+ *
+ * \param cache The cache.
+ * \param entry The entry.
+ *
+ * The `next` field of the entry is kept, so that concurrent lookups standing
+ * on the entry can go on scanning the list.
+ */
+static void upo_cache_unlink(upo_cache_t cache, upo_cache_entry_t *entry);
+
+/**
+ * \brief Writes the given fields into the given entry, as a writer of its
+ *  sequence lock.
+ *
+ * \param entry The entry.
+ * \param hash The hash value of the key.
+ * \param key The key.
+ * \param value The value.
+ */
+static void upo_cache_write(upo_cache_entry_t *entry, uint64_t hash, void *key, void *value);
+
+/**
+ * \brief Returns an entry to store a new key, with the lock held.
+ *
+ * \param cache The cache.
+ * \return An unlinked entry, which is either free or the one just evicted by
+ *  the clock hand.
+ */
+static upo_cache_entry_t* upo_cache_acquire(upo_cache_t cache);
+
+
+#endif /* UPO_CACHE_PRIVATE_H */
@@ -0,0 +1,393 @@
+/*
+ * Copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ * This file is part of UPOalglib.
+ *
+ * UPOalglib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * UPOalglib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <upo/error.h>
+#include "cms_private.h"
+
+
+/*** BEGIN of FUNDAMENTAL OPERATIONS ***/
+
+
+upo_cms_t upo_cms_create(size_t width, size_t depth, upo_ht_hasher_t key_hash)
+{
+    upo_cms_t cms = NULL;
+
+    /* preconditions */
+    assert( width > 0 );
+    assert( depth > 0 );
+    assert( key_hash != NULL );
+
+    cms = malloc(sizeof(struct upo_cms_s));
+    if (cms == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for Count-Min Sketch");
+    }
+    cms->counters = calloc(width*depth, sizeof(uint64_t));
+    if (cms->counters == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for the counters of the Count-Min Sketch");
+    }
+    cms->width = width;
+    cms->depth = depth;
+    cms->total = 0;
+    cms->key_hash = key_hash;
+
+    return cms;
+}
+
+upo_cms_t upo_cms_create_with_error(double epsilon, double delta, upo_ht_hasher_t key_hash)
+{
+    /* preconditions */
+    assert( epsilon > 0 && epsilon < 1 );
+    assert( delta > 0 && delta < 1 );
+
+    return upo_cms_create((size_t) ceil(exp(1) / epsilon), (size_t) ceil(log(1 / delta)), key_hash);
+}
+
+void upo_cms_destroy(upo_cms_t cms)
+{
+    if (cms != NULL)
+    {
+        free(cms->counters);
+        free(cms);
+    }
+}
+
+void upo_cms_clear(upo_cms_t cms)
+{
+    /* preconditions */
+    assert( cms != NULL );
+
+    memset(cms->counters, 0, cms->width*cms->depth*sizeof(uint64_t));
+    cms->total = 0;
+}
+
+uint64_t upo_cms_add(upo_cms_t cms, const void *key, uint64_t count)
+{
+    uint64_t hash = 0;
+    uint64_t estimate = UINT64_MAX;
+    uint64_t *counter = NULL;
+    size_t i = 0;
+
+    /* preconditions */
+    assert( cms != NULL );
+
+    hash = upo_ht_hash_wide(cms->key_hash, key);
+    for (i = 0; i < cms->depth; ++i)
+    {
+        counter = upo_cms_counter(cms, hash, i);
+        if (*counter < estimate)
+            estimate = *counter;
+    }
+
+    /* Conservative update: no counter needs to go beyond the new estimate */
+    estimate += count;
+    for (i = 0; i < cms->depth; ++i)
+    {
+        counter = upo_cms_counter(cms, hash, i);
+        if (*counter < estimate)
+            *counter = estimate;
+    }
+    cms->total += count;
+
+    return estimate;
+}
+
+uint64_t upo_cms_estimate(const upo_cms_t cms, const void *key)
+{
+    uint64_t hash = 0;
+    uint64_t estimate = UINT64_MAX;
+    uint64_t *counter = NULL;
+    size_t i = 0;
+
+    if (cms == NULL)
+        return 0;
+
+    hash = upo_ht_hash_wide(cms->key_hash, key);
+    for (i = 0; i < cms->depth; ++i)
+    {
+        counter = upo_cms_counter(cms, hash, i);
+        if (*counter < estimate)
+            estimate = *counter;
+    }
+
+    return estimate;
+}
+
+int upo_cms_merge(upo_cms_t cms, const upo_cms_t other)
+{
+    size_t i = 0;
+
+    /* preconditions */
+    assert( cms != NULL );
+    assert( other != NULL );
+
+    if (cms->width != other->width || cms->depth != other->depth || cms->key_hash != other->key_hash)
+        return 0;
+
+    for (i = 0; i < cms->width*cms->depth; ++i)
+    {
+        cms->counters[i] += other->counters[i];
+    }
+    cms->total += other->total;
+
+    return 1;
+}
+
+upo_cms_topk_t upo_cms_topk_create(size_t k, size_t width, size_t depth, upo_ht_hasher_t key_hash, upo_ht_comparator_t key_cmp)
+{
+    upo_cms_topk_t topk = NULL;
+
+    /* preconditions */
+    assert( k > 0 );
+    assert( key_cmp != NULL );
+
+    topk = malloc(sizeof(struct upo_cms_topk_s));
+    if (topk == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for Heavy Hitters");
+    }
+    topk->nodes = malloc(k*sizeof(upo_cms_topk_node_t));
+    topk->heap = malloc(k*sizeof(upo_cms_topk_node_t*));
+    if (topk->nodes == NULL || topk->heap == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for the heap of the Heavy Hitters");
+    }
+    topk->sketch = upo_cms_create(width, depth, key_hash);
+    topk->index = upo_ht_linprob_create(2*k, key_hash, key_cmp);
+    topk->k = k;
+    topk->size = 0;
+
+    return topk;
+}
+
+void upo_cms_topk_destroy(upo_cms_topk_t topk)
+{
+    if (topk != NULL)
+    {
+        upo_ht_linprob_destroy(topk->index, 0);
+        upo_cms_destroy(topk->sketch);
+        free(topk->heap);
+        free(topk->nodes);
+        free(topk);
+    }
+}
+
+uint64_t upo_cms_topk_add(upo_cms_topk_t topk, void *key, uint64_t count)
+{
+    uint64_t estimate = 0;
+
+    /* preconditions */
+    assert( topk != NULL );
+
+    estimate = upo_cms_add(topk->sketch, key, count);
+    upo_cms_topk_offer(topk, key, estimate);
+
+    return estimate;
+}
+
+size_t upo_cms_topk_items(const upo_cms_topk_t topk, void **keys, uint64_t *counts)
+{
+    upo_cms_topk_node_t **nodes = NULL;
+    upo_cms_topk_node_t *node = NULL;
+    size_t i = 0;
+    size_t j = 0;
+
+    /* preconditions */
+    assert( topk != NULL );
+    assert( keys != NULL );
+
+    nodes = malloc((topk->size > 0 ? topk->size : 1)*sizeof(upo_cms_topk_node_t*));
+    if (nodes == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for the items of the Heavy Hitters");
+    }
+
+    /* Insertion sort of the heap by decreasing estimate */
+    for (i = 0; i < topk->size; ++i)
+    {
+        node = topk->heap[i];
+        for (j = i; j > 0 && nodes[j-1]->count < node->count; --j)
+        {
+            nodes[j] = nodes[j-1];
+        }
+        nodes[j] = node;
+    }
+    for (i = 0; i < topk->size; ++i)
+    {
+        keys[i] = nodes[i]->key;
+        if (counts != NULL)
+            counts[i] = nodes[i]->count;
+    }
+    free(nodes);
+
+    return topk->size;
+}
+
+int upo_cms_topk_merge(upo_cms_topk_t topk, const upo_cms_topk_t other)
+{
+    size_t i = 0;
+
+    /* preconditions */
+    assert( topk != NULL );
+    assert( other != NULL );
+    assert( topk != other );
+
+    if (!upo_cms_merge(topk->sketch, other->sketch))
+        return 0;
+
+    /* The estimates of the tracked keys can only have grown */
+    for (i = 0; i < topk->size; ++i)
+    {
+        topk->heap[i]->count = upo_cms_estimate(topk->sketch, topk->heap[i]->key);
+    }
+    for (i = topk->size / 2; i > 0; --i)
+    {
+        upo_cms_topk_sift_down(topk, i - 1);
+    }
+
+    for (i = 0; i < other->size; ++i)
+    {
+        upo_cms_topk_offer(topk, other->heap[i]->key, upo_cms_estimate(topk->sketch, other->heap[i]->key));
+    }
+
+    return 1;
+}
+
+uint64_t* upo_cms_counter(const upo_cms_t cms, uint64_t hash, size_t row)
+{
+    uint64_t h1 = hash & UINT64_C(0xFFFFFFFF);
+    uint64_t h2 = (hash >> 32) | 1U;
+
+    return cms->counters + row*cms->width + (size_t) ((h1 + row*h2) % cms->width);
+}
+
+void upo_cms_topk_offer(upo_cms_topk_t topk, void *key, uint64_t count)
+{
+    upo_cms_topk_node_t *node = NULL;
+
+    node = upo_ht_linprob_get(topk->index, key);
+    if (node != NULL)
+    {
+        node->count = count;
+        upo_cms_topk_sift_down(topk, node->pos);
+        upo_cms_topk_sift_up(topk, node->pos);
+        return;
+    }
+
+    if (topk->size < topk->k)
+    {
+        node = &topk->nodes[topk->size];
+        node->pos = topk->size;
+        topk->heap[topk->size++] = node;
+    }
+    else if (count > topk->heap[0]->count)
+    {
+        /* Replace the tracked key with the least estimate */
+        node = topk->heap[0];
+        upo_ht_linprob_delete(topk->index, node->key, 0);
+    }
+    else
+    {
+        return;
+    }
+
+    node->key = key;
+    node->count = count;
+    upo_ht_linprob_put(topk->index, key, node);
+    upo_cms_topk_sift_down(topk, node->pos);
+    upo_cms_topk_sift_up(topk, node->pos);
+}
+
+void upo_cms_topk_sift_up(upo_cms_topk_t topk, size_t pos)
+{
+    while (pos > 0 && topk->heap[pos]->count < topk->heap[(pos - 1) / 2]->count)
+    {
+        upo_cms_topk_swap(topk, pos, (pos - 1) / 2);
+        pos = (pos - 1) / 2;
+    }
+}
+
+void upo_cms_topk_sift_down(upo_cms_topk_t topk, size_t pos)
+{
+    size_t child = 0;
+
+    while ((child = 2*pos + 1) < topk->size)
+    {
+        if (child + 1 < topk->size && topk->heap[child + 1]->count < topk->heap[child]->count)
+            ++child;
+        if (topk->heap[pos]->count <= topk->heap[child]->count)
+            break;
+        upo_cms_topk_swap(topk, pos, child);
+        pos = child;
+    }
+}
+
+void upo_cms_topk_swap(upo_cms_topk_t topk, size_t i, size_t j)
+{
+    upo_cms_topk_node_t *node = topk->heap[i];
+
+    topk->heap[i] = topk->heap[j];
+    topk->heap[j] = node;
+    topk->heap[i]->pos = i;
+    topk->heap[j]->pos = j;
+}
+
+
+/*** END of FUNDAMENTAL OPERATIONS ***/
+
+
+/*** BEGIN of EXTRA OPERATIONS ***/
+
+
+uint64_t upo_cms_total(const upo_cms_t cms)
+{
+    return (cms != NULL) ? cms->total : 0;
+}
+
+size_t upo_cms_width(const upo_cms_t cms)
+{
+    return (cms != NULL) ? cms->width : 0;
+}
+
+size_t upo_cms_depth(const upo_cms_t cms)
+{
+    return (cms != NULL) ? cms->depth : 0;
+}
+
+upo_cms_t upo_cms_topk_sketch(const upo_cms_topk_t topk)
+{
+    /* preconditions */
+    assert( topk != NULL );
+
+    return topk->sketch;
+}
+
+size_t upo_cms_topk_size(const upo_cms_topk_t topk)
+{
+    return (topk != NULL) ? topk->size : 0;
+}
+
+
+/*** END of EXTRA OPERATIONS ***/
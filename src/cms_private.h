@@ -0,0 +1,115 @@
+/**
+ * \file src/cms_private.h
+ *
+ * \brief Private header for the Count-Min Sketch abstract data type.
+ *
+ * \copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ *  This file is part of UPOalglib.
+ *
+ *  UPOalglib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  UPOalglib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UPO_CMS_PRIVATE_H
+#define UPO_CMS_PRIVATE_H
+
+
+#include <stdint.h>
+#include <upo/cms.h>
+#include <upo/hashtable.h>
+
+
+/** \brief Type for count-min sketches. */
+struct upo_cms_s
+{
+    uint64_t *counters; /**< The counters, row by row. */
+    size_t width; /**< The number of counters of each row. */
+    size_t depth; /**< The number of rows. */
+    uint64_t total; /**< The sum of the added counts. */
+    upo_ht_hasher_t key_hash; /**< The key hash function. */
+};
+
+/** \brief Type for keys tracked by heavy hitters structures. */
+struct upo_cms_topk_node_s
+{
+    void *key; /**< Pointer to the user-provided key. */
+    uint64_t count; /**< The estimate of the count of the key. */
+    size_t pos; /**< The position of the node in the heap. */
+};
+/** \brief Alias for the type for keys tracked by heavy hitters structures. */
+typedef struct upo_cms_topk_node_s upo_cms_topk_node_t;
+
+/** \brief Type for heavy hitters structures. */
+struct upo_cms_topk_s
+{
+    upo_cms_t sketch; /**< The count-min sketch. */
+    upo_cms_topk_node_t *nodes; /**< The `k` preallocated nodes. */
+    upo_cms_topk_node_t **heap; /**< The min-heap of the tracked nodes, by estimate. */
+    size_t k; /**< The maximum number of tracked keys. */
+    size_t size; /**< The number of tracked keys. */
+    upo_ht_linprob_t index; /**< The index, mapping tracked keys to their nodes. */
+};
+
+
+/**
+ * \brief Returns the counter of the given key in the given row.
+ *
+ * \param cms The sketch.
+ * \param hash The hash value of the key.
+ * \param row The row.
+ * \return A pointer to the counter.
+ *
+ * The counter of row `i` is \f$(h_1 + i h_2) \bmod width\f$, where \f$h_1\f$
+ * and \f$h_2\f$ are the lower and upper 32 bits of the hash value (the latter
+ * made odd).
+ */
+static uint64_t* upo_cms_counter(const upo_cms_t cms, uint64_t hash, size_t row);
+
+/**
+ * \brief Makes the given key tracked with the given estimate, if the estimate
+ *  is among the `k` largest ones.
+ *
+ * \param topk The heavy hitters structure.
+ * \param key The key.
+ * \param count The estimate of the count of the key.
+ */
+static void upo_cms_topk_offer(upo_cms_topk_t topk, void *key, uint64_t count);
+
+/**
+ * \brief Moves the given node of the heap up to its place.
+ *
+ * \param topk The heavy hitters structure.
+ * \param pos The position of the node.
+ */
+static void upo_cms_topk_sift_up(upo_cms_topk_t topk, size_t pos);
+
+/**
+ * \brief Moves the given node of the heap down to its place.
+ *
+ * \param topk The heavy hitters structure.
+ * \param pos The position of the node.
+ */
+static void upo_cms_topk_sift_down(upo_cms_topk_t topk, size_t pos);
+
+/**
+ * \brief Swaps the given nodes of the heap.
+ *
+ * \param topk The heavy hitters structure.
+ * \param i The position of the first node.
+ * \param j The position of the second node.
+ */
+static void upo_cms_topk_swap(upo_cms_topk_t topk, size_t i, size_t j);
+
+
+#endif /* UPO_CMS_PRIVATE_H */
@@ -0,0 +1,530 @@
+/*
+ * Copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ * This file is part of UPOalglib.
+ *
+ * UPOalglib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * UPOalglib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <upo/error.h>
+#include "hamt_private.h"
+
+
+/*** BEGIN of FUNDAMENTAL OPERATIONS ***/
+
+
+upo_hamt_t upo_hamt_create(upo_ht_hasher_t key_hash, upo_ht_comparator_t key_cmp)
+{
+    upo_hamt_t hamt = NULL;
+
+    /* preconditions */
+    assert( key_hash != NULL );
+    assert( key_cmp != NULL );
+
+    hamt = malloc(sizeof(struct upo_hamt_s));
+    if (hamt == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for Hash Array Mapped Trie");
+    }
+    hamt->root = NULL;
+    hamt->size = 0;
+    hamt->key_hash = key_hash;
+    hamt->key_cmp = key_cmp;
+
+    return hamt;
+}
+
+void upo_hamt_destroy(upo_hamt_t hamt)
+{
+    if (hamt != NULL)
+    {
+        upo_hamt_node_release(hamt->root);
+        free(hamt);
+    }
+}
+
+upo_hamt_t upo_hamt_snapshot(const upo_hamt_t hamt)
+{
+    upo_hamt_t snapshot = NULL;
+
+    /* preconditions */
+    assert( hamt != NULL );
+
+    snapshot = malloc(sizeof(struct upo_hamt_s));
+    if (snapshot == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for Hash Array Mapped Trie");
+    }
+    *snapshot = *hamt;
+    if (snapshot->root != NULL)
+    {
+        atomic_fetch_add_explicit(&snapshot->root->refs, 1, memory_order_relaxed);
+    }
+
+    return snapshot;
+}
+
+void* upo_hamt_put(upo_hamt_t hamt, void *key, void *value)
+{
+    upo_hamt_entry_t entry;
+    upo_hamt_node_t *root = NULL;
+    void *old_value = NULL;
+    int found = 0;
+
+    /* preconditions */
+    assert( hamt != NULL );
+
+    entry.child = NULL;
+    entry.key = key;
+    entry.value = value;
+    entry.hash = upo_ht_hash_wide(hamt->key_hash, key);
+
+    root = upo_hamt_node_put(hamt, hamt->root, &entry, 0, &old_value, &found);
+    upo_hamt_node_release(hamt->root);
+    hamt->root = root;
+    if (!found)
+    {
+        ++hamt->size;
+    }
+
+    return old_value;
+}
+
+void* upo_hamt_get(const upo_hamt_t hamt, const void *key)
+{
+    const upo_hamt_entry_t *entry = upo_hamt_find(hamt, key);
+
+    return (entry != NULL) ? entry->value : NULL;
+}
+
+int upo_hamt_contains(const upo_hamt_t hamt, const void *key)
+{
+    return upo_hamt_find(hamt, key) != NULL;
+}
+
+int upo_hamt_delete(upo_hamt_t hamt, const void *key)
+{
+    upo_hamt_node_t *root = NULL;
+    int found = 0;
+
+    /* preconditions */
+    assert( hamt != NULL );
+
+    if (hamt->root == NULL)
+        return 0;
+
+    root = upo_hamt_node_delete(hamt, hamt->root, key, upo_ht_hash_wide(hamt->key_hash, key), 0, &found);
+    if (!found)
+        return 0;
+
+    upo_hamt_node_release(hamt->root);
+    hamt->root = root;
+    --hamt->size;
+
+    return 1;
+}
+
+size_t upo_hamt_size(const upo_hamt_t hamt)
+{
+    return (hamt != NULL) ? hamt->size : 0;
+}
+
+int upo_hamt_is_empty(const upo_hamt_t hamt)
+{
+    return upo_hamt_size(hamt) == 0;
+}
+
+unsigned upo_hamt_popcount(uint32_t x)
+{
+    x = x - ((x >> 1) & 0x55555555U);
+    x = (x & 0x33333333U) + ((x >> 2) & 0x33333333U);
+    x = (x + (x >> 4)) & 0x0F0F0F0FU;
+
+    return (unsigned) ((x * 0x01010101U) >> 24);
+}
+
+uint32_t upo_hamt_bit(uint64_t hash, unsigned shift)
+{
+    return ((uint32_t) 1) << ((hash >> shift) & UPO_HAMT_MASK);
+}
+
+unsigned upo_hamt_position(const upo_hamt_node_t *node, uint32_t bit)
+{
+    return upo_hamt_popcount(node->bitmap & (bit - 1));
+}
+
+upo_hamt_node_t* upo_hamt_node_create(uint32_t bitmap, unsigned size)
+{
+    upo_hamt_node_t *node = NULL;
+
+    node = malloc(sizeof(upo_hamt_node_t) + size*sizeof(upo_hamt_entry_t));
+    if (node == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for a new node of the Hash Array Mapped Trie");
+    }
+    atomic_init(&node->refs, 1);
+    node->bitmap = bitmap;
+    node->size = size;
+
+    return node;
+}
+
+void upo_hamt_node_retain_children(upo_hamt_node_t *node, unsigned skip)
+{
+    unsigned i = 0;
+
+    for (i = 0; i < node->size; ++i)
+    {
+        if (i != skip && node->entries[i].child != NULL)
+        {
+            atomic_fetch_add_explicit(&node->entries[i].child->refs, 1, memory_order_relaxed);
+        }
+    }
+}
+
+void upo_hamt_node_release(upo_hamt_node_t *node)
+{
+    unsigned i = 0;
+
+    if (node == NULL)
+        return;
+
+    /* The last owner must see the writes of the other ones before freeing */
+    if (atomic_fetch_sub_explicit(&node->refs, 1, memory_order_acq_rel) != 1)
+        return;
+
+    for (i = 0; i < node->size; ++i)
+    {
+        upo_hamt_node_release(node->entries[i].child);
+    }
+    free(node);
+}
+
+upo_hamt_node_t* upo_hamt_node_pair(const upo_hamt_entry_t *a, const upo_hamt_entry_t *b, unsigned shift)
+{
+    upo_hamt_node_t *node = NULL;
+    uint32_t bit_a = 0;
+    uint32_t bit_b = 0;
+
+    if (shift >= UPO_HAMT_HASH_BITS)
+    {
+        node = upo_hamt_node_create(0, 2);
+        node->entries[0] = *a;
+        node->entries[1] = *b;
+        return node;
+    }
+
+    bit_a = upo_hamt_bit(a->hash, shift);
+    bit_b = upo_hamt_bit(b->hash, shift);
+    if (bit_a == bit_b)
+    {
+        node = upo_hamt_node_create(bit_a, 1);
+        node->entries[0].child = upo_hamt_node_pair(a, b, shift + UPO_HAMT_BITS);
+        node->entries[0].key = NULL;
+        node->entries[0].value = NULL;
+        node->entries[0].hash = 0;
+        return node;
+    }
+
+    node = upo_hamt_node_create(bit_a | bit_b, 2);
+    node->entries[bit_a < bit_b ? 0 : 1] = *a;
+    node->entries[bit_a < bit_b ? 1 : 0] = *b;
+
+    return node;
+}
+
+upo_hamt_node_t* upo_hamt_node_put(const upo_hamt_t hamt, const upo_hamt_node_t *node, const upo_hamt_entry_t *entry, unsigned shift, void **old_value, int *found)
+{
+    upo_hamt_node_t *copy = NULL;
+    const upo_hamt_entry_t *e = NULL;
+    uint32_t bit = 0;
+    unsigned pos = 0;
+    unsigned i = 0;
+
+    if (node == NULL)
+    {
+        copy = upo_hamt_node_create(upo_hamt_bit(entry->hash, shift), 1);
+        copy->entries[0] = *entry;
+        return copy;
+    }
+
+    if (shift >= UPO_HAMT_HASH_BITS)
+    {
+        /* Collision node: replace the value of the key or append the pair */
+        for (i = 0; i < node->size; ++i)
+        {
+            if (node->entries[i].hash == entry->hash && hamt->key_cmp(node->entries[i].key, entry->key) == 0)
+                break;
+        }
+        copy = upo_hamt_node_create(0, node->size + (i == node->size ? 1 : 0));
+        memcpy(copy->entries, node->entries, node->size*sizeof(upo_hamt_entry_t));
+        if (i < node->size)
+        {
+            *old_value = node->entries[i].value;
+            *found = 1;
+        }
+        copy->entries[i] = *entry;
+        return copy;
+    }
+
+    bit = upo_hamt_bit(entry->hash, shift);
+    pos = upo_hamt_position(node, bit);
+
+    if ((node->bitmap & bit) == 0)
+    {
+        copy = upo_hamt_node_create(node->bitmap | bit, node->size + 1);
+        memcpy(copy->entries, node->entries, pos*sizeof(upo_hamt_entry_t));
+        copy->entries[pos] = *entry;
+        memcpy(copy->entries + pos + 1, node->entries + pos, (node->size - pos)*sizeof(upo_hamt_entry_t));
+        upo_hamt_node_retain_children(copy, pos);
+        return copy;
+    }
+
+    e = &node->entries[pos];
+    copy = upo_hamt_node_create(node->bitmap, node->size);
+    memcpy(copy->entries, node->entries, node->size*sizeof(upo_hamt_entry_t));
+    if (e->child != NULL)
+    {
+        copy->entries[pos].child = upo_hamt_node_put(hamt, e->child, entry, shift + UPO_HAMT_BITS, old_value, found);
+    }
+    else if (e->hash == entry->hash && hamt->key_cmp(e->key, entry->key) == 0)
+    {
+        *old_value = e->value;
+        *found = 1;
+        copy->entries[pos] = *entry;
+    }
+    else
+    {
+        /* Push both pairs one level down */
+        copy->entries[pos].child = upo_hamt_node_pair(e, entry, shift + UPO_HAMT_BITS);
+        copy->entries[pos].key = NULL;
+        copy->entries[pos].value = NULL;
+        copy->entries[pos].hash = 0;
+    }
+    upo_hamt_node_retain_children(copy, pos);
+
+    return copy;
+}
+
+upo_hamt_node_t* upo_hamt_node_delete(const upo_hamt_t hamt, upo_hamt_node_t *node, const void *key, uint64_t hash, unsigned shift, int *found)
+{
+    upo_hamt_node_t *copy = NULL;
+    upo_hamt_node_t *child = NULL;
+    const upo_hamt_entry_t *e = NULL;
+    uint32_t bit = 0;
+    unsigned pos = 0;
+
+    if (shift >= UPO_HAMT_HASH_BITS)
+    {
+        for (pos = 0; pos < node->size; ++pos)
+        {
+            if (node->entries[pos].hash == hash && hamt->key_cmp(node->entries[pos].key, key) == 0)
+                break;
+        }
+        if (pos == node->size)
+            return node;
+        bit = 0;
+    }
+    else
+    {
+        bit = upo_hamt_bit(hash, shift);
+        if ((node->bitmap & bit) == 0)
+            return node;
+
+        pos = upo_hamt_position(node, bit);
+        e = &node->entries[pos];
+        if (e->child != NULL)
+        {
+            child = upo_hamt_node_delete(hamt, e->child, key, hash, shift + UPO_HAMT_BITS, found);
+            if (child == e->child)
+                return node;
+
+            if (child != NULL)
+            {
+                copy = upo_hamt_node_create(node->bitmap, node->size);
+                memcpy(copy->entries, node->entries, node->size*sizeof(upo_hamt_entry_t));
+                if (child->size == 1 && child->entries[0].child == NULL)
+                {
+                    /* Merge the last pair of the child into this node */
+                    copy->entries[pos] = child->entries[0];
+                    upo_hamt_node_release(child);
+                }
+                else
+                {
+                    copy->entries[pos].child = child;
+                }
+                upo_hamt_node_retain_children(copy, pos);
+                return copy;
+            }
+        }
+        else if (e->hash != hash || hamt->key_cmp(e->key, key) != 0)
+        {
+            return node;
+        }
+    }
+
+    /* Remove the entry at the found position */
+    *found = 1;
+    if (node->size == 1)
+        return NULL;
+
+    copy = upo_hamt_node_create(node->bitmap & ~bit, node->size - 1);
+    memcpy(copy->entries, node->entries, pos*sizeof(upo_hamt_entry_t));
+    memcpy(copy->entries + pos, node->entries + pos + 1, (node->size - pos - 1)*sizeof(upo_hamt_entry_t));
+    upo_hamt_node_retain_children(copy, copy->size);
+
+    return copy;
+}
+
+const upo_hamt_entry_t* upo_hamt_find(const upo_hamt_t hamt, const void *key)
+{
+    const upo_hamt_node_t *node = NULL;
+    const upo_hamt_entry_t *e = NULL;
+    uint64_t hash = 0;
+    uint32_t bit = 0;
+    unsigned shift = 0;
+    unsigned i = 0;
+
+    if (hamt == NULL || hamt->root == NULL)
+        return NULL;
+
+    hash = upo_ht_hash_wide(hamt->key_hash, key);
+    node = hamt->root;
+    while (shift < UPO_HAMT_HASH_BITS)
+    {
+        bit = upo_hamt_bit(hash, shift);
+        if ((node->bitmap & bit) == 0)
+            return NULL;
+
+        e = &node->entries[upo_hamt_position(node, bit)];
+        if (e->child == NULL)
+            return (e->hash == hash && hamt->key_cmp(e->key, key) == 0) ? e : NULL;
+
+        node = e->child;
+        shift += UPO_HAMT_BITS;
+    }
+
+    for (i = 0; i < node->size; ++i)
+    {
+        if (node->entries[i].hash == hash && hamt->key_cmp(node->entries[i].key, key) == 0)
+            return &node->entries[i];
+    }
+
+    return NULL;
+}
+
+
+/*** END of FUNDAMENTAL OPERATIONS ***/
+
+
+/*** BEGIN of EXTRA OPERATIONS ***/
+
+
+size_t upo_hamt_depth(const upo_hamt_t hamt)
+{
+    return (hamt != NULL && hamt->root != NULL) ? upo_hamt_node_depth(hamt->root) : 0;
+}
+
+upo_ht_key_list_t upo_hamt_keys(const upo_hamt_t hamt)
+{
+    upo_ht_key_list_t list = NULL;
+
+    if (hamt != NULL && hamt->root != NULL)
+    {
+        upo_hamt_node_traverse(hamt->root, upo_hamt_key_list_add, &list);
+    }
+
+    return list;
+}
+
+void upo_hamt_traverse(const upo_hamt_t hamt, upo_ht_visitor_t visit, void *visit_arg)
+{
+    /* preconditions */
+    assert( visit != NULL );
+
+    if (hamt != NULL && hamt->root != NULL)
+    {
+        upo_hamt_node_traverse(hamt->root, visit, visit_arg);
+    }
+}
+
+upo_ht_comparator_t upo_hamt_get_comparator(const upo_hamt_t hamt)
+{
+    /* preconditions */
+    assert( hamt != NULL );
+
+    return hamt->key_cmp;
+}
+
+upo_ht_hasher_t upo_hamt_get_hasher(const upo_hamt_t hamt)
+{
+    /* preconditions */
+    assert( hamt != NULL );
+
+    return hamt->key_hash;
+}
+
+void upo_hamt_node_traverse(const upo_hamt_node_t *node, upo_ht_visitor_t visit, void *visit_arg)
+{
+    unsigned i = 0;
+
+    for (i = 0; i < node->size; ++i)
+    {
+        if (node->entries[i].child != NULL)
+            upo_hamt_node_traverse(node->entries[i].child, visit, visit_arg);
+        else
+            visit(node->entries[i].key, node->entries[i].value, visit_arg);
+    }
+}
+
+void upo_hamt_key_list_add(void *key, void *value, void *list)
+{
+    upo_ht_key_list_t *head = list;
+    upo_ht_key_list_node_t *list_node = malloc(sizeof(struct upo_ht_key_list_node_s));
+
+    (void) value;
+
+    if (list_node == NULL)
+        upo_throw_sys_error("Unable to allocate memory for a new node of the key list");
+
+    list_node->key = key;
+    list_node->next = *head;
+    *head = list_node;
+}
+
+size_t upo_hamt_node_depth(const upo_hamt_node_t *node)
+{
+    size_t depth = 0;
+    size_t d = 0;
+    unsigned i = 0;
+
+    for (i = 0; i < node->size; ++i)
+    {
+        if (node->entries[i].child != NULL)
+        {
+            d = 1 + upo_hamt_node_depth(node->entries[i].child);
+            if (d > depth)
+                depth = d;
+        }
+    }
+
+    return depth;
+}
+
+
+/*** END of EXTRA OPERATIONS ***/
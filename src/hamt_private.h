@@ -0,0 +1,214 @@
+/**
+ * \file src/hamt_private.h
+ *
+ * \brief Private header for the Hash Array Mapped Trie abstract data type.
+ *
+ * \copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ *  This file is part of UPOalglib.
+ *
+ *  UPOalglib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  UPOalglib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UPO_HAMT_PRIVATE_H
+#define UPO_HAMT_PRIVATE_H
+
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <upo/hamt.h>
+
+
+/** \brief Number of bits of the hash values of keys. */
+#define UPO_HAMT_HASH_BITS 64U
+
+/** \brief Mask selecting the index of an entry from a shifted hash value. */
+#define UPO_HAMT_MASK (UPO_HAMT_BRANCHING-1U)
+
+
+/** \brief Alias for the type for nodes of hash array mapped tries. */
+typedef struct upo_hamt_node_s upo_hamt_node_t;
+
+/** \brief Type for entries of nodes of hash array mapped tries. */
+struct upo_hamt_entry_s
+{
+    upo_hamt_node_t *child; /**< The child node, or `NULL` if the entry holds a key-value pair. */
+    void *key; /**< Pointer to the user-provided key. */
+    void *value; /**< Pointer to the value associated to the key. */
+    uint64_t hash; /**< The hash value of the key. */
+};
+/** \brief Alias for the type for entries of nodes of hash array mapped tries. */
+typedef struct upo_hamt_entry_s upo_hamt_entry_t;
+
+/**
+ * \brief Type for nodes of hash array mapped tries.
+ *
+ * Nodes at the depth where the hash value has been fully consumed are
+ * collision nodes: their bitmap is unused, and their entries are key-value
+ * pairs with the same hash value.
+ */
+struct upo_hamt_node_s
+{
+    _Atomic size_t refs; /**< The number of nodes and maps referencing this node. */
+    uint32_t bitmap; /**< The set of present entries, by index. */
+    unsigned size; /**< The number of entries. */
+    upo_hamt_entry_t entries[]; /**< The present entries, in order of index. */
+};
+
+/** \brief Type for hash array mapped tries. */
+struct upo_hamt_s
+{
+    upo_hamt_node_t *root; /**< The root node, or `NULL` if the map is empty. */
+    size_t size; /**< The number of stored key-value pairs. */
+    upo_ht_hasher_t key_hash; /**< The key hash function. */
+    upo_ht_comparator_t key_cmp; /**< The key comparison function. */
+};
+
+
+/**
+ * \brief Returns the number of bits set in the given bitmap.
+ *
+ * \param x The bitmap.
+ * \return The number of bits set.
+ */
+static unsigned upo_hamt_popcount(uint32_t x);
+
+/**
+ * \brief Returns the bit of the entry of the given hash value in a node at
+ *  the given shift.
+ *
+ * \param hash The hash value.
+ * \param shift The number of bits of the hash value consumed by the levels
+ *  above the node.
+ * \return The bit of the entry in the bitmap of the node.
+ */
+static uint32_t upo_hamt_bit(uint64_t hash, unsigned shift);
+
+/**
+ * \brief Returns the position of the entry with the given bit in the given
+ *  node.
+ *
+ * \param node The node.
+ * \param bit The bit of the entry.
+ * \return The number of entries that precede the entry.
+ */
+static unsigned upo_hamt_position(const upo_hamt_node_t *node, uint32_t bit);
+
+/**
+ * \brief Allocates a node.
+ *
+ * \param bitmap The bitmap of the node.
+ * \param size The number of entries of the node.
+ * \return The node, with one reference and uninitialized entries.
+ */
+static upo_hamt_node_t* upo_hamt_node_create(uint32_t bitmap, unsigned size);
+
+/**
+ * \brief Adds a reference to the child nodes of the given node, except for
+ *  the given entry.
+ *
+ * \param node The node, which has just been copied from another one.
+ * \param skip The position of the entry whose child is new, or the size of
+ *  the node to retain all child nodes.
+ */
+static void upo_hamt_node_retain_children(upo_hamt_node_t *node, unsigned skip);
+
+/**
+ * \brief Removes a reference to the given node, freeing it (and releasing its
+ *  child nodes) if it was the last one.
+ *
+ * \param node The node, or `NULL`.
+ */
+static void upo_hamt_node_release(upo_hamt_node_t *node);
+
+/**
+ * \brief Builds the node holding two key-value pairs whose hash values are
+ *  equal up to the given shift.
+ *
+ * \param a The entry of the first pair.
+ * \param b The entry of the second pair.
+ * \param shift The number of bits of the hash values consumed by the levels
+ *  above the node.
+ * \return The node, possibly with a chain of single-child nodes down to the
+ *  level where the hash values differ.
+ */
+static upo_hamt_node_t* upo_hamt_node_pair(const upo_hamt_entry_t *a, const upo_hamt_entry_t *b, unsigned shift);
+
+/**
+ * \brief Returns a copy of the given node with the given key-value pair
+ *  stored.
+ *
+ * \param hamt The map.
+ * \param node The node, or `NULL` for an empty root.
+ * \param entry The entry of the key-value pair.
+ * \param shift The number of bits of the hash value consumed by the levels
+ *  above the node.
+ * \param old_value Set to the replaced value, if the key was present.
+ * \param found Set to `1` if the key was present.
+ * \return The new node.
+ */
+static upo_hamt_node_t* upo_hamt_node_put(const upo_hamt_t hamt, const upo_hamt_node_t *node, const upo_hamt_entry_t *entry, unsigned shift, void **old_value, int *found);
+
+/**
+ * \brief Returns a copy of the given node with the given key removed.
+ *
+ * \param hamt The map.
+ * \param node The node.
+ * \param key The key.
+ * \param hash The hash value of the key.
+ * \param shift The number of bits of the hash value consumed by the levels
+ *  above the node.
+ * \param found Set to `1` if the key was present.
+ * \return The new node, or `NULL` if the node is left empty, or the given
+ *  node itself if the key is not found.
+ */
+static upo_hamt_node_t* upo_hamt_node_delete(const upo_hamt_t hamt, upo_hamt_node_t *node, const void *key, uint64_t hash, unsigned shift, int *found);
+
+/**
+ * \brief Searches for the given key.
+ *
+ * \param hamt The map.
+ * \param key The key.
+ * \return The entry of the key, or `NULL` if the key is not found.
+ */
+static const upo_hamt_entry_t* upo_hamt_find(const upo_hamt_t hamt, const void *key);
+
+/**
+ * \brief Visits the key-value pairs stored in the subtrie of the given node.
+ *
+ * \param node The node.
+ * \param visit The function to call on each key-value pair.
+ * \param visit_arg An additional parameter to pass to the visit function.
+ */
+static void upo_hamt_node_traverse(const upo_hamt_node_t *node, upo_ht_visitor_t visit, void *visit_arg);
+
+/**
+ * \brief Prepends the given key to the given list of keys.
+ *
+ * \param key The key.
+ * \param value The value associated to the key.
+ * \param list A pointer to the head of the list.
+ */
+static void upo_hamt_key_list_add(void *key, void *value, void *list);
+
+/**
+ * \brief Returns the depth of the subtrie of the given node.
+ *
+ * \param node The node.
+ * \return The number of levels of nodes below the node.
+ */
+static size_t upo_hamt_node_depth(const upo_hamt_node_t *node);
+
+
+#endif /* UPO_HAMT_PRIVATE_H */
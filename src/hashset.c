@@ -0,0 +1,457 @@
+/*
+ * Copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ * This file is part of UPOalglib.
+ *
+ * UPOalglib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * UPOalglib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <upo/error.h>
+#include <upo/utility.h>
+#include "hashset_private.h"
+
+
+/*** BEGIN of FUNDAMENTAL OPERATIONS ***/
+
+
+upo_hs_t upo_hs_create(size_t m, upo_ht_hasher_t key_hash, upo_ht_comparator_t key_cmp)
+{
+    upo_hs_t hs = NULL;
+    size_t i = 0;
+
+    /* preconditions */
+    assert( key_hash != NULL );
+    assert( key_cmp != NULL );
+
+    hs = malloc(sizeof(struct upo_hs_s));
+    if (hs == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for Hash Set");
+    }
+
+    hs->slots = NULL;
+    if (m > 0)
+    {
+        hs->slots = malloc(m*sizeof(upo_hs_slot_t));
+        if (hs->slots == NULL)
+        {
+            upo_throw_sys_error("Unable to allocate memory for slots of the Hash Set");
+        }
+
+        for (i = 0; i < m; ++i)
+        {
+            hs->slots[i].key = NULL;
+            hs->slots[i].tombstone = 0;
+        }
+    }
+
+    hs->capacity = m;
+    hs->size = 0;
+    hs->tombstones = 0;
+    hs->key_hash = key_hash;
+    hs->key_cmp = key_cmp;
+
+    return hs;
+}
+
+void upo_hs_destroy(upo_hs_t hs, int destroy_data)
+{
+    if (hs != NULL)
+    {
+        upo_hs_clear(hs, destroy_data);
+        free(hs->slots);
+        free(hs);
+    }
+}
+
+void upo_hs_clear(upo_hs_t hs, int destroy_data)
+{
+    if (hs != NULL && hs->slots != NULL)
+    {
+        size_t i = 0;
+
+        for (i = 0; i < hs->capacity; ++i)
+        {
+            if (destroy_data && hs->slots[i].key != NULL)
+                free(hs->slots[i].key);
+
+            hs->slots[i].key = NULL;
+            hs->slots[i].tombstone = 0;
+        }
+        hs->size = 0;
+        hs->tombstones = 0;
+    }
+}
+
+int upo_hs_insert(upo_hs_t hs, void *key)
+{
+    size_t h = 0; // Slot position
+    size_t tomb = 0; // Tombstone slot position
+    int found = 0; // Tombstone found
+
+    assert( hs != NULL );
+
+    if (hs->capacity == 0)
+        upo_hs_resize(hs, UPO_HS_DEFAULT_CAPACITY);
+    else if (upo_hs_load_factor(hs) >= 0.5)
+        upo_hs_resize(hs, hs->capacity * 2);
+
+    h = hs->key_hash(key, hs->capacity);
+
+    while ((hs->slots[h].key != NULL && hs->key_cmp(key, hs->slots[h].key) != 0) || hs->slots[h].tombstone != 0) // Finds empty slot or slot with the same key
+    {
+        if (hs->slots[h].tombstone != 0 && !found)
+        {
+            found = 1;
+            tomb = h;
+        }
+
+        h = (h + 1) % hs->capacity;
+    }
+
+    if (hs->slots[h].key != NULL)
+        return 0;
+
+    if (found)
+    {
+        h = tomb;
+        hs->tombstones--;
+    }
+
+    hs->slots[h].key = key;
+    hs->slots[h].tombstone = 0;
+    hs->size++;
+
+    return 1;
+}
+
+int upo_hs_contains(const upo_hs_t hs, const void *key)
+{
+    return (hs != NULL && upo_hs_find(hs, key) < hs->capacity) ? 1 : 0;
+}
+
+void upo_hs_delete(upo_hs_t hs, const void *key, int destroy_data)
+{
+    size_t h = 0;
+
+    if (hs == NULL)
+        return;
+
+    h = upo_hs_find(hs, key);
+
+    if (h < hs->capacity)
+    {
+        if (destroy_data)
+            free(hs->slots[h].key);
+
+        hs->slots[h].key = NULL;
+        hs->slots[h].tombstone = 1;
+        hs->size--;
+        hs->tombstones++;
+
+        if (hs->capacity > 1 && upo_hs_load_factor(hs) <= 0.125)
+            upo_hs_resize(hs, hs->capacity / 2);
+        else if (hs->tombstones > UPO_HS_MAX_TOMBSTONE_RATIO * hs->capacity)
+            upo_hs_purge(hs);
+    }
+}
+
+int upo_hs_is_empty(const upo_hs_t hs)
+{
+    return upo_hs_size(hs) == 0 ? 1 : 0;
+}
+
+size_t upo_hs_capacity(const upo_hs_t hs)
+{
+    return (hs != NULL) ? hs->capacity : 0;
+}
+
+size_t upo_hs_size(const upo_hs_t hs)
+{
+    return (hs != NULL) ? hs->size : 0;
+}
+
+double upo_hs_load_factor(const upo_hs_t hs)
+{
+    return upo_hs_size(hs) / (double) upo_hs_capacity(hs);
+}
+
+upo_ht_comparator_t upo_hs_get_comparator(const upo_hs_t hs)
+{
+    return hs->key_cmp;
+}
+
+upo_ht_hasher_t upo_hs_get_hasher(const upo_hs_t hs)
+{
+    return hs->key_hash;
+}
+
+size_t upo_hs_find(const upo_hs_t hs, const void *key)
+{
+    size_t h = 0;
+
+    if (hs->size == 0)
+        return hs->capacity;
+
+    h = hs->key_hash(key, hs->capacity);
+
+    while ((hs->slots[h].key != NULL && hs->key_cmp(key, hs->slots[h].key) != 0) || hs->slots[h].tombstone) // Finds slot with the same key
+        h = (h + 1) % hs->capacity;
+
+    return (hs->slots[h].key != NULL) ? h : hs->capacity;
+}
+
+void upo_hs_insert_unique(upo_hs_t hs, void *key)
+{
+    size_t h = hs->key_hash(key, hs->capacity);
+
+    while (hs->slots[h].key != NULL)
+        h = (h + 1) % hs->capacity;
+
+    hs->slots[h].key = key;
+    hs->size++;
+}
+
+void upo_hs_resize(upo_hs_t hs, size_t n)
+{
+    upo_hs_t new_hs = NULL;
+    size_t i = 0;
+
+    /* preconditions */
+    assert( n > 0 );
+
+    /* Rebuild the slots from scratch, since keys are rehashed according to
+     * the new capacity, then swap them with the old ones (see
+     * upo_ht_linprob_resize) */
+    new_hs = upo_hs_create(n, hs->key_hash, hs->key_cmp);
+
+    for (i = 0; i < hs->capacity; ++i)
+    {
+        if (hs->slots[i].key != NULL)
+            upo_hs_insert_unique(new_hs, hs->slots[i].key);
+    }
+
+    upo_swap(&hs->slots, &new_hs->slots, sizeof hs->slots);
+    upo_swap(&hs->capacity, &new_hs->capacity, sizeof hs->capacity);
+    upo_swap(&hs->size, &new_hs->size, sizeof hs->size);
+    upo_swap(&hs->tombstones, &new_hs->tombstones, sizeof hs->tombstones);
+
+    upo_hs_destroy(new_hs, 0);
+}
+
+void upo_hs_purge(upo_hs_t hs)
+{
+    size_t i = 0;
+
+    for (i = 0; i < hs->capacity; ++i)
+    {
+        hs->slots[i].tombstone = (hs->slots[i].key != NULL) ? UPO_HS_PENDING : 0;
+    }
+
+    for (i = 0; i < hs->capacity; ++i)
+    {
+        while (hs->slots[i].tombstone == UPO_HS_PENDING)
+        {
+            size_t h = hs->key_hash(hs->slots[i].key, hs->capacity);
+
+            while (hs->slots[h].key != NULL && hs->slots[h].tombstone != UPO_HS_PENDING) // Finds the first slot not holding a rehashed key
+                h = (h + 1) % hs->capacity;
+
+            if (h == i) // Already in place
+            {
+                hs->slots[i].tombstone = 0;
+            }
+            else if (hs->slots[h].key == NULL) // Move to an empty slot
+            {
+                hs->slots[h].key = hs->slots[i].key;
+                hs->slots[h].tombstone = 0;
+                hs->slots[i].key = NULL;
+                hs->slots[i].tombstone = 0;
+            }
+            else // Swap with a pending key
+            {
+                upo_swap(&hs->slots[h], &hs->slots[i], sizeof(upo_hs_slot_t));
+                hs->slots[h].tombstone = 0;
+            }
+        }
+    }
+
+    hs->tombstones = 0;
+}
+
+size_t upo_hs_capacity_for(size_t m, size_t n)
+{
+    if (m == 0)
+        m = UPO_HS_DEFAULT_CAPACITY;
+
+    /* Insertion resizes when the load factor reaches 1/2 */
+    while (2*n > m)
+        m *= 2;
+
+    return m;
+}
+
+
+/*** END of FUNDAMENTAL OPERATIONS ***/
+
+
+/*** BEGIN of EXTRA OPERATIONS ***/
+
+
+upo_ht_key_list_t upo_hs_keys(const upo_hs_t hs)
+{
+    upo_ht_key_list_t list = NULL;
+    size_t i = 0;
+
+    if (!upo_hs_is_empty(hs))
+    {
+        for (i = 0; i < hs->capacity; ++i)
+        {
+            if (hs->slots[i].key != NULL)
+            {
+                upo_ht_key_list_node_t *node = malloc(sizeof(struct upo_ht_key_list_node_s));
+
+                if (node == NULL)
+                    upo_throw_sys_error("Unable to allocate memory for a new node of the key list");
+
+                node->key = hs->slots[i].key;
+                node->next = list;
+                list = node;
+            }
+        }
+    }
+
+    return list;
+}
+
+void upo_hs_traverse(const upo_hs_t hs, upo_hs_visitor_t visit, void *visit_arg)
+{
+    size_t i = 0;
+
+    if (!upo_hs_is_empty(hs) && visit != NULL)
+    {
+        for (i = 0; i < hs->capacity; ++i)
+        {
+            if (hs->slots[i].key != NULL)
+                visit(hs->slots[i].key, visit_arg);
+        }
+    }
+}
+
+upo_hs_t upo_hs_union(const upo_hs_t a, const upo_hs_t b)
+{
+    upo_hs_t res = NULL;
+    size_t m = 0;
+    size_t i = 0;
+
+    /* preconditions */
+    assert( a != NULL );
+    assert( b != NULL );
+    assert( a->key_hash == b->key_hash );
+    assert( a->key_cmp == b->key_cmp );
+
+    m = upo_hs_capacity_for(a->capacity, a->size + b->size);
+
+    res = upo_hs_create(m, a->key_hash, a->key_cmp);
+
+    if (m == a->capacity)
+    {
+        /* Same capacity, same hash function: the slots of the first set can
+         * be copied as they are, together with their tombstones */
+        memcpy(res->slots, a->slots, m*sizeof(upo_hs_slot_t));
+        res->size = a->size;
+        res->tombstones = a->tombstones;
+    }
+    else
+    {
+        for (i = 0; i < a->capacity; ++i)
+        {
+            if (a->slots[i].key != NULL)
+                upo_hs_insert_unique(res, a->slots[i].key);
+        }
+    }
+
+    for (i = 0; i < b->capacity; ++i)
+    {
+        if (b->slots[i].key != NULL)
+            upo_hs_insert(res, b->slots[i].key);
+    }
+
+    return res;
+}
+
+upo_hs_t upo_hs_intersection(const upo_hs_t a, const upo_hs_t b)
+{
+    upo_hs_t res = NULL;
+    upo_hs_t small = NULL;
+    upo_hs_t large = NULL;
+    size_t i = 0;
+
+    /* preconditions */
+    assert( a != NULL );
+    assert( b != NULL );
+    assert( a->key_hash == b->key_hash );
+    assert( a->key_cmp == b->key_cmp );
+
+    small = (a->size <= b->size) ? a : b;
+    large = (small == a) ? b : a;
+
+    res = upo_hs_create(upo_hs_capacity_for(0, small->size), a->key_hash, a->key_cmp);
+
+    for (i = 0; i < small->capacity; ++i)
+    {
+        if (small->slots[i].key != NULL)
+        {
+            size_t h = upo_hs_find(large, small->slots[i].key);
+
+            if (h < large->capacity)
+            {
+                /* Keep the key stored in the first set */
+                upo_hs_insert_unique(res, (small == a) ? small->slots[i].key : large->slots[h].key);
+            }
+        }
+    }
+
+    return res;
+}
+
+upo_hs_t upo_hs_difference(const upo_hs_t a, const upo_hs_t b)
+{
+    upo_hs_t res = NULL;
+    size_t i = 0;
+
+    /* preconditions */
+    assert( a != NULL );
+    assert( b != NULL );
+    assert( a->key_hash == b->key_hash );
+    assert( a->key_cmp == b->key_cmp );
+
+    res = upo_hs_create(upo_hs_capacity_for(0, a->size), a->key_hash, a->key_cmp);
+
+    for (i = 0; i < a->capacity; ++i)
+    {
+        if (a->slots[i].key != NULL && upo_hs_find(b, a->slots[i].key) == b->capacity)
+            upo_hs_insert_unique(res, a->slots[i].key);
+    }
+
+    return res;
+}
+
+
+/*** END of EXTRA OPERATIONS ***/
@@ -0,0 +1,114 @@
+/**
+ * \file src/hashset_private.h
+ *
+ * \brief Private header for the Hash Set abstract data type.
+ *
+ * \copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ *  This file is part of UPOalglib.
+ *
+ *  UPOalglib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  UPOalglib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UPO_HASHSET_PRIVATE_H
+#define UPO_HASHSET_PRIVATE_H
+
+
+#include <upo/hashset.h>
+
+
+/**
+ * \brief Maximum ratio between tombstones and capacity before tombstones are
+ *  purged by rehashing the hash set in place.
+ */
+#define UPO_HS_MAX_TOMBSTONE_RATIO 0.25
+
+/**
+ * \brief Value of the tombstone flag that marks an occupied slot whose key
+ *  still has to be rehashed while purging tombstones.
+ */
+#define UPO_HS_PENDING 2
+
+/** \brief Type for slots of hash sets. */
+struct upo_hs_slot_s
+{
+    void *key; /**< Pointer to the user-provided key. */
+    int tombstone; /**< Flag used to mark this slot as deleted (or as pending, while purging tombstones). */
+};
+/** \brief Alias for the type for slots of hash sets. */
+typedef struct upo_hs_slot_s upo_hs_slot_t;
+
+/** \brief Type for hash sets. */
+struct upo_hs_s
+{
+    upo_hs_slot_t *slots; /**< The hash set as array of slots. */
+    size_t capacity; /**< The capacity of the hash set. */
+    size_t size; /**< The number of stored keys. */
+    size_t tombstones; /**< The number of slots marked as deleted. */
+    upo_ht_hasher_t key_hash; /**< The key hash function. */
+    upo_ht_comparator_t key_cmp; /**< The key comparison function. */
+};
+
+
+/**
+ * \brief Returns the position of the slot storing the given key.
+ *
+ * \param hs The hash set.
+ * \param key The key to search for.
+ * \return The position of the slot storing \a key, or the capacity of the
+ *  hash set if the key is not found.
+ */
+static size_t upo_hs_find(const upo_hs_t hs, const void *key);
+
+/**
+ * \brief Stores the given key in the first empty slot of its probe sequence.
+ *
+ * \param hs The hash set.
+ * \param key The key to store.
+ *
+ * The key must not be already present in the hash set, which must have no
+ * slot marked as deleted and enough room to store the key without resizing.
+ * Since no key comparison is needed, this is used to fill newly created hash
+ * sets with keys that are known to be distinct.
+ */
+static void upo_hs_insert_unique(upo_hs_t hs, void *key);
+
+/**
+ * \brief Resize the given hash set to the given capacity.
+ *
+ * \param hs The hash set to resize.
+ * \param n The new capacity.
+ */
+static void upo_hs_resize(upo_hs_t hs, size_t n);
+
+/**
+ * \brief Removes all tombstones from the given hash set by rehashing its keys
+ *  in place, without changing its capacity (see upo_ht_linprob_purge()).
+ *
+ * \param hs The hash set to purge.
+ */
+static void upo_hs_purge(upo_hs_t hs);
+
+/**
+ * \brief Returns the smallest capacity, obtained by doubling the given one,
+ *  that can store the given number of keys without resizing.
+ *
+ * \param m The starting capacity.
+ * \param n The number of keys.
+ * \return The capacity.
+ */
+static size_t upo_hs_capacity_for(size_t m, size_t n);
+
+
+#endif /* UPO_HASHSET_PRIVATE_H */
@@ -19,11 +19,16 @@
 
 
 #include <assert.h>
+#include <limits.h>
 #include <math.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <upo/error.h>
+#include <upo/hires_timer.h>
+#include <upo/reclaimer.h>
 #include <upo/utility.h>
 #include "hashtable_private.h"
 
@@ -61,8 +66,13 @@ upo_ht_sepchain_t upo_ht_sepchain_create(size_t m, upo_ht_hasher_t key_hash, upo
     }
     ht->capacity = m;
     ht->size = 0;
+    ht->generations = NULL;
+    ht->generation = 0;
+    ht->policy = UPO_HT_SEPCHAIN_POLICY_HEAD;
     ht->key_hash = key_hash;
     ht->key_cmp = key_cmp;
+    ht->stats = NULL;
+    ht->budget = NULL;
 
     return ht;
 }
@@ -71,78 +81,145 @@ void upo_ht_sepchain_destroy(upo_ht_sepchain_t ht, int destroy_data)
 {
     if (ht != NULL)
     {
-        upo_ht_sepchain_clear(ht, destroy_data);
+        if (ht->slots != NULL)
+            upo_ht_sepchain_clear_slots(ht, destroy_data);
+        free(ht->stats);
+        free(ht->budget);
+        free(ht->generations);
         free(ht->slots);
         free(ht);
     }
 }
 
+void upo_ht_sepchain_destroy_async(upo_ht_sepchain_t ht, int destroy_data)
+{
+    upo_reclaimer_submit(ht, upo_ht_sepchain_reclaim_step, destroy_data);
+}
+
+int upo_ht_sepchain_reclaim_step(void *ht, int destroy_data, size_t *cursor, size_t batch)
+{
+    upo_ht_sepchain_t t = ht;
+    size_t n = 0;
+
+    while (n < batch && t->slots != NULL && *cursor < t->capacity)
+    {
+        upo_ht_sepchain_list_node_t *node = NULL;
+
+        upo_ht_sepchain_slot_renew(t, *cursor);
+
+        node = t->slots[*cursor].head;
+        if (node != NULL)
+        {
+            t->slots[*cursor].head = node->next;
+            upo_ht_sepchain_destroy_node(node, destroy_data);
+        }
+        else
+        {
+            *cursor += 1;
+        }
+        ++n;
+    }
+
+    if (t->slots != NULL && *cursor < t->capacity)
+        return 0;
+
+    free(t->stats);
+    free(t->budget);
+    free(t->generations);
+    free(t->slots);
+    free(t);
+
+    return 1;
+}
+
 void upo_ht_sepchain_clear(upo_ht_sepchain_t ht, int destroy_data)
 {
     if (ht != NULL && ht->slots != NULL)
     {
-        size_t i = 0;
-
-        /* For each slot, clear the associated list of collisions */
-        for (i = 0; i < ht->capacity; ++i)
+        if (ht->generation != 0 && !destroy_data && ht->generation < UINT_MAX)
+        {
+            /* Lists of past generations are read as empty, and their nodes
+             * are freed when their slot is written again */
+            ht->generation++;
+            ht->size = 0;
+            if (ht->budget != NULL)
+                ht->budget->data_bytes = 0;
+        }
+        else
         {
-            upo_ht_sepchain_list_node_t *list = NULL;
+            upo_ht_sepchain_clear_slots(ht, destroy_data);
+            if (ht->generation == UINT_MAX)
+                ht->generation = 1; // Stamps of all slots are now stale
+        }
+    }
+}
 
-            list = ht->slots[i].head;
-            while (list != NULL)
-            {
-                upo_ht_sepchain_list_node_t *node = list;
+void upo_ht_sepchain_clear_slots(upo_ht_sepchain_t ht, int destroy_data)
+{
+    size_t i = 0;
+
+    /* For each slot, clear the associated list of collisions */
+    for (i = 0; i < ht->capacity; ++i)
+    {
+        upo_ht_sepchain_list_node_t *list = NULL;
 
-                list = list->next;
+        upo_ht_sepchain_slot_renew(ht, i);
 
-                if (destroy_data)
-                {
-                    free(node->key);
-                    free(node->value);
-                }
+        list = ht->slots[i].head;
+        while (list != NULL)
+        {
+            upo_ht_sepchain_list_node_t *node = list;
+
+            list = list->next;
 
-                free(node);
+            if (destroy_data)
+            {
+                free(node->key);
+                free(node->value);
             }
-            ht->slots[i].head = NULL;
+
+            free(node);
         }
-        ht->size = 0;
+        ht->slots[i].head = NULL;
     }
+    ht->size = 0;
+    if (ht->budget != NULL)
+        ht->budget->data_bytes = 0;
 }
 
 void* upo_ht_sepchain_put(upo_ht_sepchain_t ht, void *key, void *value)
 {
     void *old_value = NULL;
 
-    upo_ht_comparator_t key_cmp = upo_ht_sepchain_get_comparator(ht);
-
-    upo_ht_hasher_t key_hash = upo_ht_sepchain_get_hasher(ht);
+    size_t h = upo_ht_sepchain_hash(ht, key); // Slot position
 
-    size_t h = key_hash(key, upo_ht_sepchain_capacity(ht)); // Slot position
+    upo_ht_sepchain_list_node_t **link = NULL; // Link to the node with the same key
 
-    upo_ht_sepchain_list_node_t *node = ht->slots[h].head;
+    upo_ht_sepchain_slot_renew(ht, h);
 
-    while (node != NULL && key_cmp(node->key, key) != 0) // Searches for a node with the same key
-        node = node->next;
-
-    if (node == NULL) // If node does not exist, create a new one
+    if (!upo_ht_sepchain_find(ht, h, key, 1, &link)) // If node does not exist, create a new one
     {
-        node = malloc(sizeof(struct upo_ht_sepchain_list_node_s));
-
-        if (node == NULL)
-            upo_throw_sys_error("Unable to allocate memory for a single node for Hast Table with Separate Chaining");
-
-        node->key = key;
-        node->value = value;
-        node->next = ht->slots[h].head;
+        if (ht->budget != NULL && upo_ht_sepchain_evict(ht, sizeof(upo_ht_sepchain_list_node_t) + upo_ht_budget_data_size(ht->budget, key, value), NULL) > 0)
+            upo_ht_sepchain_find(ht, h, key, 0, &link); // Evictions may have changed the list
 
-        ht->slots[h].head = node;
+        upo_ht_sepchain_link_node(link, key, value);
         ht->size++;
+        upo_ht_budget_charge(ht->budget, key, value);
     }
 
     else // If node exists, change the value and save the old one in old_value
     {
+        upo_ht_sepchain_list_node_t *node = *link;
+
         old_value = node->value;
         node->value = value;
+
+        if (ht->budget != NULL)
+        {
+            upo_ht_budget_release(ht->budget, node->key, old_value);
+            upo_ht_budget_charge(ht->budget, node->key, value);
+            upo_ht_sepchain_evict(ht, 0, node->key);
+        }
     }
 
     return old_value;
@@ -152,66 +229,42 @@ void upo_ht_sepchain_insert(upo_ht_sepchain_t ht, void *key, void *value)
 {
     if (ht != NULL && ht->slots != NULL)
     {
-        upo_ht_comparator_t key_cmp = upo_ht_sepchain_get_comparator(ht);
+        size_t h = upo_ht_sepchain_hash(ht, key); // Slot position
 
-        upo_ht_hasher_t key_hash = ht->key_hash;
+        upo_ht_sepchain_list_node_t **link = NULL; // Link to the node with the same key
 
-        size_t h = key_hash(key, upo_ht_sepchain_capacity(ht)); // Slot position
+        upo_ht_sepchain_slot_renew(ht, h);
 
-        upo_ht_sepchain_list_node_t *node = ht->slots[h].head;
-
-        while (node != NULL && key_cmp(key, node->key) != 0) // Searches for a node with the same key
-            node = node->next;
-
-        if (node == NULL) // Insert the node
+        if (!upo_ht_sepchain_find(ht, h, key, 0, &link)) // Insert the node
         {
-            node = malloc(sizeof(struct upo_ht_sepchain_list_node_s));
-
-            if (node == NULL)
-                upo_throw_sys_error("Unable to allocate memory for a single node for Hast Table with Separate Chaining");
-
-            node->key = key;
-            node->value = value;
-            node->next = ht->slots[h].head;
+            if (ht->budget != NULL && upo_ht_sepchain_evict(ht, sizeof(upo_ht_sepchain_list_node_t) + upo_ht_budget_data_size(ht->budget, key, value), NULL) > 0)
+                upo_ht_sepchain_find(ht, h, key, 0, &link); // Evictions may have changed the list
 
-            ht->slots[h].head = node;
+            upo_ht_sepchain_link_node(link, key, value);
             ht->size++;
+            upo_ht_budget_charge(ht->budget, key, value);
         }
     }
 }
 
 void* upo_ht_sepchain_get(const upo_ht_sepchain_t ht, const void *key)
 {
-    upo_ht_comparator_t key_cmp = upo_ht_sepchain_get_comparator(ht);
-
-    upo_ht_hasher_t key_hash = upo_ht_sepchain_get_hasher(ht);
-
-    size_t h = key_hash(key, upo_ht_sepchain_capacity(ht)); // Slot position
+    size_t h = upo_ht_sepchain_hash(ht, key); // Slot position
 
-    upo_ht_sepchain_list_node_t *node = ht->slots[h].head;
+    upo_ht_sepchain_list_node_t **link = NULL; // Link to the node with the same key
 
-    while (node != NULL && key_cmp(key, node->key) != 0) // Searches for a node with the same key
-        node = node->next;
-
-    return (node != NULL) ? node->value : NULL;
+    return upo_ht_sepchain_find(ht, h, key, 1, &link) ? (*link)->value : NULL;
 }
 
 int upo_ht_sepchain_contains(const upo_ht_sepchain_t ht, const void *key)
 {
     /*  ALternative #1: same as upo_ht_sepchain_get()
      *
-    upo_ht_comparator_t key_cmp = upo_ht_sepchain_get_comparator(ht);
-
-    upo_ht_hasher_t key_hash = upo_ht_sepchain_get_hasher(ht);
-
-    size_t h = key_hash(key, upo_ht_sepchain_capacity(ht)); // Slot position
-
-    upo_ht_sepchain_list_node_t *node = ht->slots[h].head;
+    size_t h = upo_ht_sepchain_hash(ht, key); // Slot position
 
-    while (node != NULL && key_cmp(node->key, key) != 0) // Searches for a node with the same key
-        node = node->next;
+    upo_ht_sepchain_list_node_t **link = NULL;
 
-    return (node != NULL) ? 1 : 0;
+    return upo_ht_sepchain_find(ht, h, key, 1, &link);
      */
 
     // Or alternative #2:
@@ -223,33 +276,147 @@ int upo_ht_sepchain_contains(const upo_ht_sepchain_t ht, const void *key)
 
 void upo_ht_sepchain_delete(upo_ht_sepchain_t ht, const void *key, int destroy_data)
 {
-    upo_ht_comparator_t key_cmp = upo_ht_sepchain_get_comparator(ht);
+    size_t h = upo_ht_sepchain_hash(ht, key); // Slot position
 
-    upo_ht_hasher_t key_hash = upo_ht_sepchain_get_hasher(ht);
+    upo_ht_sepchain_list_node_t **link = NULL; // Link to the node with the same key
 
-    size_t h = key_hash(key, upo_ht_sepchain_capacity(ht)); // Slot position
+    if (upo_ht_sepchain_find(ht, h, key, 0, &link))
+    {
+        upo_ht_sepchain_list_node_t *node = *link;
+
+        *link = node->next; // Unlink the node
+
+        upo_ht_budget_release(ht->budget, node->key, node->value);
+        upo_ht_sepchain_destroy_node(node, destroy_data);
+        ht->size--;
+    }
+}
+
+int upo_ht_sepchain_get_or_insert(upo_ht_sepchain_t ht, void *key, void ***value_ptr)
+{
+    size_t h = 0; // Slot position
+    upo_ht_sepchain_list_node_t **link = NULL; // Link to the node with the same key
+    int inserted = 0;
 
-    upo_ht_sepchain_list_node_t *node = ht->slots[h].head;
+    /* preconditions */
+    assert( ht != NULL );
+    assert( value_ptr != NULL );
+
+    h = upo_ht_sepchain_hash(ht, key);
 
-    upo_ht_sepchain_list_node_t *p = NULL; // Aux pointer to the node
+    upo_ht_sepchain_slot_renew(ht, h);
 
-    while (node != NULL && key_cmp(key, node->key) != 0) // Searches for a node with the same key
+    if (!upo_ht_sepchain_find(ht, h, key, 1, &link)) // If node does not exist, create a new one
     {
-        p = node; // Saves node to p
-        node = node->next;
+        if (ht->budget != NULL && upo_ht_sepchain_evict(ht, sizeof(upo_ht_sepchain_list_node_t) + upo_ht_budget_data_size(ht->budget, key, NULL), NULL) > 0)
+            upo_ht_sepchain_find(ht, h, key, 0, &link); // Evictions may have changed the list
+
+        upo_ht_sepchain_link_node(link, key, NULL);
+        ht->size++;
+        upo_ht_budget_charge(ht->budget, key, NULL);
+        inserted = 1;
     }
 
-    if (node != NULL)
+    *value_ptr = &(*link)->value;
+
+    return inserted;
+}
+
+void* upo_ht_sepchain_compute(upo_ht_sepchain_t ht, void *key, upo_ht_updater_t update, void *update_arg)
+{
+    size_t h = 0; // Slot position
+    upo_ht_sepchain_list_node_t **link = NULL; // Link to the node with the same key
+    int found = 0;
+    void *value = NULL;
+
+    /* preconditions */
+    assert( ht != NULL );
+    assert( update != NULL );
+
+    h = upo_ht_sepchain_hash(ht, key);
+
+    upo_ht_sepchain_slot_renew(ht, h);
+
+    found = upo_ht_sepchain_find(ht, h, key, 1, &link);
+
+    value = update(key, found ? (*link)->value : NULL, update_arg);
+
+    if (found && value != NULL) // Update the value in place
     {
-        if (p == NULL) // If key wasn't found
-            ht->slots[h].head = node->next;
+        upo_ht_sepchain_list_node_t *node = *link;
 
-        else
-            p->next = node->next;
+        if (ht->budget != NULL)
+            upo_ht_budget_release(ht->budget, node->key, node->value);
+
+        node->value = value;
+
+        if (ht->budget != NULL)
+        {
+            upo_ht_budget_charge(ht->budget, node->key, value);
+            upo_ht_sepchain_evict(ht, 0, node->key);
+        }
     }
+    else if (found) // Remove the node
+    {
+        upo_ht_sepchain_list_node_t *node = *link;
 
-    upo_ht_sepchain_destroy_node(node, destroy_data);
-    ht->size--;
+        *link = node->next;
+
+        upo_ht_budget_release(ht->budget, node->key, node->value);
+        upo_ht_sepchain_destroy_node(node, 0);
+        ht->size--;
+    }
+    else if (value != NULL) // Insert a new node
+    {
+        if (ht->budget != NULL && upo_ht_sepchain_evict(ht, sizeof(upo_ht_sepchain_list_node_t) + upo_ht_budget_data_size(ht->budget, key, value), NULL) > 0)
+            upo_ht_sepchain_find(ht, h, key, 0, &link); // Evictions may have changed the list
+
+        upo_ht_sepchain_link_node(link, key, value);
+        ht->size++;
+        upo_ht_budget_charge(ht->budget, key, value);
+    }
+
+    return value;
+}
+
+size_t upo_ht_sepchain_retain(upo_ht_sepchain_t ht, upo_ht_predicate_t pred, void *pred_arg, int destroy_data)
+{
+    size_t removed = 0;
+    size_t i = 0;
+
+    /* preconditions */
+    assert( pred != NULL );
+
+    if (ht == NULL)
+        return 0;
+
+    for (i = 0; i < ht->capacity; ++i)
+    {
+        upo_ht_sepchain_list_node_t **link = NULL; // Link to the current node
+
+        upo_ht_sepchain_slot_renew(ht, i);
+
+        link = &ht->slots[i].head;
+        while (*link != NULL)
+        {
+            upo_ht_sepchain_list_node_t *node = *link;
+
+            if (pred(node->key, node->value, pred_arg))
+            {
+                link = &node->next;
+            }
+            else
+            {
+                *link = node->next;
+                upo_ht_budget_release(ht->budget, node->key, node->value);
+                upo_ht_sepchain_destroy_node(node, destroy_data);
+                removed++;
+            }
+        }
+    }
+    ht->size -= removed;
+
+    return removed;
 }
 
 void upo_ht_sepchain_destroy_node(upo_ht_sepchain_list_node_t *node, int destroy_data)
@@ -296,423 +463,2291 @@ upo_ht_hasher_t upo_ht_sepchain_get_hasher(const upo_ht_sepchain_t ht)
     return ht->key_hash;
 }
 
+size_t upo_ht_sepchain_hash(const upo_ht_sepchain_t ht, const void *key)
+{
+    if (ht->stats != NULL)
+        ht->stats->hash_calls++;
 
-/*** END of HASH TABLE with SEPARATE CHAINING ***/
-
-
-/*** BEGIN of HASH TABLE with LINEAR PROBING ***/
-
+    return ht->key_hash(key, ht->capacity);
+}
 
-upo_ht_linprob_t upo_ht_linprob_create(size_t m, upo_ht_hasher_t key_hash, upo_ht_comparator_t key_cmp)
+int upo_ht_sepchain_cmp(const upo_ht_sepchain_t ht, const void *a, const void *b)
 {
-    upo_ht_linprob_t ht = NULL;
-    size_t i = 0;
+    if (ht->stats != NULL)
+        ht->stats->cmp_calls++;
 
-    /* preconditions */
-    assert( key_hash != NULL );
-    assert( key_cmp != NULL );
+    return ht->key_cmp(a, b);
+}
 
-    /* Allocate memory for the hash table type */
-    ht = malloc(sizeof(struct upo_ht_linprob_s));
-    if (ht == NULL)
+void upo_ht_sepchain_enable_generations(upo_ht_sepchain_t ht)
+{
+    if (ht != NULL && ht->generation == 0)
     {
-        upo_throw_sys_error("Unable to allocate memory for Hash Table with Linear Probing");
-    }
+        size_t i = 0;
 
-    /* Allocate memory for the array of slots */
-    if (m > 0)
-    {
-        ht->slots = malloc(m*sizeof(upo_ht_linprob_slot_t));
-        if (ht->slots == NULL)
+        ht->generation = 1;
+        if (ht->capacity > 0)
         {
-            upo_throw_sys_error("Unable to allocate memory for slots of the Hash Table with Separate Chaining");
+            ht->generations = malloc(ht->capacity*sizeof(unsigned));
+            if (ht->generations == NULL)
+            {
+                upo_throw_sys_error("Unable to allocate memory for slots of the Hash Table with Separate Chaining");
+            }
         }
 
-        /* Initialize the slots */
-        for (i = 0; i < m; ++i)
+        /* Current slots belong to the first generation */
+        for (i = 0; i < ht->capacity; ++i)
         {
-            ht->slots[i].key = NULL;
-            ht->slots[i].value = NULL;
-            ht->slots[i].tombstone = 0;
+            ht->generations[i] = ht->generation;
         }
     }
-
-    ht->capacity = m;
-    ht->size = 0;
-    ht->key_hash = key_hash;
-    ht->key_cmp = key_cmp;
-
-    return ht;
 }
 
-void upo_ht_linprob_destroy(upo_ht_linprob_t ht, int destroy_data)
+void upo_ht_sepchain_disable_generations(upo_ht_sepchain_t ht)
 {
-    if (ht != NULL)
+    if (ht != NULL && ht->generation != 0)
     {
-        upo_ht_linprob_clear(ht, destroy_data);
-        free(ht->slots);
-        free(ht);
+        size_t i = 0;
+
+        /* Free the lists of past generations */
+        for (i = 0; i < ht->capacity; ++i)
+        {
+            upo_ht_sepchain_slot_renew(ht, i);
+        }
+        ht->generation = 0;
+        free(ht->generations);
+        ht->generations = NULL;
     }
 }
 
-void upo_ht_linprob_clear(upo_ht_linprob_t ht, int destroy_data)
+void upo_ht_sepchain_set_policy(upo_ht_sepchain_t ht, upo_ht_sepchain_policy_t policy)
 {
-    if (ht != NULL && ht->slots != NULL)
+    if (ht != NULL)
     {
         size_t i = 0;
 
-        /* For each slot, clear the associated list of collisions */
-        for (i = 0; i < ht->capacity; ++i)
+        if (policy == UPO_HT_SEPCHAIN_POLICY_SORTED && ht->policy != policy)
         {
-            if (ht->slots[i].key != NULL)
+            /* Sort each list by insertion */
+            for (i = 0; i < ht->capacity; ++i)
             {
-                if (destroy_data)
+                upo_ht_sepchain_list_node_t *list = upo_ht_sepchain_slot_head(ht, i);
+                upo_ht_sepchain_list_node_t *sorted = NULL;
+
+                while (list != NULL)
                 {
-                    free(ht->slots[i].key);
-                    free(ht->slots[i].value);
+                    upo_ht_sepchain_list_node_t *node = list;
+                    upo_ht_sepchain_list_node_t **link = &sorted;
+
+                    list = list->next;
+
+                    while (*link != NULL && ht->key_cmp((*link)->key, node->key) < 0)
+                        link = &(*link)->next;
+
+                    node->next = *link;
+                    *link = node;
                 }
-                ht->slots[i].key = NULL;
-                ht->slots[i].value = NULL;
-                ht->slots[i].tombstone = 0;
+
+                if (upo_ht_sepchain_slot_head(ht, i) != NULL)
+                    ht->slots[i].head = sorted;
             }
         }
-        ht->size = 0;
+
+        ht->policy = policy;
     }
 }
 
-void* upo_ht_linprob_put(upo_ht_linprob_t ht, void *key, void *value)
+upo_ht_sepchain_policy_t upo_ht_sepchain_get_policy(const upo_ht_sepchain_t ht)
 {
-    void *old_value = NULL;
-
-    upo_ht_hasher_t key_hash = upo_ht_linprob_get_hasher(ht);
-
-    size_t h = key_hash(key, upo_ht_linprob_capacity(ht)); // Slot position
-    size_t tomb = 0; // Tombstone slot position
-
-    upo_ht_comparator_t key_cmp = upo_ht_linprob_get_comparator(ht);
-
-    int found = 0; // Tombstone found
+    return (ht != NULL) ? ht->policy : UPO_HT_SEPCHAIN_POLICY_HEAD;
+}
 
-    if (upo_ht_linprob_load_factor(ht) >= 0.5)
-        upo_ht_linprob_resize(ht, upo_ht_linprob_capacity(ht) * 2);
+int upo_ht_sepchain_find(const upo_ht_sepchain_t ht, size_t h, const void *key, int reorganize, upo_ht_sepchain_list_node_t ***link)
+{
+    upo_ht_sepchain_list_node_t **cur = &ht->slots[h].head; // Link to the current node
+    upo_ht_sepchain_list_node_t **prev = NULL; // Link to the previous node
+    int cmp = 1;
 
-    while ((ht->slots[h].key != NULL && key_cmp(key, ht->slots[h].key) != 0) || ht->slots[h].tombstone != 0) // Finds empty slot or slot with the same key
+    if (upo_ht_sepchain_slot_head(ht, h) == NULL) // Empty list (or list of a past generation)
     {
-        if (ht->slots[h].tombstone != 0 && !found)
-        {
-            found = 1;
-            tomb = h;
-        }
-
-        h = (h + 1) % upo_ht_linprob_capacity(ht);
+        *link = cur;
+        return 0;
     }
 
-    if (ht->slots[h].key == NULL) // If slot does not exist, create a new one
+    while (*cur != NULL && (cmp = upo_ht_sepchain_cmp(ht, key, (*cur)->key)) != 0) // Searches for a node with the same key
     {
-        if (found)
-            h = tomb;
+        if (cmp < 0 && ht->policy == UPO_HT_SEPCHAIN_POLICY_SORTED) // Greater keys follow
+            break;
 
-        ht->slots[h].key = key;
-        ht->slots[h].value = value;
-        ht->slots[h].tombstone = 0;
-        ht->size++;
+        prev = cur;
+        cur = &(*cur)->next;
     }
 
-    else // Change the value and put the old one in old_value
+    if (*cur == NULL || cmp != 0)
     {
-        old_value = ht->slots[h].value;
-        ht->slots[h].value = value;
+        /* Unsorted lists get new nodes at their head */
+        *link = (ht->policy == UPO_HT_SEPCHAIN_POLICY_SORTED) ? cur : &ht->slots[h].head;
+        return 0;
     }
 
-    return old_value;
-}
-
-void upo_ht_linprob_insert(upo_ht_linprob_t ht, void *key, void *value)
-{
-    if (ht != NULL && ht->slots != NULL)
+    if (reorganize && prev != NULL)
     {
-        upo_ht_hasher_t key_hash = upo_ht_linprob_get_hasher(ht);
-
-        size_t h = key_hash(key, upo_ht_linprob_capacity(ht)); // Slot position
-        size_t tomb = 0; // Tombstone slot position
+        upo_ht_sepchain_list_node_t *node = *cur;
 
-        upo_ht_comparator_t key_cmp = upo_ht_linprob_get_comparator(ht);
-
-        int found = 0; // Tombstone found
-
-        if (upo_ht_linprob_load_factor(ht) >= 0.5)
-            upo_ht_linprob_resize(ht, upo_ht_linprob_capacity(ht) * 2);
-
-        while ((ht->slots[h].key != NULL && key_cmp(key, ht->slots[h].key) != 0) || ht->slots[h].tombstone != 0) // Finds empty slot
+        if (ht->policy == UPO_HT_SEPCHAIN_POLICY_MOVE_TO_FRONT)
         {
-            if (ht->slots[h].tombstone != 0 && !found)
-            {
-                found = 1;
-                tomb = h;
-            }
-
-            h = (h + 1) % upo_ht_linprob_capacity(ht);
+            *cur = node->next;
+            node->next = ht->slots[h].head;
+            ht->slots[h].head = node;
+            cur = &ht->slots[h].head;
         }
-
-        if (ht->slots[h].key == NULL) // Create the new slot
+        else if (ht->policy == UPO_HT_SEPCHAIN_POLICY_TRANSPOSE)
         {
-            if (found)
-                h = tomb;
+            upo_ht_sepchain_list_node_t *pred = *prev;
 
-            ht->slots[h].key = key;
-            ht->slots[h].value = value;
-            ht->slots[h].tombstone = 0;
-            ht->size ++;
+            pred->next = node->next;
+            node->next = pred;
+            *prev = node;
+            cur = prev;
         }
     }
-}
-
-void* upo_ht_linprob_get(const upo_ht_linprob_t ht, const void *key)
-{
-    upo_ht_hasher_t key_hash = upo_ht_linprob_get_hasher(ht);
 
-    upo_ht_comparator_t key_cmp = upo_ht_linprob_get_comparator(ht);
+    *link = cur;
 
-    size_t h = key_hash(key, upo_ht_linprob_capacity(ht)); // Slot position
-
-    while ((ht->slots[h].key != NULL && key_cmp(key, ht->slots[h].key) != 0) || ht->slots[h].tombstone) // Finds slot with the same key
-        h = (h + 1) % upo_ht_linprob_capacity(ht);
-
-    return (ht->slots[h].key != NULL) ? ht->slots[h].value : NULL;
+    return 1;
 }
 
-int upo_ht_linprob_contains(const upo_ht_linprob_t ht, const void *key)
+upo_ht_sepchain_list_node_t* upo_ht_sepchain_link_node(upo_ht_sepchain_list_node_t **link, void *key, void *value)
 {
-    /* Alternative #1: same as upo_ht_linprob_get()
-    upo_ht_hasher_t key_hash = upo_ht_linprob_get_hasher(ht);
+    upo_ht_sepchain_list_node_t *node = malloc(sizeof(struct upo_ht_sepchain_list_node_s));
 
-    upo_ht_comparator_t key_cmp = upo_ht_linprob_get_comparator(ht);
+    if (node == NULL)
+        upo_throw_sys_error("Unable to allocate memory for a single node for Hast Table with Separate Chaining");
 
-    size_t h = key_hash(key, upo_ht_linprob_capacity(ht)); // Slot position
+    node->key = key;
+    node->value = value;
+    node->next = *link;
+    *link = node;
 
-    while ((ht->slots[h].key != NULL && key_cmp(key, ht->slots[h].key) != 0) || ht->slots[h].tombstone) // Finds slot with the same key
-        h = (h + 1) % upo_ht_linprob_capacity(ht);
-
-    return (ht->slots[h].key != NULL) ? 1 : 0;
-     */
-
-    // Or alternative #2:
+    return node;
+}
 
-    void *value = upo_ht_linprob_get(ht, key);
+upo_ht_sepchain_list_node_t* upo_ht_sepchain_slot_head(const upo_ht_sepchain_t ht, size_t i)
+{
+    if (ht->generation != 0 && ht->generations[i] != ht->generation)
+        return NULL;
 
-    return (value == NULL) ? 0 : 1;
+    return ht->slots[i].head;
 }
 
-void upo_ht_linprob_delete(upo_ht_linprob_t ht, const void *key, int destroy_data)
+void upo_ht_sepchain_slot_renew(upo_ht_sepchain_t ht, size_t i)
 {
-    upo_ht_hasher_t key_hash = upo_ht_linprob_get_hasher(ht);
+    if (ht->generation != 0 && ht->generations[i] != ht->generation)
+    {
+        while (ht->slots[i].head != NULL)
+        {
+            upo_ht_sepchain_list_node_t *node = ht->slots[i].head;
 
-    upo_ht_comparator_t key_cmp = upo_ht_linprob_get_comparator(ht);
+            ht->slots[i].head = node->next;
+            upo_ht_sepchain_destroy_node(node, 0);
+        }
+        ht->generations[i] = ht->generation;
+    }
+}
 
-    size_t h = key_hash(key, upo_ht_linprob_capacity(ht));
 
-    while ((ht->slots[h].key != NULL && key_cmp(key, ht->slots[h].key) != 0) || ht->slots[h].tombstone) // Finds slot with the same key
-        h = (h + 1) % upo_ht_linprob_capacity(ht);
+/*** END of HASH TABLE with SEPARATE CHAINING ***/
 
-    if (ht->slots[h].key != NULL)
-    {
-        if (destroy_data)
-        {
-            free(ht->slots[h].key);
-            free(ht->slots[h].value);
-        }
 
-        ht->slots[h].key = NULL;
-        ht->slots[h].value = NULL;
-        ht->slots[h].tombstone = 1;
-        ht->size--;
+/*** BEGIN of HASH TABLE with LINEAR PROBING ***/
 
-        if (upo_ht_linprob_load_factor(ht) <= 0.125)
-            upo_ht_linprob_resize(ht, upo_ht_linprob_capacity(ht) / 2);
-    }
-}
 
-size_t upo_ht_linprob_size(const upo_ht_linprob_t ht)
+upo_ht_linprob_t upo_ht_linprob_create(size_t m, upo_ht_hasher_t key_hash, upo_ht_comparator_t key_cmp)
+{
+    upo_ht_linprob_t ht = NULL;
+
+    /* preconditions */
+    assert( key_hash != NULL );
+    assert( key_cmp != NULL );
+
+    /* Allocate memory for the hash table type */
+    ht = malloc(sizeof(struct upo_ht_linprob_s));
+    if (ht == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for Hash Table with Linear Probing");
+    }
+
+    upo_ht_linprob_init(ht, key_hash, key_cmp);
+
+    /* Allocate memory for the array of slots */
+    upo_ht_linprob_alloc_slots(ht, m);
+
+    return ht;
+}
+
+upo_ht_linprob_t upo_ht_linprob_create_small(upo_ht_hasher_t key_hash, upo_ht_comparator_t key_cmp)
+{
+    upo_ht_linprob_t ht = NULL;
+    size_t i = 0;
+
+    /* preconditions */
+    assert( key_hash != NULL );
+    assert( key_cmp != NULL );
+
+    /* Allocate memory for the hash table type and its inline array of slots
+     * at once.
+     * Note: the size of the hash table type is a multiple of the alignment of
+     * pointers, and so of slots. */
+    ht = malloc(sizeof(struct upo_ht_linprob_s) + UPO_HT_LINPROB_SMALL_CAPACITY*sizeof(upo_ht_linprob_slot_t));
+    if (ht == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for Hash Table with Linear Probing");
+    }
+
+    upo_ht_linprob_init(ht, key_hash, key_cmp);
+
+    ht->small = 1;
+    ht->slots = upo_ht_linprob_inline_slots(ht);
+    ht->fingerprints = NULL;
+    ht->keys = NULL;
+    ht->values = NULL;
+    ht->generations = NULL;
+    ht->capacity = UPO_HT_LINPROB_SMALL_CAPACITY;
+    for (i = 0; i < ht->capacity; ++i)
+    {
+        ht->slots[i].key = NULL;
+        ht->slots[i].value = NULL;
+        ht->slots[i].tombstone = 0;
+        ht->slots[i].generation = 0;
+    }
+
+    return ht;
+}
+
+int upo_ht_linprob_is_small(const upo_ht_linprob_t ht)
+{
+    return (ht != NULL) ? ht->small : 0;
+}
+
+void upo_ht_linprob_destroy(upo_ht_linprob_t ht, int destroy_data)
+{
+    if (ht != NULL)
+    {
+        upo_ht_linprob_clear(ht, destroy_data);
+        free(ht->stats);
+        free(ht->budget);
+        upo_ht_linprob_free_slots(ht);
+        free(ht);
+    }
+}
+
+void upo_ht_linprob_destroy_async(upo_ht_linprob_t ht, int destroy_data)
+{
+    upo_reclaimer_submit(ht, upo_ht_linprob_reclaim_step, destroy_data);
+}
+
+int upo_ht_linprob_reclaim_step(void *ht, int destroy_data, size_t *cursor, size_t batch)
+{
+    upo_ht_linprob_t t = ht;
+    size_t n = 0;
+
+    /* Stale slots of past generations read as empty: their keys were left to
+     * the caller by a clear() without destroy_data, so they are not freed */
+    if (destroy_data)
+    {
+        for (n = 0; n < batch && *cursor < t->capacity; ++n, *cursor += 1)
+        {
+            if (upo_ht_linprob_slot_key(t, *cursor) != NULL)
+            {
+                free(upo_ht_linprob_slot_key(t, *cursor));
+                free(upo_ht_linprob_slot_value(t, *cursor));
+            }
+        }
+
+        if (*cursor < t->capacity)
+            return 0;
+    }
+
+    free(t->stats);
+    free(t->budget);
+    upo_ht_linprob_free_slots(t);
+    free(t);
+
+    return 1;
+}
+
+void upo_ht_linprob_clear(upo_ht_linprob_t ht, int destroy_data)
+{
+    if (ht != NULL && ht->capacity > 0)
+    {
+        size_t i = 0;
+
+        if (ht->generation != 0 && !destroy_data && ht->generation < UINT_MAX)
+        {
+            /* Slots of past generations are read as empty */
+            ht->generation++;
+        }
+        else if (ht->small)
+        {
+            /* Only the first slots are occupied */
+            for (i = 0; i < ht->size; ++i)
+            {
+                if (destroy_data)
+                {
+                    free(ht->slots[i].key);
+                    free(ht->slots[i].value);
+                }
+                upo_ht_linprob_slot_set(ht, i, NULL, NULL, 0, 0);
+            }
+            if (ht->generation == UINT_MAX)
+            {
+                for (; i < ht->capacity; ++i)
+                    upo_ht_linprob_slot_set(ht, i, NULL, NULL, 0, 0);
+                ht->generation = 1;
+            }
+        }
+        else
+        {
+            /* For each slot, clear the associated list of collisions */
+            for (i = 0; i < ht->capacity; ++i)
+            {
+                if (destroy_data && upo_ht_linprob_slot_key(ht, i) != NULL)
+                {
+                    free(upo_ht_linprob_slot_key(ht, i));
+                    free(upo_ht_linprob_slot_value(ht, i));
+                }
+                upo_ht_linprob_slot_set(ht, i, NULL, NULL, 0, 0);
+            }
+            if (ht->generation == UINT_MAX)
+                ht->generation = 1; // Stamps of all slots are now stale
+        }
+        ht->size = 0;
+        ht->tombstones = 0;
+        ht->max_probe = 0;
+        if (ht->budget != NULL)
+            ht->budget->data_bytes = 0;
+    }
+}
+
+void* upo_ht_linprob_put(upo_ht_linprob_t ht, void *key, void *value)
+{
+    void *old_value = NULL;
+
+    size_t h = 0; // Slot position
+    size_t i = 0; // Probe number
+    unsigned fp = 0; // Key fingerprint
+
+    if (!upo_ht_linprob_find(ht, key, &h, &i, &fp)) // If slot does not exist, create a new one
+    {
+        upo_ht_linprob_insert_at(ht, key, value, h, i, fp);
+    }
+    else // Change the value and put the old one in old_value
+    {
+        old_value = upo_ht_linprob_slot_value(ht, h);
+        *upo_ht_linprob_slot_value_ref(ht, h) = value;
+
+        if (ht->budget != NULL)
+        {
+            void *stored_key = upo_ht_linprob_slot_key(ht, h);
+
+            upo_ht_budget_release(ht->budget, stored_key, old_value);
+            upo_ht_budget_charge(ht->budget, stored_key, value);
+            upo_ht_linprob_evict(ht, 0, stored_key, 0);
+        }
+    }
+
+    return old_value;
+}
+
+void upo_ht_linprob_insert(upo_ht_linprob_t ht, void *key, void *value)
+{
+    if (ht != NULL)
+    {
+        size_t h = 0; // Slot position
+        size_t i = 0; // Probe number
+        unsigned fp = 0; // Key fingerprint
+
+        if (!upo_ht_linprob_find(ht, key, &h, &i, &fp)) // Create the new slot
+        {
+            upo_ht_linprob_insert_at(ht, key, value, h, i, fp);
+        }
+    }
+}
+
+void* upo_ht_linprob_get(const upo_ht_linprob_t ht, const void *key)
+{
+    size_t h = 0; // Slot position
+
+    return upo_ht_linprob_find(ht, key, &h, NULL, NULL) ? upo_ht_linprob_slot_value(ht, h) : NULL;
+}
+
+int upo_ht_linprob_contains(const upo_ht_linprob_t ht, const void *key)
+{
+    /* Alternative #1: same as upo_ht_linprob_get()
+    size_t h = 0;
+
+    return upo_ht_linprob_find(ht, key, &h, NULL, NULL);
+     */
+
+    // Or alternative #2:
+
+    void *value = upo_ht_linprob_get(ht, key);
+
+    return (value == NULL) ? 0 : 1;
+}
+
+void upo_ht_linprob_delete(upo_ht_linprob_t ht, const void *key, int destroy_data)
+{
+    size_t h = 0; // Slot position
+
+    if (upo_ht_linprob_find(ht, key, &h, NULL, NULL))
+    {
+        upo_ht_linprob_remove_at(ht, h, destroy_data);
+    }
+}
+
+int upo_ht_linprob_get_or_insert(upo_ht_linprob_t ht, void *key, void ***value_ptr)
+{
+    size_t h = 0; // Slot position
+    size_t i = 0; // Probe number
+    unsigned fp = 0; // Key fingerprint
+    int inserted = 0;
+
+    /* preconditions */
+    assert( ht != NULL );
+    assert( value_ptr != NULL );
+
+    if (!upo_ht_linprob_find(ht, key, &h, &i, &fp))
+    {
+        h = upo_ht_linprob_insert_at(ht, key, NULL, h, i, fp);
+        inserted = 1;
+    }
+
+    *value_ptr = upo_ht_linprob_slot_value_ref(ht, h);
+
+    return inserted;
+}
+
+void* upo_ht_linprob_compute(upo_ht_linprob_t ht, void *key, upo_ht_updater_t update, void *update_arg)
+{
+    size_t h = 0; // Slot position
+    size_t i = 0; // Probe number
+    unsigned fp = 0; // Key fingerprint
+    int found = 0;
+    void *value = NULL;
+
+    /* preconditions */
+    assert( ht != NULL );
+    assert( update != NULL );
+
+    found = upo_ht_linprob_find(ht, key, &h, &i, &fp);
+
+    value = update(key, found ? upo_ht_linprob_slot_value(ht, h) : NULL, update_arg);
+
+    if (found && value != NULL) // Update the value in place
+    {
+        void *stored_key = upo_ht_linprob_slot_key(ht, h);
+
+        upo_ht_budget_release(ht->budget, stored_key, upo_ht_linprob_slot_value(ht, h));
+        *upo_ht_linprob_slot_value_ref(ht, h) = value;
+
+        if (ht->budget != NULL)
+        {
+            upo_ht_budget_charge(ht->budget, stored_key, value);
+            upo_ht_linprob_evict(ht, 0, stored_key, 0);
+        }
+    }
+    else if (found) // Remove the key
+        upo_ht_linprob_remove_at(ht, h, 0);
+    else if (value != NULL) // Insert the key
+        upo_ht_linprob_insert_at(ht, key, value, h, i, fp);
+
+    return value;
+}
+
+size_t upo_ht_linprob_retain(upo_ht_linprob_t ht, upo_ht_predicate_t pred, void *pred_arg, int destroy_data)
+{
+    size_t removed = 0;
+    size_t i = 0;
+    size_t n = 0; // New capacity
+
+    /* preconditions */
+    assert( pred != NULL );
+
+    if (ht == NULL)
+        return 0;
+
+    if (ht->small)
+    {
+        /* Compact the kept pairs at the beginning of the inline array */
+        for (i = 0; i < ht->size; ++i)
+        {
+            void *key = ht->slots[i].key;
+            void *value = ht->slots[i].value;
+
+            if (pred(key, value, pred_arg))
+            {
+                upo_ht_linprob_slot_set(ht, n++, key, value, 0, 0);
+            }
+            else
+            {
+                upo_ht_budget_release(ht->budget, key, value);
+                if (destroy_data)
+                {
+                    free(key);
+                    free(value);
+                }
+            }
+        }
+        for (i = n; i < ht->size; ++i)
+            upo_ht_linprob_slot_set(ht, i, NULL, NULL, 0, 0);
+
+        removed = ht->size - n;
+        ht->size = n;
+
+        return removed;
+    }
+
+    for (i = 0; i < ht->capacity; ++i)
+    {
+        void *key = upo_ht_linprob_slot_key(ht, i);
+
+        if (key != NULL && !pred(key, upo_ht_linprob_slot_value(ht, i), pred_arg))
+        {
+            upo_ht_budget_release(ht->budget, key, upo_ht_linprob_slot_value(ht, i));
+            if (destroy_data)
+            {
+                free(key);
+                free(upo_ht_linprob_slot_value(ht, i));
+            }
+
+            upo_ht_linprob_slot_set(ht, i, NULL, NULL, 1, 0);
+            removed++;
+        }
+    }
+    ht->size -= removed;
+    ht->tombstones += removed;
+
+    /* Shrink (possibly by more than a half) or purge tombstones only once */
+    n = ht->capacity;
+    while (n > 1 && ht->size <= 0.125 * n)
+        n /= 2;
+
+    if (n < ht->capacity)
+        upo_ht_linprob_resize(ht, n);
+    else if (ht->tombstones > UPO_HT_LINPROB_MAX_TOMBSTONE_RATIO * ht->capacity)
+        upo_ht_linprob_purge(ht);
+
+    return removed;
+}
+
+size_t upo_ht_linprob_size(const upo_ht_linprob_t ht)
 {
     return (ht != NULL) ? ht->size : 0;
 }
 
-int upo_ht_linprob_is_empty(const upo_ht_linprob_t ht)
-{
-    return upo_ht_linprob_size(ht) == 0 ? 1 : 0;
+int upo_ht_linprob_is_empty(const upo_ht_linprob_t ht)
+{
+    return upo_ht_linprob_size(ht) == 0 ? 1 : 0;
+}
+
+size_t upo_ht_linprob_capacity(const upo_ht_linprob_t ht)
+{
+    return (ht != NULL) ? ht->capacity : 0;
+}
+
+upo_ht_comparator_t upo_ht_linprob_get_comparator(const upo_ht_linprob_t ht)
+{
+    return ht->key_cmp;
+}
+
+upo_ht_hasher_t upo_ht_linprob_get_hasher(const upo_ht_linprob_t ht)
+{
+    return ht->key_hash;
+}
+
+void upo_ht_linprob_set_layout(upo_ht_linprob_t ht, upo_ht_linprob_layout_t layout)
+{
+    if (ht != NULL && ht->layout != layout)
+    {
+        struct upo_ht_linprob_s old; // Keeps the slots in the old layout
+        size_t i = 0;
+
+        if (ht->small)
+            upo_ht_linprob_leave_small(ht);
+
+        old = *ht;
+
+        ht->layout = layout;
+        upo_ht_linprob_alloc_slots(ht, old.capacity);
+
+        /* Copy each slot in the same position, since home slots do not change */
+        for (i = 0; i < old.capacity; ++i)
+        {
+            void *key = upo_ht_linprob_slot_key(&old, i);
+
+            upo_ht_linprob_slot_set(ht,
+                                    i,
+                                    key,
+                                    upo_ht_linprob_slot_value(&old, i),
+                                    upo_ht_linprob_slot_tombstone(&old, i),
+                                    (key != NULL) ? upo_ht_linprob_fingerprint(ht, key) : 0);
+        }
+
+        upo_ht_linprob_free_slots(&old);
+    }
+}
+
+upo_ht_linprob_layout_t upo_ht_linprob_get_layout(const upo_ht_linprob_t ht)
+{
+    return (ht != NULL) ? ht->layout : UPO_HT_LINPROB_LAYOUT_AOS;
+}
+
+void upo_ht_linprob_set_probe(upo_ht_linprob_t ht, upo_ht_linprob_probe_t probe)
+{
+    if (ht != NULL && ht->probe != probe)
+    {
+        ht->probe = probe;
+
+        /* Home slots do not change, but probe sequences do */
+        if (!ht->small && ht->capacity > 0)
+            upo_ht_linprob_resize(ht, ht->capacity);
+    }
+}
+
+upo_ht_linprob_probe_t upo_ht_linprob_get_probe(const upo_ht_linprob_t ht)
+{
+    return (ht != NULL) ? ht->probe : UPO_HT_LINPROB_PROBE_LINEAR;
+}
+
+void upo_ht_linprob_set_rehash_threads(upo_ht_linprob_t ht, size_t n)
+{
+    /* preconditions */
+    assert( n > 0 );
+
+    if (ht != NULL)
+        ht->rehash_threads = n;
+}
+
+size_t upo_ht_linprob_get_rehash_threads(const upo_ht_linprob_t ht)
+{
+    return (ht != NULL) ? ht->rehash_threads : 1;
+}
+
+void upo_ht_linprob_enable_generations(upo_ht_linprob_t ht)
+{
+    if (ht != NULL && ht->generation == 0)
+    {
+        size_t i = 0;
+
+        ht->generation = 1;
+        if (ht->layout != UPO_HT_LINPROB_LAYOUT_AOS && ht->capacity > 0)
+        {
+            ht->generations = malloc(ht->capacity*sizeof(unsigned));
+            if (ht->generations == NULL)
+            {
+                upo_throw_sys_error("Unable to allocate memory for slots of the Hash Table with Linear Probing");
+            }
+        }
+
+        /* Current slots belong to the first generation */
+        for (i = 0; i < ht->capacity; ++i)
+        {
+            if (ht->layout == UPO_HT_LINPROB_LAYOUT_AOS)
+                ht->slots[i].generation = ht->generation;
+            else
+                ht->generations[i] = ht->generation;
+        }
+    }
+}
+
+void upo_ht_linprob_disable_generations(upo_ht_linprob_t ht)
+{
+    if (ht != NULL && ht->generation != 0)
+    {
+        size_t i = 0;
+
+        /* Empty the slots of past generations */
+        for (i = 0; i < ht->capacity; ++i)
+        {
+            if (upo_ht_linprob_slot_stale(ht, i))
+                upo_ht_linprob_slot_set(ht, i, NULL, NULL, 0, 0);
+        }
+
+        ht->generation = 0;
+        free(ht->generations);
+        ht->generations = NULL;
+    }
+}
+
+size_t upo_ht_linprob_hash(const upo_ht_linprob_t ht, const void *key)
+{
+    if (ht->stats != NULL)
+        ht->stats->hash_calls++;
+
+    return ht->key_hash(key, ht->capacity);
+}
+
+int upo_ht_linprob_cmp(const upo_ht_linprob_t ht, const void *a, const void *b)
+{
+    if (ht->stats != NULL)
+        ht->stats->cmp_calls++;
+
+    return ht->key_cmp(a, b);
+}
+
+unsigned upo_ht_linprob_fingerprint(const upo_ht_linprob_t ht, const void *key)
+{
+    uint64_t h = 0;
+
+    if (ht->layout == UPO_HT_LINPROB_LAYOUT_AOS)
+        return 0;
+
+    if (ht->stats != NULL)
+        ht->stats->hash_calls++;
+
+    h = upo_ht_hash_wide(ht->key_hash, key);
+
+    if (ht->layout == UPO_HT_LINPROB_LAYOUT_SOA_FP8)
+        return UPO_HT_LINPROB_FP_RESERVED + (unsigned) (h % (UINT8_MAX + 1U - UPO_HT_LINPROB_FP_RESERVED));
+
+    return UPO_HT_LINPROB_FP_RESERVED + (unsigned) (h % (UINT16_MAX + 1U - UPO_HT_LINPROB_FP_RESERVED));
+}
+
+int upo_ht_linprob_find(const upo_ht_linprob_t ht, const void *key, size_t *pos, size_t *probe, unsigned *fp)
+{
+    size_t h = 0; // Slot position
+    size_t i = 0; // Probe number
+    size_t step = 0; // Probe step
+    size_t tomb = 0; // Tombstone slot position
+    size_t tomb_i = 0; // Tombstone probe number
+    int found = 0; // Tombstone found
+
+    if (probe != NULL)
+        *probe = 0;
+
+    if (ht->capacity == 0)
+    {
+        *pos = 0;
+        return 0;
+    }
+
+    if (ht->small)
+    {
+        /* Scan the occupied slots without hashing the key */
+        if (fp != NULL)
+            *fp = 0;
+
+        for (h = 0; h < ht->size; ++h)
+        {
+            if (upo_ht_linprob_cmp(ht, key, ht->slots[h].key) == 0)
+            {
+                *pos = h;
+                return 1;
+            }
+        }
+
+        *pos = ht->size;
+        return 0;
+    }
+
+    step = upo_ht_linprob_probe_step(ht, key);
+
+    if (ht->layout == UPO_HT_LINPROB_LAYOUT_AOS)
+    {
+        h = upo_ht_linprob_hash(ht, key);
+
+        while (!upo_ht_linprob_slot_stale(ht, h) && ((ht->slots[h].key != NULL && upo_ht_linprob_cmp(ht, key, ht->slots[h].key) != 0) || ht->slots[h].tombstone != 0)) // Finds empty slot or slot with the same key
+        {
+            if (ht->slots[h].tombstone != 0 && !found)
+            {
+                found = 1;
+                tomb = h;
+                tomb_i = i;
+            }
+
+            h = upo_ht_linprob_probe_next(ht, h, ++i, step);
+        }
+
+        if (fp != NULL)
+            *fp = 0;
+
+        if (!upo_ht_linprob_slot_stale(ht, h) && ht->slots[h].key != NULL)
+        {
+            *pos = h;
+            if (probe != NULL)
+                *probe = i;
+            return 1;
+        }
+    }
+    else
+    {
+        unsigned key_fp = upo_ht_linprob_fingerprint(ht, key);
+        unsigned slot_fp = 0;
+
+        h = upo_ht_linprob_hash(ht, key);
+
+        if (ht->layout == UPO_HT_LINPROB_LAYOUT_SOA_FP8)
+        {
+            const uint8_t *fps = ht->fingerprints;
+
+            while ((slot_fp = fps[h]) != UPO_HT_LINPROB_FP_EMPTY && !upo_ht_linprob_slot_stale(ht, h)) // Finds empty slot or slot with the same key
+            {
+                if (slot_fp == key_fp && upo_ht_linprob_cmp(ht, key, ht->keys[h]) == 0)
+                    break;
+
+                if (slot_fp == UPO_HT_LINPROB_FP_DELETED && !found)
+                {
+                    found = 1;
+                    tomb = h;
+                    tomb_i = i;
+                }
+
+                h = upo_ht_linprob_probe_next(ht, h, ++i, step);
+            }
+        }
+        else
+        {
+            const uint16_t *fps = ht->fingerprints;
+
+            while ((slot_fp = fps[h]) != UPO_HT_LINPROB_FP_EMPTY && !upo_ht_linprob_slot_stale(ht, h)) // Finds empty slot or slot with the same key
+            {
+                if (slot_fp == key_fp && upo_ht_linprob_cmp(ht, key, ht->keys[h]) == 0)
+                    break;
+
+                if (slot_fp == UPO_HT_LINPROB_FP_DELETED && !found)
+                {
+                    found = 1;
+                    tomb = h;
+                    tomb_i = i;
+                }
+
+                h = upo_ht_linprob_probe_next(ht, h, ++i, step);
+            }
+        }
+
+        if (fp != NULL)
+            *fp = key_fp;
+
+        if (slot_fp != UPO_HT_LINPROB_FP_EMPTY && !upo_ht_linprob_slot_stale(ht, h))
+        {
+            *pos = h;
+            if (probe != NULL)
+                *probe = i;
+            return 1;
+        }
+    }
+
+    *pos = found ? tomb : h;
+    if (probe != NULL)
+        *probe = found ? tomb_i : i;
+
+    return 0;
+}
+
+size_t upo_ht_linprob_insert_at(upo_ht_linprob_t ht, void *key, void *value, size_t pos, size_t probe, unsigned fp)
+{
+    /* Within a memory budget, evict rather than grow */
+    if (ht->budget != NULL && upo_ht_linprob_evict(ht, upo_ht_budget_data_size(ht->budget, key, value), NULL, 1) > 0)
+        upo_ht_linprob_find(ht, key, &pos, &probe, &fp);
+
+    upo_ht_budget_charge(ht->budget, key, value);
+
+    if (ht->small)
+    {
+        if (ht->size < ht->capacity)
+        {
+            upo_ht_linprob_slot_set(ht, pos, key, value, 0, 0);
+            ht->size++;
+
+            return pos;
+        }
+
+        upo_ht_linprob_leave_small(ht);
+        upo_ht_linprob_find(ht, key, &pos, &probe, &fp);
+    }
+    else if (ht->capacity == 0)
+    {
+        upo_ht_linprob_resize(ht, UPO_HT_LINPROB_DEFAULT_CAPACITY);
+        upo_ht_linprob_find(ht, key, &pos, &probe, &fp);
+    }
+    else if (upo_ht_linprob_load_factor(ht) >= 0.5 || ht->size + 1 >= ht->capacity) // Keeps an empty slot to end probe sequences
+    {
+        upo_ht_linprob_resize(ht, upo_ht_linprob_capacity(ht) * 2);
+        upo_ht_linprob_find(ht, key, &pos, &probe, &fp);
+    }
+
+    if (upo_ht_linprob_slot_tombstone(ht, pos))
+        ht->tombstones--;
+
+    upo_ht_linprob_slot_set(ht, pos, key, value, 0, fp);
+    ht->size++;
+    if (probe > ht->max_probe)
+        ht->max_probe = probe;
+
+    return pos;
+}
+
+void upo_ht_linprob_remove_at(upo_ht_linprob_t ht, size_t pos, int destroy_data)
+{
+    upo_ht_budget_release(ht->budget, upo_ht_linprob_slot_key(ht, pos), upo_ht_linprob_slot_value(ht, pos));
+
+    if (destroy_data)
+    {
+        free(upo_ht_linprob_slot_key(ht, pos));
+        free(upo_ht_linprob_slot_value(ht, pos));
+    }
+
+    if (ht->small)
+    {
+        /* Fill the hole with the last pair, so occupied slots stay packed */
+        ht->size--;
+        upo_ht_linprob_slot_set(ht, pos, ht->slots[ht->size].key, ht->slots[ht->size].value, 0, 0);
+        upo_ht_linprob_slot_set(ht, ht->size, NULL, NULL, 0, 0);
+
+        return;
+    }
+
+    upo_ht_linprob_slot_set(ht, pos, NULL, NULL, 1, 0);
+    ht->size--;
+    ht->tombstones++;
+
+    if (upo_ht_linprob_load_factor(ht) <= 0.125 && ht->capacity > 1)
+        upo_ht_linprob_resize(ht, upo_ht_linprob_capacity(ht) / 2);
+    else if (ht->tombstones > UPO_HT_LINPROB_MAX_TOMBSTONE_RATIO * ht->capacity)
+        upo_ht_linprob_purge(ht);
+}
+
+void upo_ht_linprob_alloc_slots(upo_ht_linprob_t ht, size_t m)
+{
+    size_t i = 0;
+
+    ht->slots = NULL;
+    ht->fingerprints = NULL;
+    ht->keys = NULL;
+    ht->values = NULL;
+    ht->generations = NULL;
+    ht->capacity = m;
+
+    if (m == 0)
+        return;
+
+    if (ht->layout == UPO_HT_LINPROB_LAYOUT_AOS)
+    {
+        ht->slots = malloc(m*sizeof(upo_ht_linprob_slot_t));
+        if (ht->slots == NULL)
+        {
+            upo_throw_sys_error("Unable to allocate memory for slots of the Hash Table with Linear Probing");
+        }
+
+        /* Initialize the slots */
+        for (i = 0; i < m; ++i)
+        {
+            ht->slots[i].key = NULL;
+            ht->slots[i].value = NULL;
+            ht->slots[i].tombstone = 0;
+            ht->slots[i].generation = 0;
+        }
+    }
+    else
+    {
+        size_t fp_size = (ht->layout == UPO_HT_LINPROB_LAYOUT_SOA_FP8) ? sizeof(uint8_t) : sizeof(uint16_t);
+
+        /* Note: UPO_HT_LINPROB_FP_EMPTY is zero */
+        ht->fingerprints = calloc(m, fp_size);
+        ht->keys = calloc(m, sizeof(void*));
+        ht->values = calloc(m, sizeof(void*));
+        if (ht->fingerprints == NULL || ht->keys == NULL || ht->values == NULL)
+        {
+            upo_throw_sys_error("Unable to allocate memory for slots of the Hash Table with Linear Probing");
+        }
+
+        /* Note: stamps of past generations make slots read as empty */
+        if (ht->generation != 0)
+        {
+            ht->generations = calloc(m, sizeof(unsigned));
+            if (ht->generations == NULL)
+            {
+                upo_throw_sys_error("Unable to allocate memory for slots of the Hash Table with Linear Probing");
+            }
+        }
+    }
+}
+
+void upo_ht_linprob_free_slots(upo_ht_linprob_t ht)
+{
+    if (ht->slots != upo_ht_linprob_inline_slots(ht))
+        free(ht->slots);
+    free(ht->fingerprints);
+    free(ht->keys);
+    free(ht->values);
+    free(ht->generations);
+    ht->slots = NULL;
+    ht->fingerprints = NULL;
+    ht->keys = NULL;
+    ht->values = NULL;
+    ht->generations = NULL;
+}
+
+int upo_ht_linprob_slot_stale(const upo_ht_linprob_t ht, size_t i)
+{
+    if (ht->generation == 0)
+        return 0;
+
+    if (ht->layout == UPO_HT_LINPROB_LAYOUT_AOS)
+        return ht->slots[i].generation != ht->generation;
+
+    return ht->generations[i] != ht->generation;
+}
+
+void* upo_ht_linprob_slot_key(const upo_ht_linprob_t ht, size_t i)
+{
+    if (upo_ht_linprob_slot_stale(ht, i))
+        return NULL;
+
+    return (ht->layout == UPO_HT_LINPROB_LAYOUT_AOS) ? ht->slots[i].key : ht->keys[i];
+}
+
+void** upo_ht_linprob_slot_value_ref(upo_ht_linprob_t ht, size_t i)
+{
+    return (ht->layout == UPO_HT_LINPROB_LAYOUT_AOS) ? &ht->slots[i].value : &ht->values[i];
+}
+
+void* upo_ht_linprob_slot_value(const upo_ht_linprob_t ht, size_t i)
+{
+    if (upo_ht_linprob_slot_stale(ht, i))
+        return NULL;
+
+    return (ht->layout == UPO_HT_LINPROB_LAYOUT_AOS) ? ht->slots[i].value : ht->values[i];
+}
+
+int upo_ht_linprob_slot_tombstone(const upo_ht_linprob_t ht, size_t i)
+{
+    unsigned fp = 0;
+
+    if (upo_ht_linprob_slot_stale(ht, i))
+        return 0;
+
+    switch (ht->layout)
+    {
+        case UPO_HT_LINPROB_LAYOUT_AOS:
+            return ht->slots[i].tombstone;
+        case UPO_HT_LINPROB_LAYOUT_SOA_FP8:
+            fp = ((const uint8_t*) ht->fingerprints)[i];
+            break;
+        case UPO_HT_LINPROB_LAYOUT_SOA_FP16:
+            fp = ((const uint16_t*) ht->fingerprints)[i];
+            break;
+    }
+
+    if (fp == UPO_HT_LINPROB_FP_DELETED)
+        return 1;
+    if (fp == UPO_HT_LINPROB_FP_PENDING)
+        return UPO_HT_LINPROB_PENDING;
+    return 0;
+}
+
+void upo_ht_linprob_slot_set(upo_ht_linprob_t ht, size_t i, void *key, void *value, int tombstone, unsigned fp)
+{
+    if (ht->layout == UPO_HT_LINPROB_LAYOUT_AOS)
+    {
+        ht->slots[i].key = key;
+        ht->slots[i].value = value;
+        ht->slots[i].tombstone = tombstone;
+        ht->slots[i].generation = ht->generation;
+    }
+    else
+    {
+        if (tombstone == UPO_HT_LINPROB_PENDING)
+            fp = UPO_HT_LINPROB_FP_PENDING;
+        else if (tombstone != 0)
+            fp = UPO_HT_LINPROB_FP_DELETED;
+        else if (key == NULL)
+            fp = UPO_HT_LINPROB_FP_EMPTY;
+
+        ht->keys[i] = key;
+        ht->values[i] = value;
+        if (ht->layout == UPO_HT_LINPROB_LAYOUT_SOA_FP8)
+            ((uint8_t*) ht->fingerprints)[i] = (uint8_t) fp;
+        else
+            ((uint16_t*) ht->fingerprints)[i] = (uint16_t) fp;
+        if (ht->generations != NULL)
+            ht->generations[i] = ht->generation;
+    }
+}
+
+void upo_ht_linprob_slot_swap(upo_ht_linprob_t ht, size_t i, size_t j)
+{
+    if (ht->layout == UPO_HT_LINPROB_LAYOUT_AOS)
+    {
+        upo_swap(&ht->slots[i], &ht->slots[j], sizeof(upo_ht_linprob_slot_t));
+    }
+    else
+    {
+        size_t fp_size = (ht->layout == UPO_HT_LINPROB_LAYOUT_SOA_FP8) ? sizeof(uint8_t) : sizeof(uint16_t);
+
+        upo_swap((char*) ht->fingerprints + i*fp_size, (char*) ht->fingerprints + j*fp_size, fp_size);
+        upo_swap(&ht->keys[i], &ht->keys[j], sizeof(void*));
+        upo_swap(&ht->values[i], &ht->values[j], sizeof(void*));
+        if (ht->generations != NULL)
+            upo_swap(&ht->generations[i], &ht->generations[j], sizeof(unsigned));
+    }
+}
+
+size_t upo_ht_linprob_probe_step(const upo_ht_linprob_t ht, const void *key)
+{
+    if (ht->probe != UPO_HT_LINPROB_PROBE_DOUBLE)
+        return 1;
+
+    if (ht->stats != NULL)
+        ht->stats->hash_calls++;
+
+    /* Use the high half of the wide hash, which is independent of the home
+     * slot; odd steps are coprime with capacities that are powers of two */
+    return ((size_t) (upo_ht_hash_wide(ht->key_hash, key) >> 32) % ht->capacity) | 1U;
+}
+
+size_t upo_ht_linprob_probe_next(const upo_ht_linprob_t ht, size_t h, size_t i, size_t step)
+{
+    switch (ht->probe)
+    {
+        case UPO_HT_LINPROB_PROBE_QUADRATIC:
+            return (h + i) % ht->capacity; // Offsets are the triangular numbers i(i+1)/2
+        case UPO_HT_LINPROB_PROBE_DOUBLE:
+            return (h + step) % ht->capacity;
+        default:
+            return (h + 1) % ht->capacity;
+    }
+}
+
+size_t upo_ht_linprob_probe_capacity(const upo_ht_linprob_t ht, size_t n)
+{
+    size_t m = 1;
+
+    if (ht->probe == UPO_HT_LINPROB_PROBE_LINEAR)
+        return n;
+
+    while (m < n)
+        m *= 2;
+
+    return m;
+}
+
+void upo_ht_linprob_init(upo_ht_linprob_t ht, upo_ht_hasher_t key_hash, upo_ht_comparator_t key_cmp)
+{
+    ht->layout = UPO_HT_LINPROB_LAYOUT_AOS;
+    ht->probe = UPO_HT_LINPROB_PROBE_LINEAR;
+    ht->small = 0;
+    ht->generation = 0;
+    ht->size = 0;
+    ht->tombstones = 0;
+    ht->max_probe = 0;
+    ht->key_hash = key_hash;
+    ht->key_cmp = key_cmp;
+    ht->stats = NULL;
+    ht->budget = NULL;
+    ht->rehash_threads = 1;
+}
+
+upo_ht_linprob_slot_t* upo_ht_linprob_inline_slots(const upo_ht_linprob_t ht)
+{
+    /* Note: for hash tables not created in small mode, this points just past
+     * the hash table type, and is only compared with other pointers */
+    return (upo_ht_linprob_slot_t*) (ht + 1);
+}
+
+void upo_ht_linprob_leave_small(upo_ht_linprob_t ht)
+{
+    upo_ht_linprob_slot_t *pairs = ht->slots; // The inline array of slots
+    size_t n = ht->size;
+    size_t m = UPO_HT_LINPROB_DEFAULT_CAPACITY;
+    size_t i = 0;
+
+    /* preconditions */
+    assert( ht->small );
+
+    while (2*(n + 1) >= m)
+        m *= 2;
+
+    ht->small = 0;
+    upo_ht_linprob_alloc_slots(ht, m);
+    ht->size = 0;
+    ht->max_probe = 0;
+
+    for (i = 0; i < n; ++i)
+    {
+        size_t h = 0; // Slot position
+        size_t j = 0; // Probe number
+        unsigned fp = 0; // Key fingerprint
+
+        upo_ht_linprob_find(ht, pairs[i].key, &h, &j, &fp);
+        upo_ht_linprob_slot_set(ht, h, pairs[i].key, pairs[i].value, 0, fp);
+        ht->size++;
+        if (j > ht->max_probe)
+            ht->max_probe = j;
+    }
+}
+
+double upo_ht_linprob_load_factor(const upo_ht_linprob_t ht)
+{
+    return upo_ht_linprob_size(ht) / (double) upo_ht_linprob_capacity(ht);
+}
+
+void upo_ht_linprob_resize(upo_ht_linprob_t ht, size_t n)
+{
+    /* preconditions */
+    assert( n > 0 );
+
+    if (ht != NULL)
+    {
+        /* The hash table must be rebuilt from scratch since the hash value of
+         * keys will be in general different (due to the change in the
+         * capacity). */
+
+        size_t i = 0;
+        upo_ht_linprob_t new_ht = NULL;
+        upo_hires_timer_t timer = NULL;
+
+        if (ht->stats != NULL)
+        {
+            timer = upo_hires_timer_create();
+            upo_hires_timer_start(timer);
+        }
+
+        /* Create a new temporary hash table with the same storage layout */
+        new_ht = upo_ht_linprob_create(0, ht->key_hash, ht->key_cmp);
+        if (new_ht == NULL)
+        {
+            upo_throw_sys_error("Unable to allocate memory for slots of the Hash Table with Linear Probing");
+        }
+        new_ht->layout = ht->layout;
+        new_ht->probe = ht->probe;
+        new_ht->generation = ht->generation;
+        upo_ht_linprob_alloc_slots(new_ht, upo_ht_linprob_probe_capacity(ht, n));
+
+        if (ht->rehash_threads > 1 && !ht->small && ht->size >= UPO_HT_LINPROB_PARALLEL_REHASH_MIN_SIZE)
+        {
+            upo_ht_linprob_rehash_parallel(ht, new_ht);
+        }
+        else
+        {
+            /* Let the temporary hash table account its calls to the hash
+             * function in the counters of the hash table to resize */
+            new_ht->stats = ht->stats;
+
+            /* Put in the temporary hash table the key-value pairs stored in
+             * the hash table to resize.
+             * Note: by calling function 'put' we are also rehashing the keys
+             * according to the new capacity. */
+            for (i = 0; i < ht->capacity; ++i)
+            {
+                if (upo_ht_linprob_slot_key(ht, i) != NULL)
+                {
+                    upo_ht_linprob_put(new_ht, upo_ht_linprob_slot_key(ht, i), upo_ht_linprob_slot_value(ht, i));
+                }
+            }
+        }
+
+        /* Copy the new slots in the old hash table.
+         * To do so we use a trick that avoids to loop for each key-value pair:
+         * swap the arrays of slots, the size and the capacity between new and
+         * old hash tables. */
+        upo_swap(&ht->slots, &new_ht->slots, sizeof ht->slots);
+        upo_swap(&ht->fingerprints, &new_ht->fingerprints, sizeof ht->fingerprints);
+        upo_swap(&ht->keys, &new_ht->keys, sizeof ht->keys);
+        upo_swap(&ht->values, &new_ht->values, sizeof ht->values);
+        upo_swap(&ht->generations, &new_ht->generations, sizeof ht->generations);
+        upo_swap(&ht->capacity, &new_ht->capacity, sizeof ht->capacity);
+        upo_swap(&ht->size, &new_ht->size, sizeof ht->size);
+        upo_swap(&ht->tombstones, &new_ht->tombstones, sizeof ht->tombstones);
+        upo_swap(&ht->max_probe, &new_ht->max_probe, sizeof ht->max_probe);
+
+        /* Destroy temporary hash table */
+        new_ht->stats = NULL;
+        upo_ht_linprob_destroy(new_ht, 0);
+
+        if (ht->stats != NULL)
+        {
+            upo_hires_timer_stop(timer);
+            ht->stats->resizes++;
+            ht->stats->resize_time += upo_hires_timer_elapsed(timer);
+            upo_hires_timer_destroy(timer);
+        }
+    }
+}
+
+void upo_ht_linprob_rehash_parallel(upo_ht_linprob_t ht, upo_ht_linprob_t new_ht)
+{
+    size_t threads = ht->rehash_threads;
+    upo_ht_linprob_rehash_t *work = NULL;
+    size_t *homes = NULL;
+    size_t *order = NULL;
+    size_t *counts = NULL;
+    size_t *bounds = NULL;
+    size_t offset = 0;
+    size_t r = 0;
+    size_t w = 0;
+    size_t k = 0;
+
+    /* Keep at least one new slot for each region */
+    if (threads > new_ht->capacity)
+        threads = new_ht->capacity;
+
+    work = malloc(threads*sizeof(upo_ht_linprob_rehash_t));
+    homes = malloc(ht->capacity*sizeof(size_t));
+    order = malloc(ht->size*sizeof(size_t));
+    counts = calloc(threads*threads, sizeof(size_t));
+    bounds = malloc((threads + 1)*sizeof(size_t));
+    if (work == NULL || homes == NULL || order == NULL || counts == NULL || bounds == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for rehashing the Hash Table with Linear Probing");
+    }
+
+    for (w = 0; w < threads; ++w)
+    {
+        work[w].from = ht;
+        work[w].to = new_ht;
+        work[w].id = w;
+        work[w].threads = threads;
+        work[w].homes = homes;
+        work[w].order = order;
+        work[w].counts = counts;
+        work[w].bounds = bounds;
+        work[w].deferred = 0;
+        work[w].max_probe = 0;
+    }
+
+    /* Phase 1: hash the keys of each chunk of old slots */
+    upo_ht_linprob_rehash_run(work, threads, upo_ht_linprob_rehash_hash);
+
+    /* Turn the counts into offsets, so that the keys of each region are
+     * contiguous in 'order' and each chunk has its own part of them */
+    for (r = 0; r < threads; ++r)
+    {
+        bounds[r] = offset;
+        for (w = 0; w < threads; ++w)
+        {
+            size_t count = counts[w*threads + r];
+
+            counts[w*threads + r] = offset;
+            offset += count;
+        }
+    }
+    bounds[threads] = offset;
+
+    /* Phase 2: group the keys by region */
+    upo_ht_linprob_rehash_run(work, threads, upo_ht_linprob_rehash_partition);
+
+    /* Phase 3: insert the keys of each region into its slots */
+    upo_ht_linprob_rehash_run(work, threads, upo_ht_linprob_rehash_insert);
+
+    /* Insert the keys whose probe sequence crossed a region boundary */
+    for (r = 0; r < threads; ++r)
+    {
+        for (k = 0; k < work[r].deferred; ++k)
+        {
+            upo_ht_linprob_rehash_put(&work[r], order[bounds[r] + k], 0);
+        }
+    }
+
+    new_ht->size = ht->size;
+    new_ht->tombstones = 0;
+    for (w = 0; w < threads; ++w)
+    {
+        if (work[w].max_probe > new_ht->max_probe)
+            new_ht->max_probe = work[w].max_probe;
+    }
+
+    /* Account the calls to the hash function that 'put' would have made */
+    if (ht->stats != NULL)
+    {
+        ht->stats->hash_calls += ht->size;
+        if (ht->layout != UPO_HT_LINPROB_LAYOUT_AOS)
+            ht->stats->hash_calls += ht->size;
+        if (ht->probe == UPO_HT_LINPROB_PROBE_DOUBLE)
+            ht->stats->hash_calls += ht->size;
+    }
+
+    free(bounds);
+    free(counts);
+    free(order);
+    free(homes);
+    free(work);
+}
+
+void upo_ht_linprob_rehash_run(upo_ht_linprob_rehash_t *work, size_t threads, void* (*run)(void*))
+{
+    pthread_t *tids = NULL;
+    int *started = NULL;
+    size_t w = 0;
+
+    tids = malloc(threads*sizeof(pthread_t));
+    started = calloc(threads, sizeof(int));
+    if (tids == NULL || started == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for rehashing the Hash Table with Linear Probing");
+    }
+
+    for (w = 1; w < threads; ++w)
+    {
+        started[w] = (pthread_create(&tids[w], NULL, run, &work[w]) == 0);
+    }
+
+    run(&work[0]);
+
+    for (w = 1; w < threads; ++w)
+    {
+        if (started[w])
+            pthread_join(tids[w], NULL);
+        else
+            run(&work[w]); // The works of a phase are independent
+    }
+
+    free(started);
+    free(tids);
+}
+
+size_t upo_ht_linprob_rehash_region_start(const upo_ht_linprob_rehash_t *work, size_t r)
+{
+    /* Region 'r' holds the slots 'h' such that h*threads/capacity == r */
+    return (r*work->to->capacity + work->threads - 1) / work->threads;
+}
+
+void* upo_ht_linprob_rehash_hash(void *work)
+{
+    upo_ht_linprob_rehash_t *wk = work;
+    size_t begin = wk->id*wk->from->capacity / wk->threads;
+    size_t end = (wk->id + 1)*wk->from->capacity / wk->threads;
+    size_t *counts = wk->counts + wk->id*wk->threads;
+    size_t i = 0;
+
+    for (i = begin; i < end; ++i)
+    {
+        void *key = upo_ht_linprob_slot_key(wk->from, i);
+
+        if (key != NULL)
+        {
+            size_t h = upo_ht_linprob_hash(wk->to, key);
+
+            wk->homes[i] = h;
+            counts[h*wk->threads / wk->to->capacity]++;
+        }
+    }
+
+    return NULL;
+}
+
+void* upo_ht_linprob_rehash_partition(void *work)
+{
+    upo_ht_linprob_rehash_t *wk = work;
+    size_t begin = wk->id*wk->from->capacity / wk->threads;
+    size_t end = (wk->id + 1)*wk->from->capacity / wk->threads;
+    size_t *offsets = wk->counts + wk->id*wk->threads;
+    size_t i = 0;
+
+    for (i = begin; i < end; ++i)
+    {
+        if (upo_ht_linprob_slot_key(wk->from, i) != NULL)
+        {
+            wk->order[offsets[wk->homes[i]*wk->threads / wk->to->capacity]++] = i;
+        }
+    }
+
+    return NULL;
+}
+
+void* upo_ht_linprob_rehash_insert(void *work)
+{
+    upo_ht_linprob_rehash_t *wk = work;
+    size_t k = 0;
+
+    for (k = wk->bounds[wk->id]; k < wk->bounds[wk->id + 1]; ++k)
+    {
+        size_t i = wk->order[k];
+
+        if (!upo_ht_linprob_rehash_put(wk, i, 1))
+        {
+            /* Slots before 'k' have been consumed, so reuse them */
+            wk->order[wk->bounds[wk->id] + wk->deferred] = i;
+            wk->deferred++;
+        }
+    }
+
+    return NULL;
+}
+
+int upo_ht_linprob_rehash_put(upo_ht_linprob_rehash_t *work, size_t i, int bounded)
+{
+    upo_ht_linprob_t to = work->to;
+    void *key = upo_ht_linprob_slot_key(work->from, i);
+    size_t begin = upo_ht_linprob_rehash_region_start(work, work->id);
+    size_t end = upo_ht_linprob_rehash_region_start(work, work->id + 1);
+    size_t step = upo_ht_linprob_probe_step(to, key);
+    size_t h = work->homes[i];
+    size_t j = 0; // Probe number
+
+    /* Keys are distinct, so the first empty slot is the one to claim */
+    while (upo_ht_linprob_slot_key(to, h) != NULL)
+    {
+        h = upo_ht_linprob_probe_next(to, h, ++j, step);
+        if (bounded && (h < begin || h >= end))
+            return 0;
+    }
+
+    upo_ht_linprob_slot_set(to, h, key, upo_ht_linprob_slot_value(work->from, i), 0, upo_ht_linprob_fingerprint(to, key));
+    if (j > work->max_probe)
+        work->max_probe = j;
+
+    return 1;
+}
+
+void upo_ht_linprob_purge(upo_ht_linprob_t ht)
+{
+    size_t i = 0;
+
+    /* Rehash in place, without allocating a second array of slots:
+     * 1. tombstones become empty slots, while occupied slots are marked as
+     *    pending (i.e., still to rehash);
+     * 2. each pending key is moved to the first slot of its probe sequence
+     *    that is not occupied by an already rehashed key; if that slot holds
+     *    another pending key, the two keys are swapped and the key just moved
+     *    into the current slot is rehashed in turn.
+     * Rehashed keys are never moved again, so each of them is reachable from
+     * its home slot through rehashed keys only. */
+    for (i = 0; i < ht->capacity; ++i)
+    {
+        void *key = upo_ht_linprob_slot_key(ht, i);
+
+        upo_ht_linprob_slot_set(ht, i, key, upo_ht_linprob_slot_value(ht, i), (key != NULL) ? UPO_HT_LINPROB_PENDING : 0, 0);
+    }
+    ht->max_probe = 0;
+
+    for (i = 0; i < ht->capacity; ++i)
+    {
+        while (upo_ht_linprob_slot_tombstone(ht, i) == UPO_HT_LINPROB_PENDING)
+        {
+            void *key = upo_ht_linprob_slot_key(ht, i);
+            void *value = upo_ht_linprob_slot_value(ht, i);
+            unsigned fp = upo_ht_linprob_fingerprint(ht, key);
+            size_t step = upo_ht_linprob_probe_step(ht, key);
+            size_t h = upo_ht_linprob_hash(ht, key);
+            size_t j = 0; // Probe number
+
+            while (upo_ht_linprob_slot_key(ht, h) != NULL && upo_ht_linprob_slot_tombstone(ht, h) != UPO_HT_LINPROB_PENDING) // Finds the first slot not holding a rehashed key
+                h = upo_ht_linprob_probe_next(ht, h, ++j, step);
+
+            if (j > ht->max_probe)
+                ht->max_probe = j;
+
+            if (h == i) // Already in place
+            {
+                upo_ht_linprob_slot_set(ht, i, key, value, 0, fp);
+            }
+            else if (upo_ht_linprob_slot_key(ht, h) == NULL) // Move to an empty slot
+            {
+                upo_ht_linprob_slot_set(ht, h, key, value, 0, fp);
+                upo_ht_linprob_slot_set(ht, i, NULL, NULL, 0, 0);
+            }
+            else // Swap with a pending key
+            {
+                upo_ht_linprob_slot_swap(ht, h, i);
+                upo_ht_linprob_slot_set(ht, h, key, value, 0, fp);
+            }
+        }
+    }
+
+    ht->tombstones = 0;
+}
+
+
+/*** END of HASH TABLE with LINEAR PROBING ***/
+
+
+/*** BEGIN of HASH TABLE - EXTRA OPERATIONS ***/
+
+
+upo_ht_key_list_t upo_ht_sepchain_keys(const upo_ht_sepchain_t ht)
+{
+    upo_ht_key_list_t list = NULL;
+
+    size_t i;
+
+    if (!upo_ht_sepchain_is_empty(ht))
+    {
+        for (i = 0; i < upo_ht_sepchain_capacity(ht); i++)
+        {
+            upo_ht_sepchain_list_node_t *node = NULL;
+
+            for (node = upo_ht_sepchain_slot_head(ht, i); node != NULL; node = node->next)
+            {
+                upo_ht_key_list_node_t  *listNode = malloc(sizeof(struct upo_ht_key_list_node_s));
+
+                if (listNode == NULL)
+                    upo_throw_sys_error("Unable to allocate memory for a new node of the key list");
+
+                listNode->key = node->key;
+                listNode->next = list;
+                list = listNode;
+            }
+        }
+    }
+
+    return list;
+}
+
+void upo_ht_sepchain_traverse(const upo_ht_sepchain_t ht, upo_ht_visitor_t visit, void *visit_arg)
+{
+    size_t i = 0;
+
+    if (!upo_ht_sepchain_is_empty(ht) && visit != NULL)
+    {
+        for (i = 0; i < upo_ht_sepchain_capacity(ht); i++)
+        {
+            upo_ht_sepchain_list_node_t *n = upo_ht_sepchain_slot_head(ht, i);
+
+            while (n != NULL)
+            {
+                visit(n->key, n->value, visit_arg);
+                n = n->next;
+            }
+        }
+    }
+}
+
+upo_ht_key_list_t upo_ht_linprob_keys(const upo_ht_linprob_t ht)
+{
+    upo_ht_key_list_t list = NULL;
+
+    size_t i;
+
+    if (!upo_ht_linprob_is_empty(ht))
+    {
+        for (i = 0; i < upo_ht_linprob_capacity(ht); i++)
+        {
+            void *key = upo_ht_linprob_slot_key(ht, i);
+
+            if (key != NULL)
+            {
+                upo_ht_key_list_node_t *listNode = malloc(sizeof(struct upo_ht_key_list_node_s));
+
+                if (listNode == NULL)
+                    upo_throw_sys_error("Unable to allocate memory for a new node of the key list");
+
+                listNode->key = key;
+                listNode->next = list;
+                list = listNode;
+            }
+        }
+    }
+
+    return list;
+}
+
+void upo_ht_linprob_traverse(const upo_ht_linprob_t ht, upo_ht_visitor_t visit, void *visit_arg)
+{
+    size_t i;
+
+    if (!upo_ht_linprob_is_empty(ht)  && visit != NULL)
+    {
+        for (i = 0; i < upo_ht_linprob_capacity(ht); i++)
+        {
+            if (upo_ht_linprob_slot_key(ht, i) != NULL)
+                visit(upo_ht_linprob_slot_key(ht, i), upo_ht_linprob_slot_value(ht, i), visit_arg);
+        }
+    }
+}
+
+size_t upo_ht_linprob_scan(const upo_ht_linprob_t ht, size_t cursor, size_t count, upo_ht_visitor_t visit, void *visit_arg)
+{
+    size_t mask = 1;
+    size_t steps = 0;
+
+    /* preconditions */
+    assert( visit != NULL );
+
+    if (upo_ht_linprob_is_empty(ht))
+        return 0;
+
+    if (ht->small || ht->probe == UPO_HT_LINPROB_PROBE_DOUBLE)
+    {
+        /* Keys cannot be enumerated by home slot */
+        upo_ht_linprob_traverse(ht, visit, visit_arg);
+        return 0;
+    }
+
+    /* The cursor addresses the slots of the smallest power of two that covers
+     * the capacity; slots past the capacity are skipped without counting */
+    while (mask < ht->capacity)
+        mask <<= 1;
+    mask -= 1;
+
+    do
+    {
+        size_t h = cursor & mask;
+
+        if (h < ht->capacity)
+        {
+            upo_ht_linprob_scan_slot(ht, h, visit, visit_arg);
+            ++steps;
+        }
+
+        cursor = upo_ht_linprob_scan_next(cursor, mask);
+    }
+    while (cursor != 0 && steps < count);
+
+    return cursor;
 }
 
-size_t upo_ht_linprob_capacity(const upo_ht_linprob_t ht)
+void upo_ht_linprob_scan_slot(const upo_ht_linprob_t ht, size_t h, upo_ht_visitor_t visit, void *visit_arg)
 {
-    return (ht != NULL) ? ht->capacity : 0;
+    size_t j = h;
+    size_t i = 0;
+    void *key = NULL;
+
+    /* preconditions */
+    assert( ht->probe != UPO_HT_LINPROB_PROBE_DOUBLE );
+
+    /* Walk the probe sequence of the home slot up to its first empty slot,
+     * but no further than any key has ever been placed from its home slot */
+    while (i <= ht->max_probe && ((key = upo_ht_linprob_slot_key(ht, j)) != NULL || upo_ht_linprob_slot_tombstone(ht, j)))
+    {
+        if (key != NULL && upo_ht_linprob_hash(ht, key) == h)
+            visit(key, upo_ht_linprob_slot_value(ht, j), visit_arg);
+
+        j = upo_ht_linprob_probe_next(ht, j, ++i, 1);
+    }
 }
 
-upo_ht_comparator_t upo_ht_linprob_get_comparator(const upo_ht_linprob_t ht)
+size_t upo_ht_linprob_scan_next(size_t cursor, size_t mask)
 {
-    return ht->key_cmp;
+    size_t r = 0;
+    size_t bit = 0;
+
+    /* Set the unmasked bits, so that the increment carries past them */
+    cursor |= ~mask;
+
+    /* Reverse the bits, increment and reverse them back */
+    for (bit = 0; bit < sizeof cursor * CHAR_BIT; ++bit)
+        r = (r << 1) | ((cursor >> bit) & 1);
+    ++r;
+    cursor = 0;
+    for (bit = 0; bit < sizeof r * CHAR_BIT; ++bit)
+        cursor = (cursor << 1) | ((r >> bit) & 1);
+
+    return cursor;
 }
 
-upo_ht_hasher_t upo_ht_linprob_get_hasher(const upo_ht_linprob_t ht)
+
+/*** END of HASH TABLE - EXTRA OPERATIONS ***/
+
+
+/*** BEGIN of HASH TABLE STATISTICS ***/
+
+
+void upo_ht_sepchain_enable_stats(upo_ht_sepchain_t ht)
 {
-    return ht->key_hash;
+    if (ht != NULL && ht->stats == NULL)
+    {
+        ht->stats = calloc(1, sizeof(upo_ht_stats_counters_t));
+        if (ht->stats == NULL)
+        {
+            upo_throw_sys_error("Unable to allocate memory for statistics of the Hash Table with Separate Chaining");
+        }
+    }
 }
 
-double upo_ht_linprob_load_factor(const upo_ht_linprob_t ht)
+void upo_ht_sepchain_disable_stats(upo_ht_sepchain_t ht)
 {
-    return upo_ht_linprob_size(ht) / (double) upo_ht_linprob_capacity(ht);
+    if (ht != NULL)
+    {
+        free(ht->stats);
+        ht->stats = NULL;
+    }
 }
 
-void upo_ht_linprob_resize(upo_ht_linprob_t ht, size_t n)
+void upo_ht_sepchain_stats(const upo_ht_sepchain_t ht, upo_ht_stats_t *stats)
 {
+    size_t i = 0;
+
     /* preconditions */
-    assert( n > 0 );
+    assert( stats != NULL );
+
+    memset(stats, 0, sizeof *stats);
 
     if (ht != NULL)
     {
-        /* The hash table must be rebuilt from scratch since the hash value of
-         * keys will be in general different (due to the change in the
-         * capacity). */
+        stats->capacity = ht->capacity;
+        stats->size = ht->size;
 
-        size_t i = 0;
-        upo_ht_linprob_t new_ht = NULL;
+        /* Chain-length distribution */
+        for (i = 0; i < ht->capacity; ++i)
+        {
+            upo_ht_sepchain_list_node_t *node = NULL;
+            size_t len = 0;
 
-        /* Create a new temporary hash table */
-        new_ht = upo_ht_linprob_create(n, ht->key_hash, ht->key_cmp);
-        if (new_ht == NULL)
+            for (node = upo_ht_sepchain_slot_head(ht, i); node != NULL; node = node->next)
+                len++;
+
+            stats->histogram[len < UPO_HT_STATS_HISTOGRAM_SIZE ? len : UPO_HT_STATS_HISTOGRAM_SIZE-1]++;
+
+            if (len > stats->longest_cluster)
+                stats->longest_cluster = len;
+        }
+
+        if (ht->stats != NULL)
+        {
+            stats->hash_calls = ht->stats->hash_calls;
+            stats->cmp_calls = ht->stats->cmp_calls;
+            stats->resizes = ht->stats->resizes;
+            stats->resize_time = ht->stats->resize_time;
+        }
+    }
+}
+
+void upo_ht_linprob_enable_stats(upo_ht_linprob_t ht)
+{
+    if (ht != NULL && ht->stats == NULL)
+    {
+        ht->stats = calloc(1, sizeof(upo_ht_stats_counters_t));
+        if (ht->stats == NULL)
         {
-            upo_throw_sys_error("Unable to allocate memory for slots of the Hash Table with Separate Chaining");
+            upo_throw_sys_error("Unable to allocate memory for statistics of the Hash Table with Linear Probing");
         }
+    }
+}
+
+void upo_ht_linprob_disable_stats(upo_ht_linprob_t ht)
+{
+    if (ht != NULL)
+    {
+        free(ht->stats);
+        ht->stats = NULL;
+    }
+}
+
+void upo_ht_linprob_stats(const upo_ht_linprob_t ht, upo_ht_stats_t *stats)
+{
+    size_t i = 0;
+    size_t run = 0; // Length of the current run of non-empty slots
+
+    /* preconditions */
+    assert( stats != NULL );
+
+    memset(stats, 0, sizeof *stats);
+
+    if (ht != NULL)
+    {
+        stats->capacity = ht->capacity;
+        stats->size = ht->size;
+        stats->tombstones = ht->tombstones;
 
-        /* Put in the temporary hash table the key-value pairs stored in the
-         * hash table to resize.
-         * Note: by calling function 'put' we are also rehashing the keys
-         * according to the new capacity. */
         for (i = 0; i < ht->capacity; ++i)
         {
-            if (ht->slots[i].key != NULL)
+            if (upo_ht_linprob_slot_key(ht, i) != NULL)
+            {
+                /* Probe length: distance from the home slot (with wrap-around),
+                 * or from the first slot in small mode */
+                size_t h = ht->small ? 0 : ht->key_hash(upo_ht_linprob_slot_key(ht, i), ht->capacity);
+                size_t dist = (i + ht->capacity - h) % ht->capacity;
+
+                if (!ht->small && ht->probe != UPO_HT_LINPROB_PROBE_LINEAR)
+                {
+                    struct upo_ht_linprob_s view = *ht; // Does not count hash calls
+                    size_t step = 0;
+
+                    view.stats = NULL;
+                    step = upo_ht_linprob_probe_step(&view, upo_ht_linprob_slot_key(ht, i));
+                    for (dist = 0; h != i; )
+                        h = upo_ht_linprob_probe_next(ht, h, ++dist, step);
+                }
+
+                stats->histogram[dist < UPO_HT_STATS_HISTOGRAM_SIZE ? dist : UPO_HT_STATS_HISTOGRAM_SIZE-1]++;
+            }
+
+            if (upo_ht_linprob_slot_key(ht, i) != NULL || upo_ht_linprob_slot_tombstone(ht, i))
+            {
+                run++;
+                if (run > stats->longest_cluster)
+                    stats->longest_cluster = run;
+            }
+            else
             {
-                upo_ht_linprob_put(new_ht, ht->slots[i].key, ht->slots[i].value);
+                run = 0;
             }
         }
 
-        /* Copy the new slots in the old hash table.
-         * To do so we use a trick that avoids to loop for each key-value pair:
-         * swap the array of slots, the size and the capacity between new and
-         * old hash tables. */
-        upo_swap(&ht->slots, &new_ht->slots, sizeof ht->slots);
-        upo_swap(&ht->capacity, &new_ht->capacity, sizeof ht->capacity);
-        upo_swap(&ht->size, &new_ht->size, sizeof ht->size);
+        /* A cluster may wrap around the end of the array of slots */
+        if (run > 0 && run < ht->capacity)
+        {
+            for (i = 0; i < ht->capacity && (upo_ht_linprob_slot_key(ht, i) != NULL || upo_ht_linprob_slot_tombstone(ht, i)); ++i)
+                run++;
 
-        /* Destroy temporary hash table */
-        upo_ht_linprob_destroy(new_ht, 0);
+            if (run > stats->longest_cluster)
+                stats->longest_cluster = run;
+        }
+
+        if (ht->stats != NULL)
+        {
+            stats->hash_calls = ht->stats->hash_calls;
+            stats->cmp_calls = ht->stats->cmp_calls;
+            stats->resizes = ht->stats->resizes;
+            stats->resize_time = ht->stats->resize_time;
+        }
     }
 }
 
+void upo_ht_stats_print(const upo_ht_stats_t *stats, FILE *stream)
+{
+    size_t i = 0;
 
-/*** END of HASH TABLE with LINEAR PROBING ***/
+    /* preconditions */
+    assert( stats != NULL );
+    assert( stream != NULL );
 
+    fprintf(stream, "capacity: %zu, size: %zu, tombstones: %zu, longest cluster: %zu\n", stats->capacity, stats->size, stats->tombstones, stats->longest_cluster);
+    fprintf(stream, "histogram:");
+    for (i = 0; i < UPO_HT_STATS_HISTOGRAM_SIZE; ++i)
+    {
+        fprintf(stream, " %zu", stats->histogram[i]);
+    }
+    fputc('\n', stream);
+    fprintf(stream, "hash calls: %zu, comparisons: %zu, resizes: %zu, resize time: %f s\n", stats->hash_calls, stats->cmp_calls, stats->resizes, stats->resize_time);
+}
 
-/*** BEGIN of HASH TABLE - EXTRA OPERATIONS ***/
 
+/*** END of HASH TABLE STATISTICS ***/
 
-upo_ht_key_list_t upo_ht_sepchain_keys(const upo_ht_sepchain_t ht)
+
+/*** BEGIN of HASH TABLE MEMORY BUDGET ***/
+
+
+void upo_ht_sepchain_set_budget(upo_ht_sepchain_t ht, const upo_ht_budget_t *budget)
 {
-    upo_ht_key_list_t list = NULL;
+    size_t i = 0;
 
-    size_t i;
+    if (ht == NULL)
+        return;
 
-    if (!upo_ht_sepchain_is_empty(ht))
+    if (budget == NULL)
     {
-        for (i = 0; i < upo_ht_sepchain_capacity(ht); i++)
+        free(ht->budget);
+        ht->budget = NULL;
+        return;
+    }
+
+    if (ht->budget == NULL)
+    {
+        ht->budget = malloc(sizeof(upo_ht_budget_state_t));
+        if (ht->budget == NULL)
         {
-            upo_ht_sepchain_list_node_t *node = NULL;
+            upo_throw_sys_error("Unable to allocate memory for the budget of the Hash Table with Separate Chaining");
+        }
+        ht->budget->seed = UINT64_C(0x9E3779B97F4A7C15);
+    }
+    ht->budget->budget = *budget;
 
-            for (node = ht->slots[i].head; node != NULL; node = node->next)
-            {
-                upo_ht_key_list_node_t  *listNode = malloc(sizeof(struct upo_ht_key_list_node_s));
+    /* The sizing function may have changed, so data is sized again */
+    ht->budget->data_bytes = 0;
+    for (i = 0; i < ht->capacity; ++i)
+    {
+        upo_ht_sepchain_list_node_t *node = NULL;
 
-                if (listNode == NULL)
-                    upo_throw_sys_error("Unable to allocate memory for a new node of the key list");
+        for (node = upo_ht_sepchain_slot_head(ht, i); node != NULL; node = node->next)
+            upo_ht_budget_charge(ht->budget, node->key, node->value);
+    }
 
-                listNode->key = node->key;
-                listNode->next = list;
-                list = listNode;
-            }
-        }
+    upo_ht_sepchain_evict(ht, 0, NULL);
+}
+
+size_t upo_ht_sepchain_memory(const upo_ht_sepchain_t ht)
+{
+    if (ht == NULL)
+        return 0;
+
+    return sizeof(struct upo_ht_sepchain_s)
+           + ht->capacity*(sizeof(upo_ht_sepchain_slot_t) + ((ht->generation != 0) ? sizeof(unsigned) : 0))
+           + ht->size*sizeof(upo_ht_sepchain_list_node_t)
+           + ((ht->budget != NULL) ? ht->budget->data_bytes : 0);
+}
+
+size_t upo_ht_sepchain_evict(upo_ht_sepchain_t ht, size_t extra, const void *keep)
+{
+    size_t evicted = 0;
+    upo_ht_sepchain_list_node_t **link = NULL;
+
+    while (ht->size > 0
+           && upo_ht_sepchain_memory(ht) + extra > ht->budget->budget.max_bytes
+           && (link = upo_ht_sepchain_victim(ht, keep)) != NULL)
+    {
+        upo_ht_sepchain_list_node_t *node = *link;
+
+        *link = node->next;
+
+        if (ht->budget->budget.evict != NULL)
+            ht->budget->budget.evict(node->key, node->value, ht->budget->budget.arg);
+
+        upo_ht_budget_release(ht->budget, node->key, node->value);
+        upo_ht_sepchain_destroy_node(node, ht->budget->budget.destroy_data);
+        ht->size--;
+        evicted++;
     }
 
-    return list;
+    return evicted;
 }
 
-void upo_ht_sepchain_traverse(const upo_ht_sepchain_t ht, upo_ht_visitor_t visit, void *visit_arg)
+upo_ht_sepchain_list_node_t** upo_ht_sepchain_victim(upo_ht_sepchain_t ht, const void *keep)
 {
+    const upo_ht_budget_t *budget = &ht->budget->budget;
+    size_t samples = (budget->samples > 0) ? budget->samples : UPO_HT_BUDGET_DEFAULT_SAMPLES;
+    size_t start = upo_ht_budget_random(ht->budget, ht->capacity);
+    size_t found = 0;
     size_t i = 0;
+    unsigned long best_rank = 0;
+    upo_ht_sepchain_list_node_t **victim = NULL;
 
-    if (!upo_ht_sepchain_is_empty(ht) && visit != NULL)
+    /* Sample the first nodes from a random slot on */
+    for (i = 0; i < ht->capacity && found < samples; ++i)
     {
-        for (i = 0; i < upo_ht_sepchain_capacity(ht); i++)
+        size_t h = (start + i) % ht->capacity;
+        upo_ht_sepchain_list_node_t **link = NULL;
+
+        if (upo_ht_sepchain_slot_head(ht, h) == NULL)
+            continue;
+
+        for (link = &ht->slots[h].head; *link != NULL && found < samples; link = &(*link)->next)
         {
-            upo_ht_sepchain_list_node_t *n = ht->slots[i].head;
+            unsigned long rank = 0;
 
-            while (n != NULL)
+            if ((*link)->key == keep)
+                continue;
+
+            if (budget->rank == NULL)
+                return link;
+
+            rank = budget->rank((*link)->key, (*link)->value, budget->arg);
+            if (victim == NULL || rank < best_rank)
             {
-                visit(n->key, n->value, visit_arg);
-                n = n->next;
+                victim = link;
+                best_rank = rank;
             }
+            found++;
         }
     }
+
+    return victim;
 }
 
-upo_ht_key_list_t upo_ht_linprob_keys(const upo_ht_linprob_t ht)
+void upo_ht_linprob_set_budget(upo_ht_linprob_t ht, const upo_ht_budget_t *budget)
 {
-    upo_ht_key_list_t list = NULL;
+    size_t i = 0;
 
-    size_t i;
+    if (ht == NULL)
+        return;
 
-    if (!upo_ht_linprob_is_empty(ht))
+    if (budget == NULL)
     {
-        for (i = 0; i < upo_ht_linprob_capacity(ht); i++)
+        free(ht->budget);
+        ht->budget = NULL;
+        return;
+    }
+
+    if (ht->budget == NULL)
+    {
+        ht->budget = malloc(sizeof(upo_ht_budget_state_t));
+        if (ht->budget == NULL)
         {
-            upo_ht_linprob_slot_t slot = ht->slots[i];
+            upo_throw_sys_error("Unable to allocate memory for the budget of the Hash Table with Linear Probing");
+        }
+        ht->budget->seed = UINT64_C(0x9E3779B97F4A7C15);
+    }
+    ht->budget->budget = *budget;
 
-            if (slot.key != NULL)
-            {
-                upo_ht_key_list_node_t *listNode = malloc(sizeof(struct upo_ht_key_list_node_s));
+    /* The sizing function may have changed, so data is sized again */
+    ht->budget->data_bytes = 0;
+    for (i = 0; i < ht->capacity; ++i)
+    {
+        void *key = upo_ht_linprob_slot_key(ht, i);
 
-                if (listNode == NULL)
-                    upo_throw_sys_error("Unable to allocate memory for a new node of the key list");
+        if (key != NULL)
+            upo_ht_budget_charge(ht->budget, key, upo_ht_linprob_slot_value(ht, i));
+    }
 
-                listNode->key = slot.key;
-                listNode->next = list;
-                list = listNode;
-            }
-        }
+    upo_ht_linprob_evict(ht, 0, NULL, 0);
+}
+
+size_t upo_ht_linprob_memory(const upo_ht_linprob_t ht)
+{
+    return (ht != NULL) ? upo_ht_linprob_memory_at(ht, ht->capacity) : 0;
+}
+
+size_t upo_ht_linprob_grown_capacity(const upo_ht_linprob_t ht)
+{
+    size_t m = UPO_HT_LINPROB_DEFAULT_CAPACITY;
+
+    if (ht->small)
+    {
+        if (ht->size < ht->capacity)
+            return ht->capacity;
+
+        /* Same as upo_ht_linprob_leave_small() */
+        while (2*(ht->size + 1) >= m)
+            m *= 2;
+
+        return m;
     }
 
-    return list;
+    if (ht->capacity == 0)
+        return upo_ht_linprob_probe_capacity(ht, UPO_HT_LINPROB_DEFAULT_CAPACITY);
+
+    if (upo_ht_linprob_load_factor(ht) >= 0.5 || ht->size + 1 >= ht->capacity)
+        return upo_ht_linprob_probe_capacity(ht, ht->capacity * 2);
+
+    return ht->capacity;
 }
 
-void upo_ht_linprob_traverse(const upo_ht_linprob_t ht, upo_ht_visitor_t visit, void *visit_arg)
+size_t upo_ht_linprob_memory_at(const upo_ht_linprob_t ht, size_t m)
 {
-    size_t i;
+    size_t bytes = sizeof(struct upo_ht_linprob_s);
 
-    if (!upo_ht_linprob_is_empty(ht)  && visit != NULL)
+    if (ht->small && m == ht->capacity)
     {
-        for (i = 0; i < upo_ht_linprob_capacity(ht); i++)
+        bytes += m*sizeof(upo_ht_linprob_slot_t); // The inline array of slots
+    }
+    else if (ht->layout == UPO_HT_LINPROB_LAYOUT_AOS)
+    {
+        bytes += m*sizeof(upo_ht_linprob_slot_t);
+    }
+    else
+    {
+        size_t fp_size = (ht->layout == UPO_HT_LINPROB_LAYOUT_SOA_FP8) ? sizeof(uint8_t) : sizeof(uint16_t);
+
+        bytes += m*(fp_size + 2*sizeof(void*) + ((ht->generation != 0) ? sizeof(unsigned) : 0));
+    }
+
+    if (ht->budget != NULL)
+        bytes += ht->budget->data_bytes;
+
+    return bytes;
+}
+
+size_t upo_ht_linprob_evict(upo_ht_linprob_t ht, size_t extra, const void *keep, int grow)
+{
+    size_t evicted = 0;
+    size_t pos = 0;
+
+    while (ht->size > 0
+           && upo_ht_linprob_memory_at(ht, grow ? upo_ht_linprob_grown_capacity(ht) : ht->capacity) + extra > ht->budget->budget.max_bytes
+           && upo_ht_linprob_victim(ht, keep, &pos))
+    {
+        if (ht->budget->budget.evict != NULL)
+            ht->budget->budget.evict(upo_ht_linprob_slot_key(ht, pos), upo_ht_linprob_slot_value(ht, pos), ht->budget->budget.arg);
+
+        upo_ht_linprob_remove_at(ht, pos, ht->budget->budget.destroy_data);
+        evicted++;
+    }
+
+    return evicted;
+}
+
+int upo_ht_linprob_victim(upo_ht_linprob_t ht, const void *keep, size_t *pos)
+{
+    const upo_ht_budget_t *budget = &ht->budget->budget;
+    size_t samples = (budget->samples > 0) ? budget->samples : UPO_HT_BUDGET_DEFAULT_SAMPLES;
+    size_t n = ht->small ? ht->size : ht->capacity; // In small mode, pairs are packed
+    size_t start = upo_ht_budget_random(ht->budget, n);
+    size_t found = 0;
+    size_t i = 0;
+    unsigned long best_rank = 0;
+
+    /* Sample the first occupied slots from a random slot on */
+    for (i = 0; i < n && found < samples; ++i)
+    {
+        size_t h = (start + i) % n;
+        void *key = upo_ht_linprob_slot_key(ht, h);
+        unsigned long rank = 0;
+
+        if (key == NULL || key == keep)
+            continue;
+
+        if (budget->rank == NULL)
         {
-            if (ht->slots[i].key != NULL)
-                visit(ht->slots[i].key, ht->slots[i].value, visit_arg);
+            *pos = h;
+            return 1;
         }
+
+        rank = budget->rank(key, upo_ht_linprob_slot_value(ht, h), budget->arg);
+        if (found == 0 || rank < best_rank)
+        {
+            *pos = h;
+            best_rank = rank;
+        }
+        found++;
     }
+
+    return found > 0;
 }
 
+size_t upo_ht_budget_data_size(const upo_ht_budget_state_t *budget, const void *key, const void *value)
+{
+    if (budget == NULL || budget->budget.data_size == NULL)
+        return 0;
 
-/*** END of HASH TABLE - EXTRA OPERATIONS ***/
+    return budget->budget.data_size(key, value, budget->budget.arg);
+}
+
+void upo_ht_budget_charge(upo_ht_budget_state_t *budget, const void *key, const void *value)
+{
+    if (budget != NULL)
+        budget->data_bytes += upo_ht_budget_data_size(budget, key, value);
+}
+
+void upo_ht_budget_release(upo_ht_budget_state_t *budget, const void *key, const void *value)
+{
+    if (budget != NULL)
+    {
+        size_t bytes = upo_ht_budget_data_size(budget, key, value);
+
+        /* Note: saturates if the sizing function is not consistent */
+        budget->data_bytes = (bytes < budget->data_bytes) ? budget->data_bytes - bytes : 0;
+    }
+}
+
+size_t upo_ht_budget_random(upo_ht_budget_state_t *budget, size_t n)
+{
+    /* Marsaglia's xorshift64* generator */
+    budget->seed ^= budget->seed >> 12;
+    budget->seed ^= budget->seed << 25;
+    budget->seed ^= budget->seed >> 27;
+
+    return (size_t) ((budget->seed * UINT64_C(2685821657736338717)) % n);
+}
+
+
+/*** END of HASH TABLE MEMORY BUDGET ***/
 
 
 /*** BEGIN of HASH FUNCTIONS ***/
 
 
+uint64_t upo_ht_hash_wide(upo_ht_hasher_t key_hash, const void *key)
+{
+    uint64_t h = 0;
+
+    /* preconditions */
+    assert( key_hash != NULL );
+
+    h = key_hash(key, UPO_HT_HASH_WIDE_RANGE);
+
+    /* 64-bit finalizer of MurmurHash3 */
+    h ^= h >> 33;
+    h *= UINT64_C(0xff51afd7ed558ccd);
+    h ^= h >> 33;
+    h *= UINT64_C(0xc4ceb9fe1a85ec53);
+    h ^= h >> 33;
+
+    return h;
+}
+
 size_t upo_ht_hash_int_div(const void *x, size_t m)
 {
     /* preconditions */
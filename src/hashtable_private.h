@@ -28,6 +28,76 @@
 #include <upo/hashtable.h>
 
 
+/*** BEGIN of COMMON TYPES ***/
+
+
+/** \brief Type for the operation counters collected by hash table statistics. */
+struct upo_ht_stats_counters_s
+{
+    size_t hash_calls; /**< The number of calls to the key hash function. */
+    size_t cmp_calls; /**< The number of calls to the key comparison function. */
+    size_t resizes; /**< The number of resize operations. */
+    double resize_time; /**< The time (in seconds) spent resizing the hash table. */
+};
+/** \brief Alias for the type for the operation counters of hash tables. */
+typedef struct upo_ht_stats_counters_s upo_ht_stats_counters_t;
+
+/** \brief Type for the state of the memory budget of hash tables. */
+struct upo_ht_budget_state_s
+{
+    upo_ht_budget_t budget; /**< The memory budget. */
+    size_t data_bytes; /**< The bytes of data reported by the sizing function for the stored key-value pairs. */
+    uint64_t seed; /**< The state of the generator of random slots. */
+};
+/** \brief Alias for the type for the state of the memory budget of hash tables. */
+typedef struct upo_ht_budget_state_s upo_ht_budget_state_t;
+
+
+/**
+ * \brief Returns the bytes of data of the given key-value pair reported by the
+ *  sizing function of the given memory budget.
+ *
+ * \param budget The memory budget, or `NULL`.
+ * \param key The key.
+ * \param value The value.
+ * \return The bytes of data, or `0` if there is no budget or no sizing
+ *  function.
+ */
+static size_t upo_ht_budget_data_size(const upo_ht_budget_state_t *budget, const void *key, const void *value);
+
+/**
+ * \brief Adds the bytes of data of the given key-value pair, which has just
+ *  been stored, to the given memory budget.
+ *
+ * \param budget The memory budget, or `NULL`.
+ * \param key The key.
+ * \param value The value.
+ */
+static void upo_ht_budget_charge(upo_ht_budget_state_t *budget, const void *key, const void *value);
+
+/**
+ * \brief Subtracts the bytes of data of the given key-value pair, which is
+ *  being removed, from the given memory budget.
+ *
+ * \param budget The memory budget, or `NULL`.
+ * \param key The key.
+ * \param value The value.
+ */
+static void upo_ht_budget_release(upo_ht_budget_state_t *budget, const void *key, const void *value);
+
+/**
+ * \brief Returns a random slot for sampling eviction candidates.
+ *
+ * \param budget The memory budget.
+ * \param n The number of slots (must be positive).
+ * \return A number in `[0, n)`.
+ */
+static size_t upo_ht_budget_random(upo_ht_budget_state_t *budget, size_t n);
+
+
+/*** END of COMMON TYPES ***/
+
+
 /*** BEGIN of HASH TABLE with SEPARATE CHAINING ***/
 
 
@@ -55,38 +125,450 @@ struct upo_ht_sepchain_s
     upo_ht_sepchain_slot_t *slots; /**< The hash table as array of slots. */
     size_t capacity; /**< The capacity of the hash table. */
     size_t size; /**< The number of elements stored in the hash table. */
+    unsigned *generations; /**< The generation in which each slot has been last written (only when generation stamps are enabled). */
+    unsigned generation; /**< The current generation of slots, or `0` if generation stamps are disabled. */
+    upo_ht_sepchain_policy_t policy; /**< The policy for organizing the lists of collisions. */
     upo_ht_hasher_t key_hash; /**< The key hash function. */
     upo_ht_comparator_t key_cmp; /**< The key comparison function. */
+    upo_ht_stats_counters_t *stats; /**< The operation counters, or `NULL` if statistics are disabled. */
+    upo_ht_budget_state_t *budget; /**< The memory budget, or `NULL` if memory is not budgeted. */
 };
 
 
+/**
+ * \brief Hashes the given key by means of the key hash function of the given
+ *  hash table, updating statistics if enabled.
+ *
+ * \param ht The hash table.
+ * \param key The key to hash.
+ * \return The home slot of the key.
+ */
+static size_t upo_ht_sepchain_hash(const upo_ht_sepchain_t ht, const void *key);
+
+/**
+ * \brief Compares the given keys by means of the key comparison function of
+ *  the given hash table, updating statistics if enabled.
+ *
+ * \param ht The hash table.
+ * \param a The first key to compare.
+ * \param b The second key to compare.
+ * \return A number less than, equal to, or greater than zero if \a a is less
+ *  than, equal to, or greater than \a b, respectively.
+ */
+static int upo_ht_sepchain_cmp(const upo_ht_sepchain_t ht, const void *a, const void *b);
+
+/**
+ * \brief Looks for the given key in the list of collisions of the given slot.
+ *
+ * \param ht The hash table.
+ * \param h The home slot of the key.
+ * \param key The key to look for.
+ * \param reorganize Tells whether the list must be reorganized according to
+ *  self-organizing policies if the key is found (value `1`) or not (value
+ *  `0`).
+ * \param link Set to the link (i.e., the head of the list or the `next` field
+ *  of a node) that points to the node holding the key if found, or else to the
+ *  link where a node for the key should be inserted.
+ * \return `1` if the key has been found, or `0` otherwise.
+ */
+static int upo_ht_sepchain_find(const upo_ht_sepchain_t ht, size_t h, const void *key, int reorganize, upo_ht_sepchain_list_node_t ***link);
+
+/**
+ * \brief Creates a new node and inserts it in a list of collisions.
+ *
+ * \param link The link where the node must be inserted.
+ * \param key The key.
+ * \param value The value.
+ * \return The new node.
+ */
+static upo_ht_sepchain_list_node_t* upo_ht_sepchain_link_node(upo_ht_sepchain_list_node_t **link, void *key, void *value);
+
+/**
+ * \brief Returns the head of the list of collisions of the given slot.
+ *
+ * \param ht The hash table.
+ * \param i The slot position.
+ * \return The head of the list, or `NULL` if the list is empty or belongs to
+ *  a past generation.
+ */
+static upo_ht_sepchain_list_node_t* upo_ht_sepchain_slot_head(const upo_ht_sepchain_t ht, size_t i);
+
+/**
+ * \brief Prepares the given slot for being modified in the current generation.
+ *
+ * \param ht The hash table.
+ * \param i The slot position.
+ *
+ * If the slot belongs to a past generation, the nodes of its list of
+ * collisions (but not their keys and values) are freed and the slot is
+ * stamped with the current generation.
+ */
+static void upo_ht_sepchain_slot_renew(upo_ht_sepchain_t ht, size_t i);
+
+/**
+ * \brief Removes all key-value pairs from the given hash table by visiting
+ *  every slot.
+ *
+ * \param ht The hash table.
+ * \param destroy_data Tells whether the memory for keys and values of the
+ *  current generation must be freed (value `1`) or not (value `0`).
+ */
+static void upo_ht_sepchain_clear_slots(upo_ht_sepchain_t ht, int destroy_data);
+
+/**
+ * \brief Frees a bounded number of key-value pairs of the given hash table,
+ *  and the hash table itself once all of its slots are empty.
+ *
+ * \param ht The hash table (see upo_reclaimer_step_t).
+ * \param destroy_data Tells whether the memory for keys and values of the
+ *  current generation must be freed (value `1`) or not (value `0`).
+ * \param cursor The first slot not yet emptied.
+ * \param batch The maximum number of nodes (or empty slots) to visit.
+ * \return `1` if the hash table has been freed, or `0` otherwise.
+ */
+static int upo_ht_sepchain_reclaim_step(void *ht, int destroy_data, size_t *cursor, size_t batch);
+
+/**
+ * \brief Evicts key-value pairs from the given hash table until the given
+ *  number of bytes fits in its memory budget.
+ *
+ * \param ht The hash table, which must have a memory budget.
+ * \param extra The bytes to make room for.
+ * \param keep A key that must not be evicted, or `NULL`.
+ * \return The number of evicted key-value pairs.
+ */
+static size_t upo_ht_sepchain_evict(upo_ht_sepchain_t ht, size_t extra, const void *keep);
+
+/**
+ * \brief Chooses the key-value pair to evict from the given hash table.
+ *
+ * \param ht The hash table, which must have a memory budget.
+ * \param keep A key that must not be chosen, or `NULL`.
+ * \return The link pointing to the node to evict, or `NULL` if there is no
+ *  candidate.
+ */
+static upo_ht_sepchain_list_node_t** upo_ht_sepchain_victim(upo_ht_sepchain_t ht, const void *keep);
+
+
 /*** END of HASH TABLE with SEPARATE CHAINING ***/
 
 
 /*** BEGIN of HASH TABLE with LINEAR PROBING ***/
 
 
+/**
+ * \brief Maximum ratio between tombstones and capacity before tombstones are
+ *  purged by rehashing the hash table in place.
+ */
+#define UPO_HT_LINPROB_MAX_TOMBSTONE_RATIO 0.25
+
+/**
+ * \brief Value of the tombstone flag that marks an occupied slot whose key
+ *  still has to be rehashed while purging tombstones.
+ */
+#define UPO_HT_LINPROB_PENDING 2
+
 /** \brief Type for slots of hash tables with linear probing. */
 struct upo_ht_linprob_slot_s
 {
     void *key; /**< Pointer to the user-provided key. */
     void *value; /**< Pointer to the value associated to the key. */
-    int tombstone; /**< Flag used to mark this slot as deleted. */
+    int tombstone; /**< Flag used to mark this slot as deleted (or as pending, while purging tombstones). */
+    unsigned generation; /**< The generation in which this slot has been last written (when generation stamps are enabled). */
 };
 
 /** \brief Alias for type for slots of hash tables with linear probing. */
 typedef struct upo_ht_linprob_slot_s upo_ht_linprob_slot_t;
 
+/** \brief Fingerprint value that marks an empty slot. */
+#define UPO_HT_LINPROB_FP_EMPTY 0U
+
+/** \brief Fingerprint value that marks a deleted slot. */
+#define UPO_HT_LINPROB_FP_DELETED 1U
+
+/** \brief Fingerprint value that marks a pending slot while purging tombstones. */
+#define UPO_HT_LINPROB_FP_PENDING 2U
+
+/**
+ * \brief Number of reserved fingerprint values (the fingerprints of keys are
+ *  never smaller than this value).
+ */
+#define UPO_HT_LINPROB_FP_RESERVED 3U
+
 /** \brief Type for hash tables with linear probing. */
 struct upo_ht_linprob_s
 {
-    upo_ht_linprob_slot_t *slots; /**< The hash table as array of slots. */
+    upo_ht_linprob_layout_t layout; /**< The storage layout of slots. */
+    upo_ht_linprob_probe_t probe; /**< The probe sequence. */
+    int small; /**< Tells whether the hash table is in small mode, where the first `size` slots of the inline array of slots are scanned linearly. */
+    upo_ht_linprob_slot_t *slots; /**< The hash table as array of slots (array-of-structures layout only). */
+    void *fingerprints; /**< The array of 8-bit or 16-bit fingerprints (structure-of-arrays layouts only). */
+    void **keys; /**< The array of keys (structure-of-arrays layouts only). */
+    void **values; /**< The array of values (structure-of-arrays layouts only). */
+    unsigned *generations; /**< The array of generation stamps (structure-of-arrays layouts only, when generation stamps are enabled). */
+    unsigned generation; /**< The current generation of slots, or `0` if generation stamps are disabled. */
     size_t capacity; /**< The capacity of the hash table. */
     size_t size; /**< The number of stored key-value pairs. */
+    size_t tombstones; /**< The number of slots marked as deleted. */
+    size_t max_probe; /**< An upper bound on the probe number at which each stored key has been placed (i.e., on its distance from its home slot along the probe sequence), reset only when slots are rebuilt. */
     upo_ht_hasher_t key_hash; /**< The key hash function. */
     upo_ht_comparator_t key_cmp; /**< The key comparison function. */
+    upo_ht_stats_counters_t *stats; /**< The operation counters, or `NULL` if statistics are disabled. */
+    upo_ht_budget_state_t *budget; /**< The memory budget, or `NULL` if memory is not budgeted. */
+    size_t rehash_threads; /**< The number of threads that rehash keys on resize. */
 };
 
+/** \brief Type for the work of a thread rehashing a hash table in parallel. */
+struct upo_ht_linprob_rehash_s
+{
+    upo_ht_linprob_t from; /**< The hash table being resized. */
+    upo_ht_linprob_t to; /**< The temporary hash table with the new slots. */
+    size_t id; /**< The index of the thread, that is of its chunk of old slots and of its region of new slots. */
+    size_t threads; /**< The number of threads. */
+    size_t *homes; /**< The home slot in the new slots of the key of each old slot. */
+    size_t *order; /**< The old slots of the keys, grouped by region of their home slot. */
+    size_t *counts; /**< The number of keys of each chunk (row) for each region (column), then their offsets in `order`. */
+    size_t *bounds; /**< The offsets in `order` where the keys of each region begin. */
+    size_t deferred; /**< The number of keys of the region left to insert (moved to the beginning of the region in `order`). */
+    size_t max_probe; /**< The largest probe number at which the thread has placed a key. */
+};
+/** \brief Alias for the type for the work of a thread rehashing a hash table in parallel. */
+typedef struct upo_ht_linprob_rehash_s upo_ht_linprob_rehash_t;
+
+
+/**
+ * \brief Hashes the given key by means of the key hash function of the given
+ *  hash table, updating statistics if enabled.
+ *
+ * \param ht The hash table.
+ * \param key The key to hash.
+ * \return The home slot of the key.
+ */
+static size_t upo_ht_linprob_hash(const upo_ht_linprob_t ht, const void *key);
+
+/**
+ * \brief Compares the given keys by means of the key comparison function of
+ *  the given hash table, updating statistics if enabled.
+ *
+ * \param ht The hash table.
+ * \param a The first key to compare.
+ * \param b The second key to compare.
+ * \return A number less than, equal to, or greater than zero if \a a is less
+ *  than, equal to, or greater than \a b, respectively.
+ */
+static int upo_ht_linprob_cmp(const upo_ht_linprob_t ht, const void *a, const void *b);
+
+/**
+ * \brief Computes the step of the probe sequence of the given key, updating
+ *  statistics if enabled.
+ *
+ * \param ht The hash table.
+ * \param key The key.
+ * \return The odd step of double hashing, or `1` for the other probe
+ *  sequences (without calling the key hash function).
+ */
+static size_t upo_ht_linprob_probe_step(const upo_ht_linprob_t ht, const void *key);
+
+/**
+ * \brief Returns the next slot of a probe sequence.
+ *
+ * \param ht The hash table.
+ * \param h The current slot of the probe sequence.
+ * \param i The number of the probe to perform (`1` for the slot following the
+ *  home slot).
+ * \param step The step returned by upo_ht_linprob_probe_step() for the key.
+ * \return The position of the next slot.
+ */
+static size_t upo_ht_linprob_probe_next(const upo_ht_linprob_t ht, size_t h, size_t i, size_t step);
+
+/**
+ * \brief Returns the capacity to use for the probe sequence of the given hash
+ *  table.
+ *
+ * \param ht The hash table.
+ * \param n The requested capacity.
+ * \return \a n for linear probing, or the smallest power of two not smaller
+ *  than \a n for the other probe sequences.
+ */
+static size_t upo_ht_linprob_probe_capacity(const upo_ht_linprob_t ht, size_t n);
+
+/**
+ * \brief Initializes the fields of the given hash table, except slots.
+ *
+ * \param ht The hash table.
+ * \param key_hash The key hash function.
+ * \param key_cmp The key comparison function.
+ */
+static void upo_ht_linprob_init(upo_ht_linprob_t ht, upo_ht_hasher_t key_hash, upo_ht_comparator_t key_cmp);
+
+/**
+ * \brief Returns the array of slots allocated together with the given hash
+ *  table by upo_ht_linprob_create_small().
+ *
+ * \param ht The hash table.
+ * \return The inline array of slots (which only exists for hash tables
+ *  created in small mode).
+ */
+static upo_ht_linprob_slot_t* upo_ht_linprob_inline_slots(const upo_ht_linprob_t ht);
+
+/**
+ * \brief Switches the given hash table from small mode to hashed slots.
+ *
+ * \param ht The hash table, which must be in small mode.
+ *
+ * The new capacity is the smallest one, doubling the default capacity, that
+ * keeps the load factor below `0.5` after one more insertion.
+ */
+static void upo_ht_linprob_leave_small(upo_ht_linprob_t ht);
+
+/**
+ * \brief Computes the fingerprint of the given key for the storage layout of
+ *  the given hash table, updating statistics if enabled.
+ *
+ * \param ht The hash table.
+ * \param key The key.
+ * \return The fingerprint of the key, which is never smaller than
+ *  `UPO_HT_LINPROB_FP_RESERVED`, or `0` for the array-of-structures layout
+ *  (where no hash function is called).
+ */
+static unsigned upo_ht_linprob_fingerprint(const upo_ht_linprob_t ht, const void *key);
+
+/**
+ * \brief Looks for the given key in the given hash table.
+ *
+ * \param ht The hash table, whose capacity must be positive.
+ * \param key The key to look for.
+ * \param pos Set to the slot holding the key if found, or else to the slot
+ *  where the key should be stored (i.e., the first tombstone or the empty slot
+ *  that ends the probe sequence).
+ * \param probe If not `NULL`, set to the probe number of slot \a pos.
+ * \param fp If not `NULL`, set to the fingerprint of the key.
+ * \return `1` if the key has been found, or `0` otherwise.
+ *
+ * With structure-of-arrays layouts, the probe sequence is scanned in the array
+ * of fingerprints and keys are compared only when fingerprints match.
+ */
+static int upo_ht_linprob_find(const upo_ht_linprob_t ht, const void *key, size_t *pos, size_t *probe, unsigned *fp);
+
+/**
+ * \brief Stores the given key-value pair in the given hash table, where the
+ *  key has been looked up without success.
+ *
+ * \param ht The hash table.
+ * \param key The key.
+ * \param value The value.
+ * \param pos The slot returned by upo_ht_linprob_find() for \a key.
+ * \param probe The probe number returned by upo_ht_linprob_find() for \a key.
+ * \param fp The fingerprint returned by upo_ht_linprob_find() for \a key.
+ * \return The slot where the key-value pair has been stored.
+ *
+ * If the load factor has reached `0.5` (or if storing the key-value pair would
+ * leave no empty slot), the hash table is resized (and the key looked up
+ * again) before storing the key-value pair.
+ * With a memory budget, key-value pairs are evicted first if the resize or the
+ * data of the new pair would not fit (see upo_ht_linprob_evict()).
+ */
+static size_t upo_ht_linprob_insert_at(upo_ht_linprob_t ht, void *key, void *value, size_t pos, size_t probe, unsigned fp);
+
+/**
+ * \brief Removes the key-value pair stored in the given slot, leaving a
+ *  tombstone, and then shrinks or purges the hash table if needed.
+ *
+ * \param ht The hash table.
+ * \param pos The slot position.
+ * \param destroy_data Tells whether the memory for the key and the value must
+ *  be freed (value `1`) or not (value `0`).
+ */
+static void upo_ht_linprob_remove_at(upo_ht_linprob_t ht, size_t pos, int destroy_data);
+
+/**
+ * \brief Allocates and initializes to empty the slots of the given hash table
+ *  according to its storage layout.
+ *
+ * \param ht The hash table, whose slots must not be allocated.
+ * \param m The capacity.
+ */
+static void upo_ht_linprob_alloc_slots(upo_ht_linprob_t ht, size_t m);
+
+/**
+ * \brief Frees the slots of the given hash table (but not their keys and
+ *  values).
+ *
+ * \param ht The hash table.
+ */
+static void upo_ht_linprob_free_slots(upo_ht_linprob_t ht);
+
+/**
+ * \brief Tells if the given slot belongs to a past generation, in which case
+ *  it must be read as empty.
+ *
+ * \param ht The hash table.
+ * \param i The slot position.
+ * \return `1` if the slot is stale, or `0` otherwise (and always `0` when
+ *  generation stamps are disabled).
+ */
+static int upo_ht_linprob_slot_stale(const upo_ht_linprob_t ht, size_t i);
+
+/**
+ * \brief Returns the key stored in the given slot.
+ *
+ * \param ht The hash table.
+ * \param i The slot position.
+ * \return The key, or `NULL` if the slot is empty or deleted.
+ */
+static void* upo_ht_linprob_slot_key(const upo_ht_linprob_t ht, size_t i);
+
+/**
+ * \brief Returns a pointer to the value stored in the given slot, through
+ *  which the value can be updated in place.
+ *
+ * \param ht The hash table.
+ * \param i The slot position, which must hold a key.
+ * \return The pointer to the value.
+ */
+static void** upo_ht_linprob_slot_value_ref(upo_ht_linprob_t ht, size_t i);
+
+/**
+ * \brief Returns the value stored in the given slot.
+ *
+ * \param ht The hash table.
+ * \param i The slot position.
+ * \return The value, or `NULL` if the slot is empty or deleted.
+ */
+static void* upo_ht_linprob_slot_value(const upo_ht_linprob_t ht, size_t i);
+
+/**
+ * \brief Returns the tombstone flag of the given slot.
+ *
+ * \param ht The hash table.
+ * \param i The slot position.
+ * \return `1` if the slot is deleted, `UPO_HT_LINPROB_PENDING` if the slot is
+ *  pending, or `0` otherwise.
+ */
+static int upo_ht_linprob_slot_tombstone(const upo_ht_linprob_t ht, size_t i);
+
+/**
+ * \brief Sets the content of the given slot, stamping it with the current
+ *  generation.
+ *
+ * \param ht The hash table.
+ * \param i The slot position.
+ * \param key The key, or `NULL` for empty and deleted slots.
+ * \param value The value.
+ * \param tombstone The tombstone flag (`0`, `1` or `UPO_HT_LINPROB_PENDING`).
+ * \param fp The fingerprint of \a key (only used by structure-of-arrays
+ *  layouts, for occupied slots).
+ */
+static void upo_ht_linprob_slot_set(upo_ht_linprob_t ht, size_t i, void *key, void *value, int tombstone, unsigned fp);
+
+/**
+ * \brief Swaps the content of the given slots.
+ *
+ * \param ht The hash table.
+ * \param i The first slot position.
+ * \param j The second slot position.
+ */
+static void upo_ht_linprob_slot_swap(upo_ht_linprob_t ht, size_t i, size_t j);
 
 /**
  * \brief Resize the given hash table to the given capacity.
@@ -96,6 +578,170 @@ struct upo_ht_linprob_s
  */
 static void upo_ht_linprob_resize(upo_ht_linprob_t ht, size_t n);
 
+/**
+ * \brief Stores the key-value pairs of the given hash table into the empty
+ *  slots of the given temporary hash table by means of several threads.
+ *
+ * \param ht The hash table to resize.
+ * \param new_ht The temporary hash table, whose statistics must be disabled.
+ */
+static void upo_ht_linprob_rehash_parallel(upo_ht_linprob_t ht, upo_ht_linprob_t new_ht);
+
+/**
+ * \brief Runs the given function on the given works, one per thread, and
+ *  waits for all of them.
+ *
+ * \param work The array of works, whose first one is run by the calling
+ *  thread.
+ * \param threads The number of works.
+ * \param run The function to run.
+ */
+static void upo_ht_linprob_rehash_run(upo_ht_linprob_rehash_t *work, size_t threads, void* (*run)(void*));
+
+/**
+ * \brief Returns the first slot of the given region of the new slots.
+ *
+ * \param work The work of a thread.
+ * \param r The region (up to the number of threads, to get the end of the
+ *  last region).
+ * \return The first slot of the region.
+ */
+static size_t upo_ht_linprob_rehash_region_start(const upo_ht_linprob_rehash_t *work, size_t r);
+
+/**
+ * \brief Hashes the keys of the chunk of old slots of the given work and
+ *  counts them by region of their home slot.
+ *
+ * \param work The work (of type upo_ht_linprob_rehash_t).
+ * \return `NULL`.
+ */
+static void* upo_ht_linprob_rehash_hash(void *work);
+
+/**
+ * \brief Stores the old slots of the keys of the chunk of the given work in
+ *  the part of `order` reserved to the chunk in the region of their home slot.
+ *
+ * \param work The work (of type upo_ht_linprob_rehash_t).
+ * \return `NULL`.
+ */
+static void* upo_ht_linprob_rehash_partition(void *work);
+
+/**
+ * \brief Inserts the keys of the region of the given work into the slots of
+ *  that region, deferring the keys whose probe sequence leaves it.
+ *
+ * \param work The work (of type upo_ht_linprob_rehash_t).
+ * \return `NULL`.
+ */
+static void* upo_ht_linprob_rehash_insert(void *work);
+
+/**
+ * \brief Inserts the given key-value pair into the first empty slot of its
+ *  probe sequence in the new slots.
+ *
+ * \param work The work of a thread.
+ * \param i The old slot of the key.
+ * \param bounded Tells whether the slots outside the region of the work must
+ *  be left untouched.
+ * \return `1` if the key has been inserted, or `0` if its probe sequence left
+ *  the region.
+ */
+static int upo_ht_linprob_rehash_put(upo_ht_linprob_rehash_t *work, size_t i, int bounded);
+
+/**
+ * \brief Removes all tombstones from the given hash table by rehashing its
+ *  keys in place, without changing its capacity.
+ *
+ * \param ht The hash table to purge.
+ *
+ * Unlike upo_ht_linprob_resize(), no additional array of slots is allocated.
+ */
+static void upo_ht_linprob_purge(upo_ht_linprob_t ht);
+
+/**
+ * \brief Frees the keys and values of a bounded number of slots of the given
+ *  hash table, and the hash table itself once all of its slots are visited.
+ *
+ * \param ht The hash table (see upo_reclaimer_step_t).
+ * \param destroy_data Tells whether the memory for keys and values must be
+ *  freed (value `1`) or not (value `0`); if not, the slots need no visit.
+ * \param cursor The first slot not yet visited.
+ * \param batch The maximum number of slots to visit.
+ * \return `1` if the hash table has been freed, or `0` otherwise.
+ */
+static int upo_ht_linprob_reclaim_step(void *ht, int destroy_data, size_t *cursor, size_t batch);
+
+/**
+ * \brief Returns the capacity that the given hash table would have after
+ *  storing a new key.
+ *
+ * \param ht The hash table.
+ * \return The capacity that upo_ht_linprob_insert_at() would resize the hash
+ *  table to, or the current capacity if no resize is needed.
+ */
+static size_t upo_ht_linprob_grown_capacity(const upo_ht_linprob_t ht);
+
+/**
+ * \brief Returns the memory accounted for the given hash table as if it had
+ *  the given capacity.
+ *
+ * \param ht The hash table.
+ * \param m The capacity (the current one, to get the current memory).
+ * \return The number of bytes.
+ */
+static size_t upo_ht_linprob_memory_at(const upo_ht_linprob_t ht, size_t m);
+
+/**
+ * \brief Evicts key-value pairs from the given hash table until the given
+ *  number of bytes fits in its memory budget.
+ *
+ * \param ht The hash table, which must have a memory budget.
+ * \param extra The bytes to make room for.
+ * \param keep A key that must not be evicted, or `NULL`.
+ * \param grow Tells whether a new key is going to be stored, so that the
+ *  hash table must also fit its budget after the resize that the new key
+ *  would cause.
+ * \return The number of evicted key-value pairs.
+ */
+static size_t upo_ht_linprob_evict(upo_ht_linprob_t ht, size_t extra, const void *keep, int grow);
+
+/**
+ * \brief Chooses the key-value pair to evict from the given hash table.
+ *
+ * \param ht The hash table, which must have a memory budget.
+ * \param keep A key that must not be chosen, or `NULL`.
+ * \param pos Set to the slot of the chosen key-value pair.
+ * \return `1` if a key-value pair has been chosen, or `0` if there is no
+ *  candidate.
+ */
+static int upo_ht_linprob_victim(upo_ht_linprob_t ht, const void *keep, size_t *pos);
+
+/**
+ * \brief Visits the key-value pairs whose home slot is the given one.
+ *
+ * \param ht The hash table.
+ * \param h The home slot.
+ * \param visit The visit function.
+ * \param visit_arg An additional parameter to pass to the visit function.
+ *
+ * The keys hashed to `h` all lie on the probe sequence starting at `h`,
+ * within its first `max_probe + 1` slots and before its first empty slot, so
+ * only that run of slots is examined (and its keys hashed).
+ * The probe sequence must be linear or quadratic, since with double hashing
+ * it depends on the key.
+ */
+static void upo_ht_linprob_scan_slot(const upo_ht_linprob_t ht, size_t h, upo_ht_visitor_t visit, void *visit_arg);
+
+/**
+ * \brief Returns the cursor following the given one in reverse binary order.
+ *
+ * \param cursor The cursor.
+ * \param mask The mask of the bits of the cursor that address a slot.
+ * \return The cursor obtained by incrementing the masked bits of `cursor`
+ *  starting from the most significant one, or `0` if all of them were set.
+ */
+static size_t upo_ht_linprob_scan_next(size_t cursor, size_t mask);
+
 /**
  * \brief Destroy the given node of Separate Chaining Hashtable
  *
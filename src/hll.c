@@ -0,0 +1,558 @@
+/*
+ * Copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ * This file is part of UPOalglib.
+ *
+ * UPOalglib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * UPOalglib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <upo/error.h>
+#include "hll_private.h"
+
+
+/*** BEGIN of FUNDAMENTAL OPERATIONS ***/
+
+
+upo_hll_t upo_hll_create(unsigned precision, upo_ht_hasher_t key_hash)
+{
+    upo_hll_t hll = NULL;
+
+    /* preconditions */
+    assert( precision >= UPO_HLL_MIN_PRECISION && precision <= UPO_HLL_MAX_PRECISION );
+
+    hll = malloc(sizeof(struct upo_hll_s));
+    if (hll == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for HyperLogLog");
+    }
+    hll->registers = NULL;
+    hll->sparse = NULL;
+    hll->sparse_size = 0;
+    hll->sparse_capacity = 0;
+    hll->precision = precision;
+    hll->key_hash = key_hash;
+
+    return hll;
+}
+
+void upo_hll_destroy(upo_hll_t hll)
+{
+    if (hll != NULL)
+    {
+        free(hll->registers);
+        free(hll->sparse);
+        free(hll);
+    }
+}
+
+void upo_hll_clear(upo_hll_t hll)
+{
+    /* preconditions */
+    assert( hll != NULL );
+
+    free(hll->registers);
+    hll->registers = NULL;
+    hll->sparse_size = 0;
+}
+
+void upo_hll_add(upo_hll_t hll, const void *key)
+{
+    /* preconditions */
+    assert( hll != NULL );
+    assert( hll->key_hash != NULL );
+
+    upo_hll_add_hash(hll, upo_ht_hash_wide(hll->key_hash, key));
+}
+
+void upo_hll_add_hash(upo_hll_t hll, uint64_t hash)
+{
+    uint64_t rest = 0;
+
+    /* preconditions */
+    assert( hll != NULL );
+
+    /* The value is the position of the first 1 bit after the index bits */
+    rest = hash << hll->precision;
+    upo_hll_update(hll, (size_t) (hash >> (64 - hll->precision)), (rest == 0) ? 64 - hll->precision + 1 : upo_hll_clz(rest) + 1);
+}
+
+double upo_hll_estimate(const upo_hll_t hll)
+{
+    size_t histogram[64 - UPO_HLL_MIN_PRECISION + 2];
+    size_t m = 0;
+    size_t i = 0;
+    unsigned q = 0;
+    unsigned k = 0;
+    double z = 0;
+
+    if (hll == NULL)
+        return 0;
+
+    m = ((size_t) 1) << hll->precision;
+    q = 64 - hll->precision;
+    memset(histogram, 0, sizeof histogram);
+    if (hll->registers != NULL)
+    {
+        for (i = 0; i < m; ++i)
+        {
+            ++histogram[hll->registers[i]];
+        }
+    }
+    else
+    {
+        histogram[0] = m - hll->sparse_size;
+        for (i = 0; i < hll->sparse_size; ++i)
+        {
+            ++histogram[hll->sparse[i] & ((1U << UPO_HLL_VALUE_BITS) - 1)];
+        }
+    }
+    if (histogram[0] == m)
+        return 0;
+
+    /* Improved raw estimator of Ertl (Algorithm 6) */
+    z = m * upo_hll_tau(1 - (double) histogram[q+1] / m);
+    for (k = q; k >= 1; --k)
+    {
+        z = 0.5 * (z + histogram[k]);
+    }
+    z += m * upo_hll_sigma((double) histogram[0] / m);
+
+    return m / (2 * log(2)) * m / z;
+}
+
+int upo_hll_merge(upo_hll_t hll, const upo_hll_t other)
+{
+    size_t i = 0;
+
+    /* preconditions */
+    assert( hll != NULL );
+    assert( other != NULL );
+
+    if (hll->precision != other->precision || hll->key_hash != other->key_hash)
+        return 0;
+
+    if (other->registers == NULL && hll->registers == NULL)
+    {
+        upo_hll_merge_sparse(hll, other);
+        return 1;
+    }
+    if (other->registers == NULL)
+    {
+        for (i = 0; i < other->sparse_size; ++i)
+        {
+            upo_hll_update(hll, other->sparse[i] >> UPO_HLL_VALUE_BITS, other->sparse[i] & ((1U << UPO_HLL_VALUE_BITS) - 1));
+        }
+        return 1;
+    }
+
+    if (hll->registers == NULL)
+    {
+        upo_hll_to_dense(hll);
+    }
+    upo_hll_max_registers(hll->registers, other->registers, ((size_t) 1) << hll->precision);
+
+    return 1;
+}
+
+size_t upo_hll_serialized_size(const upo_hll_t hll)
+{
+    /* preconditions */
+    assert( hll != NULL );
+
+    if (hll->registers == NULL)
+        return UPO_HLL_HEADER_SIZE + 4*hll->sparse_size;
+
+    return UPO_HLL_HEADER_SIZE + 3*(((size_t) 1) << hll->precision)/4;
+}
+
+void upo_hll_serialize(const upo_hll_t hll, void *buf)
+{
+    unsigned char *p = buf;
+    size_t m = 0;
+    size_t i = 0;
+
+    /* preconditions */
+    assert( hll != NULL );
+    assert( buf != NULL );
+
+    upo_hll_store(p, UPO_HLL_MAGIC, 8);
+    p[8] = (unsigned char) hll->precision;
+    p[9] = (hll->registers != NULL) ? 1 : 0;
+    p[10] = 0;
+    p[11] = 0;
+    upo_hll_store(p + 12, hll->sparse_size, 4);
+    p += UPO_HLL_HEADER_SIZE;
+
+    if (hll->registers == NULL)
+    {
+        for (i = 0; i < hll->sparse_size; ++i, p += 4)
+        {
+            upo_hll_store(p, hll->sparse[i], 4);
+        }
+        return;
+    }
+
+    m = ((size_t) 1) << hll->precision;
+    for (i = 0; i < m; i += 4, p += 3)
+    {
+        upo_hll_store(p, (uint64_t) hll->registers[i]
+                         | ((uint64_t) hll->registers[i+1] << 6)
+                         | ((uint64_t) hll->registers[i+2] << 12)
+                         | ((uint64_t) hll->registers[i+3] << 18), 3);
+    }
+}
+
+upo_hll_t upo_hll_deserialize(const void *buf, size_t size, upo_ht_hasher_t key_hash)
+{
+    upo_hll_t hll = NULL;
+    const unsigned char *p = buf;
+    unsigned precision = 0;
+    unsigned max_value = 0;
+    size_t m = 0;
+    size_t n = 0;
+    size_t i = 0;
+    uint64_t packed = 0;
+    uint32_t entry = 0;
+
+    /* preconditions */
+    assert( buf != NULL || size == 0 );
+
+    if (size < UPO_HLL_HEADER_SIZE || upo_hll_load(p, 8) != UPO_HLL_MAGIC || p[10] != 0 || p[11] != 0)
+        return NULL;
+
+    precision = p[8];
+    if (precision < UPO_HLL_MIN_PRECISION || precision > UPO_HLL_MAX_PRECISION)
+        return NULL;
+    m = ((size_t) 1) << precision;
+    max_value = 64 - precision + 1;
+    n = (size_t) upo_hll_load(p + 12, 4);
+
+    if (p[9] == 0)
+    {
+        if (n > upo_hll_sparse_limit(precision) || size != UPO_HLL_HEADER_SIZE + 4*n)
+            return NULL;
+
+        hll = upo_hll_create(precision, key_hash);
+        p += UPO_HLL_HEADER_SIZE;
+        for (i = 0; i < n; ++i, p += 4)
+        {
+            entry = (uint32_t) upo_hll_load(p, 4);
+
+            /* Entries must be sorted by index, without duplicates */
+            if ((entry >> UPO_HLL_VALUE_BITS) >= m
+                || (entry & ((1U << UPO_HLL_VALUE_BITS) - 1)) == 0
+                || (entry & ((1U << UPO_HLL_VALUE_BITS) - 1)) > max_value
+                || (i > 0 && (entry >> UPO_HLL_VALUE_BITS) <= (hll->sparse[i-1] >> UPO_HLL_VALUE_BITS)))
+            {
+                upo_hll_destroy(hll);
+                return NULL;
+            }
+            upo_hll_update(hll, entry >> UPO_HLL_VALUE_BITS, entry & ((1U << UPO_HLL_VALUE_BITS) - 1));
+        }
+        return hll;
+    }
+
+    if (p[9] != 1 || n != 0 || size != UPO_HLL_HEADER_SIZE + 3*m/4)
+        return NULL;
+
+    hll = upo_hll_create(precision, key_hash);
+    upo_hll_to_dense(hll);
+    p += UPO_HLL_HEADER_SIZE;
+    for (i = 0; i < m; i += 4, p += 3)
+    {
+        packed = upo_hll_load(p, 3);
+        hll->registers[i] = (uint8_t) (packed & 0x3F);
+        hll->registers[i+1] = (uint8_t) ((packed >> 6) & 0x3F);
+        hll->registers[i+2] = (uint8_t) ((packed >> 12) & 0x3F);
+        hll->registers[i+3] = (uint8_t) ((packed >> 18) & 0x3F);
+        if (hll->registers[i] > max_value || hll->registers[i+1] > max_value
+            || hll->registers[i+2] > max_value || hll->registers[i+3] > max_value)
+        {
+            upo_hll_destroy(hll);
+            return NULL;
+        }
+    }
+
+    return hll;
+}
+
+size_t upo_hll_sparse_limit(unsigned precision)
+{
+    /* A sparse entry takes as much memory as 4 dense registers */
+    return (((size_t) 1) << precision) / 4;
+}
+
+void upo_hll_update(upo_hll_t hll, size_t index, unsigned value)
+{
+    size_t lo = 0;
+    size_t hi = 0;
+    size_t mid = 0;
+    uint32_t *p = NULL;
+
+    if (hll->registers != NULL)
+    {
+        if (hll->registers[index] < value)
+            hll->registers[index] = (uint8_t) value;
+        return;
+    }
+
+    hi = hll->sparse_size;
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if ((hll->sparse[mid] >> UPO_HLL_VALUE_BITS) < index)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo < hll->sparse_size && (hll->sparse[lo] >> UPO_HLL_VALUE_BITS) == index)
+    {
+        if ((hll->sparse[lo] & ((1U << UPO_HLL_VALUE_BITS) - 1)) < value)
+            hll->sparse[lo] = (uint32_t) (index << UPO_HLL_VALUE_BITS) | value;
+        return;
+    }
+
+    if (hll->sparse_size == upo_hll_sparse_limit(hll->precision))
+    {
+        upo_hll_to_dense(hll);
+        hll->registers[index] = (uint8_t) value;
+        return;
+    }
+    if (hll->sparse_size == hll->sparse_capacity)
+    {
+        hll->sparse_capacity = (hll->sparse_capacity > 0) ? 2*hll->sparse_capacity : UPO_HLL_SPARSE_CAPACITY;
+        if (hll->sparse_capacity > upo_hll_sparse_limit(hll->precision))
+            hll->sparse_capacity = upo_hll_sparse_limit(hll->precision);
+        p = realloc(hll->sparse, hll->sparse_capacity*sizeof(uint32_t));
+        if (p == NULL)
+        {
+            upo_throw_sys_error("Unable to allocate memory for the sparse registers of the HyperLogLog");
+        }
+        hll->sparse = p;
+    }
+    memmove(hll->sparse + lo + 1, hll->sparse + lo, (hll->sparse_size - lo)*sizeof(uint32_t));
+    hll->sparse[lo] = (uint32_t) (index << UPO_HLL_VALUE_BITS) | value;
+    ++hll->sparse_size;
+}
+
+void upo_hll_merge_sparse(upo_hll_t hll, const upo_hll_t other)
+{
+    uint32_t *merged = NULL;
+    size_t i = 0;
+    size_t j = 0;
+    size_t n = 0;
+
+    if (other->sparse_size == 0 || hll == other)
+        return;
+
+    merged = malloc((hll->sparse_size + other->sparse_size)*sizeof(uint32_t));
+    if (merged == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for the sparse registers of the HyperLogLog");
+    }
+    while (i < hll->sparse_size || j < other->sparse_size)
+    {
+        if (j == other->sparse_size
+            || (i < hll->sparse_size && (hll->sparse[i] >> UPO_HLL_VALUE_BITS) < (other->sparse[j] >> UPO_HLL_VALUE_BITS)))
+        {
+            merged[n++] = hll->sparse[i++];
+        }
+        else if (i == hll->sparse_size
+                 || (other->sparse[j] >> UPO_HLL_VALUE_BITS) < (hll->sparse[i] >> UPO_HLL_VALUE_BITS))
+        {
+            merged[n++] = other->sparse[j++];
+        }
+        else
+        {
+            /* Same index: the entry with the greater value wins */
+            merged[n++] = (hll->sparse[i] > other->sparse[j]) ? hll->sparse[i] : other->sparse[j];
+            ++i;
+            ++j;
+        }
+    }
+
+    free(hll->sparse);
+    hll->sparse = merged;
+    hll->sparse_capacity = hll->sparse_size + other->sparse_size;
+    hll->sparse_size = n;
+    if (n > upo_hll_sparse_limit(hll->precision))
+    {
+        upo_hll_to_dense(hll);
+    }
+}
+
+void upo_hll_to_dense(upo_hll_t hll)
+{
+    size_t i = 0;
+
+    hll->registers = calloc(((size_t) 1) << hll->precision, sizeof(uint8_t));
+    if (hll->registers == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for the registers of the HyperLogLog");
+    }
+    for (i = 0; i < hll->sparse_size; ++i)
+    {
+        hll->registers[hll->sparse[i] >> UPO_HLL_VALUE_BITS] = (uint8_t) (hll->sparse[i] & ((1U << UPO_HLL_VALUE_BITS) - 1));
+    }
+    free(hll->sparse);
+    hll->sparse = NULL;
+    hll->sparse_size = 0;
+    hll->sparse_capacity = 0;
+}
+
+void upo_hll_max_registers(uint8_t *dst, const uint8_t *src, size_t m)
+{
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    for (; i + 32 <= m; i += 32)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i*) (dst + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*) (src + i));
+
+        _mm256_storeu_si256((__m256i*) (dst + i), _mm256_max_epu8(a, b));
+    }
+#elif defined(__SSE2__)
+    for (; i + 16 <= m; i += 16)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i*) (dst + i));
+        __m128i b = _mm_loadu_si128((const __m128i*) (src + i));
+
+        _mm_storeu_si128((__m128i*) (dst + i), _mm_max_epu8(a, b));
+    }
+#endif
+    for (; i < m; ++i)
+    {
+        if (dst[i] < src[i])
+            dst[i] = src[i];
+    }
+}
+
+unsigned upo_hll_clz(uint64_t x)
+{
+    unsigned n = 0;
+
+    /* preconditions */
+    assert( x != 0 );
+
+    if ((x >> 32) == 0) { n += 32; x <<= 32; }
+    if ((x >> 48) == 0) { n += 16; x <<= 16; }
+    if ((x >> 56) == 0) { n += 8; x <<= 8; }
+    if ((x >> 60) == 0) { n += 4; x <<= 4; }
+    if ((x >> 62) == 0) { n += 2; x <<= 2; }
+    if ((x >> 63) == 0) { n += 1; }
+
+    return n;
+}
+
+double upo_hll_sigma(double x)
+{
+    double y = 1;
+    double z = x;
+    double z_old = 0;
+
+    if (x == 1)
+        return HUGE_VAL;
+
+    do
+    {
+        x *= x;
+        z_old = z;
+        z += x * y;
+        y += y;
+    }
+    while (z != z_old);
+
+    return z;
+}
+
+double upo_hll_tau(double x)
+{
+    double y = 1;
+    double z = 1 - x;
+    double z_old = 0;
+
+    if (x == 0 || x == 1)
+        return 0;
+
+    do
+    {
+        x = sqrt(x);
+        z_old = z;
+        y *= 0.5;
+        z -= (1 - x) * (1 - x) * y;
+    }
+    while (z != z_old);
+
+    return z / 3;
+}
+
+void upo_hll_store(unsigned char *p, uint64_t x, size_t n)
+{
+    size_t i = 0;
+
+    for (i = 0; i < n; ++i)
+    {
+        p[i] = (unsigned char) (x >> (8*i));
+    }
+}
+
+uint64_t upo_hll_load(const unsigned char *p, size_t n)
+{
+    uint64_t x = 0;
+    size_t i = 0;
+
+    for (i = 0; i < n; ++i)
+    {
+        x |= ((uint64_t) p[i]) << (8*i);
+    }
+
+    return x;
+}
+
+
+/*** END of FUNDAMENTAL OPERATIONS ***/
+
+
+/*** BEGIN of EXTRA OPERATIONS ***/
+
+
+int upo_hll_is_sparse(const upo_hll_t hll)
+{
+    /* preconditions */
+    assert( hll != NULL );
+
+    return hll->registers == NULL;
+}
+
+unsigned upo_hll_precision(const upo_hll_t hll)
+{
+    return (hll != NULL) ? hll->precision : 0;
+}
+
+upo_ht_hasher_t upo_hll_get_hasher(const upo_hll_t hll)
+{
+    /* preconditions */
+    assert( hll != NULL );
+
+    return hll->key_hash;
+}
+
+
+/*** END of EXTRA OPERATIONS ***/
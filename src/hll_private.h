@@ -0,0 +1,166 @@
+/**
+ * \file src/hll_private.h
+ *
+ * \brief Private header for the HyperLogLog abstract data type.
+ *
+ * \copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ *  This file is part of UPOalglib.
+ *
+ *  UPOalglib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  UPOalglib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UPO_HLL_PRIVATE_H
+#define UPO_HLL_PRIVATE_H
+
+
+#include <stdint.h>
+#include <upo/hll.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+# include <immintrin.h>
+#endif
+
+
+/** \brief Value identifying serialized HyperLogLogs ("UPOHLL" followed by two zero bytes, in little-endian byte order). */
+#define UPO_HLL_MAGIC UINT64_C(0x00004c4c484f5055)
+
+/** \brief Number of bytes of the header of serialized HyperLogLogs. */
+#define UPO_HLL_HEADER_SIZE 16U
+
+/** \brief Number of bits of sparse entries holding the value of the register. */
+#define UPO_HLL_VALUE_BITS 6U
+
+/** \brief Initial number of entries allocated for the sparse encoding. */
+#define UPO_HLL_SPARSE_CAPACITY 16U
+
+
+/**
+ * \brief Type for HyperLogLogs.
+ *
+ * Sparse entries hold the index of a nonzero register followed by its value
+ * in the lower UPO_HLL_VALUE_BITS bits, so sorting entries sorts registers by
+ * index.
+ *
+ * Serialized HyperLogLogs are made of UPO_HLL_MAGIC (as a 64-bit integer),
+ * the precision and the encoding (`0` for sparse, `1` for dense) as bytes,
+ * two zero bytes and the number of sparse entries (as a 32-bit integer),
+ * followed either by the sparse entries (as 32-bit integers) or by the
+ * registers packed in 6 bits each (4 registers in 3 bytes, the first one in
+ * the lowest bits).
+ */
+struct upo_hll_s
+{
+    uint8_t *registers; /**< The registers, or `NULL` with the sparse encoding. */
+    uint32_t *sparse; /**< The sorted sparse entries, or `NULL` with the dense encoding. */
+    size_t sparse_size; /**< The number of sparse entries. */
+    size_t sparse_capacity; /**< The number of allocated sparse entries. */
+    unsigned precision; /**< The number of bits selecting a register. */
+    upo_ht_hasher_t key_hash; /**< The key hash function, or `NULL`. */
+};
+
+
+/**
+ * \brief Returns the largest number of sparse entries of a HyperLogLog with
+ *  the given precision.
+ *
+ * \param precision The precision.
+ * \return The number of entries taking as much memory as the dense registers.
+ */
+static size_t upo_hll_sparse_limit(unsigned precision);
+
+/**
+ * \brief Raises the given register to the given value, if it is lower.
+ *
+ * \param hll The HyperLogLog.
+ * \param index The index of the register.
+ * \param value The value.
+ */
+static void upo_hll_update(upo_hll_t hll, size_t index, unsigned value);
+
+/**
+ * \brief Merges the sorted sparse entries of another HyperLogLog into the
+ *  given one, both with the sparse encoding.
+ *
+ * \param hll The HyperLogLog to update.
+ * \param other The other HyperLogLog.
+ *
+ * The entries are merged in a single pass; the given HyperLogLog switches to
+ * the dense encoding if the merged entries exceed the sparse limit.
+ */
+static void upo_hll_merge_sparse(upo_hll_t hll, const upo_hll_t other);
+
+/**
+ * \brief Switches the given HyperLogLog to the dense encoding.
+ *
+ * \param hll The HyperLogLog, with the sparse encoding.
+ */
+static void upo_hll_to_dense(upo_hll_t hll);
+
+/**
+ * \brief Raises each register of a dense array to the value of the same
+ *  register of another one, if it is lower.
+ *
+ * \param dst The registers to update.
+ * \param src The other registers.
+ * \param m The number of registers.
+ */
+static void upo_hll_max_registers(uint8_t *dst, const uint8_t *src, size_t m);
+
+/**
+ * \brief Returns the number of leading zero bits of the given integer.
+ *
+ * \param x The integer, not zero.
+ * \return The number of zero bits before the most significant 1 bit.
+ */
+static unsigned upo_hll_clz(uint64_t x);
+
+/**
+ * \brief Computes \f$\sigma(x) = x + \sum_{k \ge 1} x^{2^k} 2^{k-1}\f$ for the
+ *  estimator.
+ *
+ * \param x The fraction of registers that are zero.
+ * \return The value of the function.
+ */
+static double upo_hll_sigma(double x);
+
+/**
+ * \brief Computes \f$\tau(x) = \frac{1}{3}(1 - x - \sum_{k \ge 1} (1 -
+ *  x^{2^{-k}})^2 2^{-k})\f$ for the estimator.
+ *
+ * \param x The fraction of registers that are not saturated.
+ * \return The value of the function.
+ */
+static double upo_hll_tau(double x);
+
+/**
+ * \brief Stores the given integer in little-endian byte order.
+ *
+ * \param p The destination.
+ * \param x The integer.
+ * \param n The number of bytes.
+ */
+static void upo_hll_store(unsigned char *p, uint64_t x, size_t n);
+
+/**
+ * \brief Loads an integer stored in little-endian byte order.
+ *
+ * \param p The source.
+ * \param n The number of bytes.
+ * \return The integer.
+ */
+static uint64_t upo_hll_load(const unsigned char *p, size_t n);
+
+
+#endif /* UPO_HLL_PRIVATE_H */
@@ -0,0 +1,882 @@
+/*
+ * Copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ * This file is part of UPOalglib.
+ *
+ * UPOalglib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * UPOalglib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Needed for fsync(), ftruncate() and pread()/pwrite() */
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <upo/error.h>
+#include "kvstore_private.h"
+
+
+/*** BEGIN of FUNDAMENTAL OPERATIONS ***/
+
+
+upo_kvstore_t upo_kvstore_open(const char *path)
+{
+    upo_kvstore_t store = NULL;
+    char *compact_path = NULL;
+
+    /* preconditions */
+    assert( path != NULL );
+
+    store = malloc(sizeof(struct upo_kvstore_s));
+    if (store == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for Key-Value Store");
+    }
+    store->path = malloc(strlen(path) + 1);
+    compact_path = malloc(strlen(path) + sizeof UPO_KVSTORE_COMPACT_SUFFIX);
+    if (store->path == NULL || compact_path == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for the path of the Key-Value Store");
+    }
+    strcpy(store->path, path);
+    strcpy(compact_path, path);
+    strcat(compact_path, UPO_KVSTORE_COMPACT_SUFFIX);
+
+    /* A new log left by a crash during a compaction may be incomplete */
+    if (unlink(compact_path) != 0 && errno != ENOENT)
+    {
+        upo_throw_sys_error("Unable to remove the new log of an interrupted compaction");
+    }
+    free(compact_path);
+
+    store->fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (store->fd < 0)
+    {
+        upo_throw_sys_error("Unable to open the log of the Key-Value Store");
+    }
+
+    store->index = upo_ht_linprob_create(UPO_KVSTORE_INDEX_CAPACITY, upo_kvstore_entry_hash, upo_kvstore_entry_cmp);
+    store->end = 0;
+    store->live = 0;
+    store->appended = 0;
+    store->durable = 0;
+    store->syncs = 0;
+    store->sync = 0;
+    store->syncing = 0;
+    store->compacting = 0;
+    store->compactor = 0;
+    if (pthread_mutex_init(&store->lock, NULL) != 0
+        || pthread_cond_init(&store->synced, NULL) != 0)
+    {
+        upo_throw_error("Unable to initialize the lock of the Key-Value Store");
+    }
+
+    upo_kvstore_replay(store);
+
+    return store;
+}
+
+void upo_kvstore_close(upo_kvstore_t store)
+{
+    if (store != NULL)
+    {
+        if (store->compactor)
+        {
+            pthread_join(store->compactor_thread, NULL);
+        }
+
+        upo_kvstore_sync(store);
+        close(store->fd);
+
+        upo_ht_linprob_traverse(store->index, upo_kvstore_entry_free, NULL);
+        upo_ht_linprob_destroy(store->index, 0);
+        pthread_cond_destroy(&store->synced);
+        pthread_mutex_destroy(&store->lock);
+        free(store->path);
+        free(store);
+    }
+}
+
+void upo_kvstore_put(upo_kvstore_t store, const void *key, size_t key_size, const void *value, size_t value_size)
+{
+    uint64_t offset = 0;
+    uint64_t appended = 0;
+    int sync = 0;
+
+    /* preconditions */
+    assert( store != NULL );
+    assert( key != NULL || key_size == 0 );
+    assert( value != NULL || value_size == 0 );
+    assert( key_size <= UPO_KVSTORE_MAX_SIZE );
+    assert( value_size <= UPO_KVSTORE_MAX_SIZE );
+
+    pthread_mutex_lock(&store->lock);
+    offset = upo_kvstore_append(store, key, key_size, value, value_size);
+    upo_kvstore_apply(store, key, key_size, value_size, offset);
+    appended = store->appended;
+    sync = store->sync;
+    pthread_mutex_unlock(&store->lock);
+
+    if (sync)
+    {
+        upo_kvstore_sync_to(store, appended);
+    }
+}
+
+int upo_kvstore_get(const upo_kvstore_t store, const void *key, size_t key_size, void *value, size_t *value_size)
+{
+    upo_kvstore_entry_t probe;
+    upo_kvstore_entry_t *entry = NULL;
+    size_t n = 0;
+
+    /* preconditions */
+    assert( store != NULL );
+    assert( key != NULL || key_size == 0 );
+    assert( value == NULL || value_size != NULL );
+
+    probe.key = key;
+    probe.key_size = key_size;
+
+    pthread_mutex_lock(&store->lock);
+    entry = upo_ht_linprob_get(store->index, &probe);
+    if (entry != NULL && value_size != NULL)
+    {
+        if (value != NULL)
+        {
+            n = *value_size < entry->value_size ? *value_size : entry->value_size;
+            if (!upo_kvstore_read(store->fd, value, n, entry->offset + UPO_KVSTORE_HEADER_SIZE + entry->key_size))
+            {
+                upo_throw_error("Unexpected end of the log of the Key-Value Store");
+            }
+        }
+        *value_size = entry->value_size;
+    }
+    pthread_mutex_unlock(&store->lock);
+
+    return entry != NULL;
+}
+
+int upo_kvstore_contains(const upo_kvstore_t store, const void *key, size_t key_size)
+{
+    return upo_kvstore_get(store, key, key_size, NULL, NULL);
+}
+
+int upo_kvstore_delete(upo_kvstore_t store, const void *key, size_t key_size)
+{
+    upo_kvstore_entry_t probe;
+    uint64_t offset = 0;
+    uint64_t appended = 0;
+    int found = 0;
+    int sync = 0;
+
+    /* preconditions */
+    assert( store != NULL );
+    assert( key != NULL || key_size == 0 );
+    assert( key_size <= UPO_KVSTORE_MAX_SIZE );
+
+    probe.key = key;
+    probe.key_size = key_size;
+
+    pthread_mutex_lock(&store->lock);
+    found = upo_ht_linprob_contains(store->index, &probe);
+    if (found)
+    {
+        offset = upo_kvstore_append(store, key, key_size, NULL, UPO_KVSTORE_TOMBSTONE);
+        upo_kvstore_apply(store, key, key_size, UPO_KVSTORE_TOMBSTONE, offset);
+        appended = store->appended;
+        sync = store->sync;
+    }
+    pthread_mutex_unlock(&store->lock);
+
+    if (sync)
+    {
+        upo_kvstore_sync_to(store, appended);
+    }
+
+    return found;
+}
+
+void upo_kvstore_sync(upo_kvstore_t store)
+{
+    uint64_t appended = 0;
+
+    /* preconditions */
+    assert( store != NULL );
+
+    pthread_mutex_lock(&store->lock);
+    appended = store->appended;
+    pthread_mutex_unlock(&store->lock);
+
+    upo_kvstore_sync_to(store, appended);
+}
+
+void upo_kvstore_set_sync(upo_kvstore_t store, int sync)
+{
+    /* preconditions */
+    assert( store != NULL );
+
+    pthread_mutex_lock(&store->lock);
+    store->sync = sync;
+    pthread_mutex_unlock(&store->lock);
+}
+
+int upo_kvstore_compact(upo_kvstore_t store)
+{
+    /* preconditions */
+    assert( store != NULL );
+
+    pthread_mutex_lock(&store->lock);
+    if (store->compacting)
+    {
+        pthread_mutex_unlock(&store->lock);
+        return 0;
+    }
+    store->compacting = 1;
+    pthread_mutex_unlock(&store->lock);
+
+    upo_kvstore_compact_run(store);
+
+    return 1;
+}
+
+int upo_kvstore_compact_async(upo_kvstore_t store)
+{
+    /* preconditions */
+    assert( store != NULL );
+
+    pthread_mutex_lock(&store->lock);
+    if (store->compacting)
+    {
+        pthread_mutex_unlock(&store->lock);
+        return 0;
+    }
+    if (store->compactor)
+    {
+        /* The previous background compaction has released the lock for the last time */
+        pthread_join(store->compactor_thread, NULL);
+        store->compactor = 0;
+    }
+    store->compacting = 1;
+    if (pthread_create(&store->compactor_thread, NULL, upo_kvstore_compact_thread, store) != 0)
+    {
+        store->compacting = 0;
+        pthread_mutex_unlock(&store->lock);
+        return 0;
+    }
+    store->compactor = 1;
+    pthread_mutex_unlock(&store->lock);
+
+    return 1;
+}
+
+uint32_t upo_kvstore_crc32(uint32_t crc, const void *data, size_t size)
+{
+    /* CRC-32 of the 16 values of a nibble (reflected polynomial 0xEDB88320) */
+    static const uint32_t table[16] = {
+        0x00000000U, 0x1DB71064U, 0x3B6E20C8U, 0x26D930ACU,
+        0x76DC4190U, 0x6B6B51F4U, 0x4DB26158U, 0x5005713CU,
+        0xEDB88320U, 0xF00F9344U, 0xD6D6A3E8U, 0xCB61B38CU,
+        0x9B64C2B0U, 0x86D3D2D4U, 0xA00AE278U, 0xBDBDF21CU
+    };
+    const unsigned char *p = data;
+    size_t i = 0;
+
+    crc = ~crc;
+    for (i = 0; i < size; ++i)
+    {
+        crc ^= p[i];
+        crc = (crc >> 4) ^ table[crc & 0xFU];
+        crc = (crc >> 4) ^ table[crc & 0xFU];
+    }
+
+    return ~crc;
+}
+
+void upo_kvstore_store_u32(unsigned char *p, uint32_t x)
+{
+    p[0] = (unsigned char) x;
+    p[1] = (unsigned char) (x >> 8);
+    p[2] = (unsigned char) (x >> 16);
+    p[3] = (unsigned char) (x >> 24);
+}
+
+uint32_t upo_kvstore_load_u32(const unsigned char *p)
+{
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+size_t upo_kvstore_entry_hash(const void *entry, size_t m)
+{
+    const upo_kvstore_entry_t *e = entry;
+    uint64_t h = UINT64_C(0xcbf29ce484222325);
+    size_t i = 0;
+
+    /* preconditions */
+    assert( entry != NULL );
+    assert( m > 0 );
+
+    for (i = 0; i < e->key_size; ++i)
+    {
+        h ^= e->key[i];
+        h *= UINT64_C(0x100000001b3);
+    }
+
+    return (size_t) (h % m);
+}
+
+int upo_kvstore_entry_cmp(const void *a, const void *b)
+{
+    const upo_kvstore_entry_t *ea = a;
+    const upo_kvstore_entry_t *eb = b;
+
+    /* preconditions */
+    assert( a != NULL );
+    assert( b != NULL );
+
+    if (ea->key_size != eb->key_size)
+        return ea->key_size < eb->key_size ? -1 : 1;
+
+    return ea->key_size > 0 ? memcmp(ea->key, eb->key, ea->key_size) : 0;
+}
+
+void upo_kvstore_entry_free(void *key, void *value, void *arg)
+{
+    (void) value;
+    (void) arg;
+
+    free(key);
+}
+
+uint64_t upo_kvstore_record_size(size_t key_size, size_t value_size)
+{
+    return UPO_KVSTORE_HEADER_SIZE + (uint64_t) key_size + (value_size == UPO_KVSTORE_TOMBSTONE ? 0 : (uint64_t) value_size);
+}
+
+void upo_kvstore_write(int fd, const void *data, size_t size, uint64_t offset)
+{
+    const unsigned char *p = data;
+    ssize_t n = 0;
+
+    while (size > 0)
+    {
+        n = pwrite(fd, p, size, (off_t) offset);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            upo_throw_sys_error("Unable to write the log of the Key-Value Store");
+        }
+        p += n;
+        size -= (size_t) n;
+        offset += (uint64_t) n;
+    }
+}
+
+int upo_kvstore_read(int fd, void *data, size_t size, uint64_t offset)
+{
+    unsigned char *p = data;
+    ssize_t n = 0;
+
+    while (size > 0)
+    {
+        n = pread(fd, p, size, (off_t) offset);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            upo_throw_sys_error("Unable to read the log of the Key-Value Store");
+        }
+        if (n == 0)
+            return 0;
+        p += n;
+        size -= (size_t) n;
+        offset += (uint64_t) n;
+    }
+
+    return 1;
+}
+
+int upo_kvstore_read_record(int fd, uint64_t offset, uint64_t end, unsigned char **buf, size_t *buf_size, size_t *key_size, size_t *value_size)
+{
+    unsigned char header[UPO_KVSTORE_HEADER_SIZE];
+    uint64_t size = 0;
+    unsigned char *p = NULL;
+
+    if (end - offset < UPO_KVSTORE_HEADER_SIZE || !upo_kvstore_read(fd, header, UPO_KVSTORE_HEADER_SIZE, offset))
+        return 0;
+
+    *key_size = upo_kvstore_load_u32(header + 4);
+    *value_size = upo_kvstore_load_u32(header + 8);
+    size = upo_kvstore_record_size(*key_size, *value_size);
+    if (size > end - offset)
+        return 0;
+
+    if (*buf_size < size)
+    {
+        p = realloc(*buf, (size_t) size);
+        if (p == NULL)
+        {
+            upo_throw_sys_error("Unable to allocate memory for a record of the Key-Value Store");
+        }
+        *buf = p;
+        *buf_size = (size_t) size;
+    }
+    memcpy(*buf, header, UPO_KVSTORE_HEADER_SIZE);
+    if (!upo_kvstore_read(fd, *buf + UPO_KVSTORE_HEADER_SIZE, (size_t) size - UPO_KVSTORE_HEADER_SIZE, offset + UPO_KVSTORE_HEADER_SIZE))
+        return 0;
+
+    return upo_kvstore_crc32(0, *buf + 4, (size_t) size - 4) == upo_kvstore_load_u32(header);
+}
+
+uint64_t upo_kvstore_append(upo_kvstore_t store, const void *key, size_t key_size, const void *value, size_t value_size)
+{
+    unsigned char *record = NULL;
+    uint64_t size = upo_kvstore_record_size(key_size, value_size);
+    uint64_t offset = store->end;
+
+    record = malloc((size_t) size);
+    if (record == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for a record of the Key-Value Store");
+    }
+    upo_kvstore_store_u32(record + 4, (uint32_t) key_size);
+    upo_kvstore_store_u32(record + 8, (uint32_t) value_size);
+    if (key_size > 0)
+        memcpy(record + UPO_KVSTORE_HEADER_SIZE, key, key_size);
+    if (value_size != UPO_KVSTORE_TOMBSTONE && value_size > 0)
+        memcpy(record + UPO_KVSTORE_HEADER_SIZE + key_size, value, value_size);
+    upo_kvstore_store_u32(record, upo_kvstore_crc32(0, record + 4, (size_t) size - 4));
+
+    upo_kvstore_write(store->fd, record, (size_t) size, offset);
+    free(record);
+
+    store->end += size;
+    store->appended += size;
+
+    return offset;
+}
+
+int upo_kvstore_apply(upo_kvstore_t store, const void *key, size_t key_size, size_t value_size, uint64_t offset)
+{
+    upo_kvstore_entry_t probe;
+    upo_kvstore_entry_t *entry = NULL;
+    int found = 0;
+
+    probe.key = key;
+    probe.key_size = key_size;
+
+    entry = upo_ht_linprob_get(store->index, &probe);
+    found = entry != NULL;
+    if (found)
+    {
+        store->live -= upo_kvstore_record_size(entry->key_size, entry->value_size);
+        if (value_size == UPO_KVSTORE_TOMBSTONE)
+        {
+            upo_ht_linprob_delete(store->index, &probe, 0);
+            free(entry);
+            return 1;
+        }
+    }
+    else if (value_size == UPO_KVSTORE_TOMBSTONE)
+    {
+        return 0;
+    }
+    else
+    {
+        entry = malloc(sizeof(upo_kvstore_entry_t) + key_size);
+        if (entry == NULL)
+        {
+            upo_throw_sys_error("Unable to allocate memory for an entry of the Key-Value Store");
+        }
+        if (key_size > 0)
+            memcpy(entry + 1, key, key_size);
+        entry->key = (const unsigned char*) (entry + 1);
+        entry->key_size = key_size;
+        upo_ht_linprob_put(store->index, entry, entry);
+    }
+
+    entry->value_size = value_size;
+    entry->offset = offset;
+    store->live += upo_kvstore_record_size(key_size, value_size);
+
+    return found;
+}
+
+void upo_kvstore_replay(upo_kvstore_t store)
+{
+    struct stat st;
+    unsigned char *buf = NULL;
+    size_t buf_size = 0;
+    size_t key_size = 0;
+    size_t value_size = 0;
+    uint64_t size = 0;
+    uint64_t offset = 0;
+
+    if (fstat(store->fd, &st) != 0)
+    {
+        upo_throw_sys_error("Unable to get the size of the log of the Key-Value Store");
+    }
+    size = (uint64_t) st.st_size;
+
+    while (offset < size && upo_kvstore_read_record(store->fd, offset, size, &buf, &buf_size, &key_size, &value_size))
+    {
+        upo_kvstore_apply(store, buf + UPO_KVSTORE_HEADER_SIZE, key_size, value_size, offset);
+        offset += upo_kvstore_record_size(key_size, value_size);
+    }
+    free(buf);
+
+    if (offset < size)
+    {
+        /* Drop the torn or corrupted tail, so that new records follow valid ones */
+        if (ftruncate(store->fd, (off_t) offset) != 0 || fsync(store->fd) != 0)
+        {
+            upo_throw_sys_error("Unable to truncate the log of the Key-Value Store");
+        }
+        ++store->syncs;
+    }
+    store->end = offset;
+}
+
+void upo_kvstore_sync_to(upo_kvstore_t store, uint64_t appended)
+{
+    uint64_t target = 0;
+    int fd = -1;
+
+    pthread_mutex_lock(&store->lock);
+    while (store->durable < appended)
+    {
+        if (store->syncing)
+        {
+            /* Another thread is syncing: its sync may cover our records too */
+            pthread_cond_wait(&store->synced, &store->lock);
+            continue;
+        }
+
+        /* Sync every record appended so far, for us and for the waiting threads */
+        store->syncing = 1;
+        target = store->appended;
+        fd = store->fd;
+        pthread_mutex_unlock(&store->lock);
+
+        if (fsync(fd) != 0)
+        {
+            upo_throw_sys_error("Unable to sync the log of the Key-Value Store");
+        }
+
+        pthread_mutex_lock(&store->lock);
+        store->syncing = 0;
+        ++store->syncs;
+        if (store->durable < target)
+            store->durable = target;
+        pthread_cond_broadcast(&store->synced);
+    }
+    pthread_mutex_unlock(&store->lock);
+}
+
+void upo_kvstore_sync_dir(const char *path)
+{
+    char *dir = NULL;
+    char *slash = NULL;
+    int fd = -1;
+
+    dir = malloc(strlen(path) + 2);
+    if (dir == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for the path of the Key-Value Store");
+    }
+    strcpy(dir, path);
+    slash = strrchr(dir, '/');
+    if (slash == NULL)
+        strcpy(dir, ".");
+    else
+        slash[slash == dir ? 1 : 0] = '\0';
+
+    /* Note: some file systems do not support syncing directories */
+    fd = open(dir, O_RDONLY);
+    if (fd >= 0)
+    {
+        fsync(fd);
+        close(fd);
+    }
+    free(dir);
+}
+
+void upo_kvstore_copy(int from, uint64_t from_offset, int to, uint64_t to_offset, uint64_t size)
+{
+    unsigned char *buf = NULL;
+    size_t n = 0;
+
+    buf = malloc(UPO_KVSTORE_COPY_BUFFER_SIZE);
+    if (buf == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for compacting the Key-Value Store");
+    }
+    while (size > 0)
+    {
+        n = size < UPO_KVSTORE_COPY_BUFFER_SIZE ? (size_t) size : UPO_KVSTORE_COPY_BUFFER_SIZE;
+        if (!upo_kvstore_read(from, buf, n, from_offset))
+        {
+            upo_throw_error("Unexpected end of the log of the Key-Value Store");
+        }
+        upo_kvstore_write(to, buf, n, to_offset);
+        from_offset += n;
+        to_offset += n;
+        size -= n;
+    }
+    free(buf);
+}
+
+void upo_kvstore_remap_entry(void *key, void *value, void *remap)
+{
+    upo_kvstore_entry_t *entry = key;
+    upo_kvstore_remap_t *r = remap;
+    size_t lo = 0;
+    size_t hi = 0;
+    size_t mid = 0;
+
+    (void) value;
+
+    if (entry->offset >= r->tail)
+    {
+        entry->offset = r->tail_to + (entry->offset - r->tail);
+        return;
+    }
+
+    /* The record was live when it was copied, and has not been replaced since */
+    hi = r->size;
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (r->from[mid] < entry->offset)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    assert( lo < r->size && r->from[lo] == entry->offset );
+
+    entry->offset = r->to[lo];
+}
+
+void upo_kvstore_compact_run(upo_kvstore_t store)
+{
+    upo_kvstore_remap_t remap;
+    upo_kvstore_entry_t probe;
+    upo_kvstore_entry_t *entry = NULL;
+    unsigned char *buf = NULL;
+    size_t buf_size = 0;
+    size_t key_size = 0;
+    size_t value_size = 0;
+    uint64_t size = 0;
+    uint64_t offset = 0;
+    uint64_t snapshot = 0;
+    char *new_path = NULL;
+    void *p = NULL;
+    int old_fd = -1;
+    int new_fd = -1;
+    int live = 0;
+
+    new_path = malloc(strlen(store->path) + sizeof UPO_KVSTORE_COMPACT_SUFFIX);
+    if (new_path == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for the path of the Key-Value Store");
+    }
+    strcpy(new_path, store->path);
+    strcat(new_path, UPO_KVSTORE_COMPACT_SUFFIX);
+
+    new_fd = open(new_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (new_fd < 0)
+    {
+        upo_throw_sys_error("Unable to create the new log of the Key-Value Store");
+    }
+
+    /* Only this thread replaces the log, and records before the snapshot never change */
+    pthread_mutex_lock(&store->lock);
+    old_fd = store->fd;
+    snapshot = store->end;
+    pthread_mutex_unlock(&store->lock);
+
+    memset(&remap, 0, sizeof remap);
+    while (offset < snapshot)
+    {
+        if (!upo_kvstore_read_record(old_fd, offset, snapshot, &buf, &buf_size, &key_size, &value_size))
+        {
+            upo_throw_error("Corrupted record in the log of the Key-Value Store");
+        }
+        size = upo_kvstore_record_size(key_size, value_size);
+
+        live = 0;
+        if (value_size != UPO_KVSTORE_TOMBSTONE)
+        {
+            probe.key = buf + UPO_KVSTORE_HEADER_SIZE;
+            probe.key_size = key_size;
+            pthread_mutex_lock(&store->lock);
+            entry = upo_ht_linprob_get(store->index, &probe);
+            live = entry != NULL && entry->offset == offset;
+            pthread_mutex_unlock(&store->lock);
+        }
+
+        if (live)
+        {
+            if (remap.size == remap.capacity)
+            {
+                remap.capacity = remap.capacity > 0 ? 2*remap.capacity : 64;
+                p = realloc(remap.from, remap.capacity*sizeof(uint64_t));
+                if (p != NULL)
+                {
+                    remap.from = p;
+                    p = realloc(remap.to, remap.capacity*sizeof(uint64_t));
+                }
+                if (p == NULL)
+                {
+                    upo_throw_sys_error("Unable to allocate memory for compacting the Key-Value Store");
+                }
+                remap.to = p;
+            }
+            remap.from[remap.size] = offset;
+            remap.to[remap.size] = remap.tail_to;
+            ++remap.size;
+
+            upo_kvstore_write(new_fd, buf, (size_t) size, remap.tail_to);
+            remap.tail_to += size;
+        }
+        offset += size;
+    }
+    free(buf);
+
+    if (fsync(new_fd) != 0)
+    {
+        upo_throw_sys_error("Unable to sync the new log of the Key-Value Store");
+    }
+
+    pthread_mutex_lock(&store->lock);
+
+    /* The old log must not be closed while another thread syncs it */
+    while (store->syncing)
+    {
+        pthread_cond_wait(&store->synced, &store->lock);
+    }
+
+    /* Copy the records appended during the compaction, which are all kept */
+    remap.tail = snapshot;
+    upo_kvstore_copy(old_fd, snapshot, new_fd, remap.tail_to, store->end - snapshot);
+    upo_ht_linprob_traverse(store->index, upo_kvstore_remap_entry, &remap);
+
+    if (fsync(new_fd) != 0)
+    {
+        upo_throw_sys_error("Unable to sync the new log of the Key-Value Store");
+    }
+    store->syncs += 2;
+    if (rename(new_path, store->path) != 0)
+    {
+        upo_throw_sys_error("Unable to replace the log of the Key-Value Store");
+    }
+    upo_kvstore_sync_dir(store->path);
+
+    close(old_fd);
+    store->fd = new_fd;
+    store->end = remap.tail_to + (store->end - snapshot);
+    store->durable = store->appended;
+    store->compacting = 0;
+    pthread_cond_broadcast(&store->synced);
+
+    pthread_mutex_unlock(&store->lock);
+
+    free(remap.from);
+    free(remap.to);
+    free(new_path);
+}
+
+void* upo_kvstore_compact_thread(void *store)
+{
+    upo_kvstore_compact_run(store);
+
+    return NULL;
+}
+
+
+/*** END of FUNDAMENTAL OPERATIONS ***/
+
+
+/*** BEGIN of EXTRA OPERATIONS ***/
+
+
+size_t upo_kvstore_size(const upo_kvstore_t store)
+{
+    size_t size = 0;
+
+    if (store != NULL)
+    {
+        pthread_mutex_lock(&store->lock);
+        size = upo_ht_linprob_size(store->index);
+        pthread_mutex_unlock(&store->lock);
+    }
+
+    return size;
+}
+
+int upo_kvstore_is_empty(const upo_kvstore_t store)
+{
+    return upo_kvstore_size(store) == 0;
+}
+
+uint64_t upo_kvstore_log_size(const upo_kvstore_t store)
+{
+    uint64_t end = 0;
+
+    if (store != NULL)
+    {
+        pthread_mutex_lock(&store->lock);
+        end = store->end;
+        pthread_mutex_unlock(&store->lock);
+    }
+
+    return end;
+}
+
+uint64_t upo_kvstore_live_size(const upo_kvstore_t store)
+{
+    uint64_t live = 0;
+
+    if (store != NULL)
+    {
+        pthread_mutex_lock(&store->lock);
+        live = store->live;
+        pthread_mutex_unlock(&store->lock);
+    }
+
+    return live;
+}
+
+size_t upo_kvstore_syncs(const upo_kvstore_t store)
+{
+    size_t syncs = 0;
+
+    if (store != NULL)
+    {
+        pthread_mutex_lock(&store->lock);
+        syncs = store->syncs;
+        pthread_mutex_unlock(&store->lock);
+    }
+
+    return syncs;
+}
+
+
+/*** END of EXTRA OPERATIONS ***/
@@ -0,0 +1,303 @@
+/**
+ * \file src/kvstore_private.h
+ *
+ * \brief Private header for the Key-Value Store abstract data type.
+ *
+ * \copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ *  This file is part of UPOalglib.
+ *
+ *  UPOalglib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  UPOalglib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UPO_KVSTORE_PRIVATE_H
+#define UPO_KVSTORE_PRIVATE_H
+
+
+#include <pthread.h>
+#include <stdint.h>
+#include <upo/hashtable.h>
+#include <upo/kvstore.h>
+
+
+/** \brief Number of bytes of the header of log records. */
+#define UPO_KVSTORE_HEADER_SIZE 12U
+
+/** \brief Value size marking the records of removed keys. */
+#define UPO_KVSTORE_TOMBSTONE 0xFFFFFFFFU
+
+/** \brief Suffix of the path of the new log written by a compaction. */
+#define UPO_KVSTORE_COMPACT_SUFFIX ".compact"
+
+/** \brief Number of bytes buffered when copying records into a new log. */
+#define UPO_KVSTORE_COPY_BUFFER_SIZE 65536U
+
+/** \brief Initial number of slots of the index. */
+#define UPO_KVSTORE_INDEX_CAPACITY 64U
+
+
+/**
+ * \brief Type for entries of the index of key-value stores.
+ *
+ * Entries are both the keys and the values of the index; the bytes of the key
+ * are allocated together with the entry.
+ */
+struct upo_kvstore_entry_s
+{
+    const unsigned char *key; /**< The bytes of the key. */
+    size_t key_size; /**< The number of bytes of the key. */
+    size_t value_size; /**< The number of bytes of the current value. */
+    uint64_t offset; /**< The offset in the log of the record of the current value. */
+};
+/** \brief Alias for the type for entries of the index of key-value stores. */
+typedef struct upo_kvstore_entry_s upo_kvstore_entry_t;
+
+/**
+ * \brief Type for key-value stores.
+ *
+ * Log records are made of a header (the CRC-32 of the rest of the record, the
+ * size of the key and the size of the value or UPO_KVSTORE_TOMBSTONE, as
+ * 32-bit little-endian integers) followed by the bytes of the key and of the
+ * value.
+ * Durability is tracked in bytes appended since the store was opened rather
+ * than in offsets, since offsets move back when the log is compacted.
+ */
+struct upo_kvstore_s
+{
+    char *path; /**< The path of the log. */
+    int fd; /**< The file descriptor of the log. */
+    upo_ht_linprob_t index; /**< The index, mapping keys to their entries. */
+    uint64_t end; /**< The size of the log. */
+    uint64_t live; /**< The number of bytes of the records referenced by the index. */
+    uint64_t appended; /**< The number of bytes appended since the store was opened. */
+    uint64_t durable; /**< The number of appended bytes known to be durable. */
+    size_t syncs; /**< The number of calls to `fsync()` on the log. */
+    int sync; /**< Tells if updates wait for their records to be durable. */
+    int syncing; /**< Tells if a thread is syncing the log without holding the lock. */
+    int compacting; /**< Tells if a compaction is running. */
+    int compactor; /**< Tells if the background compaction thread must be joined. */
+    pthread_t compactor_thread; /**< The background compaction thread. */
+    pthread_mutex_t lock; /**< The lock protecting the store. */
+    pthread_cond_t synced; /**< Signaled when a thread ends syncing the log. */
+};
+
+/** \brief Type for the map from old to new offsets built by compactions. */
+struct upo_kvstore_remap_s
+{
+    uint64_t *from; /**< The offsets of the copied records in the old log, in increasing order. */
+    uint64_t *to; /**< The offsets of the copied records in the new log. */
+    size_t size; /**< The number of copied records. */
+    size_t capacity; /**< The number of allocated elements of the arrays. */
+    uint64_t tail; /**< The offset in the old log of the records copied at the end of the compaction. */
+    uint64_t tail_to; /**< The offset of those records in the new log. */
+};
+/** \brief Alias for the type for the map from old to new offsets. */
+typedef struct upo_kvstore_remap_s upo_kvstore_remap_t;
+
+
+/**
+ * \brief Computes the CRC-32 (IEEE 802.3) of the given bytes.
+ *
+ * \param crc The CRC-32 of the preceding bytes, or `0`.
+ * \param data The bytes.
+ * \param size The number of bytes.
+ * \return The CRC-32 of the preceding bytes followed by the given ones.
+ */
+static uint32_t upo_kvstore_crc32(uint32_t crc, const void *data, size_t size);
+
+/**
+ * \brief Stores the given 32-bit integer in little-endian byte order.
+ *
+ * \param p The destination, 4 bytes long.
+ * \param x The integer.
+ */
+static void upo_kvstore_store_u32(unsigned char *p, uint32_t x);
+
+/**
+ * \brief Loads a 32-bit integer stored in little-endian byte order.
+ *
+ * \param p The source, 4 bytes long.
+ * \return The integer.
+ */
+static uint32_t upo_kvstore_load_u32(const unsigned char *p);
+
+/**
+ * \brief Hashes the key of the given index entry by means of the FNV-1a
+ *  function.
+ *
+ * \param entry The index entry.
+ * \param m The number of possible hash values.
+ * \return The hash value, in `[0, m)`.
+ */
+static size_t upo_kvstore_entry_hash(const void *entry, size_t m);
+
+/**
+ * \brief Compares the keys of the given index entries.
+ *
+ * \param a The first index entry.
+ * \param b The second index entry.
+ * \return A negative, zero or positive value if the first key is shorter,
+ *  equal or longer (or, with the same size, lexicographically less, equal or
+ *  greater) than the second key.
+ */
+static int upo_kvstore_entry_cmp(const void *a, const void *b);
+
+/**
+ * \brief Frees the given index entry.
+ *
+ * \param key The index entry.
+ * \param value The index entry.
+ * \param arg Unused.
+ */
+static void upo_kvstore_entry_free(void *key, void *value, void *arg);
+
+/**
+ * \brief Returns the number of bytes of the record of a value of the given
+ *  size.
+ *
+ * \param key_size The number of bytes of the key.
+ * \param value_size The number of bytes of the value, or
+ *  UPO_KVSTORE_TOMBSTONE.
+ * \return The number of bytes of the record.
+ */
+static uint64_t upo_kvstore_record_size(size_t key_size, size_t value_size);
+
+/**
+ * \brief Writes the given bytes at the given offset of the given file.
+ *
+ * \param fd The file descriptor.
+ * \param data The bytes.
+ * \param size The number of bytes.
+ * \param offset The offset.
+ */
+static void upo_kvstore_write(int fd, const void *data, size_t size, uint64_t offset);
+
+/**
+ * \brief Reads bytes at the given offset of the given file.
+ *
+ * \param fd The file descriptor.
+ * \param data The buffer.
+ * \param size The number of bytes to read.
+ * \param offset The offset.
+ * \return `1` if all the bytes have been read, or `0` if the end of the
+ *  file has been reached first.
+ */
+static int upo_kvstore_read(int fd, void *data, size_t size, uint64_t offset);
+
+/**
+ * \brief Reads and checks the log record at the given offset.
+ *
+ * \param fd The file descriptor of the log.
+ * \param offset The offset of the record.
+ * \param end The size of the log.
+ * \param buf The buffer holding the record, reallocated if needed.
+ * \param buf_size The number of bytes of the buffer.
+ * \param key_size Set to the number of bytes of the key.
+ * \param value_size Set to the number of bytes of the value, or to
+ *  UPO_KVSTORE_TOMBSTONE.
+ * \return `1` if a complete record with a matching checksum has been read,
+ *  or `0` otherwise.
+ */
+static int upo_kvstore_read_record(int fd, uint64_t offset, uint64_t end, unsigned char **buf, size_t *buf_size, size_t *key_size, size_t *value_size);
+
+/**
+ * \brief Appends a record to the log of the given key-value store.
+ *
+ * \param store The key-value store, whose lock must be held.
+ * \param key The bytes of the key.
+ * \param key_size The number of bytes of the key.
+ * \param value The bytes of the value.
+ * \param value_size The number of bytes of the value, or
+ *  UPO_KVSTORE_TOMBSTONE.
+ * \return The offset of the record.
+ */
+static uint64_t upo_kvstore_append(upo_kvstore_t store, const void *key, size_t key_size, const void *value, size_t value_size);
+
+/**
+ * \brief Applies a record to the index of the given key-value store.
+ *
+ * \param store The key-value store, whose lock must be held.
+ * \param key The bytes of the key.
+ * \param key_size The number of bytes of the key.
+ * \param value_size The number of bytes of the value, or
+ *  UPO_KVSTORE_TOMBSTONE.
+ * \param offset The offset of the record.
+ * \return `1` if the key was present, or `0` otherwise.
+ */
+static int upo_kvstore_apply(upo_kvstore_t store, const void *key, size_t key_size, size_t value_size, uint64_t offset);
+
+/**
+ * \brief Rebuilds the index of the given key-value store from its log,
+ *  truncating the log at the first invalid record.
+ *
+ * \param store The key-value store.
+ */
+static void upo_kvstore_replay(upo_kvstore_t store);
+
+/**
+ * \brief Makes the given number of appended bytes of the log durable,
+ *  sharing the `fsync()` calls with concurrent threads.
+ *
+ * \param store The key-value store.
+ * \param appended The number of appended bytes.
+ */
+static void upo_kvstore_sync_to(upo_kvstore_t store, uint64_t appended);
+
+/**
+ * \brief Syncs the directory holding the given file, so that a rename of the
+ *  file is durable.
+ *
+ * \param path The path of the file.
+ */
+static void upo_kvstore_sync_dir(const char *path);
+
+/**
+ * \brief Copies bytes from a file to another.
+ *
+ * \param from The file descriptor of the source file.
+ * \param from_offset The offset of the bytes in the source file.
+ * \param to The file descriptor of the destination file.
+ * \param to_offset The offset of the bytes in the destination file.
+ * \param size The number of bytes.
+ */
+static void upo_kvstore_copy(int from, uint64_t from_offset, int to, uint64_t to_offset, uint64_t size);
+
+/**
+ * \brief Updates the offset of the given index entry after a compaction.
+ *
+ * \param key The index entry.
+ * \param value The index entry.
+ * \param remap The map from old to new offsets.
+ */
+static void upo_kvstore_remap_entry(void *key, void *value, void *remap);
+
+/**
+ * \brief Compacts the log of the given key-value store.
+ *
+ * \param store The key-value store, whose `compacting` flag has been set
+ *  by the caller; the flag is cleared at the end.
+ */
+static void upo_kvstore_compact_run(upo_kvstore_t store);
+
+/**
+ * \brief Runs upo_kvstore_compact_run() on the key-value store passed as
+ *  argument.
+ *
+ * \param store The key-value store.
+ * \return `NULL`.
+ */
+static void* upo_kvstore_compact_thread(void *store);
+
+
+#endif /* UPO_KVSTORE_PRIVATE_H */
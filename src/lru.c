@@ -0,0 +1,367 @@
+/*
+ * Copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ * This file is part of UPOalglib.
+ *
+ * UPOalglib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * UPOalglib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include <upo/error.h>
+#include "lru_private.h"
+
+
+/*** BEGIN of FUNDAMENTAL OPERATIONS ***/
+
+
+upo_lru_t upo_lru_create(size_t capacity, upo_ht_hasher_t key_hash, upo_ht_comparator_t key_cmp)
+{
+    upo_lru_t lru = NULL;
+    size_t i = 0;
+
+    /* preconditions */
+    assert( capacity > 0 );
+    assert( key_hash != NULL );
+    assert( key_cmp != NULL );
+
+    lru = malloc(sizeof(struct upo_lru_s));
+    if (lru == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for LRU Cache");
+    }
+
+    lru->slots = malloc(capacity*sizeof(upo_lru_node_t*));
+    lru->nodes = malloc(capacity*sizeof(upo_lru_node_t));
+    if (lru->slots == NULL || lru->nodes == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for nodes of the LRU Cache");
+    }
+
+    for (i = 0; i < capacity; ++i)
+    {
+        lru->slots[i] = NULL;
+    }
+
+    lru->capacity = capacity;
+    lru->key_hash = key_hash;
+    lru->key_cmp = key_cmp;
+    lru->evict = NULL;
+    lru->evict_arg = NULL;
+    lru->free = NULL;
+    lru->newest = NULL;
+    lru->oldest = NULL;
+    lru->size = 0;
+
+    /* All nodes start in the list of free nodes */
+    for (i = capacity; i > 0; --i)
+    {
+        lru->nodes[i-1].next = lru->free;
+        lru->free = &lru->nodes[i-1];
+    }
+
+    return lru;
+}
+
+void upo_lru_destroy(upo_lru_t lru, int destroy_data)
+{
+    if (lru != NULL)
+    {
+        upo_lru_clear(lru, destroy_data);
+        free(lru->nodes);
+        free(lru->slots);
+        free(lru);
+    }
+}
+
+void upo_lru_clear(upo_lru_t lru, int destroy_data)
+{
+    if (lru != NULL)
+    {
+        while (lru->oldest != NULL)
+        {
+            upo_lru_node_t *node = lru->oldest;
+
+            upo_lru_unlink(lru, node);
+            if (destroy_data)
+            {
+                free(node->key);
+                free(node->value);
+            }
+            lru->slots[node->slot] = NULL;
+            node->next = lru->free;
+            lru->free = node;
+        }
+        lru->size = 0;
+    }
+}
+
+void* upo_lru_put(upo_lru_t lru, void *key, void *value, int destroy_data)
+{
+    size_t slot = 0;
+    upo_lru_node_t **link = NULL;
+    upo_lru_node_t *node = NULL;
+    void *old_value = NULL;
+
+    /* preconditions */
+    assert( lru != NULL );
+
+    slot = lru->key_hash(key, lru->capacity);
+    link = upo_lru_find(lru, slot, key);
+
+    if (*link != NULL) // Change the value and put the old one in old_value
+    {
+        node = *link;
+        old_value = node->value;
+        node->value = value;
+        upo_lru_unlink(lru, node);
+    }
+    else
+    {
+        if (lru->size == lru->capacity)
+            upo_lru_evict(lru, destroy_data);
+
+        /* Note: the eviction may have changed the list of collisions, so the
+         * new node goes to its head */
+        node = lru->free;
+        lru->free = node->next;
+        node->key = key;
+        node->value = value;
+        node->slot = slot;
+        node->next = lru->slots[slot];
+        lru->slots[slot] = node;
+        lru->size++;
+    }
+
+    upo_lru_link_newest(lru, node);
+
+    return old_value;
+}
+
+void* upo_lru_get(upo_lru_t lru, const void *key)
+{
+    upo_lru_node_t *node = NULL;
+
+    if (lru == NULL)
+        return NULL;
+
+    node = *upo_lru_find(lru, lru->key_hash(key, lru->capacity), key);
+    if (node == NULL)
+        return NULL;
+
+    if (node != lru->newest)
+    {
+        upo_lru_unlink(lru, node);
+        upo_lru_link_newest(lru, node);
+    }
+
+    return node->value;
+}
+
+void* upo_lru_peek(const upo_lru_t lru, const void *key)
+{
+    upo_lru_node_t *node = NULL;
+
+    if (lru == NULL)
+        return NULL;
+
+    node = *upo_lru_find(lru, lru->key_hash(key, lru->capacity), key);
+
+    return (node != NULL) ? node->value : NULL;
+}
+
+int upo_lru_contains(const upo_lru_t lru, const void *key)
+{
+    if (lru == NULL)
+        return 0;
+
+    return *upo_lru_find(lru, lru->key_hash(key, lru->capacity), key) != NULL;
+}
+
+void upo_lru_delete(upo_lru_t lru, const void *key, int destroy_data)
+{
+    upo_lru_node_t **link = NULL;
+
+    if (lru == NULL)
+        return;
+
+    link = upo_lru_find(lru, lru->key_hash(key, lru->capacity), key);
+    if (*link != NULL)
+        upo_lru_remove(lru, link, destroy_data);
+}
+
+int upo_lru_evict(upo_lru_t lru, int destroy_data)
+{
+    upo_lru_node_t *node = NULL;
+    upo_lru_node_t **link = NULL;
+
+    if (lru == NULL || lru->oldest == NULL)
+        return 0;
+
+    node = lru->oldest;
+
+    /* Find the node by address, without hashing nor comparing its key */
+    link = &lru->slots[node->slot];
+    while (*link != node)
+        link = &(*link)->next;
+
+    if (lru->evict != NULL)
+        lru->evict(node->key, node->value, lru->evict_arg);
+
+    upo_lru_remove(lru, link, destroy_data);
+
+    return 1;
+}
+
+void upo_lru_set_evictor(upo_lru_t lru, upo_lru_evictor_t evict, void *evict_arg)
+{
+    if (lru != NULL)
+    {
+        lru->evict = evict;
+        lru->evict_arg = evict_arg;
+    }
+}
+
+void* upo_lru_oldest(const upo_lru_t lru)
+{
+    return (lru != NULL && lru->oldest != NULL) ? lru->oldest->key : NULL;
+}
+
+size_t upo_lru_size(const upo_lru_t lru)
+{
+    return (lru != NULL) ? lru->size : 0;
+}
+
+int upo_lru_is_empty(const upo_lru_t lru)
+{
+    return upo_lru_size(lru) == 0 ? 1 : 0;
+}
+
+size_t upo_lru_capacity(const upo_lru_t lru)
+{
+    return (lru != NULL) ? lru->capacity : 0;
+}
+
+upo_ht_comparator_t upo_lru_get_comparator(const upo_lru_t lru)
+{
+    return lru->key_cmp;
+}
+
+upo_ht_hasher_t upo_lru_get_hasher(const upo_lru_t lru)
+{
+    return lru->key_hash;
+}
+
+upo_lru_node_t** upo_lru_find(const upo_lru_t lru, size_t slot, const void *key)
+{
+    upo_lru_node_t **link = &lru->slots[slot];
+
+    while (*link != NULL && lru->key_cmp(key, (*link)->key) != 0)
+        link = &(*link)->next;
+
+    return link;
+}
+
+void upo_lru_unlink(upo_lru_t lru, upo_lru_node_t *node)
+{
+    if (node->newer != NULL)
+        node->newer->older = node->older;
+    else
+        lru->newest = node->older;
+
+    if (node->older != NULL)
+        node->older->newer = node->newer;
+    else
+        lru->oldest = node->newer;
+}
+
+void upo_lru_link_newest(upo_lru_t lru, upo_lru_node_t *node)
+{
+    node->newer = NULL;
+    node->older = lru->newest;
+    if (lru->newest != NULL)
+        lru->newest->newer = node;
+    else
+        lru->oldest = node;
+    lru->newest = node;
+}
+
+void upo_lru_remove(upo_lru_t lru, upo_lru_node_t **link, int destroy_data)
+{
+    upo_lru_node_t *node = *link;
+
+    *link = node->next;
+    upo_lru_unlink(lru, node);
+
+    if (destroy_data)
+    {
+        free(node->key);
+        free(node->value);
+    }
+
+    node->key = NULL;
+    node->value = NULL;
+    node->next = lru->free;
+    lru->free = node;
+    lru->size--;
+}
+
+
+/*** END of FUNDAMENTAL OPERATIONS ***/
+
+
+/*** BEGIN of EXTRA OPERATIONS ***/
+
+
+upo_ht_key_list_t upo_lru_keys(const upo_lru_t lru)
+{
+    upo_ht_key_list_t list = NULL;
+    upo_lru_node_t *node = NULL;
+
+    if (lru != NULL)
+    {
+        /* Prepend keys from the oldest one, so the list starts from the newest */
+        for (node = lru->oldest; node != NULL; node = node->newer)
+        {
+            upo_ht_key_list_node_t *list_node = malloc(sizeof(struct upo_ht_key_list_node_s));
+
+            if (list_node == NULL)
+                upo_throw_sys_error("Unable to allocate memory for a new node of the key list");
+
+            list_node->key = node->key;
+            list_node->next = list;
+            list = list_node;
+        }
+    }
+
+    return list;
+}
+
+void upo_lru_traverse(const upo_lru_t lru, upo_ht_visitor_t visit, void *visit_arg)
+{
+    upo_lru_node_t *node = NULL;
+
+    if (lru != NULL && visit != NULL)
+    {
+        for (node = lru->newest; node != NULL; node = node->older)
+        {
+            visit(node->key, node->value, visit_arg);
+        }
+    }
+}
+
+
+/*** END of EXTRA OPERATIONS ***/
@@ -0,0 +1,101 @@
+/**
+ * \file src/lru_private.h
+ *
+ * \brief Private header for the LRU cache abstract data type.
+ *
+ * \copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ *  This file is part of UPOalglib.
+ *
+ *  UPOalglib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  UPOalglib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UPO_LRU_PRIVATE_H
+#define UPO_LRU_PRIVATE_H
+
+
+#include <upo/lru.h>
+
+
+/** \brief Type for nodes of LRU caches. */
+struct upo_lru_node_s
+{
+    void *key; /**< Pointer to the user-provided key. */
+    void *value; /**< Pointer to the value associated to the key. */
+    size_t slot; /**< The slot whose list of collisions holds this node. */
+    struct upo_lru_node_s *next; /**< Pointer to the next node in the list of collisions (or in the list of free nodes). */
+    struct upo_lru_node_s *newer; /**< Pointer to the next more recently used node. */
+    struct upo_lru_node_s *older; /**< Pointer to the next less recently used node. */
+};
+/** \brief Alias for the type for nodes of LRU caches. */
+typedef struct upo_lru_node_s upo_lru_node_t;
+
+/** \brief Type for LRU caches. */
+struct upo_lru_s
+{
+    upo_lru_node_t **slots; /**< The heads of the lists of collisions. */
+    upo_lru_node_t *nodes; /**< The array of all nodes. */
+    upo_lru_node_t *free; /**< The list of unused nodes. */
+    upo_lru_node_t *newest; /**< The most recently used node. */
+    upo_lru_node_t *oldest; /**< The least recently used node. */
+    size_t capacity; /**< The maximum number of key-value pairs, which is also the number of slots. */
+    size_t size; /**< The number of stored key-value pairs. */
+    upo_ht_hasher_t key_hash; /**< The key hash function. */
+    upo_ht_comparator_t key_cmp; /**< The key comparison function. */
+    upo_lru_evictor_t evict; /**< The eviction function, or `NULL`. */
+    void *evict_arg; /**< The additional parameter of the eviction function. */
+};
+
+
+/**
+ * \brief Searches for the given key in the given slot of the given LRU cache.
+ *
+ * \param lru The LRU cache.
+ * \param slot The slot of the key.
+ * \param key The key to search for.
+ * \return The link (i.e., the head of the list of collisions or the `next`
+ *  field of a node) pointing to the node of the key, or to `NULL` if the key
+ *  is not found.
+ */
+static upo_lru_node_t** upo_lru_find(const upo_lru_t lru, size_t slot, const void *key);
+
+/**
+ * \brief Unlinks the given node from the recency list of the given LRU cache.
+ *
+ * \param lru The LRU cache.
+ * \param node The node.
+ */
+static void upo_lru_unlink(upo_lru_t lru, upo_lru_node_t *node);
+
+/**
+ * \brief Links the given node as the most recently used one.
+ *
+ * \param lru The LRU cache.
+ * \param node The node, which must not be in the recency list.
+ */
+static void upo_lru_link_newest(upo_lru_t lru, upo_lru_node_t *node);
+
+/**
+ * \brief Removes the node pointed by the given link from the given LRU cache,
+ *  and returns it to the list of free nodes.
+ *
+ * \param lru The LRU cache.
+ * \param link The link pointing to the node in its list of collisions.
+ * \param destroy_data Tells whether the key and the value of the node must be
+ *  freed.
+ */
+static void upo_lru_remove(upo_lru_t lru, upo_lru_node_t **link, int destroy_data);
+
+
+#endif /* UPO_LRU_PRIVATE_H */
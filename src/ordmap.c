@@ -0,0 +1,389 @@
+/*
+ * Copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ * This file is part of UPOalglib.
+ *
+ * UPOalglib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * UPOalglib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <upo/error.h>
+#include "ordmap_private.h"
+
+
+/*** BEGIN of FUNDAMENTAL OPERATIONS ***/
+
+
+upo_ordmap_t upo_ordmap_create(size_t n, upo_ht_hasher_t key_hash, upo_ht_comparator_t key_cmp)
+{
+    upo_ordmap_t map = NULL;
+
+    /* preconditions */
+    assert( key_hash != NULL );
+    assert( key_cmp != NULL );
+
+    map = malloc(sizeof(struct upo_ordmap_s));
+    if (map == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for Ordered Map");
+    }
+
+    map->key_hash = key_hash;
+    map->key_cmp = key_cmp;
+
+    upo_ordmap_alloc(map, n);
+
+    return map;
+}
+
+void upo_ordmap_destroy(upo_ordmap_t map, int destroy_data)
+{
+    if (map != NULL)
+    {
+        upo_ordmap_clear(map, destroy_data);
+        free(map->index);
+        free(map->entries);
+        free(map);
+    }
+}
+
+void upo_ordmap_clear(upo_ordmap_t map, int destroy_data)
+{
+    if (map != NULL)
+    {
+        size_t i = 0;
+
+        for (i = 0; i < map->used && destroy_data; ++i)
+        {
+            if (map->entries[i].key != NULL)
+            {
+                free(map->entries[i].key);
+                free(map->entries[i].value);
+            }
+        }
+
+        /* Note: all bits set is UPO_ORDMAP_EMPTY for every width */
+        memset(map->index, 0xFF, map->index_capacity*upo_ordmap_index_width(map->index_capacity));
+        map->used = 0;
+        map->size = 0;
+    }
+}
+
+void* upo_ordmap_put(upo_ordmap_t map, void *key, void *value)
+{
+    uint64_t hash = 0;
+    size_t pos = 0; // Index slot position
+    int64_t ix = 0; // Entry position
+    void *old_value = NULL;
+
+    /* preconditions */
+    assert( map != NULL );
+
+    hash = upo_ht_hash_wide(map->key_hash, key);
+    ix = upo_ordmap_find(map, key, hash, &pos);
+
+    if (ix >= 0) // Change the value in place, keeping the insertion order
+    {
+        old_value = map->entries[ix].value;
+        map->entries[ix].value = value;
+    }
+    else
+    {
+        if (map->used == map->capacity)
+        {
+            upo_ordmap_resize(map, 2*map->size + 1);
+            upo_ordmap_find(map, key, hash, &pos);
+        }
+
+        map->entries[map->used].hash = hash;
+        map->entries[map->used].key = key;
+        map->entries[map->used].value = value;
+        upo_ordmap_index_set(map, pos, (int64_t) map->used);
+        map->used++;
+        map->size++;
+    }
+
+    return old_value;
+}
+
+void upo_ordmap_insert(upo_ordmap_t map, void *key, void *value)
+{
+    if (map != NULL && !upo_ordmap_contains(map, key))
+    {
+        upo_ordmap_put(map, key, value);
+    }
+}
+
+void* upo_ordmap_get(const upo_ordmap_t map, const void *key)
+{
+    size_t pos = 0; // Index slot position
+    int64_t ix = 0; // Entry position
+
+    if (map == NULL)
+        return NULL;
+
+    ix = upo_ordmap_find(map, key, upo_ht_hash_wide(map->key_hash, key), &pos);
+
+    return (ix >= 0) ? map->entries[ix].value : NULL;
+}
+
+int upo_ordmap_contains(const upo_ordmap_t map, const void *key)
+{
+    size_t pos = 0; // Index slot position
+
+    if (map == NULL)
+        return 0;
+
+    return upo_ordmap_find(map, key, upo_ht_hash_wide(map->key_hash, key), &pos) >= 0;
+}
+
+void upo_ordmap_delete(upo_ordmap_t map, const void *key, int destroy_data)
+{
+    size_t pos = 0; // Index slot position
+    int64_t ix = 0; // Entry position
+
+    if (map == NULL)
+        return;
+
+    ix = upo_ordmap_find(map, key, upo_ht_hash_wide(map->key_hash, key), &pos);
+    if (ix >= 0)
+    {
+        if (destroy_data)
+        {
+            free(map->entries[ix].key);
+            free(map->entries[ix].value);
+        }
+
+        /* Leave a hole in the entries and keep probe sequences going on */
+        map->entries[ix].key = NULL;
+        map->entries[ix].value = NULL;
+        upo_ordmap_index_set(map, pos, UPO_ORDMAP_DUMMY);
+        map->size--;
+    }
+}
+
+size_t upo_ordmap_size(const upo_ordmap_t map)
+{
+    return (map != NULL) ? map->size : 0;
+}
+
+int upo_ordmap_is_empty(const upo_ordmap_t map)
+{
+    return upo_ordmap_size(map) == 0 ? 1 : 0;
+}
+
+size_t upo_ordmap_capacity(const upo_ordmap_t map)
+{
+    return (map != NULL) ? map->capacity : 0;
+}
+
+upo_ht_comparator_t upo_ordmap_get_comparator(const upo_ordmap_t map)
+{
+    return map->key_cmp;
+}
+
+upo_ht_hasher_t upo_ordmap_get_hasher(const upo_ordmap_t map)
+{
+    return map->key_hash;
+}
+
+size_t upo_ordmap_index_width(size_t m)
+{
+    /* Positions of entries are smaller than m, which is a power of two */
+    if (m <= INT8_MAX + 1U)
+        return sizeof(int8_t);
+    if (m <= INT16_MAX + 1U)
+        return sizeof(int16_t);
+    if (m <= INT32_MAX + 1U)
+        return sizeof(int32_t);
+
+    return sizeof(int64_t);
+}
+
+int64_t upo_ordmap_index_get(const upo_ordmap_t map, size_t i)
+{
+    switch (upo_ordmap_index_width(map->index_capacity))
+    {
+        case sizeof(int8_t):
+            return ((const int8_t*) map->index)[i];
+        case sizeof(int16_t):
+            return ((const int16_t*) map->index)[i];
+        case sizeof(int32_t):
+            return ((const int32_t*) map->index)[i];
+        default:
+            return ((const int64_t*) map->index)[i];
+    }
+}
+
+void upo_ordmap_index_set(upo_ordmap_t map, size_t i, int64_t ix)
+{
+    switch (upo_ordmap_index_width(map->index_capacity))
+    {
+        case sizeof(int8_t):
+            ((int8_t*) map->index)[i] = (int8_t) ix;
+            break;
+        case sizeof(int16_t):
+            ((int16_t*) map->index)[i] = (int16_t) ix;
+            break;
+        case sizeof(int32_t):
+            ((int32_t*) map->index)[i] = (int32_t) ix;
+            break;
+        default:
+            ((int64_t*) map->index)[i] = ix;
+            break;
+    }
+}
+
+int64_t upo_ordmap_find(const upo_ordmap_t map, const void *key, uint64_t hash, size_t *pos)
+{
+    size_t mask = map->index_capacity - 1;
+    size_t i = (size_t) hash & mask;
+    uint64_t perturb = hash;
+    int64_t ix = 0;
+    int found = 0; // Slot of a removed key found
+
+    /* Note: there is always an empty slot, since used slots are at most as
+     * many as entries */
+    while ((ix = upo_ordmap_index_get(map, i)) != UPO_ORDMAP_EMPTY)
+    {
+        if (ix == UPO_ORDMAP_DUMMY)
+        {
+            if (!found)
+            {
+                found = 1;
+                *pos = i;
+            }
+        }
+        else if (map->entries[ix].hash == hash && map->key_cmp(key, map->entries[ix].key) == 0)
+        {
+            *pos = i;
+            return ix;
+        }
+
+        perturb >>= UPO_ORDMAP_PERTURB_SHIFT;
+        i = (size_t) (5*i + 1 + perturb) & mask;
+    }
+
+    if (!found)
+        *pos = i;
+
+    return -1;
+}
+
+void upo_ordmap_resize(upo_ordmap_t map, size_t n)
+{
+    void *old_index = map->index;
+    upo_ordmap_entry_t *old_entries = map->entries;
+    size_t old_used = map->used;
+    size_t i = 0;
+
+    upo_ordmap_alloc(map, n);
+
+    /* Entries keep their relative order; keys are distinct and hash values
+     * are stored, so neither the hash nor the comparison functions are called
+     * (but for keys with the same hash value) */
+    for (i = 0; i < old_used; ++i)
+    {
+        if (old_entries[i].key != NULL)
+        {
+            size_t pos = 0; // Index slot position
+
+            upo_ordmap_find(map, old_entries[i].key, old_entries[i].hash, &pos);
+            map->entries[map->used] = old_entries[i];
+            upo_ordmap_index_set(map, pos, (int64_t) map->used);
+            map->used++;
+            map->size++;
+        }
+    }
+
+    free(old_index);
+    free(old_entries);
+}
+
+void upo_ordmap_alloc(upo_ordmap_t map, size_t n)
+{
+    size_t m = UPO_ORDMAP_MIN_INDEX_CAPACITY;
+
+    /* The index is at most two thirds full */
+    while (2*m/3 < n)
+        m *= 2;
+
+    map->index_capacity = m;
+    map->capacity = 2*m/3;
+    map->index = malloc(m*upo_ordmap_index_width(m));
+    map->entries = malloc(map->capacity*sizeof(upo_ordmap_entry_t));
+    if (map->index == NULL || map->entries == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for entries of the Ordered Map");
+    }
+
+    memset(map->index, 0xFF, m*upo_ordmap_index_width(m));
+    map->used = 0;
+    map->size = 0;
+}
+
+
+/*** END of FUNDAMENTAL OPERATIONS ***/
+
+
+/*** BEGIN of EXTRA OPERATIONS ***/
+
+
+upo_ht_key_list_t upo_ordmap_keys(const upo_ordmap_t map)
+{
+    upo_ht_key_list_t list = NULL;
+    size_t i = 0;
+
+    if (!upo_ordmap_is_empty(map))
+    {
+        /* Prepend keys from the last one, so the list is in insertion order */
+        for (i = map->used; i > 0; --i)
+        {
+            if (map->entries[i-1].key != NULL)
+            {
+                upo_ht_key_list_node_t *node = malloc(sizeof(struct upo_ht_key_list_node_s));
+
+                if (node == NULL)
+                    upo_throw_sys_error("Unable to allocate memory for a new node of the key list");
+
+                node->key = map->entries[i-1].key;
+                node->next = list;
+                list = node;
+            }
+        }
+    }
+
+    return list;
+}
+
+void upo_ordmap_traverse(const upo_ordmap_t map, upo_ht_visitor_t visit, void *visit_arg)
+{
+    size_t i = 0;
+
+    if (!upo_ordmap_is_empty(map) && visit != NULL)
+    {
+        for (i = 0; i < map->used; ++i)
+        {
+            if (map->entries[i].key != NULL)
+                visit(map->entries[i].key, map->entries[i].value, visit_arg);
+        }
+    }
+}
+
+
+/*** END of EXTRA OPERATIONS ***/
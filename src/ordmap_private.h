@@ -0,0 +1,140 @@
+/**
+ * \file src/ordmap_private.h
+ *
+ * \brief Private header for the Ordered Map abstract data type.
+ *
+ * \copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ *  This file is part of UPOalglib.
+ *
+ *  UPOalglib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  UPOalglib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UPO_ORDMAP_PRIVATE_H
+#define UPO_ORDMAP_PRIVATE_H
+
+
+#include <stdint.h>
+#include <upo/ordmap.h>
+
+
+/** \brief Minimum number of slots of the index (a power of two). */
+#define UPO_ORDMAP_MIN_INDEX_CAPACITY 8U
+
+/** \brief Index value that marks an empty slot. */
+#define UPO_ORDMAP_EMPTY (-1)
+
+/** \brief Index value that marks the slot of a removed key. */
+#define UPO_ORDMAP_DUMMY (-2)
+
+/**
+ * \brief Number of bits of the hash value that are mixed into each probe (see
+ *  upo_ordmap_find()).
+ */
+#define UPO_ORDMAP_PERTURB_SHIFT 5
+
+/** \brief Type for entries of ordered maps. */
+struct upo_ordmap_entry_s
+{
+    uint64_t hash; /**< The hash value of the key. */
+    void *key; /**< Pointer to the user-provided key, or `NULL` for removed keys. */
+    void *value; /**< Pointer to the value associated to the key. */
+};
+/** \brief Alias for the type for entries of ordered maps. */
+typedef struct upo_ordmap_entry_s upo_ordmap_entry_t;
+
+/** \brief Type for ordered maps. */
+struct upo_ordmap_s
+{
+    void *index; /**< The array of 8-bit, 16-bit, 32-bit or 64-bit signed positions of entries (or UPO_ORDMAP_EMPTY or UPO_ORDMAP_DUMMY). */
+    size_t index_capacity; /**< The number of slots of the index (a power of two). */
+    upo_ordmap_entry_t *entries; /**< The array of entries in insertion order. */
+    size_t capacity; /**< The number of entries, that is two thirds of the slots of the index. */
+    size_t used; /**< The number of entries in use, including the ones of removed keys. */
+    size_t size; /**< The number of stored key-value pairs. */
+    upo_ht_hasher_t key_hash; /**< The key hash function. */
+    upo_ht_comparator_t key_cmp; /**< The key comparison function. */
+};
+
+
+/**
+ * \brief Returns the size in bytes of the slots of an index with the given
+ *  number of slots.
+ *
+ * \param m The number of slots of the index.
+ * \return The smallest size among 1, 2, 4 and 8 that can store any position
+ *  of an entry.
+ */
+static size_t upo_ordmap_index_width(size_t m);
+
+/**
+ * \brief Returns the value stored in the given slot of the index.
+ *
+ * \param map The ordered map.
+ * \param i The position of the slot.
+ * \return The position of an entry, or UPO_ORDMAP_EMPTY or UPO_ORDMAP_DUMMY.
+ */
+static int64_t upo_ordmap_index_get(const upo_ordmap_t map, size_t i);
+
+/**
+ * \brief Stores the given value in the given slot of the index.
+ *
+ * \param map The ordered map.
+ * \param i The position of the slot.
+ * \param ix The position of an entry, or UPO_ORDMAP_EMPTY or UPO_ORDMAP_DUMMY.
+ */
+static void upo_ordmap_index_set(upo_ordmap_t map, size_t i, int64_t ix);
+
+/**
+ * \brief Searches for the given key in the index of the given ordered map.
+ *
+ * \param map The ordered map.
+ * \param key The key to search for.
+ * \param hash The hash value of the key.
+ * \param pos Set to the slot of the index pointing to the entry of the key
+ *  if found, or otherwise to the slot where the key can be inserted (the
+ *  first slot of a removed key, or else the empty slot ending the probe
+ *  sequence).
+ * \return The position of the entry of the key, or `-1` if the key is not
+ *  found.
+ *
+ * Slots are probed in the same way as CPython dictionaries: starting from
+ * `i = hash % m`, the next slot is `(5*i + 1 + perturb) % m`, where `perturb`
+ * starts from the hash value and is shifted right by UPO_ORDMAP_PERTURB_SHIFT
+ * bits at each probe.
+ * This way, all bits of the hash value affect the probe sequence, which
+ * eventually visits every slot.
+ */
+static int64_t upo_ordmap_find(const upo_ordmap_t map, const void *key, uint64_t hash, size_t *pos);
+
+/**
+ * \brief Rebuilds the given ordered map so that it can store the given number
+ *  of key-value pairs, dropping the entries of removed keys.
+ *
+ * \param map The ordered map.
+ * \param n The number of key-value pairs to store without resizing.
+ */
+static void upo_ordmap_resize(upo_ordmap_t map, size_t n);
+
+/**
+ * \brief Allocates an empty index and array of entries for the given ordered
+ *  map.
+ *
+ * \param map The ordered map.
+ * \param n The number of key-value pairs to store without resizing.
+ */
+static void upo_ordmap_alloc(upo_ordmap_t map, size_t n);
+
+
+#endif /* UPO_ORDMAP_PRIVATE_H */
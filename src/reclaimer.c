@@ -0,0 +1,175 @@
+/*
+ * Copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ * This file is part of UPOalglib.
+ *
+ * UPOalglib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * UPOalglib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include "reclaimer_private.h"
+
+
+/** \brief The reclaimer shared by all data structures. */
+static struct upo_reclaimer_s upo_reclaimer = {PTHREAD_MUTEX_INITIALIZER,
+                                               PTHREAD_COND_INITIALIZER,
+                                               PTHREAD_COND_INITIALIZER,
+                                               NULL,
+                                               NULL,
+                                               0,
+                                               UPO_RECLAIMER_DEFAULT_BATCH_SIZE,
+                                               0};
+
+
+void upo_reclaimer_submit(void *obj, upo_reclaimer_step_t step, int destroy_data)
+{
+    upo_reclaimer_job_t *job = NULL;
+    int queued = 0;
+
+    /* preconditions */
+    assert( step != NULL );
+
+    if (obj == NULL)
+        return;
+
+    job = malloc(sizeof(upo_reclaimer_job_t));
+    if (job != NULL)
+    {
+        job->obj = obj;
+        job->step = step;
+        job->destroy_data = destroy_data;
+        job->cursor = 0;
+        job->next = NULL;
+
+        pthread_mutex_lock(&upo_reclaimer.lock);
+        if (!upo_reclaimer.started)
+        {
+            pthread_t thread;
+
+            if (pthread_create(&thread, NULL, upo_reclaimer_run, NULL) == 0)
+            {
+                pthread_detach(thread);
+                upo_reclaimer.started = 1;
+            }
+        }
+        if (upo_reclaimer.started)
+        {
+            if (upo_reclaimer.tail != NULL)
+                upo_reclaimer.tail->next = job;
+            else
+                upo_reclaimer.head = job;
+            upo_reclaimer.tail = job;
+            upo_reclaimer.pending++;
+            queued = 1;
+            pthread_cond_signal(&upo_reclaimer.work);
+        }
+        pthread_mutex_unlock(&upo_reclaimer.lock);
+    }
+
+    if (!queued)
+    {
+        /* Without a reclaimer thread, free the data structure right away */
+        free(job);
+        upo_reclaimer_reclaim_now(obj, step, destroy_data);
+    }
+}
+
+void upo_reclaimer_drain(void)
+{
+    pthread_mutex_lock(&upo_reclaimer.lock);
+    while (upo_reclaimer.pending > 0)
+        pthread_cond_wait(&upo_reclaimer.idle, &upo_reclaimer.lock);
+    pthread_mutex_unlock(&upo_reclaimer.lock);
+}
+
+size_t upo_reclaimer_pending(void)
+{
+    size_t pending = 0;
+
+    pthread_mutex_lock(&upo_reclaimer.lock);
+    pending = upo_reclaimer.pending;
+    pthread_mutex_unlock(&upo_reclaimer.lock);
+
+    return pending;
+}
+
+void upo_reclaimer_set_batch_size(size_t n)
+{
+    /* preconditions */
+    assert( n > 0 );
+
+    pthread_mutex_lock(&upo_reclaimer.lock);
+    upo_reclaimer.batch = n;
+    pthread_mutex_unlock(&upo_reclaimer.lock);
+}
+
+void* upo_reclaimer_run(void *arg)
+{
+    (void) arg;
+
+    pthread_mutex_lock(&upo_reclaimer.lock);
+    for (;;)
+    {
+        upo_reclaimer_job_t *job = NULL;
+        size_t batch = 0;
+        int done = 0;
+
+        while (upo_reclaimer.head == NULL)
+            pthread_cond_wait(&upo_reclaimer.work, &upo_reclaimer.lock);
+
+        job = upo_reclaimer.head;
+        upo_reclaimer.head = job->next;
+        if (upo_reclaimer.head == NULL)
+            upo_reclaimer.tail = NULL;
+        job->next = NULL;
+        batch = upo_reclaimer.batch;
+
+        /* Run the step without holding the lock, so that submissions never
+         * wait for elements to be freed */
+        pthread_mutex_unlock(&upo_reclaimer.lock);
+        done = job->step(job->obj, job->destroy_data, &job->cursor, batch);
+        if (done)
+            free(job);
+        pthread_mutex_lock(&upo_reclaimer.lock);
+
+        if (done)
+        {
+            upo_reclaimer.pending--;
+            if (upo_reclaimer.pending == 0)
+                pthread_cond_broadcast(&upo_reclaimer.idle);
+        }
+        else
+        {
+            /* Let the other data structures make progress */
+            if (upo_reclaimer.tail != NULL)
+                upo_reclaimer.tail->next = job;
+            else
+                upo_reclaimer.head = job;
+            upo_reclaimer.tail = job;
+        }
+    }
+
+    return NULL;
+}
+
+void upo_reclaimer_reclaim_now(void *obj, upo_reclaimer_step_t step, int destroy_data)
+{
+    size_t cursor = 0;
+
+    while (!step(obj, destroy_data, &cursor, UPO_RECLAIMER_DEFAULT_BATCH_SIZE))
+        ;
+}
@@ -0,0 +1,80 @@
+/**
+ * \file src/reclaimer_private.h
+ *
+ * \brief Private header for the background reclaimer of data structures.
+ *
+ * \copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ *  This file is part of UPOalglib.
+ *
+ *  UPOalglib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  UPOalglib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UPO_RECLAIMER_PRIVATE_H
+#define UPO_RECLAIMER_PRIVATE_H
+
+
+#include <pthread.h>
+#include <upo/reclaimer.h>
+
+
+/** \brief Type for data structures waiting to be freed. */
+struct upo_reclaimer_job_s
+{
+    void *obj; /**< Pointer to the data structure to free. */
+    upo_reclaimer_step_t step; /**< The reclaim step function of the data structure. */
+    int destroy_data; /**< Tells whether the data stored in the data structure must be freed. */
+    size_t cursor; /**< The progress of the reclaim, updated by the step function. */
+    struct upo_reclaimer_job_s *next; /**< Pointer to the next job in the queue. */
+};
+/** \brief Alias for the type for data structures waiting to be freed. */
+typedef struct upo_reclaimer_job_s upo_reclaimer_job_t;
+
+/** \brief Type for the background reclaimer. */
+struct upo_reclaimer_s
+{
+    pthread_mutex_t lock; /**< The mutex protecting the queue. */
+    pthread_cond_t work; /**< Signaled when a job is queued. */
+    pthread_cond_t idle; /**< Signaled when the last pending job is done. */
+    upo_reclaimer_job_t *head; /**< The first job of the queue, or `NULL`. */
+    upo_reclaimer_job_t *tail; /**< The last job of the queue, or `NULL`. */
+    size_t pending; /**< The number of jobs not yet done, including the running one. */
+    size_t batch; /**< The maximum number of elements freed by each step. */
+    int started; /**< Tells whether the reclaimer thread has been started. */
+};
+
+
+/**
+ * \brief The body of the reclaimer thread.
+ *
+ * \param arg Unused.
+ * \return Never returns.
+ *
+ * Runs one step of the job at the head of the queue at a time, with the queue
+ * unlocked, and moves the job to the tail of the queue if it is not done.
+ */
+static void* upo_reclaimer_run(void *arg);
+
+/**
+ * \brief Frees the given data structure on the calling thread.
+ *
+ * \param obj The data structure to free.
+ * \param step The reclaim step function of the data structure.
+ * \param destroy_data Tells whether the data stored in the data structure
+ *  must be freed.
+ */
+static void upo_reclaimer_reclaim_now(void *obj, upo_reclaimer_step_t step, int destroy_data);
+
+
+#endif /* UPO_RECLAIMER_PRIVATE_H */
@@ -0,0 +1,654 @@
+/*
+ * Copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ * This file is part of UPOalglib.
+ *
+ * UPOalglib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * UPOalglib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Needed for ftruncate() and robust process-shared mutexes */
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <upo/error.h>
+#include "shmht_private.h"
+
+
+#if ATOMIC_LLONG_LOCK_FREE != 2
+# error "Shared-memory hash tables need lock-free 64-bit atomics"
+#endif
+
+
+/*** BEGIN of FUNDAMENTAL OPERATIONS ***/
+
+
+upo_shmht_t upo_shmht_create(const char *name, size_t capacity, size_t heap_size)
+{
+    upo_shmht_t ht = NULL;
+    pthread_mutexattr_t attr;
+    size_t m = 2;
+    size_t length = 0;
+    void *base = NULL;
+    int fd = -1;
+
+    /* preconditions */
+    assert( name != NULL );
+    assert( capacity > 0 );
+
+    while (m < capacity)
+        m *= 2;
+    heap_size = (heap_size + UPO_SHMHT_ALIGN - 1) / UPO_SHMHT_ALIGN * UPO_SHMHT_ALIGN;
+    length = upo_shmht_header_length() + m*sizeof(upo_shmht_slot_t) + heap_size;
+
+    fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+    {
+        if (errno == EEXIST)
+            return NULL;
+        upo_throw_sys_error("Unable to create the shared memory object of the Shared-Memory Hash Table");
+    }
+
+    /* Note: the new object is filled with zeros, so all slots are empty */
+    if (ftruncate(fd, (off_t) length) != 0)
+    {
+        upo_throw_sys_error("Unable to size the shared memory object of the Shared-Memory Hash Table");
+    }
+
+    base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED)
+    {
+        upo_throw_sys_error("Unable to map the shared memory object of the Shared-Memory Hash Table");
+    }
+    close(fd);
+
+    ht = malloc(sizeof(struct upo_shmht_s));
+    if (ht == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for Shared-Memory Hash Table");
+    }
+    ((upo_shmht_header_t*) base)->capacity = m;
+    upo_shmht_attach(ht, base, length);
+
+    ht->header->heap_size = heap_size;
+    ht->header->tombstones = 0;
+    atomic_init(&ht->header->heap_used, 0);
+    atomic_init(&ht->header->size, 0);
+    atomic_init(&ht->header->seq, 0);
+    atomic_init(&ht->header->move_from, 0);
+    atomic_init(&ht->header->move_to, 0);
+
+    if (pthread_mutexattr_init(&attr) != 0
+        || pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED) != 0
+        || pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST) != 0
+        || pthread_mutex_init(&ht->header->lock, &attr) != 0)
+    {
+        upo_throw_error("Unable to initialize the lock of the Shared-Memory Hash Table");
+    }
+    pthread_mutexattr_destroy(&attr);
+
+    /* Let other processes open the table only once it is complete */
+    atomic_store_explicit(&ht->header->magic, UPO_SHMHT_MAGIC, memory_order_release);
+
+    return ht;
+}
+
+upo_shmht_t upo_shmht_open(const char *name)
+{
+    upo_shmht_t ht = NULL;
+    struct stat st;
+    upo_shmht_header_t *header = NULL;
+    void *base = NULL;
+    size_t length = 0;
+    int fd = -1;
+
+    /* preconditions */
+    assert( name != NULL );
+
+    fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0)
+        return NULL;
+
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < upo_shmht_header_length())
+    {
+        close(fd);
+        return NULL;
+    }
+    length = (size_t) st.st_size;
+
+    base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        upo_throw_sys_error("Unable to map the shared memory object of the Shared-Memory Hash Table");
+    }
+
+    header = base;
+    if (atomic_load_explicit(&header->magic, memory_order_acquire) != UPO_SHMHT_MAGIC
+        || length != upo_shmht_header_length() + header->capacity*sizeof(upo_shmht_slot_t) + header->heap_size)
+    {
+        munmap(base, length);
+        return NULL;
+    }
+
+    ht = malloc(sizeof(struct upo_shmht_s));
+    if (ht == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for Shared-Memory Hash Table");
+    }
+    upo_shmht_attach(ht, base, length);
+
+    return ht;
+}
+
+void upo_shmht_close(upo_shmht_t ht)
+{
+    if (ht != NULL)
+    {
+        munmap(ht->header, ht->length);
+        free(ht);
+    }
+}
+
+int upo_shmht_unlink(const char *name)
+{
+    /* preconditions */
+    assert( name != NULL );
+
+    return shm_unlink(name) == 0;
+}
+
+int upo_shmht_put(upo_shmht_t ht, const void *key, size_t key_size, const void *value, size_t value_size)
+{
+    upo_shmht_header_t *header = NULL;
+    uint64_t hash = 0;
+    uint64_t key_offset = 0;
+    uint64_t value_offset = 0;
+    size_t pos = 0;
+    int found = 0;
+    int stored = 0;
+
+    /* preconditions */
+    assert( ht != NULL );
+    assert( key != NULL || key_size == 0 );
+    assert( value != NULL || value_size == 0 );
+
+    header = ht->header;
+    hash = upo_shmht_hash(key, key_size);
+
+    upo_shmht_lock(ht);
+
+    found = upo_shmht_find(ht, key, key_size, hash, &pos);
+    if (!found && !upo_shmht_has_room(ht, pos) && header->tombstones > 0)
+    {
+        upo_shmht_purge(ht);
+        upo_shmht_find(ht, key, key_size, hash, &pos);
+    }
+    if ((!found && !upo_shmht_has_room(ht, pos)) || !upo_shmht_heap_has_room(ht, key_size, value_size, !found))
+    {
+        pthread_mutex_unlock(&header->lock);
+        return 0;
+    }
+
+    /* Records are written before being linked, so readers never see them
+     * incomplete */
+    if ((found || upo_shmht_alloc(ht, key, key_size, &key_offset))
+        && upo_shmht_alloc(ht, value, value_size, &value_offset))
+    {
+        upo_shmht_write_begin(ht);
+        if (!found)
+        {
+            if (atomic_load_explicit(&ht->slots[pos].key, memory_order_relaxed) == UPO_SHMHT_DELETED)
+                header->tombstones--;
+            atomic_store_explicit(&ht->slots[pos].hash, hash, memory_order_relaxed);
+            atomic_store_explicit(&ht->slots[pos].value, value_offset, memory_order_relaxed);
+            atomic_store_explicit(&ht->slots[pos].key, key_offset + 1, memory_order_relaxed);
+            atomic_fetch_add_explicit(&header->size, 1, memory_order_relaxed);
+        }
+        else
+        {
+            atomic_store_explicit(&ht->slots[pos].value, value_offset, memory_order_relaxed);
+        }
+        upo_shmht_write_end(ht);
+        stored = 1;
+    }
+
+    pthread_mutex_unlock(&header->lock);
+
+    return stored;
+}
+
+int upo_shmht_get(const upo_shmht_t ht, const void *key, size_t key_size, void *value, size_t *value_size)
+{
+    uint64_t hash = 0;
+    uint64_t seq = 0;
+    size_t size = 0;
+    size_t spins = 0;
+    int found = 0;
+
+    /* preconditions */
+    assert( key != NULL || key_size == 0 );
+    assert( value == NULL || value_size != NULL );
+
+    if (ht == NULL)
+        return 0;
+
+    hash = upo_shmht_hash(key, key_size);
+
+    do
+    {
+        size_t pos = 0;
+
+        seq = atomic_load_explicit(&ht->header->seq, memory_order_acquire);
+        if (seq % 2 != 0) // Being written
+        {
+            if (++spins % UPO_SHMHT_READ_SPINS == 0)
+                upo_shmht_read_wait(ht);
+            continue;
+        }
+
+        found = upo_shmht_find(ht, key, key_size, hash, &pos);
+        if (found)
+        {
+            uint64_t offset = atomic_load_explicit(&ht->slots[pos].value, memory_order_relaxed);
+            uint64_t record_size = 0;
+
+            if (offset <= ht->header->heap_size - sizeof record_size)
+            {
+                memcpy(&record_size, ht->heap + offset, sizeof record_size);
+                if (record_size <= ht->header->heap_size - offset - sizeof record_size)
+                {
+                    size = (size_t) record_size;
+                    if (value != NULL)
+                        memcpy(value, ht->heap + offset + sizeof record_size, (size < *value_size) ? size : *value_size);
+                }
+            }
+        }
+
+        atomic_thread_fence(memory_order_acquire);
+    }
+    while (seq % 2 != 0 || atomic_load_explicit(&ht->header->seq, memory_order_relaxed) != seq); // Changed while reading
+
+    if (found && value_size != NULL)
+        *value_size = size;
+
+    return found;
+}
+
+int upo_shmht_contains(const upo_shmht_t ht, const void *key, size_t key_size)
+{
+    return upo_shmht_get(ht, key, key_size, NULL, NULL);
+}
+
+int upo_shmht_delete(upo_shmht_t ht, const void *key, size_t key_size)
+{
+    uint64_t hash = 0;
+    size_t pos = 0;
+    int found = 0;
+
+    /* preconditions */
+    assert( key != NULL || key_size == 0 );
+
+    if (ht == NULL)
+        return 0;
+
+    hash = upo_shmht_hash(key, key_size);
+
+    upo_shmht_lock(ht);
+
+    found = upo_shmht_find(ht, key, key_size, hash, &pos);
+    if (found)
+    {
+        upo_shmht_write_begin(ht);
+        atomic_store_explicit(&ht->slots[pos].key, UPO_SHMHT_DELETED, memory_order_relaxed);
+        atomic_fetch_sub_explicit(&ht->header->size, 1, memory_order_relaxed);
+        ht->header->tombstones++;
+        upo_shmht_write_end(ht);
+    }
+
+    pthread_mutex_unlock(&ht->header->lock);
+
+    return found;
+}
+
+
+size_t upo_shmht_header_length(void)
+{
+    return (sizeof(upo_shmht_header_t) + UPO_SHMHT_ALIGN - 1) / UPO_SHMHT_ALIGN * UPO_SHMHT_ALIGN;
+}
+
+void upo_shmht_attach(upo_shmht_t ht, void *base, size_t length)
+{
+    ht->header = base;
+    ht->slots = (upo_shmht_slot_t*) ((unsigned char*) base + upo_shmht_header_length());
+    ht->heap = (unsigned char*) (ht->slots + ht->header->capacity);
+    ht->length = length;
+}
+
+uint64_t upo_shmht_hash(const void *key, size_t key_size)
+{
+    const unsigned char *bytes = key;
+    uint64_t h = UINT64_C(14695981039346656037);
+    size_t i = 0;
+
+    for (i = 0; i < key_size; ++i)
+    {
+        h ^= bytes[i];
+        h *= UINT64_C(1099511628211);
+    }
+
+    return h;
+}
+
+int upo_shmht_record_equals(const upo_shmht_t ht, uint64_t offset, const void *key, size_t key_size)
+{
+    uint64_t size = 0;
+
+    if (offset > ht->header->heap_size - sizeof size)
+        return 0;
+
+    memcpy(&size, ht->heap + offset, sizeof size);
+
+    return size == key_size
+           && size <= ht->header->heap_size - offset - sizeof size
+           && memcmp(ht->heap + offset + sizeof size, key, key_size) == 0;
+}
+
+int upo_shmht_find(const upo_shmht_t ht, const void *key, size_t key_size, uint64_t hash, size_t *pos)
+{
+    size_t m = (size_t) ht->header->capacity;
+    size_t h = (size_t) (hash & (m - 1));
+    size_t free_pos = m; // First deleted slot
+    size_t i = 0;
+
+    for (i = 0; i < m; ++i, h = (h + 1) & (m - 1))
+    {
+        uint64_t k = atomic_load_explicit(&ht->slots[h].key, memory_order_relaxed);
+
+        if (k == UPO_SHMHT_EMPTY)
+        {
+            *pos = (free_pos < m) ? free_pos : h;
+            return 0;
+        }
+
+        if (k == UPO_SHMHT_DELETED)
+        {
+            if (free_pos == m)
+                free_pos = h;
+        }
+        else if (atomic_load_explicit(&ht->slots[h].hash, memory_order_relaxed) == hash
+                 && upo_shmht_record_equals(ht, k - 1, key, key_size))
+        {
+            *pos = h;
+            return 1;
+        }
+    }
+
+    *pos = free_pos;
+
+    return 0;
+}
+
+int upo_shmht_has_room(const upo_shmht_t ht, size_t pos)
+{
+    const upo_shmht_header_t *header = ht->header;
+
+    if (pos == header->capacity)
+        return 0;
+
+    /* Keep at least one empty slot, so that probe sequences end */
+    return atomic_load_explicit(&ht->slots[pos].key, memory_order_relaxed) == UPO_SHMHT_DELETED
+           || atomic_load_explicit(&header->size, memory_order_relaxed) + header->tombstones + 2 <= header->capacity;
+}
+
+void upo_shmht_purge(upo_shmht_t ht)
+{
+    size_t m = (size_t) ht->header->capacity;
+    size_t i = 0;
+    int purged = 0;
+
+    upo_shmht_write_begin(ht);
+
+    /* A move may leave a hole behind the scan when it wraps around */
+    do
+    {
+        purged = 0;
+        for (i = 0; i < m; ++i)
+        {
+            if (atomic_load_explicit(&ht->slots[i].key, memory_order_relaxed) == UPO_SHMHT_DELETED)
+            {
+                upo_shmht_purge_hole(ht, i);
+                purged = 1;
+            }
+        }
+    }
+    while (purged);
+    ht->header->tombstones = 0;
+
+    upo_shmht_write_end(ht);
+}
+
+void upo_shmht_purge_hole(upo_shmht_t ht, size_t pos)
+{
+    upo_shmht_header_t *header = ht->header;
+    size_t m = (size_t) header->capacity;
+    size_t j = pos;
+
+    /* Note: the table always keeps an empty slot, so the scan ends */
+    for (j = (j + 1) & (m - 1); ; j = (j + 1) & (m - 1))
+    {
+        uint64_t k = atomic_load_explicit(&ht->slots[j].key, memory_order_relaxed);
+        size_t home = 0;
+
+        if (k == UPO_SHMHT_EMPTY)
+            break;
+        if (k == UPO_SHMHT_DELETED)
+            continue;
+
+        /* Move the key back if its probe sequence passes the hole */
+        home = (size_t) (atomic_load_explicit(&ht->slots[j].hash, memory_order_relaxed) & (m - 1));
+        if (((j - home) & (m - 1)) >= ((j - pos) & (m - 1)))
+        {
+            atomic_store_explicit(&header->move_to, pos, memory_order_relaxed);
+            atomic_store_explicit(&header->move_from, j + 1, memory_order_release);
+            atomic_store_explicit(&ht->slots[pos].hash, atomic_load_explicit(&ht->slots[j].hash, memory_order_relaxed), memory_order_relaxed);
+            atomic_store_explicit(&ht->slots[pos].value, atomic_load_explicit(&ht->slots[j].value, memory_order_relaxed), memory_order_relaxed);
+            atomic_store_explicit(&ht->slots[pos].key, k, memory_order_release);
+            atomic_store_explicit(&ht->slots[j].key, UPO_SHMHT_DELETED, memory_order_release);
+            atomic_store_explicit(&header->move_from, 0, memory_order_release);
+            pos = j;
+        }
+    }
+
+    atomic_store_explicit(&ht->slots[pos].key, UPO_SHMHT_EMPTY, memory_order_release);
+}
+
+int upo_shmht_heap_has_room(const upo_shmht_t ht, size_t key_size, size_t value_size, int with_key)
+{
+    const upo_shmht_header_t *header = ht->header;
+    uint64_t used = atomic_load_explicit(&header->heap_used, memory_order_relaxed);
+    uint64_t length = 0;
+
+    if (key_size > header->heap_size || value_size > header->heap_size)
+        return 0;
+
+    length = upo_shmht_record_length(value_size);
+    if (with_key)
+        length += upo_shmht_record_length(key_size);
+
+    return length <= header->heap_size - used;
+}
+
+uint64_t upo_shmht_record_length(uint64_t size)
+{
+    return sizeof size + (size + UPO_SHMHT_ALIGN - 1) / UPO_SHMHT_ALIGN * UPO_SHMHT_ALIGN;
+}
+
+int upo_shmht_alloc(upo_shmht_t ht, const void *data, size_t size, uint64_t *offset)
+{
+    upo_shmht_header_t *header = ht->header;
+    uint64_t used = atomic_load_explicit(&header->heap_used, memory_order_relaxed);
+    uint64_t record_size = size;
+    uint64_t length = 0;
+
+    if (record_size > header->heap_size)
+        return 0;
+
+    length = upo_shmht_record_length(record_size);
+    if (length > header->heap_size - used)
+        return 0;
+
+    memcpy(ht->heap + used, &record_size, sizeof record_size);
+    if (size > 0)
+        memcpy(ht->heap + used + sizeof record_size, data, size);
+
+    *offset = used;
+    atomic_store_explicit(&header->heap_used, used + length, memory_order_relaxed);
+
+    return 1;
+}
+
+void upo_shmht_lock(upo_shmht_t ht)
+{
+    int rc = pthread_mutex_lock(&ht->header->lock);
+
+    if (rc == EOWNERDEAD)
+    {
+        upo_shmht_recover(ht);
+        pthread_mutex_consistent(&ht->header->lock);
+    }
+    else if (rc != 0)
+    {
+        errno = rc;
+        upo_throw_sys_error("Unable to lock the Shared-Memory Hash Table");
+    }
+}
+
+void upo_shmht_recover(upo_shmht_t ht)
+{
+    upo_shmht_header_t *header = ht->header;
+    uint64_t from = atomic_load_explicit(&header->move_from, memory_order_relaxed);
+    uint64_t seq = atomic_load_explicit(&header->seq, memory_order_relaxed);
+    uint64_t size = 0;
+    uint64_t tombstones = 0;
+    size_t m = (size_t) header->capacity;
+    size_t i = 0;
+
+    if (from != 0)
+    {
+        uint64_t to = atomic_load_explicit(&header->move_to, memory_order_relaxed);
+        uint64_t k = atomic_load_explicit(&ht->slots[from-1].key, memory_order_relaxed);
+
+        /* The copy has been linked: finish the move */
+        if (k == atomic_load_explicit(&ht->slots[to].key, memory_order_relaxed))
+        {
+            atomic_store_explicit(&ht->slots[from-1].key, UPO_SHMHT_DELETED, memory_order_relaxed);
+        }
+        atomic_store_explicit(&header->move_from, 0, memory_order_relaxed);
+    }
+
+    /* The dead writer may have linked or deleted a key without updating the
+     * counters */
+    for (i = 0; i < m; ++i)
+    {
+        uint64_t k = atomic_load_explicit(&ht->slots[i].key, memory_order_relaxed);
+
+        if (k == UPO_SHMHT_DELETED)
+            ++tombstones;
+        else if (k != UPO_SHMHT_EMPTY)
+            ++size;
+    }
+    atomic_store_explicit(&header->size, size, memory_order_relaxed);
+    header->tombstones = tombstones;
+
+    if (seq % 2 != 0)
+        atomic_store_explicit(&header->seq, seq + 1, memory_order_release);
+}
+
+void upo_shmht_read_wait(upo_shmht_t ht)
+{
+    int rc = pthread_mutex_trylock(&ht->header->lock);
+
+    if (rc == EBUSY) // The writer is alive
+    {
+        sched_yield();
+        return;
+    }
+
+    if (rc == EOWNERDEAD)
+    {
+        upo_shmht_recover(ht);
+        pthread_mutex_consistent(&ht->header->lock);
+    }
+    else if (rc != 0)
+    {
+        errno = rc;
+        upo_throw_sys_error("Unable to lock the Shared-Memory Hash Table");
+    }
+
+    pthread_mutex_unlock(&ht->header->lock);
+}
+
+void upo_shmht_write_begin(upo_shmht_t ht)
+{
+    uint64_t seq = atomic_load_explicit(&ht->header->seq, memory_order_relaxed);
+
+    atomic_store_explicit(&ht->header->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+void upo_shmht_write_end(upo_shmht_t ht)
+{
+    uint64_t seq = atomic_load_explicit(&ht->header->seq, memory_order_relaxed);
+
+    atomic_store_explicit(&ht->header->seq, seq + 1, memory_order_release);
+}
+
+
+/*** END of FUNDAMENTAL OPERATIONS ***/
+
+
+/*** BEGIN of EXTRA OPERATIONS ***/
+
+
+size_t upo_shmht_size(const upo_shmht_t ht)
+{
+    return (ht != NULL) ? (size_t) atomic_load_explicit(&ht->header->size, memory_order_relaxed) : 0;
+}
+
+int upo_shmht_is_empty(const upo_shmht_t ht)
+{
+    return upo_shmht_size(ht) == 0;
+}
+
+size_t upo_shmht_capacity(const upo_shmht_t ht)
+{
+    return (ht != NULL) ? (size_t) ht->header->capacity : 0;
+}
+
+size_t upo_shmht_heap_used(const upo_shmht_t ht)
+{
+    return (ht != NULL) ? (size_t) atomic_load_explicit(&ht->header->heap_used, memory_order_relaxed) : 0;
+}
+
+
+/*** END of EXTRA OPERATIONS ***/
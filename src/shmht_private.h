@@ -0,0 +1,273 @@
+/**
+ * \file src/shmht_private.h
+ *
+ * \brief Private header for the Shared-Memory Hash Table abstract data type.
+ *
+ * \copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ *  This file is part of UPOalglib.
+ *
+ *  UPOalglib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  UPOalglib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UPO_SHMHT_PRIVATE_H
+#define UPO_SHMHT_PRIVATE_H
+
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <upo/shmht.h>
+
+
+/** \brief Value identifying shared memory objects holding a hash table. */
+#define UPO_SHMHT_MAGIC UINT64_C(0x55504f53484d4854)
+
+/** \brief Value of the key offset of slots that have never been used. */
+#define UPO_SHMHT_EMPTY UINT64_C(0)
+
+/** \brief Value of the key offset of slots whose key has been removed. */
+#define UPO_SHMHT_DELETED UINT64_MAX
+
+/** \brief Alignment (in bytes) of the parts of the table and of heap records. */
+#define UPO_SHMHT_ALIGN 8U
+
+/** \brief Number of times a reader retries while the table is being written before checking the writer is alive. */
+#define UPO_SHMHT_READ_SPINS 1024U
+
+
+/** \brief Type for the header at the beginning of shared-memory hash tables. */
+struct upo_shmht_header_s
+{
+    _Atomic uint64_t magic; /**< UPO_SHMHT_MAGIC, once the table has been completely created. */
+    uint64_t capacity; /**< The number of slots (a power of two). */
+    uint64_t heap_size; /**< The number of bytes of the heap. */
+    _Atomic uint64_t heap_used; /**< The number of bytes of the heap used so far (only updated with the lock held). */
+    uint64_t tombstones; /**< The number of slots marked as deleted (only accessed with the lock held). */
+    _Atomic uint64_t size; /**< The number of stored key-value pairs. */
+    _Atomic uint64_t seq; /**< The sequence number of the table, which is odd while a writer updates slots. */
+    _Atomic uint64_t move_from; /**< The slot being moved back by a purge plus one, or `0` if no slot is being moved. */
+    _Atomic uint64_t move_to; /**< The hole the slot being moved back by a purge is copied to. */
+    pthread_mutex_t lock; /**< The process-shared lock serializing writers. */
+};
+/** \brief Alias for the type for the header of shared-memory hash tables. */
+typedef struct upo_shmht_header_s upo_shmht_header_t;
+
+/** \brief Type for slots of shared-memory hash tables. */
+struct upo_shmht_slot_s
+{
+    _Atomic uint64_t hash; /**< The hash value of the key. */
+    _Atomic uint64_t key; /**< The offset of the key record in the heap plus one, or UPO_SHMHT_EMPTY or UPO_SHMHT_DELETED. */
+    _Atomic uint64_t value; /**< The offset of the value record in the heap. */
+};
+/** \brief Alias for the type for slots of shared-memory hash tables. */
+typedef struct upo_shmht_slot_s upo_shmht_slot_t;
+
+/**
+ * \brief Type for shared-memory hash tables, as mapped by a process.
+ *
+ * Heap records are made of the size of the data (as a 64-bit integer)
+ * followed by the bytes of the data.
+ */
+struct upo_shmht_s
+{
+    upo_shmht_header_t *header; /**< The header, at the beginning of the mapping. */
+    upo_shmht_slot_t *slots; /**< The array of slots, following the header. */
+    unsigned char *heap; /**< The heap of key and value records, following the slots. */
+    size_t length; /**< The number of bytes of the mapping. */
+};
+
+
+/**
+ * \brief Returns the number of bytes of the header, rounded up to the
+ *  alignment of the table.
+ *
+ * \return The number of bytes before the array of slots.
+ */
+static size_t upo_shmht_header_length(void);
+
+/**
+ * \brief Makes the pointers of the given handle point into the given mapping.
+ *
+ * \param ht The handle.
+ * \param base The beginning of the mapping, whose header holds the capacity.
+ * \param length The number of bytes of the mapping.
+ */
+static void upo_shmht_attach(upo_shmht_t ht, void *base, size_t length);
+
+/**
+ * \brief Hashes the given bytes by means of the 64-bit FNV-1a function.
+ *
+ * \param key The bytes.
+ * \param key_size The number of bytes.
+ * \return The hash value.
+ */
+static uint64_t upo_shmht_hash(const void *key, size_t key_size);
+
+/**
+ * \brief Tells if the heap record at the given offset holds the given bytes.
+ *
+ * \param ht The hash table.
+ * \param offset The offset of the record.
+ * \param key The bytes.
+ * \param key_size The number of bytes.
+ * \return `1` if the record holds the same bytes, or `0` otherwise
+ *  (including when the offset is out of the heap, as a reader racing with a
+ *  writer may see).
+ */
+static int upo_shmht_record_equals(const upo_shmht_t ht, uint64_t offset, const void *key, size_t key_size);
+
+/**
+ * \brief Searches for the given key.
+ *
+ * \param ht The hash table.
+ * \param key The bytes of the key.
+ * \param key_size The number of bytes of the key.
+ * \param hash The hash value of the key.
+ * \param pos Set to the slot of the key if found, or otherwise to the first
+ *  deleted or empty slot of its probe sequence (or to the capacity if there
+ *  is none).
+ * \return `1` if the key is found, or `0` otherwise.
+ *
+ * At most `capacity` slots are probed, so that the search ends even if a
+ * reader sees the slots while a writer updates them.
+ */
+static int upo_shmht_find(const upo_shmht_t ht, const void *key, size_t key_size, uint64_t hash, size_t *pos);
+
+/**
+ * \brief Tells if a new key can be stored in the given slot.
+ *
+ * \param ht The hash table, whose lock must be held.
+ * \param pos The slot found by upo_shmht_find() for the key.
+ * \return `1` if the slot is deleted, or if it is empty and storing the key
+ *  would leave another empty slot; `0` otherwise.
+ */
+static int upo_shmht_has_room(const upo_shmht_t ht, size_t pos);
+
+/**
+ * \brief Removes all deleted slots, moving live slots back along their probe
+ *  sequences.
+ *
+ * \param ht The hash table, whose lock must be held.
+ *
+ * The slots are rebuilt in place, one move at a time, so that every key stays
+ * reachable even if the writer dies in the middle of the purge.
+ * Readers retry their lookups while the slots are rebuilt.
+ */
+static void upo_shmht_purge(upo_shmht_t ht);
+
+/**
+ * \brief Turns the given deleted slot into an empty one.
+ *
+ * \param ht The hash table, whose lock must be held.
+ * \param pos The deleted slot.
+ *
+ * The slots following the hole up to the first empty one are scanned, and
+ * each live slot whose probe sequence passes the hole is moved back into it,
+ * leaving a new hole behind (as in backward-shift deletion); the last hole
+ * is made empty.
+ * Each move is recorded in the header and copies the slot before deleting
+ * the original, so a key is never missing: at worst it is found twice, and
+ * upo_shmht_recover() deletes the original.
+ */
+static void upo_shmht_purge_hole(upo_shmht_t ht, size_t pos);
+
+/**
+ * \brief Tells if the records of a key-value pair fit in the rest of the heap.
+ *
+ * \param ht The hash table, whose lock must be held.
+ * \param key_size The number of bytes of the key.
+ * \param value_size The number of bytes of the value.
+ * \param with_key Tells whether a record is needed for the key (value `1`),
+ *  or only for the value (value `0`).
+ * \return `1` if all the needed records fit, or `0` otherwise.
+ *
+ * Since the heap is only appended to, a pair is stored only if all of its
+ * records fit, so that a failed store takes no space.
+ */
+static int upo_shmht_heap_has_room(const upo_shmht_t ht, size_t key_size, size_t value_size, int with_key);
+
+/**
+ * \brief Returns the number of bytes of the heap taken by a record.
+ *
+ * \param size The number of bytes of the data, at most the size of the heap.
+ * \return The size of the record, including its size field and padding.
+ */
+static uint64_t upo_shmht_record_length(uint64_t size);
+
+/**
+ * \brief Appends a record with the given bytes to the heap.
+ *
+ * \param ht The hash table, whose lock must be held.
+ * \param data The bytes.
+ * \param size The number of bytes.
+ * \param offset Set to the offset of the new record.
+ * \return `1` if the record has been appended, or `0` if the heap is full.
+ */
+static int upo_shmht_alloc(upo_shmht_t ht, const void *data, size_t size, uint64_t *offset);
+
+/**
+ * \brief Acquires the lock of the given hash table.
+ *
+ * \param ht The hash table.
+ *
+ * If the previous owner died while holding the lock, the table is repaired
+ * by means of upo_shmht_recover() and the lock is made consistent again.
+ */
+static void upo_shmht_lock(upo_shmht_t ht);
+
+/**
+ * \brief Repairs the given hash table after a writer died while holding its
+ *  lock.
+ *
+ * \param ht The hash table, whose lock must be held.
+ *
+ * The slots written by the dead writer only hold complete records, except
+ * for a key copied by an interrupted move of upo_shmht_purge_hole(): if the
+ * copy has been linked, the original slot is deleted.
+ * The number of stored pairs and of deleted slots are then counted again from
+ * the slots, since the dead writer may have updated a slot but not the
+ * counters, and the sequence number is made even.
+ */
+static void upo_shmht_recover(upo_shmht_t ht);
+
+/**
+ * \brief Lets a reader wait for the writer updating the given hash table.
+ *
+ * \param ht The hash table, whose sequence number has been found odd many
+ *  times in a row.
+ *
+ * The lock is tried without blocking: if a writer holds it, the processor is
+ * yielded to it; if the writer died while holding it (so that the sequence
+ * number would stay odd forever), the table is repaired by means of
+ * upo_shmht_recover() and the lock is released again.
+ */
+static void upo_shmht_read_wait(upo_shmht_t ht);
+
+/**
+ * \brief Begins an update of the slots, making the sequence number odd.
+ *
+ * \param ht The hash table, whose lock must be held.
+ */
+static void upo_shmht_write_begin(upo_shmht_t ht);
+
+/**
+ * \brief Ends an update of the slots, making the sequence number even.
+ *
+ * \param ht The hash table, whose lock must be held.
+ */
+static void upo_shmht_write_end(upo_shmht_t ht);
+
+
+#endif /* UPO_SHMHT_PRIVATE_H */
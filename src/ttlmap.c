@@ -0,0 +1,521 @@
+/*
+ * Copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ * This file is part of UPOalglib.
+ *
+ * UPOalglib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * UPOalglib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include <upo/error.h>
+#include "ttlmap_private.h"
+
+
+/*** BEGIN of FUNDAMENTAL OPERATIONS ***/
+
+
+upo_ttlmap_t upo_ttlmap_create(size_t m, upo_ht_hasher_t key_hash, upo_ht_comparator_t key_cmp)
+{
+    upo_ttlmap_t map = NULL;
+    size_t i = 0;
+    size_t l = 0;
+
+    /* preconditions */
+    assert( key_hash != NULL );
+    assert( key_cmp != NULL );
+
+    map = malloc(sizeof(struct upo_ttlmap_s));
+    if (map == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for TTL Map");
+    }
+
+    map->num_slots = 1;
+    while (map->num_slots < m)
+    {
+        map->num_slots <<= 1;
+    }
+
+    map->slots = malloc(map->num_slots*sizeof(upo_ttlmap_node_t*));
+    if (map->slots == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for slots of the TTL Map");
+    }
+
+    for (i = 0; i < map->num_slots; ++i)
+    {
+        map->slots[i] = NULL;
+    }
+    for (l = 0; l < UPO_TTLMAP_LEVELS; ++l)
+    {
+        for (i = 0; i < UPO_TTLMAP_WHEEL_SIZE; ++i)
+        {
+            map->wheel[l][i] = NULL;
+        }
+    }
+
+    map->size = 0;
+    map->scheduled = 0;
+    map->now = 0;
+    map->key_hash = key_hash;
+    map->key_cmp = key_cmp;
+    map->expire = NULL;
+    map->expire_arg = NULL;
+
+    return map;
+}
+
+void upo_ttlmap_destroy(upo_ttlmap_t map, int destroy_data)
+{
+    if (map != NULL)
+    {
+        upo_ttlmap_clear(map, destroy_data);
+        free(map->slots);
+        free(map);
+    }
+}
+
+void upo_ttlmap_clear(upo_ttlmap_t map, int destroy_data)
+{
+    size_t i = 0;
+    size_t l = 0;
+
+    if (map == NULL)
+        return;
+
+    for (i = 0; i < map->num_slots; ++i)
+    {
+        upo_ttlmap_node_t *node = map->slots[i];
+
+        while (node != NULL)
+        {
+            upo_ttlmap_node_t *next = node->next;
+
+            if (destroy_data)
+            {
+                free(node->key);
+                free(node->value);
+            }
+            free(node);
+            node = next;
+        }
+        map->slots[i] = NULL;
+    }
+    for (l = 0; l < UPO_TTLMAP_LEVELS; ++l)
+    {
+        for (i = 0; i < UPO_TTLMAP_WHEEL_SIZE; ++i)
+        {
+            map->wheel[l][i] = NULL;
+        }
+    }
+
+    map->size = 0;
+    map->scheduled = 0;
+}
+
+void* upo_ttlmap_put(upo_ttlmap_t map, void *key, void *value, uint64_t ttl)
+{
+    uint64_t hash = 0;
+    upo_ttlmap_node_t **link = NULL;
+    upo_ttlmap_node_t *node = NULL;
+    void *old_value = NULL;
+
+    /* preconditions */
+    assert( map != NULL );
+
+    hash = upo_ht_hash_wide(map->key_hash, key);
+    link = upo_ttlmap_find(map, key, hash);
+
+    if (*link != NULL) // Change the value and put the old one in old_value
+    {
+        node = *link;
+        old_value = node->value;
+        node->value = value;
+        upo_ttlmap_set_expiry(map, node, ttl);
+    }
+    else
+    {
+        node = malloc(sizeof(struct upo_ttlmap_node_s));
+        if (node == NULL)
+        {
+            upo_throw_sys_error("Unable to allocate memory for a new node of the TTL Map");
+        }
+
+        node->key = key;
+        node->value = value;
+        node->hash = hash;
+        node->expires = UPO_TTLMAP_NO_TTL;
+        node->timer_next = NULL;
+        node->timer_link = NULL;
+        node->next = *link;
+        *link = node;
+        map->size++;
+
+        upo_ttlmap_set_expiry(map, node, ttl);
+
+        if (map->size > map->num_slots)
+            upo_ttlmap_grow(map);
+    }
+
+    return old_value;
+}
+
+void* upo_ttlmap_get(const upo_ttlmap_t map, const void *key)
+{
+    upo_ttlmap_node_t *node = NULL;
+
+    if (map == NULL)
+        return NULL;
+
+    node = *upo_ttlmap_find(map, key, upo_ht_hash_wide(map->key_hash, key));
+
+    return (node != NULL) ? node->value : NULL;
+}
+
+int upo_ttlmap_contains(const upo_ttlmap_t map, const void *key)
+{
+    if (map == NULL)
+        return 0;
+
+    return *upo_ttlmap_find(map, key, upo_ht_hash_wide(map->key_hash, key)) != NULL;
+}
+
+void upo_ttlmap_delete(upo_ttlmap_t map, const void *key, int destroy_data)
+{
+    upo_ttlmap_node_t **link = NULL;
+
+    if (map == NULL)
+        return;
+
+    link = upo_ttlmap_find(map, key, upo_ht_hash_wide(map->key_hash, key));
+    if (*link != NULL)
+        upo_ttlmap_remove(map, link, destroy_data);
+}
+
+int upo_ttlmap_set_ttl(upo_ttlmap_t map, const void *key, uint64_t ttl)
+{
+    upo_ttlmap_node_t *node = NULL;
+
+    if (map == NULL)
+        return 0;
+
+    node = *upo_ttlmap_find(map, key, upo_ht_hash_wide(map->key_hash, key));
+    if (node == NULL)
+        return 0;
+
+    upo_ttlmap_set_expiry(map, node, ttl);
+
+    return 1;
+}
+
+uint64_t upo_ttlmap_ttl(const upo_ttlmap_t map, const void *key)
+{
+    upo_ttlmap_node_t *node = NULL;
+
+    if (map == NULL)
+        return UPO_TTLMAP_NO_TTL;
+
+    node = *upo_ttlmap_find(map, key, upo_ht_hash_wide(map->key_hash, key));
+    if (node == NULL || node->expires == UPO_TTLMAP_NO_TTL)
+        return UPO_TTLMAP_NO_TTL;
+
+    return node->expires - map->now;
+}
+
+size_t upo_ttlmap_advance(upo_ttlmap_t map, uint64_t ticks, int destroy_data)
+{
+    size_t count = 0;
+
+    if (map == NULL)
+        return 0;
+
+    while (ticks > 0 && map->scheduled > 0)
+    {
+        upo_ttlmap_node_t **slot = NULL;
+
+        --ticks;
+        map->now++;
+
+        /* Entering a new range of a level moves the pairs of that range down,
+         * and the first range of a level enters a new range of the next one */
+        if ((map->now & UPO_TTLMAP_WHEEL_MASK) == 0)
+        {
+            size_t level = 1;
+
+            while (level < UPO_TTLMAP_LEVELS
+                   && upo_ttlmap_cascade(map, level, (map->now >> (UPO_TTLMAP_WHEEL_BITS*level)) & UPO_TTLMAP_WHEEL_MASK))
+            {
+                ++level;
+            }
+        }
+
+        /* All pairs in the current slot of the lowest level expire now */
+        slot = &map->wheel[0][map->now & UPO_TTLMAP_WHEEL_MASK];
+        while (*slot != NULL)
+        {
+            upo_ttlmap_node_t *node = *slot;
+            upo_ttlmap_node_t **link = &map->slots[node->hash & (map->num_slots-1)];
+
+            assert( node->expires == map->now );
+
+            /* Find the node by address, without comparing its key */
+            while (*link != node)
+                link = &(*link)->next;
+
+            if (map->expire != NULL)
+                map->expire(node->key, node->value, map->expire_arg);
+
+            upo_ttlmap_remove(map, link, destroy_data);
+            ++count;
+        }
+    }
+
+    /* With no pair to expire, the clock jumps at once */
+    map->now += ticks;
+
+    return count;
+}
+
+uint64_t upo_ttlmap_now(const upo_ttlmap_t map)
+{
+    return (map != NULL) ? map->now : 0;
+}
+
+void upo_ttlmap_set_expirer(upo_ttlmap_t map, upo_ttlmap_expirer_t expire, void *expire_arg)
+{
+    if (map != NULL)
+    {
+        map->expire = expire;
+        map->expire_arg = expire_arg;
+    }
+}
+
+size_t upo_ttlmap_size(const upo_ttlmap_t map)
+{
+    return (map != NULL) ? map->size : 0;
+}
+
+int upo_ttlmap_is_empty(const upo_ttlmap_t map)
+{
+    return upo_ttlmap_size(map) == 0 ? 1 : 0;
+}
+
+upo_ht_comparator_t upo_ttlmap_get_comparator(const upo_ttlmap_t map)
+{
+    return map->key_cmp;
+}
+
+upo_ht_hasher_t upo_ttlmap_get_hasher(const upo_ttlmap_t map)
+{
+    return map->key_hash;
+}
+
+upo_ttlmap_node_t** upo_ttlmap_find(const upo_ttlmap_t map, const void *key, uint64_t hash)
+{
+    upo_ttlmap_node_t **link = &map->slots[hash & (map->num_slots-1)];
+
+    while (*link != NULL && ((*link)->hash != hash || map->key_cmp(key, (*link)->key) != 0))
+        link = &(*link)->next;
+
+    return link;
+}
+
+void upo_ttlmap_schedule(upo_ttlmap_t map, upo_ttlmap_node_t *node)
+{
+    uint64_t expires = node->expires;
+    size_t level = 0;
+    upo_ttlmap_node_t **slot = NULL;
+
+    assert( node->timer_link == NULL );
+    assert( expires != UPO_TTLMAP_NO_TTL && expires >= map->now );
+
+    if (expires - map->now >= UPO_TTLMAP_WHEEL_SPAN)
+    {
+        expires = map->now + UPO_TTLMAP_WHEEL_SPAN - 1;
+    }
+    while (level < UPO_TTLMAP_LEVELS-1
+           && ((expires - map->now) >> (UPO_TTLMAP_WHEEL_BITS*(level+1))) != 0)
+    {
+        ++level;
+    }
+
+    slot = &map->wheel[level][(expires >> (UPO_TTLMAP_WHEEL_BITS*level)) & UPO_TTLMAP_WHEEL_MASK];
+
+    node->timer_next = *slot;
+    if (*slot != NULL)
+        (*slot)->timer_link = &node->timer_next;
+    node->timer_link = slot;
+    *slot = node;
+    map->scheduled++;
+}
+
+void upo_ttlmap_unschedule(upo_ttlmap_t map, upo_ttlmap_node_t *node)
+{
+    if (node->timer_link != NULL)
+    {
+        *node->timer_link = node->timer_next;
+        if (node->timer_next != NULL)
+            node->timer_next->timer_link = node->timer_link;
+        node->timer_next = NULL;
+        node->timer_link = NULL;
+        map->scheduled--;
+    }
+}
+
+void upo_ttlmap_set_expiry(upo_ttlmap_t map, upo_ttlmap_node_t *node, uint64_t ttl)
+{
+    upo_ttlmap_unschedule(map, node);
+
+    if (ttl == UPO_TTLMAP_NO_TTL)
+    {
+        node->expires = UPO_TTLMAP_NO_TTL;
+    }
+    else
+    {
+        node->expires = (ttl <= UINT64_MAX - map->now) ? map->now + ttl : UINT64_MAX;
+        upo_ttlmap_schedule(map, node);
+    }
+}
+
+int upo_ttlmap_cascade(upo_ttlmap_t map, size_t level, size_t slot)
+{
+    upo_ttlmap_node_t *node = map->wheel[level][slot];
+
+    map->wheel[level][slot] = NULL;
+    while (node != NULL)
+    {
+        upo_ttlmap_node_t *next = node->timer_next;
+
+        node->timer_next = NULL;
+        node->timer_link = NULL;
+        map->scheduled--;
+        upo_ttlmap_schedule(map, node);
+        node = next;
+    }
+
+    return slot == 0;
+}
+
+void upo_ttlmap_remove(upo_ttlmap_t map, upo_ttlmap_node_t **link, int destroy_data)
+{
+    upo_ttlmap_node_t *node = *link;
+
+    *link = node->next;
+    upo_ttlmap_unschedule(map, node);
+
+    if (destroy_data)
+    {
+        free(node->key);
+        free(node->value);
+    }
+    free(node);
+    map->size--;
+}
+
+void upo_ttlmap_grow(upo_ttlmap_t map)
+{
+    size_t num_slots = 2*map->num_slots;
+    upo_ttlmap_node_t **slots = NULL;
+    size_t i = 0;
+
+    slots = malloc(num_slots*sizeof(upo_ttlmap_node_t*));
+    if (slots == NULL)
+    {
+        upo_throw_sys_error("Unable to allocate memory for slots of the TTL Map");
+    }
+
+    for (i = 0; i < num_slots; ++i)
+    {
+        slots[i] = NULL;
+    }
+
+    /* Relink nodes by their stored hash value, leaving the timing wheel as is */
+    for (i = 0; i < map->num_slots; ++i)
+    {
+        upo_ttlmap_node_t *node = map->slots[i];
+
+        while (node != NULL)
+        {
+            upo_ttlmap_node_t *next = node->next;
+            size_t j = node->hash & (num_slots-1);
+
+            node->next = slots[j];
+            slots[j] = node;
+            node = next;
+        }
+    }
+
+    free(map->slots);
+    map->slots = slots;
+    map->num_slots = num_slots;
+}
+
+
+/*** END of FUNDAMENTAL OPERATIONS ***/
+
+
+/*** BEGIN of EXTRA OPERATIONS ***/
+
+
+upo_ht_key_list_t upo_ttlmap_keys(const upo_ttlmap_t map)
+{
+    upo_ht_key_list_t list = NULL;
+    size_t i = 0;
+
+    if (map != NULL)
+    {
+        for (i = 0; i < map->num_slots; ++i)
+        {
+            upo_ttlmap_node_t *node = NULL;
+
+            for (node = map->slots[i]; node != NULL; node = node->next)
+            {
+                upo_ht_key_list_node_t *list_node = malloc(sizeof(struct upo_ht_key_list_node_s));
+
+                if (list_node == NULL)
+                    upo_throw_sys_error("Unable to allocate memory for a new node of the key list");
+
+                list_node->key = node->key;
+                list_node->next = list;
+                list = list_node;
+            }
+        }
+    }
+
+    return list;
+}
+
+void upo_ttlmap_traverse(const upo_ttlmap_t map, upo_ht_visitor_t visit, void *visit_arg)
+{
+    size_t i = 0;
+
+    if (map != NULL && visit != NULL)
+    {
+        for (i = 0; i < map->num_slots; ++i)
+        {
+            upo_ttlmap_node_t *node = NULL;
+
+            for (node = map->slots[i]; node != NULL; node = node->next)
+            {
+                visit(node->key, node->value, visit_arg);
+            }
+        }
+    }
+}
+
+
+/*** END of EXTRA OPERATIONS ***/
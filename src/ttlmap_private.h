@@ -0,0 +1,146 @@
+/**
+ * \file src/ttlmap_private.h
+ *
+ * \brief Private header for the TTL Map abstract data type.
+ *
+ * \copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ *  This file is part of UPOalglib.
+ *
+ *  UPOalglib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  UPOalglib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UPO_TTLMAP_PRIVATE_H
+#define UPO_TTLMAP_PRIVATE_H
+
+
+#include <stdint.h>
+#include <upo/ttlmap.h>
+
+
+/** \brief Number of bits of the tick selecting a slot of a level. */
+#define UPO_TTLMAP_WHEEL_BITS 6U
+
+/** \brief Mask selecting a slot of a level from a shifted tick. */
+#define UPO_TTLMAP_WHEEL_MASK (UPO_TTLMAP_WHEEL_SIZE-1U)
+
+/** \brief Number of ticks covered by the whole timing wheel. */
+#define UPO_TTLMAP_WHEEL_SPAN (((uint64_t) 1) << (UPO_TTLMAP_WHEEL_BITS*UPO_TTLMAP_LEVELS))
+
+
+/** \brief Type for nodes of TTL maps. */
+struct upo_ttlmap_node_s
+{
+    void *key; /**< Pointer to the user-provided key. */
+    void *value; /**< Pointer to the value associated to the key. */
+    uint64_t hash; /**< The hash value of the key. */
+    uint64_t expires; /**< The tick at which the pair expires, or UPO_TTLMAP_NO_TTL. */
+    struct upo_ttlmap_node_s *next; /**< Pointer to the next node in the list of collisions. */
+    struct upo_ttlmap_node_s *timer_next; /**< Pointer to the next node in the same slot of the timing wheel. */
+    struct upo_ttlmap_node_s **timer_link; /**< The link pointing to this node in its slot of the timing wheel, or `NULL` if the node is not scheduled. */
+};
+/** \brief Alias for the type for nodes of TTL maps. */
+typedef struct upo_ttlmap_node_s upo_ttlmap_node_t;
+
+/** \brief Type for TTL maps. */
+struct upo_ttlmap_s
+{
+    upo_ttlmap_node_t **slots; /**< The heads of the lists of collisions. */
+    size_t num_slots; /**< The number of slots (a power of two). */
+    size_t size; /**< The number of stored key-value pairs. */
+    size_t scheduled; /**< The number of stored key-value pairs that expire. */
+    upo_ttlmap_node_t *wheel[UPO_TTLMAP_LEVELS][UPO_TTLMAP_WHEEL_SIZE]; /**< The slots of the timing wheel. */
+    uint64_t now; /**< The current tick. */
+    upo_ht_hasher_t key_hash; /**< The key hash function. */
+    upo_ht_comparator_t key_cmp; /**< The key comparison function. */
+    upo_ttlmap_expirer_t expire; /**< The expiration function, or `NULL`. */
+    void *expire_arg; /**< The additional parameter of the expiration function. */
+};
+
+
+/**
+ * \brief Searches for the given key.
+ *
+ * \param map The TTL map.
+ * \param key The key to search for.
+ * \param hash The hash value of the key.
+ * \return The link (i.e., the head of the list of collisions or the `next`
+ *  field of a node) pointing to the node of the key, or to `NULL` if the key
+ *  is not found.
+ */
+static upo_ttlmap_node_t** upo_ttlmap_find(const upo_ttlmap_t map, const void *key, uint64_t hash);
+
+/**
+ * \brief Links the given node into the slot of the timing wheel matching its
+ *  expiration time.
+ *
+ * \param map The TTL map.
+ * \param node The node, which must not be scheduled and must expire.
+ *
+ * The level is the lowest one whose span covers the distance between the
+ * current tick and the expiration time; pairs expiring beyond the span of
+ * the whole wheel go to the last slot it covers and are rescheduled when
+ * that slot is reached.
+ */
+static void upo_ttlmap_schedule(upo_ttlmap_t map, upo_ttlmap_node_t *node);
+
+/**
+ * \brief Unlinks the given node from its slot of the timing wheel, if any.
+ *
+ * \param map The TTL map.
+ * \param node The node.
+ */
+static void upo_ttlmap_unschedule(upo_ttlmap_t map, upo_ttlmap_node_t *node);
+
+/**
+ * \brief Sets the expiration time of the given node and reschedules it.
+ *
+ * \param map The TTL map.
+ * \param node The node.
+ * \param ttl The time-to-live, or UPO_TTLMAP_NO_TTL.
+ */
+static void upo_ttlmap_set_expiry(upo_ttlmap_t map, upo_ttlmap_node_t *node, uint64_t ttl);
+
+/**
+ * \brief Moves the nodes of the given slot of the given level to the lower
+ *  levels.
+ *
+ * \param map The TTL map.
+ * \param level The level.
+ * \param slot The slot.
+ * \return `1` if the slot is the first one of its level, meaning that the
+ *  level above must be cascaded too, or `0` otherwise.
+ */
+static int upo_ttlmap_cascade(upo_ttlmap_t map, size_t level, size_t slot);
+
+/**
+ * \brief Removes the node pointed by the given link from the hash table and
+ *  frees it.
+ *
+ * \param map The TTL map.
+ * \param link The link pointing to the node in its list of collisions.
+ * \param destroy_data Tells whether the key and the value of the node must be
+ *  freed.
+ */
+static void upo_ttlmap_remove(upo_ttlmap_t map, upo_ttlmap_node_t **link, int destroy_data);
+
+/**
+ * \brief Doubles the number of slots of the hash table.
+ *
+ * \param map The TTL map.
+ */
+static void upo_ttlmap_grow(upo_ttlmap_t map);
+
+
+#endif /* UPO_TTLMAP_PRIVATE_H */
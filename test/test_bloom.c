@@ -0,0 +1,262 @@
+/*
+ * Copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ * This file is part of UPOalglib.
+ *
+ * UPOalglib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * UPOalglib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <upo/bloom.h>
+
+
+#define NUM_KEYS 10000
+#define NUM_PROBES 100000
+
+
+static size_t int_hash(const void *key, size_t m);
+static size_t count_false_positives(upo_bloom_t bloom, int first);
+
+static void test_create_destroy();
+static void test_add_contains();
+static void test_fpr();
+static void test_merge();
+static void test_serialize();
+
+
+// Hashes an integer key (which may be negative)
+size_t int_hash(const void *key, size_t m)
+{
+    return (size_t) (unsigned) *((const int*) key) % m;
+}
+
+// Counts the keys in [first, first+NUM_PROBES) reported as present
+size_t count_false_positives(upo_bloom_t bloom, int first)
+{
+    size_t count = 0;
+    int key = 0;
+
+    for (key = first; key < first + NUM_PROBES; ++key)
+    {
+        if (upo_bloom_contains(bloom, &key))
+            ++count;
+    }
+
+    return count;
+}
+
+void test_create_destroy()
+{
+    upo_bloom_t bloom = upo_bloom_create(1000, 0.01, int_hash);
+    int key = 1;
+
+    assert( bloom != NULL );
+    assert( upo_bloom_count(bloom) == 0 );
+    assert( upo_bloom_bits(bloom) % UPO_BLOOM_BLOCK_BITS == 0 );
+    assert( upo_bloom_fpr(bloom) == 0 );
+    assert( !upo_bloom_contains(bloom, &key) );
+    assert( upo_bloom_get_hasher(bloom) == int_hash );
+
+    /* About 10 bits per key for 1% of false positives, a bit more with blocks */
+    assert( upo_bloom_bits(bloom) >= 9600 && upo_bloom_bits(bloom) <= 14000 );
+
+    upo_bloom_destroy(bloom);
+
+    /* Even an empty filter has a block */
+    bloom = upo_bloom_create(0, 0.5, int_hash);
+    assert( upo_bloom_bits(bloom) == UPO_BLOOM_BLOCK_BITS );
+    upo_bloom_destroy(bloom);
+
+    upo_bloom_destroy(NULL);
+    assert( upo_bloom_count(NULL) == 0 );
+    assert( upo_bloom_bits(NULL) == 0 );
+    assert( !upo_bloom_contains(NULL, &key) );
+}
+
+void test_add_contains()
+{
+    upo_bloom_t bloom = upo_bloom_create(NUM_KEYS, 0.01, int_hash);
+    int key = 0;
+
+    for (key = 0; key < NUM_KEYS; ++key)
+    {
+        upo_bloom_add(bloom, &key);
+    }
+    assert( upo_bloom_count(bloom) == NUM_KEYS );
+
+    /* No false negatives */
+    for (key = 0; key < NUM_KEYS; ++key)
+    {
+        assert( upo_bloom_contains(bloom, &key) );
+    }
+
+    upo_bloom_clear(bloom);
+    assert( upo_bloom_count(bloom) == 0 );
+    assert( count_false_positives(bloom, 0) == 0 );
+
+    upo_bloom_destroy(bloom);
+}
+
+void test_fpr()
+{
+    double targets[] = {0.1, 0.01, 0.001};
+    size_t i = 0;
+
+    for (i = 0; i < sizeof targets/sizeof targets[0]; ++i)
+    {
+        upo_bloom_t bloom = upo_bloom_create(NUM_KEYS, targets[i], int_hash);
+        double measured = 0;
+        int key = 0;
+
+        for (key = 0; key < NUM_KEYS; ++key)
+        {
+            upo_bloom_add(bloom, &key);
+        }
+        assert( upo_bloom_fpr(bloom) <= targets[i] );
+        assert( upo_bloom_fpr(bloom) > targets[i]/2 );
+
+        /* The measured rate matches the target up to sampling noise */
+        measured = (double) count_false_positives(bloom, -NUM_PROBES) / NUM_PROBES;
+        assert( measured <= 1.3*targets[i] );
+
+        upo_bloom_destroy(bloom);
+    }
+}
+
+void test_merge()
+{
+    upo_bloom_t a = upo_bloom_create(NUM_KEYS, 0.01, int_hash);
+    upo_bloom_t b = upo_bloom_create(NUM_KEYS, 0.01, int_hash);
+    upo_bloom_t c = upo_bloom_create(2*NUM_KEYS, 0.01, int_hash);
+    upo_bloom_t d = upo_bloom_create(NUM_KEYS, 0.01, upo_ht_hash_int_div);
+    upo_bloom_t all = upo_bloom_create(NUM_KEYS, 0.01, int_hash);
+    int key = 0;
+
+    for (key = 0; key < NUM_KEYS; ++key)
+    {
+        upo_bloom_add((key % 2 == 0) ? a : b, &key);
+        upo_bloom_add(all, &key);
+    }
+
+    assert( upo_bloom_merge(a, c) == 0 );
+    assert( upo_bloom_merge(a, d) == 0 );
+    assert( upo_bloom_merge(a, b) == 1 );
+    assert( upo_bloom_count(a) == NUM_KEYS );
+    for (key = 0; key < NUM_KEYS; ++key)
+    {
+        assert( upo_bloom_contains(a, &key) );
+    }
+
+    /* The merged filter has the same bits as the filter of all keys */
+    assert( upo_bloom_serialized_size(a) == upo_bloom_serialized_size(all) );
+    {
+        size_t size = upo_bloom_serialized_size(a);
+        unsigned char *buf_a = malloc(size);
+        unsigned char *buf_all = malloc(size);
+
+        assert( buf_a != NULL && buf_all != NULL );
+        upo_bloom_serialize(a, buf_a);
+        upo_bloom_serialize(all, buf_all);
+        assert( memcmp(buf_a, buf_all, size) == 0 );
+        free(buf_a);
+        free(buf_all);
+    }
+
+    upo_bloom_destroy(a);
+    upo_bloom_destroy(b);
+    upo_bloom_destroy(c);
+    upo_bloom_destroy(d);
+    upo_bloom_destroy(all);
+}
+
+void test_serialize()
+{
+    upo_bloom_t bloom = upo_bloom_create(1000, 0.01, int_hash);
+    upo_bloom_t copy = NULL;
+    unsigned char *buf = NULL;
+    size_t size = 0;
+    int key = 0;
+
+    for (key = 0; key < 1000; ++key)
+    {
+        upo_bloom_add(bloom, &key);
+    }
+
+    size = upo_bloom_serialized_size(bloom);
+    assert( size == 24 + upo_bloom_bits(bloom)/8 );
+    buf = malloc(size);
+    assert( buf != NULL );
+    upo_bloom_serialize(bloom, buf);
+    assert( memcmp(buf, "UPOBLOOM", 8) == 0 );
+
+    copy = upo_bloom_deserialize(buf, size, int_hash);
+    assert( copy != NULL );
+    assert( upo_bloom_count(copy) == 1000 );
+    assert( upo_bloom_bits(copy) == upo_bloom_bits(bloom) );
+    for (key = 0; key < 1000; ++key)
+    {
+        assert( upo_bloom_contains(copy, &key) );
+    }
+    assert( count_false_positives(copy, 1000) == count_false_positives(bloom, 1000) );
+    assert( upo_bloom_merge(copy, bloom) == 1 );
+    upo_bloom_destroy(copy);
+
+    /* Truncated, oversized or corrupted buffers are rejected */
+    assert( upo_bloom_deserialize(buf, 0, int_hash) == NULL );
+    assert( upo_bloom_deserialize(buf, 23, int_hash) == NULL );
+    assert( upo_bloom_deserialize(buf, size - 1, int_hash) == NULL );
+    buf[0] ^= 1;
+    assert( upo_bloom_deserialize(buf, size, int_hash) == NULL );
+    buf[0] ^= 1;
+    buf[15] = 0x80;
+    assert( upo_bloom_deserialize(buf, size, int_hash) == NULL );
+
+    free(buf);
+    upo_bloom_destroy(bloom);
+}
+
+
+int main()
+{
+    printf("Test case 'create/destroy'... ");
+    fflush(stdout);
+    test_create_destroy();
+    printf("OK\n");
+
+    printf("Test case 'add/contains'... ");
+    fflush(stdout);
+    test_add_contains();
+    printf("OK\n");
+
+    printf("Test case 'false positive rate'... ");
+    fflush(stdout);
+    test_fpr();
+    printf("OK\n");
+
+    printf("Test case 'merge'... ");
+    fflush(stdout);
+    test_merge();
+    printf("OK\n");
+
+    printf("Test case 'serialize'... ");
+    fflush(stdout);
+    test_serialize();
+    printf("OK\n");
+
+    return 0;
+}
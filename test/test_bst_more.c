@@ -27,6 +27,9 @@
 #include <upo/error.h>
 
 
+#define SET_N 2000
+
+
 typedef struct {
             int *keys;
             int *values;
@@ -42,6 +45,9 @@ static void test_min_max();
 static void test_delete_min_max();
 static void test_floor_ceiling();
 static void test_bst_property();
+static void test_set_operations();
+static void collect_pair(void *key, void *value, void *arg);
+static size_t floor_log2(size_t n);
 
 
 int int_compare(const void *a, const void *b)
@@ -846,6 +852,167 @@ void test_bst_property()
     upo_bst_destroy(bst, 0);
 }
 
+void collect_pair(void *key, void *value, void *arg)
+{
+    visit_state_t *state = arg;
+
+    state->keys[state->count] = *(int*) key;
+    state->values[state->count] = *(int*) value;
+    ++state->count;
+}
+
+size_t floor_log2(size_t n)
+{
+    size_t h = 0;
+
+    while (n > 1)
+    {
+        n /= 2;
+        ++h;
+    }
+
+    return h;
+}
+
+void test_set_operations()
+{
+    static int keys1[SET_N];
+    static int values1[SET_N];
+    static int keys2[SET_N];
+    static int values2[SET_N];
+    static int out_keys[2*SET_N];
+    static int out_values[2*SET_N];
+    int min_key = INT_MIN;
+    int max_key = INT_MAX;
+    upo_bst_t bst1 = upo_bst_create(int_compare);
+    upo_bst_t bst2 = upo_bst_create(int_compare);
+    upo_bst_t empty = upo_bst_create(int_compare);
+    upo_bst_t res = NULL;
+    visit_state_t state;
+    size_t i = 0;
+    size_t j = 0;
+    int k = 0;
+
+    /* The first tree is degenerate (multiples of 2 in increasing order), the
+     * second one holds the multiples of 3 in a shuffled order */
+    for (i = 0; i < SET_N; ++i)
+    {
+        keys1[i] = 2*(int) i;
+        values1[i] = 1;
+        upo_bst_put(bst1, &keys1[i], &values1[i]);
+        keys2[i] = 3*(int) i;
+        values2[i] = 2;
+    }
+    for (i = SET_N - 1; i > 0; --i)
+    {
+        j = (size_t) rand() % (i + 1);
+        k = keys2[i];
+        keys2[i] = keys2[j];
+        keys2[j] = k;
+    }
+    for (i = 0; i < SET_N; ++i)
+    {
+        upo_bst_put(bst2, &keys2[i], &values2[i]);
+    }
+
+    state.keys = out_keys;
+    state.values = out_values;
+
+    /* Union: the multiples of 2 or 3 below 4000, then those of 3 up to 6000 */
+    res = upo_bst_union(bst1, bst2);
+    state.count = 0;
+    upo_bst_traverse_in_order(res, collect_pair, &state);
+    for (k = 0, i = 0; k < 3*SET_N; ++k)
+    {
+        if ((k % 2 == 0 && k < 2*SET_N) || k % 3 == 0)
+        {
+            assert( i < state.count );
+            assert( out_keys[i] == k );
+            /* Keys found in both trees take the value from the first one */
+            assert( out_values[i] == ((k % 2 == 0 && k < 2*SET_N) ? 1 : 2) );
+            ++i;
+        }
+    }
+    assert( i == state.count );
+    assert( upo_bst_size(res) == state.count );
+    assert( upo_bst_height(res) == floor_log2(state.count) );
+    assert( upo_bst_is_bst(res, &min_key, &max_key) );
+    upo_bst_destroy(res, 0);
+
+    /* Intersection: the multiples of 6 below 4000 */
+    res = upo_bst_intersection(bst1, bst2);
+    state.count = 0;
+    upo_bst_traverse_in_order(res, collect_pair, &state);
+    for (k = 0, i = 0; k < 2*SET_N; k += 6, ++i)
+    {
+        assert( out_keys[i] == k );
+        assert( out_values[i] == 1 );
+    }
+    assert( i == state.count );
+    assert( upo_bst_height(res) == floor_log2(state.count) );
+    upo_bst_destroy(res, 0);
+
+    /* Difference: the multiples of 2 below 4000 that are not multiples of 3 */
+    res = upo_bst_difference(bst1, bst2);
+    state.count = 0;
+    upo_bst_traverse_in_order(res, collect_pair, &state);
+    for (k = 0, i = 0; k < 2*SET_N; k += 2)
+    {
+        if (k % 3 != 0)
+        {
+            assert( out_keys[i] == k );
+            ++i;
+        }
+    }
+    assert( i == state.count );
+    assert( upo_bst_height(res) == floor_log2(state.count) );
+    upo_bst_destroy(res, 0);
+
+    res = upo_bst_difference(bst2, bst1);
+    assert( upo_bst_size(res) == SET_N - (2*SET_N + 5)/6 );
+    assert( !upo_bst_contains(res, &keys1[0]) );
+    upo_bst_destroy(res, 0);
+
+    /* Empty operands */
+    res = upo_bst_union(empty, bst1);
+    assert( upo_bst_size(res) == SET_N );
+    assert( upo_bst_height(res) == floor_log2(SET_N) );
+    upo_bst_destroy(res, 0);
+    res = upo_bst_intersection(bst1, empty);
+    assert( upo_bst_is_empty(res) );
+    upo_bst_destroy(res, 0);
+    res = upo_bst_difference(bst1, empty);
+    assert( upo_bst_size(res) == SET_N );
+    upo_bst_destroy(res, 0);
+    res = upo_bst_difference(empty, bst1);
+    assert( upo_bst_is_empty(res) );
+    upo_bst_destroy(res, 0);
+    res = upo_bst_union(empty, empty);
+    assert( upo_bst_is_empty(res) );
+    assert( upo_bst_get_comparator(res) == int_compare );
+    upo_bst_destroy(res, 0);
+
+    /* NULL operands are read as empty trees */
+    res = upo_bst_union(NULL, bst1);
+    assert( upo_bst_size(res) == SET_N );
+    assert( upo_bst_get_comparator(res) == int_compare );
+    upo_bst_destroy(res, 0);
+    res = upo_bst_intersection(bst1, NULL);
+    assert( upo_bst_is_empty(res) );
+    upo_bst_destroy(res, 0);
+    res = upo_bst_difference(bst1, NULL);
+    assert( upo_bst_size(res) == SET_N );
+    upo_bst_destroy(res, 0);
+    res = upo_bst_difference(NULL, bst1);
+    assert( upo_bst_is_empty(res) );
+    upo_bst_destroy(res, 0);
+    assert( upo_bst_union(NULL, NULL) == NULL );
+
+    upo_bst_destroy(bst1, 0);
+    upo_bst_destroy(bst2, 0);
+    upo_bst_destroy(empty, 0);
+}
+
 
 int main()
 {
@@ -874,5 +1041,10 @@ int main()
     test_bst_property();
     printf("OK\n");
 
+    printf("Test case 'set operations'... ");
+    fflush(stdout);
+    test_set_operations();
+    printf("OK\n");
+
     return 0;
 }
@@ -0,0 +1,393 @@
+/*
+ * Copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ * This file is part of UPOalglib.
+ *
+ * UPOalglib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * UPOalglib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <upo/cache.h>
+
+
+/** \brief Number of keys used by the concurrent test. */
+#define NUM_KEYS 1000
+
+/** \brief Number of reader threads used by the concurrent test. */
+#define NUM_READERS 4
+
+
+/** \brief Data shared by the threads of the concurrent test. */
+struct shared_s
+{
+    upo_cache_t cache;
+    int *keys;
+    int stop;
+    pthread_mutex_t lock;
+};
+
+
+static int int_compare(const void *a, const void *b);
+static void count_evict(void *key, void *value, void *info);
+static void* reader(void *arg);
+
+static void test_create_destroy();
+static void test_put_get_delete();
+static void test_eviction();
+static void test_scan_resistance();
+static void test_destroy_data();
+static void test_concurrent();
+static void test_null();
+
+
+int int_compare(const void *a, const void *b)
+{
+    const int *aa = a;
+    const int *bb = b;
+
+    assert( a != NULL );
+    assert( b != NULL );
+
+    return (*aa > *bb) - (*aa < *bb);
+}
+
+// Counts evicted pairs, whose value must be the key
+void count_evict(void *key, void *value, void *info)
+{
+    size_t *counter = info;
+
+    assert( key != NULL );
+    assert( key == value );
+
+    (*counter)++;
+}
+
+// Looks keys up until told to stop, checking that each key maps to itself
+void* reader(void *arg)
+{
+    struct shared_s *shared = arg;
+    size_t i = 0;
+    int stop = 0;
+
+    while (!stop)
+    {
+        for (i = 0; i < NUM_KEYS; ++i)
+        {
+            void *value = upo_cache_get(shared->cache, &shared->keys[i]);
+
+            assert( value == NULL || value == &shared->keys[i] );
+        }
+
+        pthread_mutex_lock(&shared->lock);
+        stop = shared->stop;
+        pthread_mutex_unlock(&shared->lock);
+    }
+
+    return NULL;
+}
+
+void test_create_destroy()
+{
+    upo_cache_t cache = upo_cache_create(10, upo_ht_hash_int_div, int_compare);
+
+    assert( cache != NULL );
+    assert( upo_cache_is_empty(cache) );
+    assert( upo_cache_size(cache) == 0 );
+    assert( upo_cache_capacity(cache) == 10 );
+    assert( upo_cache_get_comparator(cache) == int_compare );
+    assert( upo_cache_get_hasher(cache) == upo_ht_hash_int_div );
+
+    upo_cache_destroy(cache, 0);
+}
+
+void test_put_get_delete()
+{
+    int keys[] = {0, 10, 20, 1, 11, 2};
+    int values[] = {5, 6, 7, 8, 9, 10};
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t i = 0;
+    int missing = 30;
+    upo_cache_t cache = upo_cache_create(10, upo_ht_hash_int_div, int_compare);
+
+    for (i = 0; i < n; ++i)
+    {
+        assert( upo_cache_put(cache, &keys[i], &keys[i]) == NULL );
+        assert( upo_cache_size(cache) == i+1 );
+    }
+    for (i = 0; i < n; ++i)
+    {
+        assert( upo_cache_get(cache, &keys[i]) == &keys[i] );
+        assert( upo_cache_put(cache, &keys[i], &values[i]) == &keys[i] );
+        assert( upo_cache_get(cache, &keys[i]) == &values[i] );
+        assert( upo_cache_contains(cache, &keys[i]) );
+    }
+    assert( upo_cache_size(cache) == n );
+    assert( upo_cache_get(cache, &missing) == NULL );
+    assert( !upo_cache_contains(cache, &missing) );
+
+    upo_cache_delete(cache, &keys[1], 0);
+    upo_cache_delete(cache, &keys[1], 0);
+    upo_cache_delete(cache, &missing, 0);
+    assert( upo_cache_size(cache) == n-1 );
+    assert( !upo_cache_contains(cache, &keys[1]) );
+    for (i = 2; i < n; ++i)
+    {
+        assert( upo_cache_get(cache, &keys[i]) == &values[i] );
+    }
+
+    /* Removed entries are reused */
+    upo_cache_put(cache, &keys[1], &keys[1]);
+    assert( upo_cache_get(cache, &keys[1]) == &keys[1] );
+
+    upo_cache_clear(cache, 0);
+    assert( upo_cache_is_empty(cache) );
+    for (i = 0; i < n; ++i)
+    {
+        assert( !upo_cache_contains(cache, &keys[i]) );
+        upo_cache_put(cache, &keys[i], &keys[i]);
+    }
+    assert( upo_cache_size(cache) == n );
+
+    upo_cache_destroy(cache, 0);
+}
+
+void test_eviction()
+{
+    int keys[100];
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t m = 8;
+    size_t i = 0;
+    size_t evicted = 0;
+    upo_cache_t cache = upo_cache_create(m, upo_ht_hash_int_div, int_compare);
+
+    upo_cache_set_evictor(cache, count_evict, &evicted);
+
+    for (i = 0; i < n; ++i)
+    {
+        keys[i] = (int) i;
+        upo_cache_put(cache, &keys[i], &keys[i]);
+
+        assert( upo_cache_size(cache) == (i < m ? i+1 : m) );
+    }
+    assert( evicted == n-m );
+
+    /* Never used keys are evicted in insertion order */
+    for (i = 0; i < n; ++i)
+    {
+        assert( upo_cache_contains(cache, &keys[i]) == (i >= n-m) );
+    }
+
+    /* No eviction callback for explicit removals */
+    upo_cache_delete(cache, &keys[n-1], 0);
+    upo_cache_clear(cache, 0);
+    assert( evicted == n-m );
+
+    upo_cache_destroy(cache, 0);
+}
+
+void test_scan_resistance()
+{
+    int hot[8];
+    int scan[1000];
+    size_t m = 16;
+    size_t i = 0;
+    size_t j = 0;
+    upo_cache_t cache = upo_cache_create(m, upo_ht_hash_int_div, int_compare);
+
+    for (i = 0; i < sizeof hot/sizeof hot[0]; ++i)
+    {
+        hot[i] = (int) i;
+        upo_cache_put(cache, &hot[i], &hot[i]);
+    }
+
+    /* Hot keys are used between chunks of a long scan of keys used once */
+    for (i = 0; i < sizeof scan/sizeof scan[0]; ++i)
+    {
+        scan[i] = (int) (1000 + i);
+        if (i % 4 == 0)
+        {
+            for (j = 0; j < sizeof hot/sizeof hot[0]; ++j)
+            {
+                assert( upo_cache_get(cache, &hot[j]) == &hot[j] );
+            }
+        }
+        upo_cache_put(cache, &scan[i], &scan[i]);
+    }
+    for (j = 0; j < sizeof hot/sizeof hot[0]; ++j)
+    {
+        assert( upo_cache_contains(cache, &hot[j]) );
+    }
+
+    upo_cache_destroy(cache, 0);
+}
+
+void test_destroy_data()
+{
+    size_t i = 0;
+    upo_cache_t cache = upo_cache_create(16, upo_ht_hash_int_div, int_compare);
+
+    for (i = 0; i < 12; ++i)
+    {
+        int *key = malloc(sizeof(int));
+
+        assert( key != NULL );
+
+        *key = (int) i;
+        upo_cache_put(cache, key, malloc(sizeof(int)));
+        if (i % 4 == 0)
+            upo_cache_delete(cache, key, 1);
+        if (i == 6)
+            upo_cache_clear(cache, 1);
+    }
+    assert( upo_cache_size(cache) == 4 );
+
+    /* Replacing a value keeps the stored key, so an equal key can be freed */
+    {
+        int lookup = 100;
+        int *key = malloc(sizeof(int));
+        int *old_value = malloc(sizeof(int));
+        int *value = malloc(sizeof(int));
+
+        assert( key != NULL && old_value != NULL && value != NULL );
+
+        *key = lookup;
+        upo_cache_put(cache, key, old_value);
+        key = malloc(sizeof(int));
+        assert( key != NULL );
+        *key = lookup;
+        assert( upo_cache_put(cache, key, value) == old_value );
+        free(old_value);
+        free(key);
+        assert( upo_cache_get(cache, &lookup) == value );
+        assert( upo_cache_size(cache) == 5 );
+    }
+
+    upo_cache_destroy(cache, 1);
+}
+
+void test_concurrent()
+{
+    struct shared_s shared;
+    pthread_t threads[NUM_READERS];
+    int keys[NUM_KEYS];
+    size_t i = 0;
+    size_t round = 0;
+    size_t evicted = 0;
+
+    for (i = 0; i < NUM_KEYS; ++i)
+    {
+        keys[i] = (int) i;
+    }
+
+    shared.cache = upo_cache_create(NUM_KEYS/4, upo_ht_hash_int_div, int_compare);
+    shared.keys = keys;
+    shared.stop = 0;
+    pthread_mutex_init(&shared.lock, NULL);
+
+    upo_cache_set_evictor(shared.cache, count_evict, &evicted);
+
+    for (i = 0; i < NUM_READERS; ++i)
+    {
+        assert( pthread_create(&threads[i], NULL, reader, &shared) == 0 );
+    }
+
+    /* Keep evicting, removing and reinserting keys under the readers */
+    for (round = 0; round < 200; ++round)
+    {
+        for (i = 0; i < NUM_KEYS; ++i)
+        {
+            if ((i + round) % 7 == 0)
+                upo_cache_delete(shared.cache, &keys[i], 0);
+            else
+                upo_cache_put(shared.cache, &keys[i], &keys[i]);
+        }
+    }
+
+    pthread_mutex_lock(&shared.lock);
+    shared.stop = 1;
+    pthread_mutex_unlock(&shared.lock);
+
+    for (i = 0; i < NUM_READERS; ++i)
+    {
+        assert( pthread_join(threads[i], NULL) == 0 );
+    }
+
+    assert( upo_cache_size(shared.cache) <= NUM_KEYS/4 );
+    assert( evicted > 0 );
+
+    pthread_mutex_destroy(&shared.lock);
+    upo_cache_destroy(shared.cache, 0);
+}
+
+void test_null()
+{
+    upo_cache_t cache = NULL;
+
+    assert( upo_cache_size(cache) == 0 );
+    assert( upo_cache_is_empty(cache) );
+    assert( upo_cache_capacity(cache) == 0 );
+    assert( !upo_cache_contains(cache, NULL) );
+    assert( upo_cache_get(cache, NULL) == NULL );
+
+    upo_cache_set_evictor(cache, NULL, NULL);
+    upo_cache_clear(cache, 0);
+    upo_cache_delete(cache, NULL, 0);
+    upo_cache_destroy(cache, 0);
+}
+
+
+int main()
+{
+    printf("Test case 'create/destroy'... ");
+    fflush(stdout);
+    test_create_destroy();
+    printf("OK\n");
+
+    printf("Test case 'put/get/delete'... ");
+    fflush(stdout);
+    test_put_get_delete();
+    printf("OK\n");
+
+    printf("Test case 'eviction'... ");
+    fflush(stdout);
+    test_eviction();
+    printf("OK\n");
+
+    printf("Test case 'scan resistance'... ");
+    fflush(stdout);
+    test_scan_resistance();
+    printf("OK\n");
+
+    printf("Test case 'destroy data'... ");
+    fflush(stdout);
+    test_destroy_data();
+    printf("OK\n");
+
+    printf("Test case 'concurrent'... ");
+    fflush(stdout);
+    test_concurrent();
+    printf("OK\n");
+
+    printf("Test case 'null'... ");
+    fflush(stdout);
+    test_null();
+    printf("OK\n");
+
+
+    return 0;
+}
@@ -0,0 +1,362 @@
+/*
+ * Copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ * This file is part of UPOalglib.
+ *
+ * UPOalglib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * UPOalglib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <upo/cms.h>
+
+
+#define NUM_KEYS 5000
+#define NUM_HEAVY 10
+#define NUM_LIGHT 50000
+#define NUM_THREADS 4
+
+
+static int int_compare(const void *a, const void *b);
+static void make_stream();
+static void* count_part(void *arg);
+
+static void test_create_destroy();
+static void test_add_estimate();
+static void test_merge();
+static void test_topk();
+static void test_topk_merge();
+
+
+static int keys[NUM_KEYS];
+static uint64_t counts[NUM_KEYS];
+static size_t *stream;
+static size_t stream_size;
+
+
+/* Arguments of the threads of test_merge() and test_topk_merge() */
+struct part_s
+{
+    upo_cms_t cms;
+    upo_cms_topk_t topk;
+    size_t begin;
+    size_t end;
+};
+
+
+int int_compare(const void *a, const void *b)
+{
+    const int *aa = a;
+    const int *bb = b;
+
+    assert( a != NULL );
+    assert( b != NULL );
+
+    return (*aa > *bb) - (*aa < *bb);
+}
+
+// Makes a shuffled stream of key indices where the first NUM_HEAVY keys are
+// much more frequent than the others, and counts the occurrences of each key
+void make_stream()
+{
+    size_t i = 0;
+    size_t j = 0;
+
+    stream_size = NUM_LIGHT;
+    for (i = 0; i < NUM_HEAVY; ++i)
+    {
+        stream_size += 2000 - 100*i;
+    }
+    stream = malloc(stream_size*sizeof(size_t));
+    assert( stream != NULL );
+
+    for (i = 0; i < NUM_KEYS; ++i)
+    {
+        keys[i] = (int) i;
+        counts[i] = 0;
+    }
+    for (i = 0, j = 0; i < NUM_HEAVY; ++i)
+    {
+        size_t n = 0;
+
+        for (n = 0; n < 2000 - 100*i; ++n)
+        {
+            stream[j++] = i;
+        }
+    }
+    while (j < stream_size)
+    {
+        stream[j++] = NUM_HEAVY + (size_t) rand() % (NUM_KEYS - NUM_HEAVY);
+    }
+    for (i = stream_size - 1; i > 0; --i)
+    {
+        size_t k = (size_t) rand() % (i + 1);
+        size_t tmp = stream[i];
+
+        stream[i] = stream[k];
+        stream[k] = tmp;
+    }
+    for (i = 0; i < stream_size; ++i)
+    {
+        ++counts[stream[i]];
+    }
+}
+
+// Counts a part of the stream into a sketch or a heavy hitters structure
+void* count_part(void *arg)
+{
+    struct part_s *part = arg;
+    size_t i = 0;
+
+    for (i = part->begin; i < part->end; ++i)
+    {
+        if (part->topk != NULL)
+            upo_cms_topk_add(part->topk, &keys[stream[i]], 1);
+        else
+            upo_cms_add(part->cms, &keys[stream[i]], 1);
+    }
+
+    return NULL;
+}
+
+void test_create_destroy()
+{
+    upo_cms_t cms = upo_cms_create(100, 4, upo_ht_hash_int_div);
+    int key = 1;
+
+    assert( cms != NULL );
+    assert( upo_cms_width(cms) == 100 );
+    assert( upo_cms_depth(cms) == 4 );
+    assert( upo_cms_total(cms) == 0 );
+    assert( upo_cms_estimate(cms, &key) == 0 );
+    upo_cms_destroy(cms);
+
+    /* e/0.01 counters per row and ln(100) rows */
+    cms = upo_cms_create_with_error(0.01, 0.01, upo_ht_hash_int_div);
+    assert( upo_cms_width(cms) == 272 );
+    assert( upo_cms_depth(cms) == 5 );
+    upo_cms_destroy(cms);
+
+    upo_cms_destroy(NULL);
+    upo_cms_topk_destroy(NULL);
+    assert( upo_cms_width(NULL) == 0 );
+    assert( upo_cms_depth(NULL) == 0 );
+    assert( upo_cms_total(NULL) == 0 );
+    assert( upo_cms_estimate(NULL, &key) == 0 );
+    assert( upo_cms_topk_size(NULL) == 0 );
+}
+
+void test_add_estimate()
+{
+    upo_cms_t cms = upo_cms_create_with_error(0.001, 0.01, upo_ht_hash_int_div);
+    size_t i = 0;
+    size_t exceeding = 0;
+
+    for (i = 0; i < stream_size; ++i)
+    {
+        uint64_t estimate = upo_cms_add(cms, &keys[stream[i]], 1);
+
+        assert( estimate == upo_cms_estimate(cms, &keys[stream[i]]) );
+    }
+    assert( upo_cms_total(cms) == stream_size );
+
+    /* Never below the true count, and rarely more than epsilon*N above it */
+    for (i = 0; i < NUM_KEYS; ++i)
+    {
+        uint64_t estimate = upo_cms_estimate(cms, &keys[i]);
+
+        assert( estimate >= counts[i] );
+        if (estimate > counts[i] + stream_size/1000)
+            ++exceeding;
+    }
+    assert( exceeding <= NUM_KEYS/100 );
+
+    /* Adding a larger count at once */
+    assert( upo_cms_add(cms, &keys[0], 1000) == upo_cms_estimate(cms, &keys[0]) );
+    assert( upo_cms_estimate(cms, &keys[0]) >= counts[0] + 1000 );
+
+    upo_cms_clear(cms);
+    assert( upo_cms_total(cms) == 0 );
+    assert( upo_cms_estimate(cms, &keys[0]) == 0 );
+
+    upo_cms_destroy(cms);
+}
+
+void test_merge()
+{
+    pthread_t threads[NUM_THREADS];
+    struct part_s parts[NUM_THREADS];
+    upo_cms_t other = NULL;
+    size_t i = 0;
+
+    /* Each thread counts a part of the stream into its own sketch */
+    for (i = 0; i < NUM_THREADS; ++i)
+    {
+        parts[i].cms = upo_cms_create(2000, 4, upo_ht_hash_int_div);
+        parts[i].topk = NULL;
+        parts[i].begin = i*stream_size/NUM_THREADS;
+        parts[i].end = (i + 1)*stream_size/NUM_THREADS;
+        assert( pthread_create(&threads[i], NULL, count_part, &parts[i]) == 0 );
+    }
+    for (i = 0; i < NUM_THREADS; ++i)
+    {
+        assert( pthread_join(threads[i], NULL) == 0 );
+    }
+    for (i = 1; i < NUM_THREADS; ++i)
+    {
+        assert( upo_cms_merge(parts[0].cms, parts[i].cms) == 1 );
+        upo_cms_destroy(parts[i].cms);
+    }
+
+    assert( upo_cms_total(parts[0].cms) == stream_size );
+    for (i = 0; i < NUM_KEYS; ++i)
+    {
+        assert( upo_cms_estimate(parts[0].cms, &keys[i]) >= counts[i] );
+    }
+    for (i = 0; i < NUM_HEAVY; ++i)
+    {
+        assert( upo_cms_estimate(parts[0].cms, &keys[i]) <= counts[i] + stream_size/100 );
+    }
+
+    /* Sketches of different sizes or hash functions cannot be merged */
+    other = upo_cms_create(1000, 4, upo_ht_hash_int_div);
+    assert( upo_cms_merge(parts[0].cms, other) == 0 );
+    upo_cms_destroy(other);
+    other = upo_cms_create(2000, 3, upo_ht_hash_int_div);
+    assert( upo_cms_merge(parts[0].cms, other) == 0 );
+    upo_cms_destroy(other);
+
+    upo_cms_destroy(parts[0].cms);
+}
+
+void test_topk()
+{
+    upo_cms_topk_t topk = upo_cms_topk_create(NUM_HEAVY, 2000, 4, upo_ht_hash_int_div, int_compare);
+    void *items[NUM_HEAVY];
+    uint64_t estimates[NUM_HEAVY];
+    size_t i = 0;
+
+    assert( upo_cms_topk_size(topk) == 0 );
+    assert( upo_cms_topk_items(topk, items, estimates) == 0 );
+
+    for (i = 0; i < stream_size; ++i)
+    {
+        upo_cms_topk_add(topk, &keys[stream[i]], 1);
+    }
+    assert( upo_cms_topk_size(topk) == NUM_HEAVY );
+    assert( upo_cms_total(upo_cms_topk_sketch(topk)) == stream_size );
+
+    /* The heavy hitters come out in order of frequency */
+    assert( upo_cms_topk_items(topk, items, estimates) == NUM_HEAVY );
+    for (i = 0; i < NUM_HEAVY; ++i)
+    {
+        assert( *((int*) items[i]) == (int) i );
+        assert( estimates[i] >= counts[i] );
+        assert( i == 0 || estimates[i] <= estimates[i-1] );
+    }
+    assert( upo_cms_topk_items(topk, items, NULL) == NUM_HEAVY );
+
+    upo_cms_topk_destroy(topk);
+
+    /* A single tracked key is the most frequent one */
+    topk = upo_cms_topk_create(1, 2000, 4, upo_ht_hash_int_div, int_compare);
+    for (i = 0; i < stream_size; ++i)
+    {
+        upo_cms_topk_add(topk, &keys[stream[i]], 1);
+    }
+    assert( upo_cms_topk_items(topk, items, estimates) == 1 );
+    assert( *((int*) items[0]) == 0 );
+    upo_cms_topk_destroy(topk);
+}
+
+void test_topk_merge()
+{
+    pthread_t threads[NUM_THREADS];
+    struct part_s parts[NUM_THREADS];
+    void *items[NUM_HEAVY];
+    uint64_t estimates[NUM_HEAVY];
+    upo_cms_topk_t other = NULL;
+    size_t i = 0;
+
+    for (i = 0; i < NUM_THREADS; ++i)
+    {
+        parts[i].cms = NULL;
+        parts[i].topk = upo_cms_topk_create(NUM_HEAVY, 2000, 4, upo_ht_hash_int_div, int_compare);
+        parts[i].begin = i*stream_size/NUM_THREADS;
+        parts[i].end = (i + 1)*stream_size/NUM_THREADS;
+        assert( pthread_create(&threads[i], NULL, count_part, &parts[i]) == 0 );
+    }
+    for (i = 0; i < NUM_THREADS; ++i)
+    {
+        assert( pthread_join(threads[i], NULL) == 0 );
+    }
+    for (i = 1; i < NUM_THREADS; ++i)
+    {
+        assert( upo_cms_topk_merge(parts[0].topk, parts[i].topk) == 1 );
+        upo_cms_topk_destroy(parts[i].topk);
+    }
+
+    assert( upo_cms_topk_items(parts[0].topk, items, estimates) == NUM_HEAVY );
+    for (i = 0; i < NUM_HEAVY; ++i)
+    {
+        assert( *((int*) items[i]) == (int) i );
+        assert( estimates[i] >= counts[i] );
+    }
+
+    other = upo_cms_topk_create(NUM_HEAVY, 1000, 4, upo_ht_hash_int_div, int_compare);
+    assert( upo_cms_topk_merge(parts[0].topk, other) == 0 );
+    upo_cms_topk_destroy(other);
+
+    upo_cms_topk_destroy(parts[0].topk);
+}
+
+
+int main()
+{
+    srand(7);
+    make_stream();
+
+    printf("Test case 'create/destroy'... ");
+    fflush(stdout);
+    test_create_destroy();
+    printf("OK\n");
+
+    printf("Test case 'add/estimate'... ");
+    fflush(stdout);
+    test_add_estimate();
+    printf("OK\n");
+
+    printf("Test case 'merge'... ");
+    fflush(stdout);
+    test_merge();
+    printf("OK\n");
+
+    printf("Test case 'top-k'... ");
+    fflush(stdout);
+    test_topk();
+    printf("OK\n");
+
+    printf("Test case 'top-k merge'... ");
+    fflush(stdout);
+    test_topk_merge();
+    printf("OK\n");
+
+    free(stream);
+
+    return 0;
+}
@@ -0,0 +1,438 @@
+/*
+ * Copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ * This file is part of UPOalglib.
+ *
+ * UPOalglib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * UPOalglib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <upo/hamt.h>
+
+
+#define NUM_KEYS 5000
+#define NUM_VERSIONS 8
+#define MODEL_KEYS 300
+
+
+static int int_compare(const void *a, const void *b);
+static size_t const_hash(const void *key, size_t m);
+static void count_visit(void *key, void *value, void *info);
+static void check_model(upo_hamt_t hamt, int **model, int *keys);
+
+static void test_create_destroy();
+static void test_put_get_delete();
+static void test_snapshot();
+static void test_collisions();
+static void test_shape();
+static void test_versions();
+
+
+int int_compare(const void *a, const void *b)
+{
+    const int *aa = a;
+    const int *bb = b;
+
+    assert( a != NULL );
+    assert( b != NULL );
+
+    return (*aa > *bb) - (*aa < *bb);
+}
+
+// Hashes every key to the same value
+size_t const_hash(const void *key, size_t m)
+{
+    (void) key;
+
+    return 42 % m;
+}
+
+// Counts the visited pairs in the size_t given as info
+void count_visit(void *key, void *value, void *info)
+{
+    size_t *count = info;
+
+    assert( key != NULL );
+    assert( value != NULL );
+
+    (*count)++;
+}
+
+// Checks that the map holds exactly the pairs of the model (value pointers, or NULL for missing keys)
+void check_model(upo_hamt_t hamt, int **model, int *keys)
+{
+    size_t n = 0;
+    size_t i = 0;
+
+    for (i = 0; i < MODEL_KEYS; ++i)
+    {
+        assert( upo_hamt_get(hamt, &keys[i]) == model[i] );
+        if (model[i] != NULL)
+            ++n;
+    }
+    assert( upo_hamt_size(hamt) == n );
+}
+
+void test_create_destroy()
+{
+    upo_hamt_t hamt = upo_hamt_create(upo_ht_hash_int_div, int_compare);
+    int key = 1;
+
+    assert( hamt != NULL );
+    assert( upo_hamt_is_empty(hamt) );
+    assert( upo_hamt_size(hamt) == 0 );
+    assert( upo_hamt_depth(hamt) == 0 );
+    assert( upo_hamt_keys(hamt) == NULL );
+    assert( upo_hamt_get(hamt, &key) == NULL );
+    assert( upo_hamt_delete(hamt, &key) == 0 );
+    assert( upo_hamt_get_comparator(hamt) == int_compare );
+    assert( upo_hamt_get_hasher(hamt) == upo_ht_hash_int_div );
+
+    upo_hamt_destroy(hamt);
+
+    upo_hamt_destroy(NULL);
+    assert( upo_hamt_size(NULL) == 0 );
+    assert( upo_hamt_is_empty(NULL) );
+    assert( upo_hamt_depth(NULL) == 0 );
+    assert( upo_hamt_get(NULL, &key) == NULL );
+    assert( !upo_hamt_contains(NULL, &key) );
+    assert( upo_hamt_keys(NULL) == NULL );
+}
+
+void test_put_get_delete()
+{
+    static int keys[NUM_KEYS];
+    static int values[NUM_KEYS];
+    size_t i = 0;
+    size_t count = 0;
+    int missing = -1;
+    upo_ht_key_list_t list = NULL;
+    upo_hamt_t hamt = upo_hamt_create(upo_ht_hash_int_div, int_compare);
+
+    for (i = 0; i < NUM_KEYS; ++i)
+    {
+        keys[i] = (int) (7*i);
+        values[i] = (int) i;
+        assert( upo_hamt_put(hamt, &keys[i], &keys[i]) == NULL );
+        assert( upo_hamt_size(hamt) == i+1 );
+    }
+    /* Replacing values returns the old ones */
+    for (i = 0; i < NUM_KEYS; ++i)
+    {
+        assert( upo_hamt_put(hamt, &keys[i], &values[i]) == &keys[i] );
+    }
+    assert( upo_hamt_size(hamt) == NUM_KEYS );
+    for (i = 0; i < NUM_KEYS; ++i)
+    {
+        assert( upo_hamt_contains(hamt, &keys[i]) );
+        assert( *((int*) upo_hamt_get(hamt, &keys[i])) == (int) i );
+    }
+    assert( !upo_hamt_contains(hamt, &missing) );
+    assert( upo_hamt_delete(hamt, &missing) == 0 );
+
+    /* 5000 keys fit in 3 levels of 32-way nodes (plus a few deeper ones) */
+    assert( upo_hamt_depth(hamt) >= 2 && upo_hamt_depth(hamt) <= 5 );
+
+    upo_hamt_traverse(hamt, count_visit, &count);
+    assert( count == NUM_KEYS );
+    for (count = 0, list = upo_hamt_keys(hamt); list != NULL; ++count)
+    {
+        upo_ht_key_list_node_t *node = list;
+
+        assert( upo_hamt_contains(hamt, node->key) );
+        list = list->next;
+        free(node);
+    }
+    assert( count == NUM_KEYS );
+
+    for (i = 0; i < NUM_KEYS; i += 2)
+    {
+        assert( upo_hamt_delete(hamt, &keys[i]) == 1 );
+        assert( upo_hamt_delete(hamt, &keys[i]) == 0 );
+    }
+    assert( upo_hamt_size(hamt) == NUM_KEYS/2 );
+    for (i = 0; i < NUM_KEYS; ++i)
+    {
+        assert( upo_hamt_contains(hamt, &keys[i]) == (i % 2 == 1) );
+    }
+    for (i = 1; i < NUM_KEYS; i += 2)
+    {
+        assert( upo_hamt_delete(hamt, &keys[i]) == 1 );
+    }
+    assert( upo_hamt_is_empty(hamt) );
+    assert( upo_hamt_depth(hamt) == 0 );
+
+    upo_hamt_destroy(hamt);
+}
+
+void test_snapshot()
+{
+    static int keys[NUM_KEYS];
+    static int values[NUM_KEYS];
+    size_t i = 0;
+    upo_hamt_t hamt = upo_hamt_create(upo_ht_hash_int_div, int_compare);
+    upo_hamt_t snap = NULL;
+    upo_hamt_t snap2 = NULL;
+
+    for (i = 0; i < NUM_KEYS; ++i)
+    {
+        keys[i] = (int) i;
+        values[i] = -((int) i);
+        upo_hamt_put(hamt, &keys[i], &keys[i]);
+    }
+
+    snap = upo_hamt_snapshot(hamt);
+    assert( upo_hamt_size(snap) == NUM_KEYS );
+
+    /* Updates of the map do not show in the snapshot */
+    for (i = 0; i < NUM_KEYS; i += 3)
+    {
+        upo_hamt_put(hamt, &keys[i], &values[i]);
+    }
+    for (i = 1; i < NUM_KEYS; i += 3)
+    {
+        assert( upo_hamt_delete(hamt, &keys[i]) == 1 );
+    }
+    assert( upo_hamt_size(hamt) == NUM_KEYS - (NUM_KEYS + 1)/3 );
+    assert( upo_hamt_size(snap) == NUM_KEYS );
+    for (i = 0; i < NUM_KEYS; ++i)
+    {
+        assert( upo_hamt_get(snap, &keys[i]) == &keys[i] );
+        if (i % 3 == 0)
+            assert( upo_hamt_get(hamt, &keys[i]) == &values[i] );
+        else if (i % 3 == 1)
+            assert( upo_hamt_get(hamt, &keys[i]) == NULL );
+        else
+            assert( upo_hamt_get(hamt, &keys[i]) == &keys[i] );
+    }
+
+    /* Nor do updates of the snapshot show in the map */
+    snap2 = upo_hamt_snapshot(snap);
+    for (i = 0; i < NUM_KEYS; i += 3)
+    {
+        assert( upo_hamt_delete(snap, &keys[i]) == 1 );
+    }
+    for (i = 0; i < NUM_KEYS; ++i)
+    {
+        assert( upo_hamt_contains(snap, &keys[i]) == (i % 3 != 0) );
+        assert( upo_hamt_contains(hamt, &keys[i]) == (i % 3 != 1) );
+        assert( upo_hamt_get(snap2, &keys[i]) == &keys[i] );
+    }
+
+    /* Versions may be destroyed in any order */
+    upo_hamt_destroy(snap);
+    for (i = 0; i < NUM_KEYS; ++i)
+    {
+        assert( upo_hamt_get(snap2, &keys[i]) == &keys[i] );
+    }
+    upo_hamt_destroy(hamt);
+    assert( upo_hamt_size(snap2) == NUM_KEYS );
+    upo_hamt_destroy(snap2);
+}
+
+void test_collisions()
+{
+    int keys[50];
+    size_t i = 0;
+    size_t count = 0;
+    int missing = -1;
+    upo_hamt_t hamt = upo_hamt_create(const_hash, int_compare);
+    upo_hamt_t snap = NULL;
+
+    /* All keys have the same hash value and end up in one collision node */
+    for (i = 0; i < 50; ++i)
+    {
+        keys[i] = (int) i;
+        assert( upo_hamt_put(hamt, &keys[i], &keys[i]) == NULL );
+    }
+    assert( upo_hamt_size(hamt) == 50 );
+    assert( upo_hamt_depth(hamt) == 13 );
+    assert( upo_hamt_put(hamt, &keys[10], &keys[11]) == &keys[10] );
+    for (i = 0; i < 50; ++i)
+    {
+        assert( upo_hamt_get(hamt, &keys[i]) == &keys[i == 10 ? 11 : i] );
+    }
+    assert( !upo_hamt_contains(hamt, &missing) );
+
+    snap = upo_hamt_snapshot(hamt);
+    for (i = 0; i < 49; ++i)
+    {
+        assert( upo_hamt_delete(hamt, &keys[i]) == 1 );
+    }
+    assert( upo_hamt_delete(hamt, &missing) == 0 );
+    assert( upo_hamt_size(hamt) == 1 );
+    assert( upo_hamt_get(hamt, &keys[49]) == &keys[49] );
+
+    /* The last pair has been merged back into the root */
+    assert( upo_hamt_depth(hamt) == 0 );
+
+    upo_hamt_traverse(snap, count_visit, &count);
+    assert( count == 50 );
+    upo_hamt_destroy(snap);
+    upo_hamt_destroy(hamt);
+}
+
+void test_shape()
+{
+    static int keys[NUM_KEYS];
+    size_t i = 0;
+    size_t depth = 0;
+    upo_hamt_t hamt = upo_hamt_create(upo_ht_hash_int_div, int_compare);
+
+    for (i = 0; i < NUM_KEYS; ++i)
+    {
+        keys[i] = (int) i;
+        upo_hamt_put(hamt, &keys[i], &keys[i]);
+    }
+    for (i = 0; i < 32; ++i)
+    {
+        upo_hamt_delete(hamt, &keys[i]);
+    }
+    depth = upo_hamt_depth(hamt);
+
+    /* Removing and adding back keys leaves the same trie */
+    for (i = 0; i < 32; ++i)
+    {
+        upo_hamt_put(hamt, &keys[i], &keys[i]);
+    }
+    for (i = 0; i < 32; ++i)
+    {
+        upo_hamt_delete(hamt, &keys[i]);
+    }
+    assert( upo_hamt_depth(hamt) == depth );
+
+    /* A single pair stays in the root */
+    for (i = 33; i < NUM_KEYS; ++i)
+    {
+        upo_hamt_delete(hamt, &keys[i]);
+    }
+    assert( upo_hamt_size(hamt) == 1 );
+    assert( upo_hamt_depth(hamt) == 0 );
+    assert( upo_hamt_get(hamt, &keys[32]) == &keys[32] );
+
+    upo_hamt_destroy(hamt);
+}
+
+void test_versions()
+{
+    static int keys[MODEL_KEYS];
+    static int values[MODEL_KEYS];
+    static int *models[NUM_VERSIONS][MODEL_KEYS];
+    upo_hamt_t versions[NUM_VERSIONS];
+    size_t i = 0;
+    size_t v = 0;
+    size_t step = 0;
+
+    srand(17);
+
+    for (i = 0; i < MODEL_KEYS; ++i)
+    {
+        keys[i] = (int) (i*i);
+        values[i] = (int) i;
+    }
+    for (v = 0; v < NUM_VERSIONS; ++v)
+    {
+        versions[v] = upo_hamt_create(upo_ht_hash_int_div, int_compare);
+        for (i = 0; i < MODEL_KEYS; ++i)
+        {
+            models[v][i] = NULL;
+        }
+    }
+
+    /* Random updates of random versions, some of which are replaced by snapshots of others */
+    for (step = 0; step < 20000; ++step)
+    {
+        size_t k = (size_t) rand() % MODEL_KEYS;
+        int op = rand() % 10;
+
+        v = (size_t) rand() % NUM_VERSIONS;
+        if (op < 5)
+        {
+            int *value = (rand() % 2) ? &keys[k] : &values[k];
+
+            assert( upo_hamt_put(versions[v], &keys[k], value) == models[v][k] );
+            models[v][k] = value;
+        }
+        else if (op < 9)
+        {
+            assert( upo_hamt_delete(versions[v], &keys[k]) == (models[v][k] != NULL) );
+            models[v][k] = NULL;
+        }
+        else
+        {
+            size_t w = (size_t) rand() % NUM_VERSIONS;
+
+            if (w != v)
+            {
+                upo_hamt_destroy(versions[w]);
+                versions[w] = upo_hamt_snapshot(versions[v]);
+                for (i = 0; i < MODEL_KEYS; ++i)
+                {
+                    models[w][i] = models[v][i];
+                }
+            }
+        }
+        if (step % 500 == 0)
+        {
+            for (i = 0; i < NUM_VERSIONS; ++i)
+            {
+                check_model(versions[i], models[i], keys);
+            }
+        }
+    }
+    for (v = 0; v < NUM_VERSIONS; ++v)
+    {
+        check_model(versions[v], models[v], keys);
+        upo_hamt_destroy(versions[v]);
+    }
+}
+
+
+int main()
+{
+    printf("Test case 'create/destroy'... ");
+    fflush(stdout);
+    test_create_destroy();
+    printf("OK\n");
+
+    printf("Test case 'put/get/delete'... ");
+    fflush(stdout);
+    test_put_get_delete();
+    printf("OK\n");
+
+    printf("Test case 'snapshot'... ");
+    fflush(stdout);
+    test_snapshot();
+    printf("OK\n");
+
+    printf("Test case 'collisions'... ");
+    fflush(stdout);
+    test_collisions();
+    printf("OK\n");
+
+    printf("Test case 'shape'... ");
+    fflush(stdout);
+    test_shape();
+    printf("OK\n");
+
+    printf("Test case 'versions'... ");
+    fflush(stdout);
+    test_versions();
+    printf("OK\n");
+
+    return 0;
+}
@@ -0,0 +1,548 @@
+/*
+ * Copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ * This file is part of UPOalglib.
+ *
+ * UPOalglib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * UPOalglib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <upo/hashset.h>
+
+
+static int int_compare(const void *a, const void *b);
+static void count_key_visit(void *key, void *info);
+
+static void test_create_destroy();
+static void test_insert_contains_delete();
+static void test_clear();
+static void test_resize();
+static void test_keys_traverse();
+static void test_union();
+static void test_intersection();
+static void test_difference();
+static void test_null();
+static void test_churn();
+
+
+int int_compare(const void *a, const void *b)
+{
+    const int *aa = a;
+    const int *bb = b;
+
+    assert( a != NULL );
+    assert( b != NULL );
+
+    return (*aa > *bb) - (*aa < *bb);
+}
+
+void count_key_visit(void *key, void *info)
+{
+    size_t *counter = info;
+
+    assert( info != NULL );
+
+    if (key != NULL)
+    {
+        *counter += 1;
+    }
+}
+
+void test_create_destroy()
+{
+    upo_hs_t hs;
+
+    hs = upo_hs_create(UPO_HS_DEFAULT_CAPACITY, upo_ht_hash_int_div, int_compare);
+
+    assert( hs != NULL );
+    assert( upo_hs_is_empty(hs) );
+    assert( upo_hs_capacity(hs) == UPO_HS_DEFAULT_CAPACITY );
+    assert( upo_hs_get_hasher(hs) == upo_ht_hash_int_div );
+    assert( upo_hs_get_comparator(hs) == int_compare );
+
+    upo_hs_destroy(hs, 0);
+
+    hs = upo_hs_create(0, upo_ht_hash_int_div, int_compare);
+
+    assert( hs != NULL );
+
+    upo_hs_destroy(hs, 1);
+}
+
+void test_insert_contains_delete()
+{
+    int keys1[] = {0,1,2,3,4,5,6,7,8,9};
+    int keys2[] = {0,16,32,48,64,80,96,112,128,144};
+    int missing[] = {10,11,160,176};
+    int *sets[] = {keys1, keys2};
+    size_t n = sizeof keys1/sizeof keys1[0];
+    size_t i = 0;
+    size_t k = 0;
+
+    /* First set: no collision; second set: all collisions */
+    for (k = 0; k < sizeof sets/sizeof sets[0]; ++k)
+    {
+        int *keys = sets[k];
+        upo_hs_t hs = upo_hs_create(UPO_HS_DEFAULT_CAPACITY, upo_ht_hash_int_div, int_compare);
+
+        assert( hs != NULL );
+
+        /* Insertion */
+        for (i = 0; i < n; ++i)
+        {
+            assert( upo_hs_insert(hs, &keys[i]) == 1 );
+        }
+        assert( upo_hs_size(hs) == n );
+
+        /* Duplicates */
+        for (i = 0; i < n; ++i)
+        {
+            int dup = keys[i];
+
+            assert( upo_hs_insert(hs, &dup) == 0 );
+        }
+        assert( upo_hs_size(hs) == n );
+
+        /* Search */
+        for (i = 0; i < n; ++i)
+        {
+            assert( upo_hs_contains(hs, &keys[i]) );
+        }
+        for (i = 0; i < sizeof missing/sizeof missing[0]; ++i)
+        {
+            assert( !upo_hs_contains(hs, &missing[i]) );
+        }
+
+        /* Removal of every other key */
+        for (i = 0; i < n; i += 2)
+        {
+            upo_hs_delete(hs, &keys[i], 0);
+        }
+        assert( upo_hs_size(hs) == n/2 );
+        for (i = 0; i < n; ++i)
+        {
+            assert( upo_hs_contains(hs, &keys[i]) == (i % 2 == 1) );
+        }
+
+        /* Removal of missing keys */
+        for (i = 0; i < sizeof missing/sizeof missing[0]; ++i)
+        {
+            upo_hs_delete(hs, &missing[i], 0);
+        }
+        assert( upo_hs_size(hs) == n/2 );
+
+        /* Reinsertion reuses deleted slots */
+        for (i = 0; i < n; i += 2)
+        {
+            assert( upo_hs_insert(hs, &keys[i]) == 1 );
+        }
+        for (i = 0; i < n; ++i)
+        {
+            assert( upo_hs_contains(hs, &keys[i]) );
+        }
+
+        upo_hs_destroy(hs, 0);
+    }
+}
+
+void test_clear()
+{
+    int keys[] = {0,1,2,3,4,10,11,12,13,14};
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t i = 0;
+    upo_hs_t hs;
+
+    hs = upo_hs_create(UPO_HS_DEFAULT_CAPACITY, upo_ht_hash_int_div, int_compare);
+
+    /* Without malloc */
+    for (i = 0; i < n; ++i)
+    {
+        upo_hs_insert(hs, &keys[i]);
+    }
+    assert( !upo_hs_is_empty(hs) );
+
+    upo_hs_clear(hs, 0);
+
+    assert( upo_hs_is_empty(hs) );
+
+    /* With malloc */
+    for (i = 0; i < n; ++i)
+    {
+        int *key = malloc(sizeof(int));
+        *key = keys[i];
+
+        upo_hs_insert(hs, key);
+    }
+    assert( upo_hs_size(hs) == n );
+
+    upo_hs_clear(hs, 1);
+
+    assert( upo_hs_is_empty(hs) );
+
+    upo_hs_destroy(hs, 1);
+}
+
+void test_resize()
+{
+    int keys[100];
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t i = 0;
+    upo_hs_t hs;
+
+    hs = upo_hs_create(1, upo_ht_hash_int_div, int_compare);
+
+    for (i = 0; i < n; ++i)
+    {
+        keys[i] = (int) i;
+        upo_hs_insert(hs, &keys[i]);
+
+        assert( upo_hs_size(hs) <= upo_hs_capacity(hs) );
+    }
+    for (i = 0; i < n; ++i)
+    {
+        assert( upo_hs_contains(hs, &keys[i]) );
+    }
+    for (i = 0; i < n; ++i)
+    {
+        upo_hs_delete(hs, &keys[i], 0);
+
+        assert( upo_hs_size(hs) <= upo_hs_capacity(hs) );
+        assert( !upo_hs_contains(hs, &keys[i]) );
+    }
+    assert( upo_hs_is_empty(hs) );
+    assert( upo_hs_capacity(hs) < n );
+
+    upo_hs_destroy(hs, 0);
+}
+
+void test_keys_traverse()
+{
+    int keys[] = {0,1,2,3,4,10,11,12,13,14};
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t i = 0;
+    size_t counter = 0;
+    upo_hs_t hs;
+    upo_ht_key_list_t key_list;
+
+    hs = upo_hs_create(UPO_HS_DEFAULT_CAPACITY, upo_ht_hash_int_div, int_compare);
+
+    assert( upo_hs_keys(hs) == NULL );
+
+    upo_hs_traverse(hs, count_key_visit, &counter);
+    assert( counter == 0 );
+
+    for (i = 0; i < n; ++i)
+    {
+        upo_hs_insert(hs, &keys[i]);
+    }
+
+    key_list = upo_hs_keys(hs);
+    for (i = 0; i < n; ++i)
+    {
+        upo_ht_key_list_node_t *node = NULL;
+
+        for (node = key_list;
+             node != NULL && int_compare(&keys[i], node->key) != 0;
+             node = node->next)
+        {
+            ; /* empty */
+        }
+        assert( node != NULL );
+    }
+    while (key_list != NULL)
+    {
+        upo_ht_key_list_t tmp = key_list;
+        key_list = key_list->next;
+        free(tmp);
+    }
+
+    upo_hs_traverse(hs, count_key_visit, &counter);
+    assert( counter == n );
+
+    upo_hs_destroy(hs, 0);
+}
+
+void test_union()
+{
+    int keys1[] = {0,1,2,3,4,16,32};
+    int keys2[] = {3,4,5,6,7,48,64,80};
+    int dups[] = {3,4};
+    size_t n1 = sizeof keys1/sizeof keys1[0];
+    size_t n2 = sizeof keys2/sizeof keys2[0];
+    size_t i = 0;
+    upo_hs_t a;
+    upo_hs_t b;
+    upo_hs_t u;
+
+    a = upo_hs_create(UPO_HS_DEFAULT_CAPACITY, upo_ht_hash_int_div, int_compare);
+    b = upo_hs_create(UPO_HS_DEFAULT_CAPACITY, upo_ht_hash_int_div, int_compare);
+
+    for (i = 0; i < n1; ++i)
+    {
+        upo_hs_insert(a, &keys1[i]);
+    }
+    /* Leave a tombstone in the first set */
+    upo_hs_delete(a, &keys1[n1-1], 0);
+    for (i = 0; i < n2; ++i)
+    {
+        upo_hs_insert(b, &keys2[i]);
+    }
+
+    u = upo_hs_union(a, b);
+
+    assert( upo_hs_size(u) == n1 - 1 + n2 - sizeof dups/sizeof dups[0] );
+    for (i = 0; i < n1-1; ++i)
+    {
+        assert( upo_hs_contains(u, &keys1[i]) );
+    }
+    for (i = 0; i < n2; ++i)
+    {
+        assert( upo_hs_contains(u, &keys2[i]) );
+    }
+    assert( !upo_hs_contains(u, &keys1[n1-1]) );
+    assert( upo_hs_load_factor(u) <= 0.5 );
+
+    /* The inputs are left untouched */
+    assert( upo_hs_size(a) == n1-1 );
+    assert( upo_hs_size(b) == n2 );
+
+    upo_hs_destroy(u, 0);
+
+    /* Union with an empty set */
+    upo_hs_clear(b, 0);
+    u = upo_hs_union(b, a);
+    assert( upo_hs_size(u) == upo_hs_size(a) );
+    upo_hs_destroy(u, 0);
+
+    upo_hs_destroy(a, 0);
+    upo_hs_destroy(b, 0);
+}
+
+void test_intersection()
+{
+    int keys1[] = {0,1,2,3,4,16,32};
+    int keys2[] = {3,4,5,16,48,64,80,96};
+    int common[] = {3,4,16};
+    size_t n1 = sizeof keys1/sizeof keys1[0];
+    size_t n2 = sizeof keys2/sizeof keys2[0];
+    size_t nc = sizeof common/sizeof common[0];
+    size_t i = 0;
+    upo_hs_t a;
+    upo_hs_t b;
+    upo_hs_t r;
+    upo_ht_key_list_t key_list;
+
+    a = upo_hs_create(UPO_HS_DEFAULT_CAPACITY, upo_ht_hash_int_div, int_compare);
+    b = upo_hs_create(UPO_HS_DEFAULT_CAPACITY, upo_ht_hash_int_div, int_compare);
+
+    for (i = 0; i < n1; ++i)
+    {
+        upo_hs_insert(a, &keys1[i]);
+    }
+    for (i = 0; i < n2; ++i)
+    {
+        upo_hs_insert(b, &keys2[i]);
+    }
+
+    /* Both when the first set is the smaller and when it is the larger one */
+    r = upo_hs_intersection(a, b);
+    assert( upo_hs_size(r) == nc );
+    for (i = 0; i < nc; ++i)
+    {
+        assert( upo_hs_contains(r, &common[i]) );
+    }
+    upo_hs_destroy(r, 0);
+
+    r = upo_hs_intersection(b, a);
+    assert( upo_hs_size(r) == nc );
+    /* Keys are the ones of the first set */
+    for (key_list = upo_hs_keys(r); key_list != NULL; )
+    {
+        upo_ht_key_list_t tmp = key_list;
+
+        assert( (int*) key_list->key >= keys2 && (int*) key_list->key < keys2 + n2 );
+
+        key_list = key_list->next;
+        free(tmp);
+    }
+    upo_hs_destroy(r, 0);
+
+    /* Disjoint sets */
+    upo_hs_clear(b, 0);
+    upo_hs_insert(b, &keys2[n2-1]);
+    r = upo_hs_intersection(a, b);
+    assert( upo_hs_is_empty(r) );
+    upo_hs_destroy(r, 0);
+
+    upo_hs_destroy(a, 0);
+    upo_hs_destroy(b, 0);
+}
+
+void test_difference()
+{
+    int keys1[] = {0,1,2,3,4,16,32};
+    int keys2[] = {3,4,5,16,48};
+    int diff[] = {0,1,2,32};
+    size_t n1 = sizeof keys1/sizeof keys1[0];
+    size_t n2 = sizeof keys2/sizeof keys2[0];
+    size_t nd = sizeof diff/sizeof diff[0];
+    size_t i = 0;
+    upo_hs_t a;
+    upo_hs_t b;
+    upo_hs_t r;
+
+    a = upo_hs_create(UPO_HS_DEFAULT_CAPACITY, upo_ht_hash_int_div, int_compare);
+    b = upo_hs_create(UPO_HS_DEFAULT_CAPACITY, upo_ht_hash_int_div, int_compare);
+
+    for (i = 0; i < n1; ++i)
+    {
+        upo_hs_insert(a, &keys1[i]);
+    }
+    for (i = 0; i < n2; ++i)
+    {
+        upo_hs_insert(b, &keys2[i]);
+    }
+
+    r = upo_hs_difference(a, b);
+    assert( upo_hs_size(r) == nd );
+    for (i = 0; i < nd; ++i)
+    {
+        assert( upo_hs_contains(r, &diff[i]) );
+    }
+    for (i = 0; i < n2; ++i)
+    {
+        assert( !upo_hs_contains(r, &keys2[i]) );
+    }
+    upo_hs_destroy(r, 0);
+
+    r = upo_hs_difference(a, a);
+    assert( upo_hs_is_empty(r) );
+    upo_hs_destroy(r, 0);
+
+    upo_hs_destroy(a, 0);
+    upo_hs_destroy(b, 0);
+}
+
+void test_null()
+{
+    upo_hs_t hs = NULL;
+
+    assert( upo_hs_size(hs) == 0 );
+    assert( upo_hs_is_empty(hs) );
+    assert( !upo_hs_contains(hs, NULL) );
+    assert( upo_hs_keys(hs) == NULL );
+
+    upo_hs_clear(hs, 0);
+    upo_hs_delete(hs, NULL, 0);
+    upo_hs_destroy(hs, 0);
+}
+
+void test_churn()
+{
+    int keys[1000];
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t live = 20;
+    size_t m = 64;
+    size_t i = 0;
+    upo_hs_t hs;
+
+    for (i = 0; i < n; ++i)
+    {
+        keys[i] = (int) (7*i);
+    }
+
+    hs = upo_hs_create(m, upo_ht_hash_int_div, int_compare);
+
+    for (i = 0; i < live; ++i)
+    {
+        upo_hs_insert(hs, &keys[i]);
+    }
+
+    /* The size stays constant, thus tombstones must be purged in place */
+    for (i = live; i < n; ++i)
+    {
+        upo_hs_delete(hs, &keys[i-live], 0);
+        assert( upo_hs_insert(hs, &keys[i]) == 1 );
+
+        assert( upo_hs_capacity(hs) == m );
+        assert( upo_hs_size(hs) == live );
+    }
+
+    for (i = 0; i < n; ++i)
+    {
+        assert( upo_hs_contains(hs, &keys[i]) == (i >= n-live) );
+    }
+
+    upo_hs_destroy(hs, 0);
+}
+
+
+int main()
+{
+    printf("Test case 'create/destroy'... ");
+    fflush(stdout);
+    test_create_destroy();
+    printf("OK\n");
+
+    printf("Test case 'insert/contains/delete'... ");
+    fflush(stdout);
+    test_insert_contains_delete();
+    printf("OK\n");
+
+    printf("Test case 'clear'... ");
+    fflush(stdout);
+    test_clear();
+    printf("OK\n");
+
+    printf("Test case 'resize'... ");
+    fflush(stdout);
+    test_resize();
+    printf("OK\n");
+
+    printf("Test case 'keys/traverse'... ");
+    fflush(stdout);
+    test_keys_traverse();
+    printf("OK\n");
+
+    printf("Test case 'union'... ");
+    fflush(stdout);
+    test_union();
+    printf("OK\n");
+
+    printf("Test case 'intersection'... ");
+    fflush(stdout);
+    test_intersection();
+    printf("OK\n");
+
+    printf("Test case 'difference'... ");
+    fflush(stdout);
+    test_difference();
+    printf("OK\n");
+
+    printf("Test case 'null'... ");
+    fflush(stdout);
+    test_null();
+    printf("OK\n");
+
+    printf("Test case 'churn'... ");
+    fflush(stdout);
+    test_churn();
+    printf("OK\n");
+
+
+    return 0;
+}
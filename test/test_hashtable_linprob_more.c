@@ -35,8 +35,29 @@ static void int_key_value_print(void *key, void *value, void *info);
 #endif // UPO_DEBUG
 static void count_key_visit(void *key, void *value, void *info);
 
+static void* compute_update(const void *key, void *value, void *info);
+
+static int is_multiple(const void *key, const void *value, void *info);
+
+static size_t int_value_size(const void *key, const void *value, void *info);
+static unsigned long int_key_rank(const void *key, const void *value, void *info);
+static void mark_key_visit(void *key, void *value, void *info);
+
 static void test_keys();
 static void test_traverse();
+static void test_stats();
+static void test_tombstones();
+static void test_layouts();
+static void test_layout_tombstones();
+static void test_generations();
+static void test_get_or_insert();
+static void test_compute();
+static void test_retain();
+static void test_small();
+static void test_probes();
+static void test_budget();
+static void test_scan();
+static void test_parallel_rehash();
 
 
 int int_compare(const void *a, const void *b)
@@ -89,6 +110,62 @@ void count_key_visit(void *key, void *value, void *info)
     }
 }
 
+void* compute_update(const void *key, void *value, void *info)
+{
+    (void) key;
+    (void) value;
+
+    /* The new value is the additional parameter (NULL removes the key) */
+    return info;
+}
+
+int is_multiple(const void *key, const void *value, void *info)
+{
+    const int *ikey = key;
+    const int *divisor = info;
+
+    assert( key != NULL );
+    assert( info != NULL );
+
+    (void) value;
+
+    return (*ikey % *divisor) == 0;
+}
+
+// Sizes the data of a pair as the int value (or as nothing for NULL values)
+size_t int_value_size(const void *key, const void *value, void *info)
+{
+    assert( key != NULL );
+
+    (void) info;
+
+    return (value != NULL) ? (size_t) *((const int*) value) : 0;
+}
+
+// Ranks a pair by its int key, so that the smallest key is evicted first
+unsigned long int_key_rank(const void *key, const void *value, void *info)
+{
+    assert( key != NULL );
+
+    (void) value;
+    (void) info;
+
+    return (unsigned long) *((const int*) key);
+}
+
+// Counts the visits of each int key in the array passed as additional parameter
+void mark_key_visit(void *key, void *value, void *info)
+{
+    size_t *seen = info;
+
+    assert( key != NULL );
+    assert( info != NULL );
+
+    (void) value;
+
+    seen[*((const int*) key)] += 1;
+}
+
 void test_keys()
 {
     int keys1[] = {0,1,2,3,4,5,6,7,8,9};
@@ -370,6 +447,1105 @@ void test_traverse()
     upo_ht_linprob_destroy(ht, 0);
 }
 
+void test_stats()
+{
+    int keys[] = {0,16,32,5,1,2,3,4,6,7,8,9};
+    int values[] = {0,1,2,3,4,5,6,7,8,9,10,11};
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t i = 0;
+    upo_ht_linprob_t ht = NULL;
+    upo_ht_stats_t stats;
+
+    ht = upo_ht_linprob_create(UPO_HT_LINPROB_DEFAULT_CAPACITY, upo_ht_hash_int_div, int_compare);
+
+    assert( ht != NULL );
+
+    /* Statistics disabled: only structural fields */
+    upo_ht_linprob_put(ht, &keys[0], &values[0]);
+    upo_ht_linprob_stats(ht, &stats);
+    assert( stats.capacity == UPO_HT_LINPROB_DEFAULT_CAPACITY );
+    assert( stats.size == 1 );
+    assert( stats.histogram[0] == 1 );
+    assert( stats.hash_calls == 0 );
+    assert( stats.cmp_calls == 0 );
+
+    upo_ht_linprob_enable_stats(ht);
+
+    /* Keys 0, 16 and 32 share the same home slot */
+    for (i = 1; i < 4; ++i)
+    {
+        upo_ht_linprob_put(ht, &keys[i], &values[i]);
+    }
+    upo_ht_linprob_stats(ht, &stats);
+    assert( stats.size == 4 );
+    assert( stats.histogram[0] == 2 );
+    assert( stats.histogram[1] == 1 );
+    assert( stats.histogram[2] == 1 );
+    assert( stats.longest_cluster == 3 );
+    assert( stats.tombstones == 0 );
+    assert( stats.hash_calls == 3 );
+    assert( stats.cmp_calls > 0 );
+    assert( stats.resizes == 0 );
+
+    /* Deletion leaves a tombstone inside the cluster */
+    upo_ht_linprob_delete(ht, &keys[1], 0);
+    upo_ht_linprob_stats(ht, &stats);
+    assert( stats.size == 3 );
+    assert( stats.tombstones == 1 );
+    assert( stats.longest_cluster == 3 );
+    assert( stats.hash_calls == 4 );
+
+    /* Growing triggers a resize */
+    for (i = 4; i < n; ++i)
+    {
+        upo_ht_linprob_put(ht, &keys[i], &values[i]);
+    }
+    upo_ht_linprob_stats(ht, &stats);
+    assert( stats.size == n-1 );
+    assert( stats.resizes == 1 );
+    assert( stats.resize_time >= 0 );
+    assert( stats.hash_calls > n );
+#ifdef UPO_DEBUG
+    upo_ht_stats_print(&stats, stderr);
+#endif // UPO_DEBUG
+
+    upo_ht_linprob_disable_stats(ht);
+    upo_ht_linprob_stats(ht, &stats);
+    assert( stats.size == n-1 );
+    assert( stats.hash_calls == 0 );
+    assert( stats.resizes == 0 );
+
+    upo_ht_linprob_destroy(ht, 0);
+
+    /* Empty and NULL hash tables */
+    ht = upo_ht_linprob_create(UPO_HT_LINPROB_DEFAULT_CAPACITY, upo_ht_hash_int_div, int_compare);
+    upo_ht_linprob_enable_stats(ht);
+    upo_ht_linprob_stats(ht, &stats);
+    assert( stats.size == 0 );
+    assert( stats.longest_cluster == 0 );
+    upo_ht_linprob_destroy(ht, 0);
+
+    upo_ht_linprob_stats(NULL, &stats);
+    assert( stats.capacity == 0 );
+}
+
+void test_tombstones()
+{
+    int keys[1000];
+    int values[1000];
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t live = 20;
+    size_t m = 64;
+    size_t i = 0;
+    upo_ht_linprob_t ht = NULL;
+    upo_ht_stats_t stats;
+
+    for (i = 0; i < n; ++i)
+    {
+        keys[i] = (int) (7*i);
+        values[i] = (int) i;
+    }
+
+    ht = upo_ht_linprob_create(m, upo_ht_hash_int_div, int_compare);
+
+    assert( ht != NULL );
+
+    for (i = 0; i < live; ++i)
+    {
+        upo_ht_linprob_put(ht, &keys[i], &values[i]);
+    }
+
+    /* Churn: the size stays constant, thus the hash table never resizes, and
+     * tombstones must be purged in place */
+    for (i = live; i < n; ++i)
+    {
+        upo_ht_linprob_delete(ht, &keys[i-live], 0);
+        upo_ht_linprob_put(ht, &keys[i], &values[i]);
+
+        upo_ht_linprob_stats(ht, &stats);
+        assert( stats.capacity == m );
+        assert( stats.size == live );
+        assert( stats.tombstones <= m/4 );
+        assert( upo_ht_linprob_get(ht, &keys[i-live/2]) == &values[i-live/2] );
+    }
+
+    for (i = 0; i < n; ++i)
+    {
+        int *value = upo_ht_linprob_get(ht, &keys[i]);
+
+        if (i < n-live)
+        {
+            assert( value == NULL );
+        }
+        else
+        {
+            assert( value != NULL && *value == values[i] );
+        }
+    }
+
+    /* Clearing also removes tombstones */
+    upo_ht_linprob_delete(ht, &keys[n-1], 0);
+    upo_ht_linprob_clear(ht, 0);
+    upo_ht_linprob_stats(ht, &stats);
+    assert( stats.tombstones == 0 );
+    assert( stats.longest_cluster == 0 );
+
+    upo_ht_linprob_destroy(ht, 0);
+}
+
+void test_layouts()
+{
+    upo_ht_linprob_layout_t layouts[] = {UPO_HT_LINPROB_LAYOUT_SOA_FP8, UPO_HT_LINPROB_LAYOUT_SOA_FP16};
+    int keys[500];
+    int values[500];
+    int missing = 0;
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t j = 0;
+
+    for (j = 0; j < n; ++j)
+    {
+        keys[j] = (int) (3*j);
+        values[j] = (int) j;
+    }
+
+    for (j = 0; j < sizeof layouts/sizeof layouts[0]; ++j)
+    {
+        upo_ht_linprob_t ht = upo_ht_linprob_create(UPO_HT_LINPROB_DEFAULT_CAPACITY, upo_ht_hash_int_div, int_compare);
+        upo_ht_stats_t stats;
+        size_t count = 0;
+        size_t i = 0;
+
+        assert( ht != NULL );
+        assert( upo_ht_linprob_get_layout(ht) == UPO_HT_LINPROB_LAYOUT_AOS );
+
+        /* Convert a non-empty table */
+        for (i = 0; i < n/2; ++i)
+        {
+            upo_ht_linprob_put(ht, &keys[i], &values[i]);
+        }
+        upo_ht_linprob_set_layout(ht, layouts[j]);
+        assert( upo_ht_linprob_get_layout(ht) == layouts[j] );
+        assert( upo_ht_linprob_size(ht) == n/2 );
+
+        /* Insert the remaining keys, resizing the table */
+        for (i = n/2; i < n; ++i)
+        {
+            upo_ht_linprob_insert(ht, &keys[i], &values[i]);
+        }
+        assert( upo_ht_linprob_put(ht, &keys[0], &values[1]) == &values[0] );
+        assert( upo_ht_linprob_put(ht, &keys[0], &values[0]) == &values[1] );
+
+        for (i = 0; i < n; ++i)
+        {
+            assert( upo_ht_linprob_get(ht, &keys[i]) == &values[i] );
+        }
+
+        /* Missing keys are mostly filtered out by fingerprints */
+        upo_ht_linprob_enable_stats(ht);
+        for (missing = 1; missing < 300; missing += 3)
+        {
+            assert( !upo_ht_linprob_contains(ht, &missing) );
+        }
+        upo_ht_linprob_stats(ht, &stats);
+        assert( stats.cmp_calls < 100 );
+        upo_ht_linprob_disable_stats(ht);
+
+        /* Delete keys, leaving tombstones (and shrinking the table) */
+        for (i = 0; i < n; i += 2)
+        {
+            upo_ht_linprob_delete(ht, &keys[i], 0);
+        }
+        for (i = 0; i < n; ++i)
+        {
+            assert( upo_ht_linprob_get(ht, &keys[i]) == ((i % 2) ? &values[i] : NULL) );
+        }
+        upo_ht_linprob_traverse(ht, count_key_visit, &count);
+        assert( count == n/2 );
+
+        /* Back to the default layout */
+        upo_ht_linprob_set_layout(ht, UPO_HT_LINPROB_LAYOUT_AOS);
+        upo_ht_linprob_stats(ht, &stats);
+        assert( stats.size == n/2 );
+        for (i = 0; i < n; ++i)
+        {
+            assert( upo_ht_linprob_get(ht, &keys[i]) == ((i % 2) ? &values[i] : NULL) );
+        }
+
+        upo_ht_linprob_destroy(ht, 0);
+    }
+}
+
+void test_layout_tombstones()
+{
+    int keys[1000];
+    int values[1000];
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t live = 20;
+    size_t m = 64;
+    size_t i = 0;
+    upo_ht_linprob_t ht = NULL;
+    upo_ht_stats_t stats;
+
+    for (i = 0; i < n; ++i)
+    {
+        keys[i] = (int) (7*i);
+        values[i] = (int) i;
+    }
+
+    ht = upo_ht_linprob_create(m, upo_ht_hash_int_div, int_compare);
+    upo_ht_linprob_set_layout(ht, UPO_HT_LINPROB_LAYOUT_SOA_FP8);
+
+    for (i = 0; i < live; ++i)
+    {
+        upo_ht_linprob_put(ht, &keys[i], &values[i]);
+    }
+
+    /* Churn: tombstones are purged in place also in the structure-of-arrays
+     * layout */
+    for (i = live; i < n; ++i)
+    {
+        upo_ht_linprob_delete(ht, &keys[i-live], 0);
+        upo_ht_linprob_put(ht, &keys[i], &values[i]);
+
+        upo_ht_linprob_stats(ht, &stats);
+        assert( stats.capacity == m );
+        assert( stats.size == live );
+        assert( stats.tombstones <= m/4 );
+    }
+
+    for (i = 0; i < n; ++i)
+    {
+        assert( upo_ht_linprob_get(ht, &keys[i]) == ((i < n-live) ? NULL : &values[i]) );
+    }
+
+    upo_ht_linprob_destroy(ht, 0);
+}
+
+void test_generations()
+{
+    upo_ht_linprob_layout_t layouts[] = {UPO_HT_LINPROB_LAYOUT_AOS, UPO_HT_LINPROB_LAYOUT_SOA_FP16};
+    int keys[200];
+    int values[200];
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t j = 0;
+
+    for (j = 0; j < n; ++j)
+    {
+        keys[j] = (int) j;
+        values[j] = (int) j;
+    }
+
+    for (j = 0; j < sizeof layouts/sizeof layouts[0]; ++j)
+    {
+        upo_ht_linprob_t ht = upo_ht_linprob_create(UPO_HT_LINPROB_DEFAULT_CAPACITY, upo_ht_hash_int_div, int_compare);
+        upo_ht_stats_t stats;
+        size_t round = 0;
+        size_t i = 0;
+
+        assert( ht != NULL );
+
+        upo_ht_linprob_set_layout(ht, layouts[j]);
+        upo_ht_linprob_put(ht, &keys[0], &values[0]);
+        upo_ht_linprob_enable_generations(ht);
+        assert( upo_ht_linprob_get(ht, &keys[0]) == &values[0] );
+        upo_ht_linprob_clear(ht, 0);
+        assert( upo_ht_linprob_get(ht, &keys[0]) == NULL );
+
+        for (round = 1; round <= 50; ++round)
+        {
+            /* Each round stores a different number of keys, so that the hash
+             * table also resizes between clears */
+            size_t len = (round * 37) % n + 1;
+            size_t count = 0;
+
+            for (i = 0; i < len; ++i)
+            {
+                upo_ht_linprob_put(ht, &keys[(i + round) % n], &values[(i + round) % n]);
+            }
+            for (i = 0; i < len; i += 3)
+            {
+                upo_ht_linprob_delete(ht, &keys[(i + round) % n], 0);
+            }
+            for (i = 0; i < len; ++i)
+            {
+                assert( upo_ht_linprob_get(ht, &keys[(i + round) % n]) == ((i % 3 != 0) ? &values[(i + round) % n] : NULL) );
+            }
+            assert( upo_ht_linprob_size(ht) == len - (len + 2)/3 );
+            upo_ht_linprob_traverse(ht, count_key_visit, &count);
+            assert( count == upo_ht_linprob_size(ht) );
+
+            upo_ht_linprob_clear(ht, 0);
+
+            assert( upo_ht_linprob_is_empty(ht) );
+            for (i = 0; i < n; ++i)
+            {
+                assert( !upo_ht_linprob_contains(ht, &keys[i]) );
+            }
+            count = 0;
+            upo_ht_linprob_traverse(ht, count_key_visit, &count);
+            assert( count == 0 );
+            assert( upo_ht_linprob_keys(ht) == NULL );
+            upo_ht_linprob_stats(ht, &stats);
+            assert( stats.tombstones == 0 );
+            assert( stats.longest_cluster == 0 );
+        }
+
+        /* Disabling generation stamps keeps the live slots only */
+        upo_ht_linprob_put(ht, &keys[1], &values[1]);
+        upo_ht_linprob_disable_generations(ht);
+        assert( upo_ht_linprob_size(ht) == 1 );
+        assert( upo_ht_linprob_get(ht, &keys[1]) == &values[1] );
+        assert( upo_ht_linprob_get(ht, &keys[2]) == NULL );
+
+        upo_ht_linprob_destroy(ht, 0);
+    }
+}
+
+void test_get_or_insert()
+{
+    int keys[] = {3,1,4,1,5,9,2,6,5,3,5};
+    int counts[10] = {0};
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t i = 0;
+    upo_ht_linprob_t ht = NULL;
+    upo_ht_stats_t stats;
+
+    ht = upo_ht_linprob_create(97, upo_ht_hash_int_div, int_compare);
+
+    assert( ht != NULL );
+
+    upo_ht_linprob_enable_stats(ht);
+
+    for (i = 0; i < n; ++i)
+    {
+        void **value = NULL;
+        int inserted = upo_ht_linprob_get_or_insert(ht, &keys[i], &value);
+
+        assert( value != NULL );
+        assert( inserted == (*value == NULL) );
+        if (inserted)
+            *value = &counts[keys[i]];
+        ++*((int*) *value);
+    }
+
+    /* One hash per lookup */
+    upo_ht_linprob_stats(ht, &stats);
+    assert( stats.hash_calls == n );
+
+    assert( upo_ht_linprob_size(ht) == 7 );
+    assert( counts[1] == 2 && counts[3] == 2 && counts[5] == 3 && counts[9] == 1 );
+    assert( upo_ht_linprob_get(ht, &keys[4]) == &counts[5] );
+
+    upo_ht_linprob_destroy(ht, 0);
+}
+
+void test_compute()
+{
+    int keys[] = {0,1,2,3,4,5,6,7,8,9};
+    int values[] = {0,10,20,30,40,50,60,70,80,90};
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t i = 0;
+    upo_ht_linprob_t ht = NULL;
+
+    ht = upo_ht_linprob_create(16, upo_ht_hash_int_div, int_compare);
+
+    assert( ht != NULL );
+
+    /* Insert absent keys */
+    for (i = 0; i < n; ++i)
+    {
+        assert( upo_ht_linprob_compute(ht, &keys[i], compute_update, &values[i]) == &values[i] );
+        assert( upo_ht_linprob_get(ht, &keys[i]) == &values[i] );
+    }
+    assert( upo_ht_linprob_size(ht) == n );
+
+    /* Update in place */
+    assert( upo_ht_linprob_compute(ht, &keys[3], compute_update, &values[0]) == &values[0] );
+    assert( upo_ht_linprob_get(ht, &keys[3]) == &values[0] );
+    assert( upo_ht_linprob_size(ht) == n );
+
+    /* Remove present keys and skip absent ones */
+    for (i = 0; i < n; i += 2)
+    {
+        assert( upo_ht_linprob_compute(ht, &keys[i], compute_update, NULL) == NULL );
+    }
+    assert( upo_ht_linprob_size(ht) == n/2 );
+    for (i = 0; i < n; ++i)
+    {
+        assert( upo_ht_linprob_contains(ht, &keys[i]) == (int) (i % 2) );
+    }
+    assert( upo_ht_linprob_compute(ht, &keys[0], compute_update, NULL) == NULL );
+    assert( upo_ht_linprob_size(ht) == n/2 );
+
+    upo_ht_linprob_destroy(ht, 0);
+}
+
+void test_retain()
+{
+    int keys[200];
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t i = 0;
+    size_t resizes = 0;
+    int divisor = 2;
+    upo_ht_linprob_t ht = NULL;
+    upo_ht_stats_t stats;
+
+    for (i = 0; i < n; ++i)
+    {
+        keys[i] = (int) i;
+    }
+
+    ht = upo_ht_linprob_create(16, upo_ht_hash_int_div, int_compare);
+
+    assert( ht != NULL );
+
+    assert( upo_ht_linprob_retain(ht, is_multiple, &divisor, 0) == 0 );
+
+    for (i = 0; i < n; ++i)
+    {
+        upo_ht_linprob_put(ht, &keys[i], &keys[i]);
+    }
+
+    upo_ht_linprob_enable_stats(ht);
+    upo_ht_linprob_stats(ht, &stats);
+    resizes = stats.resizes;
+
+    /* Keep multiples of 2 */
+    assert( upo_ht_linprob_retain(ht, is_multiple, &divisor, 0) == n/2 );
+    upo_ht_linprob_stats(ht, &stats);
+    assert( stats.resizes - resizes <= 1 );
+    assert( stats.tombstones <= stats.capacity/4 );
+    assert( upo_ht_linprob_size(ht) == n/2 );
+    for (i = 0; i < n; ++i)
+    {
+        assert( upo_ht_linprob_get(ht, &keys[i]) == ((i % 2 == 0) ? &keys[i] : NULL) );
+    }
+
+    /* Keep multiples of 50, shrinking the hash table */
+    divisor = 50;
+    upo_ht_linprob_stats(ht, &stats);
+    resizes = stats.resizes;
+    assert( upo_ht_linprob_retain(ht, is_multiple, &divisor, 0) == n/2 - 4 );
+    upo_ht_linprob_stats(ht, &stats);
+    assert( stats.resizes - resizes <= 1 );
+    assert( stats.tombstones <= stats.capacity/4 );
+    assert( upo_ht_linprob_size(ht) == 4 );
+    for (i = 0; i < n; ++i)
+    {
+        assert( upo_ht_linprob_contains(ht, &keys[i]) == (i % 50 == 0) );
+    }
+
+    /* Keep nothing, freeing data */
+    upo_ht_linprob_clear(ht, 0);
+    for (i = 0; i < 10; ++i)
+    {
+        int *key = malloc(sizeof(int));
+
+        assert( key != NULL );
+
+        *key = (int) (2*i + 1);
+        upo_ht_linprob_put(ht, key, malloc(sizeof(int)));
+    }
+    divisor = 2;
+    assert( upo_ht_linprob_retain(ht, is_multiple, &divisor, 1) == 10 );
+    assert( upo_ht_linprob_is_empty(ht) );
+    upo_ht_linprob_put(ht, &keys[1], &keys[1]);
+    assert( upo_ht_linprob_get(ht, &keys[1]) == &keys[1] );
+
+    upo_ht_linprob_destroy(ht, 0);
+}
+
+void test_small()
+{
+    int keys[100];
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t i = 0;
+    int divisor = 2;
+    upo_ht_linprob_t ht = NULL;
+    upo_ht_stats_t stats;
+
+    for (i = 0; i < n; ++i)
+    {
+        keys[i] = (int) i;
+    }
+
+    ht = upo_ht_linprob_create_small(upo_ht_hash_int_div, int_compare);
+
+    assert( ht != NULL );
+    assert( upo_ht_linprob_is_small(ht) );
+    assert( upo_ht_linprob_is_empty(ht) );
+    assert( upo_ht_linprob_capacity(ht) == UPO_HT_LINPROB_SMALL_CAPACITY );
+
+    upo_ht_linprob_enable_stats(ht);
+
+    /* Fill the inline array without hashing keys */
+    for (i = 0; i < UPO_HT_LINPROB_SMALL_CAPACITY; ++i)
+    {
+        assert( upo_ht_linprob_put(ht, &keys[i], &keys[i]) == NULL );
+    }
+    assert( upo_ht_linprob_put(ht, &keys[0], &keys[1]) == &keys[0] );
+    assert( upo_ht_linprob_is_small(ht) );
+    assert( upo_ht_linprob_size(ht) == UPO_HT_LINPROB_SMALL_CAPACITY );
+    for (i = 0; i < n; ++i)
+    {
+        assert( upo_ht_linprob_contains(ht, &keys[i]) == (i < UPO_HT_LINPROB_SMALL_CAPACITY) );
+    }
+    upo_ht_linprob_stats(ht, &stats);
+    assert( stats.hash_calls == 0 );
+    assert( stats.histogram[0] == 1 );
+
+    /* Remove from the middle, then reuse the freed slot */
+    upo_ht_linprob_delete(ht, &keys[3], 0);
+    upo_ht_linprob_delete(ht, &keys[3], 0);
+    assert( upo_ht_linprob_size(ht) == UPO_HT_LINPROB_SMALL_CAPACITY - 1 );
+    assert( !upo_ht_linprob_contains(ht, &keys[3]) );
+    assert( upo_ht_linprob_get(ht, &keys[UPO_HT_LINPROB_SMALL_CAPACITY-1]) == &keys[UPO_HT_LINPROB_SMALL_CAPACITY-1] );
+    upo_ht_linprob_insert(ht, &keys[3], &keys[3]);
+    assert( upo_ht_linprob_is_small(ht) );
+    upo_ht_linprob_stats(ht, &stats);
+    assert( stats.tombstones == 0 );
+
+    /* Retain compacts the inline array */
+    assert( upo_ht_linprob_retain(ht, is_multiple, &divisor, 0) == UPO_HT_LINPROB_SMALL_CAPACITY/2 );
+    assert( upo_ht_linprob_is_small(ht) );
+    for (i = 0; i < UPO_HT_LINPROB_SMALL_CAPACITY; ++i)
+    {
+        assert( upo_ht_linprob_contains(ht, &keys[i]) == (i % 2 == 0) );
+    }
+
+    /* Outgrow the inline array */
+    for (i = 0; i < n; ++i)
+    {
+        upo_ht_linprob_put(ht, &keys[i], &keys[i]);
+    }
+    assert( !upo_ht_linprob_is_small(ht) );
+    assert( upo_ht_linprob_size(ht) == n );
+    assert( upo_ht_linprob_capacity(ht) > UPO_HT_LINPROB_SMALL_CAPACITY );
+    for (i = 0; i < n; ++i)
+    {
+        assert( upo_ht_linprob_get(ht, &keys[i]) == &keys[i] );
+    }
+
+    /* Never goes back to small mode */
+    upo_ht_linprob_clear(ht, 0);
+    assert( upo_ht_linprob_is_empty(ht) );
+    assert( !upo_ht_linprob_is_small(ht) );
+    upo_ht_linprob_destroy(ht, 0);
+
+    /* Other features work in small mode */
+    ht = upo_ht_linprob_create_small(upo_ht_hash_int_div, int_compare);
+    upo_ht_linprob_enable_generations(ht);
+    for (i = 0; i < 4; ++i)
+    {
+        upo_ht_linprob_put(ht, &keys[i], &keys[i]);
+    }
+    upo_ht_linprob_clear(ht, 0);
+    assert( upo_ht_linprob_is_empty(ht) );
+    assert( upo_ht_linprob_keys(ht) == NULL );
+    for (i = 0; i < 4; ++i)
+    {
+        assert( !upo_ht_linprob_contains(ht, &keys[i]) );
+        upo_ht_linprob_put(ht, &keys[i+10], &keys[i+10]);
+    }
+    upo_ht_linprob_set_layout(ht, UPO_HT_LINPROB_LAYOUT_SOA_FP8);
+    assert( !upo_ht_linprob_is_small(ht) );
+    for (i = 0; i < 4; ++i)
+    {
+        assert( upo_ht_linprob_get(ht, &keys[i+10]) == &keys[i+10] );
+    }
+    upo_ht_linprob_destroy(ht, 0);
+
+    /* Free data, both in small mode and after the switch */
+    ht = upo_ht_linprob_create_small(upo_ht_hash_int_div, int_compare);
+    for (i = 0; i < 3*UPO_HT_LINPROB_SMALL_CAPACITY; ++i)
+    {
+        int *key = malloc(sizeof(int));
+
+        assert( key != NULL );
+
+        *key = (int) i;
+        upo_ht_linprob_put(ht, key, malloc(sizeof(int)));
+        if (i == UPO_HT_LINPROB_SMALL_CAPACITY - 1)
+        {
+            upo_ht_linprob_delete(ht, key, 1);
+            upo_ht_linprob_clear(ht, 1);
+        }
+    }
+    upo_ht_linprob_destroy(ht, 1);
+}
+
+void test_probes()
+{
+    upo_ht_linprob_probe_t probes[] = {UPO_HT_LINPROB_PROBE_LINEAR,
+                                       UPO_HT_LINPROB_PROBE_QUADRATIC,
+                                       UPO_HT_LINPROB_PROBE_DOUBLE};
+    int keys[300];
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t i = 0;
+    size_t j = 0;
+    size_t k = 0;
+
+    /* Clustered keys: runs of consecutive integers */
+    for (i = 0; i < n; ++i)
+    {
+        keys[i] = (int) (1000*(i/10) + i%10);
+    }
+
+    for (j = 0; j < sizeof probes/sizeof probes[0]; ++j)
+    {
+        for (k = 0; k < 2; ++k)
+        {
+            upo_ht_linprob_t ht = upo_ht_linprob_create(10, upo_ht_hash_int_div, int_compare);
+            upo_ht_stats_t stats;
+            size_t m = 0;
+
+            assert( ht != NULL );
+
+            upo_ht_linprob_set_probe(ht, probes[j]);
+            if (k == 1)
+                upo_ht_linprob_set_layout(ht, UPO_HT_LINPROB_LAYOUT_SOA_FP8);
+
+            assert( upo_ht_linprob_get_probe(ht) == probes[j] );
+            m = upo_ht_linprob_capacity(ht);
+            assert( probes[j] == UPO_HT_LINPROB_PROBE_LINEAR ? m == 10 : m == 16 );
+
+            for (i = 0; i < n; ++i)
+            {
+                assert( upo_ht_linprob_put(ht, &keys[i], &keys[i]) == NULL );
+            }
+            assert( upo_ht_linprob_size(ht) == n );
+            for (i = 0; i < n; ++i)
+            {
+                assert( upo_ht_linprob_get(ht, &keys[i]) == &keys[i] );
+                assert( upo_ht_linprob_put(ht, &keys[i], &keys[i]) == &keys[i] );
+            }
+
+            /* Remove odd positions, leaving tombstones in probe sequences */
+            for (i = 1; i < n; i += 2)
+            {
+                upo_ht_linprob_delete(ht, &keys[i], 0);
+            }
+            assert( upo_ht_linprob_size(ht) == n/2 );
+            for (i = 0; i < n; ++i)
+            {
+                assert( upo_ht_linprob_contains(ht, &keys[i]) == (i % 2 == 0) );
+            }
+
+            /* Reinsert them, reusing tombstones */
+            for (i = 1; i < n; i += 2)
+            {
+                upo_ht_linprob_insert(ht, &keys[i], &keys[i]);
+            }
+            for (i = 0; i < n; ++i)
+            {
+                assert( upo_ht_linprob_get(ht, &keys[i]) == &keys[i] );
+            }
+
+            /* Switching probe sequence keeps the key-value pairs */
+            upo_ht_linprob_set_probe(ht, probes[(j + 1) % 3]);
+            for (i = 0; i < n; ++i)
+            {
+                assert( upo_ht_linprob_get(ht, &keys[i]) == &keys[i] );
+            }
+            upo_ht_linprob_set_probe(ht, probes[j]);
+
+            /* Every key is found within its probe sequence */
+            upo_ht_linprob_stats(ht, &stats);
+            m = 0;
+            for (i = 0; i < UPO_HT_STATS_HISTOGRAM_SIZE; ++i)
+            {
+                m += stats.histogram[i];
+            }
+            assert( m == n );
+
+            /* Shrink down to a single slot */
+            for (i = 0; i < n; ++i)
+            {
+                upo_ht_linprob_delete(ht, &keys[i], 0);
+            }
+            assert( upo_ht_linprob_is_empty(ht) );
+            upo_ht_linprob_put(ht, &keys[0], &keys[0]);
+            assert( upo_ht_linprob_get(ht, &keys[0]) == &keys[0] );
+
+            upo_ht_linprob_destroy(ht, 0);
+        }
+    }
+}
+
+void test_budget()
+{
+    int keys[1000];
+    int sizes[] = {100, 2000};
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t i = 0;
+    size_t evicted = 0;
+    upo_ht_budget_t budget;
+    upo_ht_linprob_t ht = NULL;
+
+    for (i = 0; i < n; ++i)
+    {
+        keys[i] = (int) i;
+    }
+
+    /* The budget is the memory of an empty hash table of capacity 64 */
+    ht = upo_ht_linprob_create(64, upo_ht_hash_int_div, int_compare);
+    budget.max_bytes = upo_ht_linprob_memory(ht);
+    budget.data_size = NULL;
+    budget.rank = NULL;
+    budget.samples = 0;
+    budget.evict = count_key_visit;
+    budget.arg = &evicted;
+    budget.destroy_data = 0;
+    upo_ht_linprob_destroy(ht, 0);
+
+    /* Random eviction: the hash table stops growing at capacity 64 */
+    ht = upo_ht_linprob_create(UPO_HT_LINPROB_DEFAULT_CAPACITY, upo_ht_hash_int_div, int_compare);
+    upo_ht_linprob_set_budget(ht, &budget);
+    for (i = 0; i < n; ++i)
+    {
+        upo_ht_linprob_put(ht, &keys[i], &keys[i]);
+        assert( upo_ht_linprob_contains(ht, &keys[i]) );
+        assert( upo_ht_linprob_memory(ht) <= budget.max_bytes );
+        assert( upo_ht_linprob_capacity(ht) <= 64 );
+        assert( upo_ht_linprob_size(ht) + evicted == i+1 );
+    }
+    assert( upo_ht_linprob_size(ht) >= 16 );
+
+    /* Ranked eviction over all pairs: the smallest keys go first */
+    upo_ht_linprob_clear(ht, 0);
+    budget.rank = int_key_rank;
+    budget.samples = n;
+    upo_ht_linprob_set_budget(ht, &budget);
+    for (i = 0; i < n; ++i)
+    {
+        upo_ht_linprob_put(ht, &keys[i], &keys[i]);
+    }
+    for (i = 0; i < n; ++i)
+    {
+        assert( upo_ht_linprob_contains(ht, &keys[i]) == (i >= n - upo_ht_linprob_size(ht)) );
+    }
+
+    /* Sized data: each pair takes 100 bytes, so 10 pairs fit */
+    upo_ht_linprob_clear(ht, 0);
+    budget.max_bytes = upo_ht_linprob_memory(ht) + 10*sizes[0];
+    budget.data_size = int_value_size;
+    upo_ht_linprob_set_budget(ht, &budget);
+    for (i = 0; i < n; ++i)
+    {
+        upo_ht_linprob_put(ht, &keys[i], &sizes[0]);
+        assert( upo_ht_linprob_memory(ht) <= budget.max_bytes );
+    }
+    assert( upo_ht_linprob_size(ht) == 10 );
+    assert( upo_ht_linprob_contains(ht, &keys[n-10]) );
+
+    /* A larger value evicts other pairs, but never its own key */
+    upo_ht_linprob_put(ht, &keys[n-10], &sizes[1]);
+    assert( upo_ht_linprob_memory(ht) <= budget.max_bytes );
+    assert( upo_ht_linprob_size(ht) < 10 ); // Evictions also shrink the table
+    assert( upo_ht_linprob_get(ht, &keys[n-10]) == &sizes[1] );
+
+    /* Removing the budget lets the table grow, setting it evicts at once */
+    upo_ht_linprob_set_budget(ht, NULL);
+    for (i = 0; i < n; ++i)
+    {
+        upo_ht_linprob_put(ht, &keys[i], &sizes[0]);
+    }
+    assert( upo_ht_linprob_size(ht) == n );
+    upo_ht_linprob_set_budget(ht, &budget);
+    assert( upo_ht_linprob_memory(ht) <= budget.max_bytes );
+    assert( upo_ht_linprob_size(ht) > 0 && upo_ht_linprob_size(ht) <= 10 );
+    assert( upo_ht_linprob_contains(ht, &keys[n-1]) );
+
+    upo_ht_linprob_destroy(ht, 0);
+
+    /* In small mode, the budget of a small table keeps the inline slots */
+    ht = upo_ht_linprob_create_small(upo_ht_hash_int_div, int_compare);
+    budget.max_bytes = upo_ht_linprob_memory(ht);
+    budget.data_size = NULL;
+    budget.rank = NULL;
+    budget.samples = 0;
+    upo_ht_linprob_set_budget(ht, &budget);
+    for (i = 0; i < n; ++i)
+    {
+        upo_ht_linprob_put(ht, &keys[i], &keys[i]);
+        assert( upo_ht_linprob_is_small(ht) );
+    }
+    assert( upo_ht_linprob_size(ht) == UPO_HT_LINPROB_SMALL_CAPACITY );
+    upo_ht_linprob_destroy(ht, 0);
+
+    /* Evicted data is freed if requested */
+    ht = upo_ht_linprob_create(64, upo_ht_hash_int_div, int_compare);
+    budget.max_bytes = upo_ht_linprob_memory(ht);
+    budget.evict = NULL;
+    budget.destroy_data = 1;
+    upo_ht_linprob_set_layout(ht, UPO_HT_LINPROB_LAYOUT_SOA_FP8);
+    upo_ht_linprob_set_budget(ht, &budget);
+    for (i = 0; i < n; ++i)
+    {
+        int *key = malloc(sizeof(int));
+
+        assert( key != NULL );
+
+        *key = (int) i;
+        upo_ht_linprob_put(ht, key, malloc(sizeof(int)));
+        assert( upo_ht_linprob_memory(ht) <= budget.max_bytes );
+    }
+    upo_ht_linprob_destroy(ht, 1);
+}
+
+void test_scan()
+{
+    upo_ht_linprob_probe_t probes[] = {UPO_HT_LINPROB_PROBE_LINEAR,
+                                       UPO_HT_LINPROB_PROBE_QUADRATIC};
+    static int keys[3000];
+    static size_t seen[3000];
+    size_t n = 200;
+    size_t n_churn = sizeof keys/sizeof keys[0] - 1000;
+    size_t i = 0;
+    size_t j = 0;
+    size_t k = 0;
+
+    for (i = 0; i < sizeof keys/sizeof keys[0]; ++i)
+    {
+        keys[i] = (int) i;
+    }
+
+    for (j = 0; j < sizeof probes/sizeof probes[0]; ++j)
+    {
+        for (k = 0; k < 2; ++k)
+        {
+            upo_ht_linprob_t ht = upo_ht_linprob_create(16, upo_ht_hash_int_div, int_compare);
+            size_t cursor = 0;
+            size_t inserted = 0;
+            size_t deleted = 0;
+            size_t capacity = 0;
+            int grown = 0;
+            int shrunk = 0;
+
+            assert( ht != NULL );
+
+            upo_ht_linprob_set_probe(ht, probes[j]);
+            if (k == 1)
+                upo_ht_linprob_set_layout(ht, UPO_HT_LINPROB_LAYOUT_SOA_FP8);
+
+            for (i = 0; i < n; ++i)
+            {
+                upo_ht_linprob_put(ht, &keys[i], &keys[i]);
+            }
+
+            /* Without writes, every key is visited exactly once */
+            memset(seen, 0, sizeof seen);
+            do
+            {
+                cursor = upo_ht_linprob_scan(ht, cursor, 7, mark_key_visit, seen);
+            }
+            while (cursor != 0);
+            for (i = 0; i < n; ++i)
+            {
+                assert( seen[i] == 1 );
+            }
+
+            /* Interleave the scan with insertions that grow the table, then
+             * with removals that shrink it back */
+            memset(seen, 0, sizeof seen);
+            capacity = upo_ht_linprob_capacity(ht);
+            do
+            {
+                cursor = upo_ht_linprob_scan(ht, cursor, 4, mark_key_visit, seen);
+
+                for (i = 0; i < 40; ++i)
+                {
+                    if (inserted < n_churn)
+                    {
+                        upo_ht_linprob_put(ht, &keys[1000 + inserted], &keys[1000 + inserted]);
+                        ++inserted;
+                    }
+                    else if (deleted < n_churn)
+                    {
+                        upo_ht_linprob_delete(ht, &keys[1000 + deleted], 0);
+                        ++deleted;
+                    }
+                }
+
+                if (upo_ht_linprob_capacity(ht) > capacity)
+                    grown = 1;
+                else if (upo_ht_linprob_capacity(ht) < capacity)
+                    shrunk = 1;
+                capacity = upo_ht_linprob_capacity(ht);
+            }
+            while (cursor != 0);
+            assert( grown && shrunk );
+            for (i = 0; i < n; ++i)
+            {
+                assert( seen[i] >= 1 );
+            }
+
+            upo_ht_linprob_destroy(ht, 0);
+        }
+    }
+
+    /* Consecutive keys form a single cluster, but each of them is stored in
+     * its home slot, so each step hashes at most the key of its own slot */
+    {
+        upo_ht_linprob_t ht = upo_ht_linprob_create(16, upo_ht_hash_int_div, int_compare);
+        upo_ht_stats_t stats;
+        size_t cursor = 0;
+
+        assert( ht != NULL );
+
+        for (i = 0; i < 1500; ++i)
+        {
+            upo_ht_linprob_put(ht, &keys[i], &keys[i]);
+        }
+        upo_ht_linprob_enable_stats(ht);
+        memset(seen, 0, sizeof seen);
+        do
+        {
+            cursor = upo_ht_linprob_scan(ht, cursor, 16, mark_key_visit, seen);
+        }
+        while (cursor != 0);
+        for (i = 0; i < 1500; ++i)
+        {
+            assert( seen[i] == 1 );
+        }
+        upo_ht_linprob_stats(ht, &stats);
+        assert( stats.hash_calls == 1500 );
+        upo_ht_linprob_destroy(ht, 0);
+    }
+
+    /* With double hashing, keys cannot be enumerated by home slot, so the
+     * first call visits all of them */
+    {
+        upo_ht_linprob_t ht = upo_ht_linprob_create(16, upo_ht_hash_int_div, int_compare);
+
+        assert( ht != NULL );
+
+        upo_ht_linprob_set_probe(ht, UPO_HT_LINPROB_PROBE_DOUBLE);
+        for (i = 0; i < n; ++i)
+        {
+            upo_ht_linprob_put(ht, &keys[i*7], &keys[i*7]);
+        }
+        memset(seen, 0, sizeof seen);
+        assert( upo_ht_linprob_scan(ht, 0, 1, mark_key_visit, seen) == 0 );
+        for (i = 0; i < n; ++i)
+        {
+            assert( seen[i*7] == 1 );
+        }
+        upo_ht_linprob_destroy(ht, 0);
+    }
+
+    /* Small tables are scanned in a single step */
+    {
+        upo_ht_linprob_t ht = upo_ht_linprob_create_small(upo_ht_hash_int_div, int_compare);
+
+        assert( upo_ht_linprob_scan(ht, 0, 1, mark_key_visit, seen) == 0 );
+        memset(seen, 0, sizeof seen);
+        for (i = 0; i < 5; ++i)
+        {
+            upo_ht_linprob_put(ht, &keys[i], &keys[i]);
+        }
+        assert( upo_ht_linprob_scan(ht, 0, 1, mark_key_visit, seen) == 0 );
+        for (i = 0; i < 5; ++i)
+        {
+            assert( seen[i] == 1 );
+        }
+        upo_ht_linprob_destroy(ht, 0);
+    }
+
+    assert( upo_ht_linprob_scan(NULL, 0, 1, mark_key_visit, seen) == 0 );
+}
+
+void test_parallel_rehash()
+{
+    upo_ht_linprob_probe_t probes[] = {UPO_HT_LINPROB_PROBE_LINEAR,
+                                       UPO_HT_LINPROB_PROBE_QUADRATIC,
+                                       UPO_HT_LINPROB_PROBE_DOUBLE};
+    static int keys[200000];
+    static int clustered[100];
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t i = 0;
+    size_t j = 0;
+    size_t k = 0;
+
+    for (i = 0; i < n; ++i)
+    {
+        keys[i] = (int) (i*7919 % n); // A permutation of 0..n-1
+    }
+    for (i = 0; i < sizeof clustered/sizeof clustered[0]; ++i)
+    {
+        /* Keys hashed to the last slot, whose probe sequences wrap around */
+        clustered[i] = (int) ((i + 1)*(1U << 20) - 1);
+    }
+
+    assert( upo_ht_linprob_get_rehash_threads(NULL) == 1 );
+
+    for (j = 0; j < sizeof probes/sizeof probes[0]; ++j)
+    {
+        for (k = 0; k < 2; ++k)
+        {
+            upo_ht_linprob_t ht = upo_ht_linprob_create(UPO_HT_LINPROB_DEFAULT_CAPACITY, upo_ht_hash_int_div, int_compare);
+            upo_ht_stats_t stats;
+
+            assert( ht != NULL );
+            assert( upo_ht_linprob_get_rehash_threads(ht) == 1 );
+
+            upo_ht_linprob_set_probe(ht, probes[j]);
+            if (k == 1)
+                upo_ht_linprob_set_layout(ht, UPO_HT_LINPROB_LAYOUT_SOA_FP16);
+            upo_ht_linprob_set_rehash_threads(ht, 4);
+            assert( upo_ht_linprob_get_rehash_threads(ht) == 4 );
+            upo_ht_linprob_enable_stats(ht);
+
+            /* Grow past the threshold of parallel rehashing */
+            for (i = 0; i < sizeof clustered/sizeof clustered[0]; ++i)
+            {
+                assert( upo_ht_linprob_put(ht, &clustered[i], &clustered[i]) == NULL );
+            }
+            for (i = 0; i < n; ++i)
+            {
+                assert( upo_ht_linprob_put(ht, &keys[i], &keys[i]) == NULL );
+            }
+            for (i = 0; i < sizeof clustered/sizeof clustered[0]; ++i)
+            {
+                assert( upo_ht_linprob_get(ht, &clustered[i]) == &clustered[i] );
+                upo_ht_linprob_delete(ht, &clustered[i], 0);
+            }
+            assert( upo_ht_linprob_size(ht) == n );
+            for (i = 0; i < n; ++i)
+            {
+                assert( upo_ht_linprob_get(ht, &keys[i]) == &keys[i] );
+            }
+
+            /* Every key is found within its probe sequence */
+            upo_ht_linprob_stats(ht, &stats);
+            assert( stats.resizes > 0 );
+            {
+                size_t m = 0;
+                size_t h = 0;
+
+                for (h = 0; h < UPO_HT_STATS_HISTOGRAM_SIZE; ++h)
+                {
+                    m += stats.histogram[h];
+                }
+                assert( m == n );
+            }
+
+            /* Shrink with a parallel rehash */
+            for (i = 0; i < n - UPO_HT_LINPROB_PARALLEL_REHASH_MIN_SIZE; ++i)
+            {
+                upo_ht_linprob_delete(ht, &keys[i], 0);
+            }
+            assert( upo_ht_linprob_size(ht) == UPO_HT_LINPROB_PARALLEL_REHASH_MIN_SIZE );
+            for (i = 0; i < n; ++i)
+            {
+                assert( upo_ht_linprob_contains(ht, &keys[i]) == (i >= n - UPO_HT_LINPROB_PARALLEL_REHASH_MIN_SIZE) );
+            }
+
+            upo_ht_linprob_destroy(ht, 0);
+        }
+    }
+}
+
 
 int main()
 {
@@ -384,6 +1560,71 @@ int main()
     test_traverse();
     printf("OK\n");
 
+    printf("Test case 'stats'... ");
+    fflush(stdout);
+    test_stats();
+    printf("OK\n");
+
+    printf("Test case 'tombstones'... ");
+    fflush(stdout);
+    test_tombstones();
+    printf("OK\n");
+
+    printf("Test case 'layouts'... ");
+    fflush(stdout);
+    test_layouts();
+    printf("OK\n");
+
+    printf("Test case 'layout_tombstones'... ");
+    fflush(stdout);
+    test_layout_tombstones();
+    printf("OK\n");
+
+    printf("Test case 'generations'... ");
+    fflush(stdout);
+    test_generations();
+    printf("OK\n");
+
+    printf("Test case 'get_or_insert'... ");
+    fflush(stdout);
+    test_get_or_insert();
+    printf("OK\n");
+
+    printf("Test case 'compute'... ");
+    fflush(stdout);
+    test_compute();
+    printf("OK\n");
+
+    printf("Test case 'retain'... ");
+    fflush(stdout);
+    test_retain();
+    printf("OK\n");
+
+    printf("Test case 'small'... ");
+    fflush(stdout);
+    test_small();
+    printf("OK\n");
+
+    printf("Test case 'probes'... ");
+    fflush(stdout);
+    test_probes();
+    printf("OK\n");
+
+    printf("Test case 'budget'... ");
+    fflush(stdout);
+    test_budget();
+    printf("OK\n");
+
+    printf("Test case 'scan'... ");
+    fflush(stdout);
+    test_scan();
+    printf("OK\n");
+
+    printf("Test case 'parallel rehash'... ");
+    fflush(stdout);
+    test_parallel_rehash();
+    printf("OK\n");
+
 
     return 0;
 }
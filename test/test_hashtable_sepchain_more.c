@@ -35,8 +35,25 @@ static void int_key_value_print(void *key, void *value, void *info);
 #endif // UPO_DEBUG
 static void count_key_visit(void *key, void *value, void *info);
 
+static void* compute_update(const void *key, void *value, void *info);
+
+static int is_multiple(const void *key, const void *value, void *info);
+
+static size_t int_value_size(const void *key, const void *value, void *info);
+static unsigned long int_key_rank(const void *key, const void *value, void *info);
+
+static void check_ascending_visit(void *key, void *value, void *info);
+
 static void test_keys();
 static void test_traverse();
+static void test_stats();
+static void test_generations();
+static void test_get_or_insert();
+static void test_compute();
+static void test_retain();
+static void test_policies();
+static void test_sort_policy();
+static void test_budget();
 
 
 int int_compare(const void *a, const void *b)
@@ -89,6 +106,63 @@ void count_key_visit(void *key, void *value, void *info)
     }
 }
 
+void* compute_update(const void *key, void *value, void *info)
+{
+    (void) key;
+    (void) value;
+
+    /* The new value is the additional parameter (NULL removes the key) */
+    return info;
+}
+
+int is_multiple(const void *key, const void *value, void *info)
+{
+    const int *ikey = key;
+    const int *divisor = info;
+
+    assert( key != NULL );
+    assert( info != NULL );
+
+    (void) value;
+
+    return (*ikey % *divisor) == 0;
+}
+
+// Sizes the data of a pair as the int value (or as nothing for NULL values)
+size_t int_value_size(const void *key, const void *value, void *info)
+{
+    assert( key != NULL );
+
+    (void) info;
+
+    return (value != NULL) ? (size_t) *((const int*) value) : 0;
+}
+
+// Ranks a pair by its int key, so that the smallest key is evicted first
+unsigned long int_key_rank(const void *key, const void *value, void *info)
+{
+    assert( key != NULL );
+
+    (void) value;
+    (void) info;
+
+    return (unsigned long) *((const int*) key);
+}
+
+void check_ascending_visit(void *key, void *value, void *info)
+{
+    int *ikey = key;
+    int *prev = info;
+
+    assert( key != NULL );
+    assert( info != NULL );
+
+    (void) value;
+
+    assert( *ikey > *prev );
+    *prev = *ikey;
+}
+
 void test_keys()
 {
     int keys1[] = {0,1,2,3,4,5,6,7,8,9};
@@ -370,6 +444,528 @@ void test_traverse()
     upo_ht_sepchain_destroy(ht, 0);
 }
 
+void test_stats()
+{
+    int keys[] = {0,10,20,1,2};
+    int values[] = {0,1,2,3,4};
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t i = 0;
+    upo_ht_sepchain_t ht = NULL;
+    upo_ht_stats_t stats;
+
+    ht = upo_ht_sepchain_create(10, upo_ht_hash_int_div, int_compare);
+
+    assert( ht != NULL );
+
+    upo_ht_sepchain_enable_stats(ht);
+
+    /* Keys 0, 10 and 20 collide in slot 0 */
+    for (i = 0; i < n; ++i)
+    {
+        upo_ht_sepchain_put(ht, &keys[i], &values[i]);
+    }
+    assert( upo_ht_sepchain_get(ht, &keys[0]) == &values[0] );
+
+    upo_ht_sepchain_stats(ht, &stats);
+    assert( stats.capacity == 10 );
+    assert( stats.size == n );
+    assert( stats.histogram[0] == 7 );
+    assert( stats.histogram[1] == 2 );
+    assert( stats.histogram[3] == 1 );
+    assert( stats.longest_cluster == 3 );
+    assert( stats.hash_calls == n+1 );
+    /* 0 + 1 + 2 comparisons to insert the colliding keys, 3 to find key 0 */
+    assert( stats.cmp_calls == 6 );
+    assert( stats.resizes == 0 );
+#ifdef UPO_DEBUG
+    upo_ht_stats_print(&stats, stderr);
+#endif // UPO_DEBUG
+
+    upo_ht_sepchain_disable_stats(ht);
+    upo_ht_sepchain_stats(ht, &stats);
+    assert( stats.size == n );
+    assert( stats.hash_calls == 0 );
+    assert( stats.cmp_calls == 0 );
+
+    upo_ht_sepchain_destroy(ht, 0);
+
+    upo_ht_sepchain_stats(NULL, &stats);
+    assert( stats.capacity == 0 );
+}
+
+void test_generations()
+{
+    int keys[100];
+    int values[100];
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t round = 0;
+    size_t i = 0;
+    size_t bytes = 0;
+    upo_ht_sepchain_t ht = NULL;
+
+    for (i = 0; i < n; ++i)
+    {
+        keys[i] = (int) i;
+        values[i] = (int) i;
+    }
+
+    ht = upo_ht_sepchain_create(17, upo_ht_hash_int_div, int_compare);
+
+    assert( ht != NULL );
+
+    upo_ht_sepchain_put(ht, &keys[0], &values[0]);
+    bytes = upo_ht_sepchain_memory(ht);
+    upo_ht_sepchain_enable_generations(ht);
+    assert( upo_ht_sepchain_memory(ht) == bytes + 17*sizeof(unsigned) ); // Stamps only take memory once enabled
+    assert( upo_ht_sepchain_get(ht, &keys[0]) == &values[0] );
+    upo_ht_sepchain_clear(ht, 0);
+    assert( upo_ht_sepchain_get(ht, &keys[0]) == NULL );
+
+    for (round = 1; round <= 50; ++round)
+    {
+        size_t len = (round * 37) % n + 1;
+        size_t count = 0;
+
+        for (i = 0; i < len; ++i)
+        {
+            upo_ht_sepchain_put(ht, &keys[(i + round) % n], &values[(i + round) % n]);
+        }
+        for (i = 0; i < len; i += 3)
+        {
+            upo_ht_sepchain_delete(ht, &keys[(i + round) % n], 0);
+        }
+        for (i = 0; i < len; ++i)
+        {
+            assert( upo_ht_sepchain_get(ht, &keys[(i + round) % n]) == ((i % 3 != 0) ? &values[(i + round) % n] : NULL) );
+        }
+        assert( upo_ht_sepchain_size(ht) == len - (len + 2)/3 );
+        upo_ht_sepchain_traverse(ht, count_key_visit, &count);
+        assert( count == upo_ht_sepchain_size(ht) );
+
+        upo_ht_sepchain_clear(ht, 0);
+
+        assert( upo_ht_sepchain_is_empty(ht) );
+        for (i = 0; i < n; ++i)
+        {
+            assert( !upo_ht_sepchain_contains(ht, &keys[i]) );
+        }
+        /* Deleting a key of a past generation has no effect */
+        upo_ht_sepchain_delete(ht, &keys[round % n], 0);
+        assert( upo_ht_sepchain_size(ht) == 0 );
+        count = 0;
+        upo_ht_sepchain_traverse(ht, count_key_visit, &count);
+        assert( count == 0 );
+        assert( upo_ht_sepchain_keys(ht) == NULL );
+    }
+
+    /* Disabling generation stamps keeps the live slots only */
+    upo_ht_sepchain_put(ht, &keys[1], &values[1]);
+    upo_ht_sepchain_disable_generations(ht);
+    assert( upo_ht_sepchain_size(ht) == 1 );
+    assert( upo_ht_sepchain_get(ht, &keys[1]) == &values[1] );
+    assert( upo_ht_sepchain_get(ht, &keys[2]) == NULL );
+
+    /* Stale lists are freed on destruction */
+    upo_ht_sepchain_enable_generations(ht);
+    upo_ht_sepchain_put(ht, &keys[2], &values[2]);
+    upo_ht_sepchain_clear(ht, 0);
+    upo_ht_sepchain_destroy(ht, 0);
+}
+
+void test_get_or_insert()
+{
+    int keys[] = {3,1,4,1,5,9,2,6,5,3,5};
+    int counts[10] = {0};
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t i = 0;
+    upo_ht_sepchain_t ht = NULL;
+    upo_ht_stats_t stats;
+
+    ht = upo_ht_sepchain_create(97, upo_ht_hash_int_div, int_compare);
+
+    assert( ht != NULL );
+
+    upo_ht_sepchain_enable_stats(ht);
+
+    for (i = 0; i < n; ++i)
+    {
+        void **value = NULL;
+        int inserted = upo_ht_sepchain_get_or_insert(ht, &keys[i], &value);
+
+        assert( value != NULL );
+        assert( inserted == (*value == NULL) );
+        if (inserted)
+            *value = &counts[keys[i]];
+        ++*((int*) *value);
+    }
+
+    /* One hash per lookup */
+    upo_ht_sepchain_stats(ht, &stats);
+    assert( stats.hash_calls == n );
+
+    assert( upo_ht_sepchain_size(ht) == 7 );
+    assert( counts[1] == 2 && counts[3] == 2 && counts[5] == 3 && counts[9] == 1 );
+    assert( upo_ht_sepchain_get(ht, &keys[4]) == &counts[5] );
+
+    upo_ht_sepchain_destroy(ht, 0);
+}
+
+void test_compute()
+{
+    int keys[] = {0,1,2,3,4,5,6,7,8,9};
+    int values[] = {0,10,20,30,40,50,60,70,80,90};
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t i = 0;
+    upo_ht_sepchain_t ht = NULL;
+
+    ht = upo_ht_sepchain_create(16, upo_ht_hash_int_div, int_compare);
+
+    assert( ht != NULL );
+
+    /* Insert absent keys */
+    for (i = 0; i < n; ++i)
+    {
+        assert( upo_ht_sepchain_compute(ht, &keys[i], compute_update, &values[i]) == &values[i] );
+        assert( upo_ht_sepchain_get(ht, &keys[i]) == &values[i] );
+    }
+    assert( upo_ht_sepchain_size(ht) == n );
+
+    /* Update in place */
+    assert( upo_ht_sepchain_compute(ht, &keys[3], compute_update, &values[0]) == &values[0] );
+    assert( upo_ht_sepchain_get(ht, &keys[3]) == &values[0] );
+    assert( upo_ht_sepchain_size(ht) == n );
+
+    /* Remove present keys and skip absent ones */
+    for (i = 0; i < n; i += 2)
+    {
+        assert( upo_ht_sepchain_compute(ht, &keys[i], compute_update, NULL) == NULL );
+    }
+    assert( upo_ht_sepchain_size(ht) == n/2 );
+    for (i = 0; i < n; ++i)
+    {
+        assert( upo_ht_sepchain_contains(ht, &keys[i]) == (int) (i % 2) );
+    }
+    assert( upo_ht_sepchain_compute(ht, &keys[0], compute_update, NULL) == NULL );
+    assert( upo_ht_sepchain_size(ht) == n/2 );
+
+    upo_ht_sepchain_destroy(ht, 0);
+}
+
+void test_retain()
+{
+    int keys[200];
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t i = 0;
+    size_t resizes = 0;
+    int divisor = 2;
+    upo_ht_sepchain_t ht = NULL;
+    upo_ht_stats_t stats;
+
+    for (i = 0; i < n; ++i)
+    {
+        keys[i] = (int) i;
+    }
+
+    ht = upo_ht_sepchain_create(16, upo_ht_hash_int_div, int_compare);
+
+    assert( ht != NULL );
+
+    assert( upo_ht_sepchain_retain(ht, is_multiple, &divisor, 0) == 0 );
+
+    for (i = 0; i < n; ++i)
+    {
+        upo_ht_sepchain_put(ht, &keys[i], &keys[i]);
+    }
+
+    upo_ht_sepchain_enable_stats(ht);
+    upo_ht_sepchain_stats(ht, &stats);
+    resizes = stats.resizes;
+
+    /* Keep multiples of 2 */
+    assert( upo_ht_sepchain_retain(ht, is_multiple, &divisor, 0) == n/2 );
+    upo_ht_sepchain_stats(ht, &stats);
+    assert( stats.resizes == resizes );
+    assert( upo_ht_sepchain_size(ht) == n/2 );
+    for (i = 0; i < n; ++i)
+    {
+        assert( upo_ht_sepchain_get(ht, &keys[i]) == ((i % 2 == 0) ? &keys[i] : NULL) );
+    }
+
+    /* Keep multiples of 50, shrinking the hash table */
+    divisor = 50;
+    upo_ht_sepchain_stats(ht, &stats);
+    resizes = stats.resizes;
+    assert( upo_ht_sepchain_retain(ht, is_multiple, &divisor, 0) == n/2 - 4 );
+    upo_ht_sepchain_stats(ht, &stats);
+    assert( stats.resizes == resizes );
+    assert( upo_ht_sepchain_size(ht) == 4 );
+    for (i = 0; i < n; ++i)
+    {
+        assert( upo_ht_sepchain_contains(ht, &keys[i]) == (i % 50 == 0) );
+    }
+
+    /* Keep nothing, freeing data */
+    upo_ht_sepchain_clear(ht, 0);
+    for (i = 0; i < 10; ++i)
+    {
+        int *key = malloc(sizeof(int));
+
+        assert( key != NULL );
+
+        *key = (int) (2*i + 1);
+        upo_ht_sepchain_put(ht, key, malloc(sizeof(int)));
+    }
+    divisor = 2;
+    assert( upo_ht_sepchain_retain(ht, is_multiple, &divisor, 1) == 10 );
+    assert( upo_ht_sepchain_is_empty(ht) );
+    upo_ht_sepchain_put(ht, &keys[1], &keys[1]);
+    assert( upo_ht_sepchain_get(ht, &keys[1]) == &keys[1] );
+
+    upo_ht_sepchain_destroy(ht, 0);
+}
+
+void test_policies()
+{
+    upo_ht_sepchain_policy_t policies[] = {UPO_HT_SEPCHAIN_POLICY_HEAD,
+                                           UPO_HT_SEPCHAIN_POLICY_MOVE_TO_FRONT,
+                                           UPO_HT_SEPCHAIN_POLICY_TRANSPOSE,
+                                           UPO_HT_SEPCHAIN_POLICY_SORTED};
+    int keys[20];
+    int missing = -1;
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t i = 0;
+    size_t j = 0;
+
+    for (i = 0; i < n; ++i)
+    {
+        keys[i] = (int) ((7*i) % n);
+    }
+
+    for (j = 0; j < sizeof policies/sizeof policies[0]; ++j)
+    {
+        /* A single slot, so that all keys are in the same list */
+        upo_ht_sepchain_t ht = upo_ht_sepchain_create(1, upo_ht_hash_int_div, int_compare);
+        upo_ht_stats_t stats;
+        size_t cmps = 0;
+
+        assert( ht != NULL );
+
+        upo_ht_sepchain_set_policy(ht, policies[j]);
+        assert( upo_ht_sepchain_get_policy(ht) == policies[j] );
+
+        for (i = 0; i < n; ++i)
+        {
+            upo_ht_sepchain_put(ht, &keys[i], &keys[i]);
+        }
+        for (i = 0; i < n; ++i)
+        {
+            assert( upo_ht_sepchain_get(ht, &keys[i]) == &keys[i] );
+        }
+
+        upo_ht_sepchain_enable_stats(ht);
+
+        /* Look up the first inserted key twice */
+        upo_ht_sepchain_get(ht, &keys[0]);
+        upo_ht_sepchain_stats(ht, &stats);
+        cmps = stats.cmp_calls;
+        upo_ht_sepchain_get(ht, &keys[0]);
+        upo_ht_sepchain_stats(ht, &stats);
+        cmps = stats.cmp_calls - cmps;
+
+        switch (policies[j])
+        {
+            case UPO_HT_SEPCHAIN_POLICY_HEAD:
+                assert( cmps == n ); // Last node of the list
+                break;
+            case UPO_HT_SEPCHAIN_POLICY_MOVE_TO_FRONT:
+                assert( cmps == 1 ); // Moved to the head
+                break;
+            case UPO_HT_SEPCHAIN_POLICY_TRANSPOSE:
+                assert( cmps < n ); // Moved one step towards the head
+                break;
+            case UPO_HT_SEPCHAIN_POLICY_SORTED:
+                assert( cmps == 1 ); // Smallest key
+                break;
+        }
+
+        /* Misses stop early only in sorted lists */
+        upo_ht_sepchain_stats(ht, &stats);
+        cmps = stats.cmp_calls;
+        assert( upo_ht_sepchain_get(ht, &missing) == NULL );
+        upo_ht_sepchain_stats(ht, &stats);
+        assert( stats.cmp_calls - cmps == ((policies[j] == UPO_HT_SEPCHAIN_POLICY_SORTED) ? 1 : n) );
+
+        /* Reorganized lists still hold all keys */
+        for (i = 0; i < n; i += 2)
+        {
+            upo_ht_sepchain_delete(ht, &keys[i], 0);
+        }
+        for (i = 0; i < n; ++i)
+        {
+            assert( upo_ht_sepchain_get(ht, &keys[i]) == ((i % 2) ? &keys[i] : NULL) );
+        }
+        assert( upo_ht_sepchain_size(ht) == n/2 );
+
+        upo_ht_sepchain_destroy(ht, 0);
+    }
+}
+
+void test_sort_policy()
+{
+    int keys[] = {5,3,9,1,7,2,8,0,6,4};
+    int prev = -1;
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t i = 0;
+    upo_ht_sepchain_t ht = NULL;
+    upo_ht_key_list_t list = NULL;
+
+    ht = upo_ht_sepchain_create(1, upo_ht_hash_int_div, int_compare);
+
+    assert( ht != NULL );
+
+    for (i = 0; i < n; ++i)
+    {
+        upo_ht_sepchain_put(ht, &keys[i], &keys[i]);
+    }
+
+    /* Switching to sorted lists sorts the existing ones */
+    upo_ht_sepchain_set_policy(ht, UPO_HT_SEPCHAIN_POLICY_SORTED);
+    upo_ht_sepchain_traverse(ht, check_ascending_visit, &prev);
+    assert( prev == 9 );
+
+    /* Sorted insertions */
+    upo_ht_sepchain_delete(ht, &keys[0], 0);
+    upo_ht_sepchain_put(ht, &keys[0], &keys[0]);
+    prev = -1;
+    upo_ht_sepchain_traverse(ht, check_ascending_visit, &prev);
+    assert( prev == 9 );
+
+    list = upo_ht_sepchain_keys(ht);
+    for (i = 0; list != NULL; ++i)
+    {
+        upo_ht_key_list_node_t *node = list;
+
+        list = list->next;
+        free(node);
+    }
+    assert( i == n );
+
+    upo_ht_sepchain_destroy(ht, 0);
+}
+
+void test_budget()
+{
+    int keys[1000];
+    int sizes[] = {100, 2000};
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t m = 17;
+    size_t i = 0;
+    size_t evicted = 0;
+    size_t node_bytes = 0;
+    upo_ht_budget_t budget;
+    upo_ht_sepchain_t ht = upo_ht_sepchain_create(m, upo_ht_hash_int_div, int_compare);
+
+    for (i = 0; i < n; ++i)
+    {
+        keys[i] = (int) i;
+    }
+
+    /* The budget is the memory of the hash table with 50 pairs */
+    node_bytes = upo_ht_sepchain_memory(ht);
+    upo_ht_sepchain_put(ht, &keys[0], &keys[0]);
+    node_bytes = upo_ht_sepchain_memory(ht) - node_bytes;
+    upo_ht_sepchain_delete(ht, &keys[0], 0);
+    budget.max_bytes = upo_ht_sepchain_memory(ht) + 50*node_bytes;
+    budget.data_size = NULL;
+    budget.rank = NULL;
+    budget.samples = 0;
+    budget.evict = count_key_visit;
+    budget.arg = &evicted;
+    budget.destroy_data = 0;
+
+    /* Random eviction */
+    upo_ht_sepchain_set_budget(ht, &budget);
+    for (i = 0; i < n; ++i)
+    {
+        upo_ht_sepchain_put(ht, &keys[i], &keys[i]);
+        assert( upo_ht_sepchain_contains(ht, &keys[i]) );
+        assert( upo_ht_sepchain_memory(ht) <= budget.max_bytes );
+        assert( upo_ht_sepchain_size(ht) == (i < 50 ? i+1 : 50) );
+        assert( upo_ht_sepchain_size(ht) + evicted == i+1 );
+    }
+
+    /* Ranked eviction over all pairs: the smallest keys go first */
+    upo_ht_sepchain_clear(ht, 0);
+    budget.rank = int_key_rank;
+    budget.samples = n;
+    upo_ht_sepchain_set_budget(ht, &budget);
+    for (i = 0; i < n; ++i)
+    {
+        upo_ht_sepchain_insert(ht, &keys[i], &keys[i]);
+    }
+    for (i = 0; i < n; ++i)
+    {
+        assert( upo_ht_sepchain_contains(ht, &keys[i]) == (i >= n-50) );
+    }
+
+    /* Sized data: each pair takes 100 bytes more, so 10 pairs fit */
+    upo_ht_sepchain_clear(ht, 0);
+    budget.max_bytes = upo_ht_sepchain_memory(ht) + 10*(node_bytes + sizes[0]);
+    budget.data_size = int_value_size;
+    upo_ht_sepchain_set_budget(ht, &budget);
+    for (i = 0; i < n; ++i)
+    {
+        upo_ht_sepchain_put(ht, &keys[i], &sizes[0]);
+        assert( upo_ht_sepchain_memory(ht) <= budget.max_bytes );
+    }
+    assert( upo_ht_sepchain_size(ht) == 10 );
+    assert( upo_ht_sepchain_contains(ht, &keys[n-10]) );
+
+    /* A larger value evicts other pairs, but never its own key */
+    upo_ht_sepchain_put(ht, &keys[n-10], &sizes[1]);
+    assert( upo_ht_sepchain_size(ht) == 1 );
+    assert( upo_ht_sepchain_get(ht, &keys[n-10]) == &sizes[1] );
+    upo_ht_sepchain_delete(ht, &keys[n-10], 0);
+    assert( upo_ht_sepchain_memory(ht) + 10*(node_bytes + sizes[0]) == budget.max_bytes );
+
+    /* Removing the budget lets the table fill, setting it evicts at once */
+    upo_ht_sepchain_set_budget(ht, NULL);
+    for (i = 0; i < n; ++i)
+    {
+        upo_ht_sepchain_put(ht, &keys[i], &sizes[0]);
+    }
+    assert( upo_ht_sepchain_size(ht) == n );
+    budget.max_bytes -= 5*(node_bytes + sizes[0]);
+    upo_ht_sepchain_set_budget(ht, &budget);
+    assert( upo_ht_sepchain_size(ht) == 5 );
+    assert( upo_ht_sepchain_contains(ht, &keys[n-1]) );
+
+    upo_ht_sepchain_destroy(ht, 0);
+
+    /* Evicted data is freed if requested */
+    ht = upo_ht_sepchain_create(m, upo_ht_hash_int_div, int_compare);
+    budget.max_bytes = upo_ht_sepchain_memory(ht) + 50*node_bytes;
+    budget.data_size = NULL;
+    budget.rank = NULL;
+    budget.samples = 0;
+    budget.evict = NULL;
+    budget.destroy_data = 1;
+    upo_ht_sepchain_set_policy(ht, UPO_HT_SEPCHAIN_POLICY_MOVE_TO_FRONT);
+    upo_ht_sepchain_set_budget(ht, &budget);
+    for (i = 0; i < n; ++i)
+    {
+        int *key = malloc(sizeof(int));
+
+        assert( key != NULL );
+
+        *key = (int) i;
+        upo_ht_sepchain_put(ht, key, malloc(sizeof(int)));
+        assert( upo_ht_sepchain_memory(ht) <= budget.max_bytes );
+    }
+    assert( upo_ht_sepchain_size(ht) == 50 );
+    upo_ht_sepchain_destroy(ht, 1);
+}
+
 
 int main()
 {
@@ -383,6 +979,46 @@ int main()
     test_traverse();
     printf("OK\n");
 
+    printf("Test case 'stats'... ");
+    fflush(stdout);
+    test_stats();
+    printf("OK\n");
+
+    printf("Test case 'generations'... ");
+    fflush(stdout);
+    test_generations();
+    printf("OK\n");
+
+    printf("Test case 'get_or_insert'... ");
+    fflush(stdout);
+    test_get_or_insert();
+    printf("OK\n");
+
+    printf("Test case 'compute'... ");
+    fflush(stdout);
+    test_compute();
+    printf("OK\n");
+
+    printf("Test case 'retain'... ");
+    fflush(stdout);
+    test_retain();
+    printf("OK\n");
+
+    printf("Test case 'policies'... ");
+    fflush(stdout);
+    test_policies();
+    printf("OK\n");
+
+    printf("Test case 'sort_policy'... ");
+    fflush(stdout);
+    test_sort_policy();
+    printf("OK\n");
+
+    printf("Test case 'budget'... ");
+    fflush(stdout);
+    test_budget();
+    printf("OK\n");
+
 
     return 0;
 }
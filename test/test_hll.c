@@ -0,0 +1,309 @@
+/*
+ * Copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ * This file is part of UPOalglib.
+ *
+ * UPOalglib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * UPOalglib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <upo/hll.h>
+
+
+#define NUM_KEYS 1000000
+#define PRECISION 14U
+
+
+static void test_create_destroy();
+static void test_add_estimate();
+static void test_sparse_to_dense();
+static void test_merge();
+static void test_serialize();
+static double relative_error(double estimate, double exact);
+
+
+static int *keys;
+
+
+double relative_error(double estimate, double exact)
+{
+    return fabs(estimate - exact) / exact;
+}
+
+void test_create_destroy()
+{
+    upo_hll_t hll = upo_hll_create(PRECISION, upo_ht_hash_int_div);
+
+    assert( hll != NULL );
+    assert( upo_hll_precision(hll) == PRECISION );
+    assert( upo_hll_get_hasher(hll) == upo_ht_hash_int_div );
+    assert( upo_hll_is_sparse(hll) );
+    assert( upo_hll_estimate(hll) == 0 );
+    upo_hll_destroy(hll);
+
+    hll = upo_hll_create(UPO_HLL_MIN_PRECISION, NULL);
+    assert( upo_hll_get_hasher(hll) == NULL );
+    upo_hll_add_hash(hll, UINT64_C(0x0123456789abcdef));
+    assert( upo_hll_estimate(hll) > 0 );
+    upo_hll_destroy(hll);
+
+    upo_hll_destroy(NULL);
+    assert( upo_hll_precision(NULL) == 0 );
+    assert( upo_hll_estimate(NULL) == 0 );
+}
+
+void test_add_estimate()
+{
+    upo_hll_t hll = upo_hll_create(PRECISION, upo_ht_hash_int_div);
+    size_t n = 0;
+    size_t next = 10;
+    double estimate = 0;
+
+    /* The standard error is 1.04/sqrt(2^14), that is about 0.8% */
+    for (n = 0; n < NUM_KEYS; ++n)
+    {
+        upo_hll_add(hll, &keys[n]);
+        if (n + 1 == next)
+        {
+            assert( relative_error(upo_hll_estimate(hll), (double) next) < 0.03 );
+            next *= 10;
+        }
+    }
+
+    /* Duplicates do not change the estimate */
+    estimate = upo_hll_estimate(hll);
+    for (n = 0; n < NUM_KEYS; n += 7)
+    {
+        upo_hll_add(hll, &keys[n]);
+    }
+    assert( upo_hll_estimate(hll) == estimate );
+
+    upo_hll_clear(hll);
+    assert( upo_hll_is_sparse(hll) );
+    assert( upo_hll_estimate(hll) == 0 );
+    upo_hll_add(hll, &keys[0]);
+    upo_hll_add(hll, &keys[0]);
+    assert( relative_error(upo_hll_estimate(hll), 1) < 0.01 );
+
+    upo_hll_destroy(hll);
+
+    /* The lowest precision still gives a rough estimate */
+    hll = upo_hll_create(UPO_HLL_MIN_PRECISION, upo_ht_hash_int_div);
+    for (n = 0; n < NUM_KEYS; ++n)
+    {
+        upo_hll_add(hll, &keys[n]);
+    }
+    assert( relative_error(upo_hll_estimate(hll), NUM_KEYS) < 1 );
+    upo_hll_destroy(hll);
+}
+
+void test_sparse_to_dense()
+{
+    upo_hll_t hll = upo_hll_create(PRECISION, upo_ht_hash_int_div);
+    upo_hll_t dense = upo_hll_create(PRECISION, upo_ht_hash_int_div);
+    size_t n = 0;
+    double estimate = 0;
+
+    /* Sparse until 2^14/4 registers are set */
+    for (n = 0; upo_hll_is_sparse(hll); ++n)
+    {
+        estimate = upo_hll_estimate(hll);
+        upo_hll_add(hll, &keys[n]);
+        assert( upo_hll_estimate(hll) >= estimate );
+    }
+    assert( n > 4000 && n < 5000 );
+    assert( upo_hll_serialized_size(hll) == 16 + 3*(1U << PRECISION)/4 );
+
+    /* The same keys added to a sketch forced dense by merging give the same estimate */
+    upo_hll_merge(dense, hll);
+    assert( !upo_hll_is_sparse(dense) );
+    upo_hll_clear(hll);
+    for (; n > 0; --n)
+    {
+        upo_hll_add(hll, &keys[n-1]);
+    }
+    assert( !upo_hll_is_sparse(hll) );
+    assert( upo_hll_estimate(hll) == upo_hll_estimate(dense) );
+
+    upo_hll_destroy(hll);
+    upo_hll_destroy(dense);
+}
+
+void test_merge()
+{
+    static const size_t sizes[] = {0, 100, 3000, 50000};
+    size_t i = 0;
+    size_t j = 0;
+    size_t n = 0;
+
+    /* Every combination of sparse and dense operands */
+    for (i = 0; i < sizeof sizes/sizeof sizes[0]; ++i)
+    {
+        for (j = 0; j < sizeof sizes/sizeof sizes[0]; ++j)
+        {
+            upo_hll_t a = upo_hll_create(PRECISION, upo_ht_hash_int_div);
+            upo_hll_t b = upo_hll_create(PRECISION, upo_ht_hash_int_div);
+            upo_hll_t all = upo_hll_create(PRECISION, upo_ht_hash_int_div);
+
+            /* The two halves overlap */
+            for (n = 0; n < sizes[i]; ++n)
+            {
+                upo_hll_add(a, &keys[n]);
+                upo_hll_add(all, &keys[n]);
+            }
+            for (n = sizes[i]/2; n < sizes[i]/2 + sizes[j]; ++n)
+            {
+                upo_hll_add(b, &keys[n]);
+                upo_hll_add(all, &keys[n]);
+            }
+
+            assert( upo_hll_merge(a, b) );
+            assert( upo_hll_estimate(a) == upo_hll_estimate(all) );
+            assert( upo_hll_is_sparse(a) == upo_hll_is_sparse(all) );
+
+            upo_hll_destroy(a);
+            upo_hll_destroy(b);
+            upo_hll_destroy(all);
+        }
+    }
+
+    /* Sketches with a different precision or hasher cannot be merged */
+    {
+        upo_hll_t a = upo_hll_create(PRECISION, upo_ht_hash_int_div);
+        upo_hll_t b = upo_hll_create(PRECISION + 1, upo_ht_hash_int_div);
+        upo_hll_t c = upo_hll_create(PRECISION, NULL);
+
+        upo_hll_add(a, &keys[0]);
+        assert( !upo_hll_merge(a, b) );
+        assert( !upo_hll_merge(a, c) );
+        assert( relative_error(upo_hll_estimate(a), 1) < 0.01 );
+
+        upo_hll_destroy(a);
+        upo_hll_destroy(b);
+        upo_hll_destroy(c);
+    }
+}
+
+void test_serialize()
+{
+    static const size_t sizes[] = {0, 1, 1000, 100000};
+    size_t i = 0;
+    size_t n = 0;
+
+    for (i = 0; i < sizeof sizes/sizeof sizes[0]; ++i)
+    {
+        upo_hll_t hll = upo_hll_create(PRECISION, upo_ht_hash_int_div);
+        upo_hll_t copy = NULL;
+        unsigned char *buf = NULL;
+        unsigned char *buf2 = NULL;
+        size_t size = 0;
+
+        for (n = 0; n < sizes[i]; ++n)
+        {
+            upo_hll_add(hll, &keys[n]);
+        }
+        size = upo_hll_serialized_size(hll);
+        buf = malloc(size);
+        buf2 = malloc(size);
+        assert( buf != NULL && buf2 != NULL );
+        upo_hll_serialize(hll, buf);
+
+        copy = upo_hll_deserialize(buf, size, upo_ht_hash_int_div);
+        assert( copy != NULL );
+        assert( upo_hll_precision(copy) == PRECISION );
+        assert( upo_hll_is_sparse(copy) == upo_hll_is_sparse(hll) );
+        assert( upo_hll_estimate(copy) == upo_hll_estimate(hll) );
+        assert( upo_hll_serialized_size(copy) == size );
+        upo_hll_serialize(copy, buf2);
+        assert( memcmp(buf, buf2, size) == 0 );
+        upo_hll_destroy(copy);
+
+        /* Truncated buffers, bad magic and bad precision are rejected */
+        assert( upo_hll_deserialize(buf, size - 1, upo_ht_hash_int_div) == NULL );
+        memcpy(buf2, buf, size);
+        buf2[0] ^= 1;
+        assert( upo_hll_deserialize(buf2, size, upo_ht_hash_int_div) == NULL );
+        memcpy(buf2, buf, size);
+        buf2[8] = UPO_HLL_MAX_PRECISION + 1;
+        assert( upo_hll_deserialize(buf2, size, upo_ht_hash_int_div) == NULL );
+
+        /* Out of range register values are rejected */
+        if (size > 16)
+        {
+            memcpy(buf2, buf, size);
+            buf2[16] |= 0x3F;
+            assert( upo_hll_deserialize(buf2, size, upo_ht_hash_int_div) == NULL );
+        }
+
+        /* Unsorted sparse entries are rejected */
+        if (upo_hll_is_sparse(hll) && size >= 16 + 8)
+        {
+            memcpy(buf2, buf, size);
+            memcpy(buf2 + 16, buf + 20, 4);
+            memcpy(buf2 + 20, buf + 16, 4);
+            assert( upo_hll_deserialize(buf2, size, upo_ht_hash_int_div) == NULL );
+        }
+
+        free(buf);
+        free(buf2);
+        upo_hll_destroy(hll);
+    }
+}
+
+int main()
+{
+    size_t i = 0;
+
+    keys = malloc(NUM_KEYS*sizeof(int));
+    assert( keys != NULL );
+    for (i = 0; i < NUM_KEYS; ++i)
+    {
+        keys[i] = (int) i;
+    }
+
+    printf("Test case 'create/destroy'... ");
+    fflush(stdout);
+    test_create_destroy();
+    printf("OK\n");
+
+    printf("Test case 'add/estimate'... ");
+    fflush(stdout);
+    test_add_estimate();
+    printf("OK\n");
+
+    printf("Test case 'sparse to dense'... ");
+    fflush(stdout);
+    test_sparse_to_dense();
+    printf("OK\n");
+
+    printf("Test case 'merge'... ");
+    fflush(stdout);
+    test_merge();
+    printf("OK\n");
+
+    printf("Test case 'serialize'... ");
+    fflush(stdout);
+    test_serialize();
+    printf("OK\n");
+
+    free(keys);
+
+    return 0;
+}
@@ -0,0 +1,518 @@
+/*
+ * Copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ * This file is part of UPOalglib.
+ *
+ * UPOalglib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * UPOalglib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Needed for getpid() and truncate() */
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <upo/kvstore.h>
+
+
+#define NUM_WRITERS 4
+#define NUM_WRITES 200
+
+
+static void make_path(char *path, size_t n, const char *suffix);
+static void put_int(upo_kvstore_t store, int key, int value);
+static int get_int(upo_kvstore_t store, int key);
+static void* write_keys(void *arg);
+
+static void test_put_get_delete();
+static void test_reopen();
+static void test_torn_tail();
+static void test_corrupted_record();
+static void test_compact();
+static void test_background_compact();
+static void test_group_commit();
+
+
+/* Arguments of the writer threads of test_group_commit() */
+struct writer_s
+{
+    upo_kvstore_t store;
+    int first;
+};
+
+
+// Makes a path of log file unique to this process
+void make_path(char *path, size_t n, const char *suffix)
+{
+    snprintf(path, n, "/tmp/upo_kvstore_%ld_%s.log", (long) getpid(), suffix);
+    remove(path);
+}
+
+// Stores an integer value under an integer key
+void put_int(upo_kvstore_t store, int key, int value)
+{
+    upo_kvstore_put(store, &key, sizeof key, &value, sizeof value);
+}
+
+// Returns the integer value stored under an integer key, or -1 if the key is not found
+int get_int(upo_kvstore_t store, int key)
+{
+    int value = -1;
+    size_t value_size = sizeof value;
+
+    if (!upo_kvstore_get(store, &key, sizeof key, &value, &value_size))
+        return -1;
+    assert( value_size == sizeof value );
+
+    return value;
+}
+
+// Stores NUM_WRITES keys starting from the given one
+void* write_keys(void *arg)
+{
+    struct writer_s *w = arg;
+    int i = 0;
+
+    for (i = 0; i < NUM_WRITES; ++i)
+    {
+        put_int(w->store, w->first + i, i);
+    }
+
+    return NULL;
+}
+
+void test_put_get_delete()
+{
+    char path[128];
+    upo_kvstore_t store = NULL;
+    char buf[64];
+    size_t buf_size = 0;
+    int i = 0;
+
+    make_path(path, sizeof path, "putget");
+
+    store = upo_kvstore_open(path);
+    assert( store != NULL );
+    assert( upo_kvstore_is_empty(store) );
+    assert( upo_kvstore_log_size(store) == 0 );
+
+    for (i = 0; i < 100; ++i)
+    {
+        char key[32];
+
+        snprintf(key, sizeof key, "key-%d", i);
+        snprintf(buf, sizeof buf, "value-%d", i);
+        upo_kvstore_put(store, key, strlen(key), buf, strlen(buf) + 1);
+    }
+    assert( upo_kvstore_size(store) == 100 );
+    assert( upo_kvstore_live_size(store) == upo_kvstore_log_size(store) );
+
+    buf_size = sizeof buf;
+    assert( upo_kvstore_get(store, "key-42", 6, buf, &buf_size) == 1 );
+    assert( buf_size == 9 && strcmp(buf, "value-42") == 0 );
+    assert( upo_kvstore_contains(store, "key-99", 6) );
+    assert( !upo_kvstore_contains(store, "key-100", 7) );
+    assert( upo_kvstore_get(store, "key-100", 7, buf, &buf_size) == 0 );
+
+    /* The value is copied up to the size of the buffer */
+    buf_size = 3;
+    memset(buf, 0, sizeof buf);
+    assert( upo_kvstore_get(store, "key-7", 5, buf, &buf_size) == 1 );
+    assert( buf_size == 8 && memcmp(buf, "val", 3) == 0 && buf[3] == '\0' );
+
+    /* Replacing a value leaves the old record as garbage */
+    upo_kvstore_put(store, "key-7", 5, "seven", 6);
+    buf_size = sizeof buf;
+    assert( upo_kvstore_get(store, "key-7", 5, buf, &buf_size) == 1 );
+    assert( buf_size == 6 && strcmp(buf, "seven") == 0 );
+    assert( upo_kvstore_size(store) == 100 );
+    assert( upo_kvstore_live_size(store) < upo_kvstore_log_size(store) );
+
+    /* Empty keys and values */
+    upo_kvstore_put(store, "", 0, "", 0);
+    buf_size = sizeof buf;
+    assert( upo_kvstore_get(store, "", 0, buf, &buf_size) == 1 );
+    assert( buf_size == 0 );
+
+    assert( upo_kvstore_delete(store, "key-7", 5) == 1 );
+    assert( upo_kvstore_delete(store, "key-7", 5) == 0 );
+    assert( upo_kvstore_delete(store, "", 0) == 1 );
+    assert( !upo_kvstore_contains(store, "key-7", 5) );
+    assert( upo_kvstore_size(store) == 99 );
+
+    upo_kvstore_close(store);
+    remove(path);
+
+    upo_kvstore_close(NULL);
+    assert( upo_kvstore_size(NULL) == 0 );
+    assert( upo_kvstore_is_empty(NULL) );
+    assert( upo_kvstore_log_size(NULL) == 0 );
+    assert( upo_kvstore_live_size(NULL) == 0 );
+    assert( upo_kvstore_syncs(NULL) == 0 );
+}
+
+void test_reopen()
+{
+    char path[128];
+    upo_kvstore_t store = NULL;
+    uint64_t log_size = 0;
+    uint64_t live_size = 0;
+    int i = 0;
+
+    make_path(path, sizeof path, "reopen");
+
+    store = upo_kvstore_open(path);
+    for (i = 0; i < 1000; ++i)
+    {
+        put_int(store, i, i);
+    }
+    for (i = 0; i < 1000; i += 2)
+    {
+        put_int(store, i, -i);
+    }
+    for (i = 0; i < 1000; i += 3)
+    {
+        assert( upo_kvstore_delete(store, &i, sizeof i) == 1 );
+    }
+    log_size = upo_kvstore_log_size(store);
+    live_size = upo_kvstore_live_size(store);
+    upo_kvstore_close(store);
+
+    /* Replaying the log rebuilds the same index */
+    store = upo_kvstore_open(path);
+    assert( upo_kvstore_size(store) == 1000 - 334 );
+    assert( upo_kvstore_log_size(store) == log_size );
+    assert( upo_kvstore_live_size(store) == live_size );
+    for (i = 0; i < 1000; ++i)
+    {
+        if (i % 3 == 0)
+            assert( get_int(store, i) == -1 );
+        else
+            assert( get_int(store, i) == (i % 2 == 0 ? -i : i) );
+    }
+
+    /* New records follow the replayed ones */
+    put_int(store, 0, 7);
+    upo_kvstore_close(store);
+    store = upo_kvstore_open(path);
+    assert( get_int(store, 0) == 7 );
+    assert( upo_kvstore_size(store) == 1000 - 333 );
+    upo_kvstore_close(store);
+
+    remove(path);
+}
+
+void test_torn_tail()
+{
+    char path[128];
+    upo_kvstore_t store = NULL;
+    uint64_t log_size = 0;
+    FILE *fp = NULL;
+
+    make_path(path, sizeof path, "torn");
+
+    store = upo_kvstore_open(path);
+    put_int(store, 1, 10);
+    put_int(store, 2, 20);
+    log_size = upo_kvstore_log_size(store);
+    put_int(store, 3, 30);
+    upo_kvstore_close(store);
+
+    /* A crash in the middle of an append leaves an incomplete record */
+    assert( truncate(path, (off_t) log_size + 5) == 0 );
+
+    store = upo_kvstore_open(path);
+    assert( upo_kvstore_size(store) == 2 );
+    assert( get_int(store, 1) == 10 );
+    assert( get_int(store, 2) == 20 );
+    assert( get_int(store, 3) == -1 );
+    assert( upo_kvstore_log_size(store) == log_size );
+    put_int(store, 3, 33);
+    upo_kvstore_close(store);
+
+    /* The tail has been truncated, so the new record is found on replay */
+    store = upo_kvstore_open(path);
+    assert( upo_kvstore_size(store) == 3 );
+    assert( get_int(store, 3) == 33 );
+    log_size = upo_kvstore_log_size(store);
+    upo_kvstore_close(store);
+
+    /* So is a tail of zeros, as left by a file system that extended the file first */
+    fp = fopen(path, "ab");
+    assert( fp != NULL );
+    assert( fwrite("\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0", 1, 16, fp) == 16 );
+    fclose(fp);
+
+    store = upo_kvstore_open(path);
+    assert( upo_kvstore_size(store) == 3 );
+    assert( upo_kvstore_log_size(store) == log_size );
+    upo_kvstore_close(store);
+
+    remove(path);
+}
+
+void test_corrupted_record()
+{
+    char path[128];
+    upo_kvstore_t store = NULL;
+    uint64_t log_size = 0;
+    FILE *fp = NULL;
+    int c = 0;
+
+    make_path(path, sizeof path, "corrupted");
+
+    store = upo_kvstore_open(path);
+    put_int(store, 1, 10);
+    log_size = upo_kvstore_log_size(store);
+    put_int(store, 2, 20);
+    put_int(store, 3, 30);
+    upo_kvstore_close(store);
+
+    /* Flip a bit of the value of the second record */
+    fp = fopen(path, "r+b");
+    assert( fp != NULL );
+    assert( fseek(fp, (long) log_size + 12 + (long) sizeof(int), SEEK_SET) == 0 );
+    c = fgetc(fp);
+    assert( c != EOF );
+    assert( fseek(fp, (long) log_size + 12 + (long) sizeof(int), SEEK_SET) == 0 );
+    assert( fputc(c ^ 1, fp) != EOF );
+    fclose(fp);
+
+    /* The log ends at the first record whose checksum does not match */
+    store = upo_kvstore_open(path);
+    assert( upo_kvstore_size(store) == 1 );
+    assert( get_int(store, 1) == 10 );
+    assert( get_int(store, 2) == -1 );
+    assert( get_int(store, 3) == -1 );
+    assert( upo_kvstore_log_size(store) == log_size );
+    upo_kvstore_close(store);
+
+    remove(path);
+}
+
+void test_compact()
+{
+    char path[128];
+    char compact_path[160];
+    upo_kvstore_t store = NULL;
+    uint64_t live_size = 0;
+    FILE *fp = NULL;
+    int i = 0;
+    int j = 0;
+
+    make_path(path, sizeof path, "compact");
+
+    store = upo_kvstore_open(path);
+    for (j = 0; j < 10; ++j)
+    {
+        for (i = 0; i < 100; ++i)
+        {
+            put_int(store, i, i*j);
+        }
+    }
+    for (i = 0; i < 100; i += 10)
+    {
+        assert( upo_kvstore_delete(store, &i, sizeof i) == 1 );
+    }
+    live_size = upo_kvstore_live_size(store);
+    assert( upo_kvstore_log_size(store) > 10*live_size );
+
+    assert( upo_kvstore_compact(store) == 1 );
+    assert( upo_kvstore_log_size(store) == live_size );
+    assert( upo_kvstore_live_size(store) == live_size );
+    assert( upo_kvstore_size(store) == 90 );
+    for (i = 0; i < 100; ++i)
+    {
+        assert( get_int(store, i) == (i % 10 == 0 ? -1 : i*9) );
+    }
+
+    /* The compacted log is appended to and replayed as usual */
+    put_int(store, 0, 1);
+    upo_kvstore_close(store);
+
+    /* A leftover of an interrupted compaction is ignored */
+    snprintf(compact_path, sizeof compact_path, "%s.compact", path);
+    fp = fopen(compact_path, "wb");
+    assert( fp != NULL );
+    assert( fwrite("garbage", 1, 7, fp) == 7 );
+    fclose(fp);
+
+    store = upo_kvstore_open(path);
+    assert( upo_kvstore_size(store) == 91 );
+    assert( get_int(store, 0) == 1 );
+    for (i = 1; i < 100; ++i)
+    {
+        assert( get_int(store, i) == (i % 10 == 0 ? -1 : i*9) );
+    }
+    assert( fopen(compact_path, "rb") == NULL );
+
+    /* Compacting a log without garbage keeps it as it is */
+    live_size = upo_kvstore_live_size(store);
+    assert( upo_kvstore_compact(store) == 1 );
+    assert( upo_kvstore_log_size(store) == live_size );
+    upo_kvstore_close(store);
+
+    remove(path);
+}
+
+void test_background_compact()
+{
+    char path[128];
+    upo_kvstore_t store = NULL;
+    int i = 0;
+    int j = 0;
+
+    make_path(path, sizeof path, "background");
+
+    store = upo_kvstore_open(path);
+    for (j = 0; j < 20; ++j)
+    {
+        for (i = 0; i < 500; ++i)
+        {
+            put_int(store, i, j);
+        }
+    }
+
+    /* Keep updating, removing and adding keys while the log is compacted */
+    assert( upo_kvstore_compact_async(store) == 1 );
+    for (j = 0; j < 3; ++j)
+    {
+        for (i = 0; i < 500; i += 2)
+        {
+            put_int(store, i, 100 + j);
+        }
+        for (i = 1; i < 500; i += 10)
+        {
+            upo_kvstore_delete(store, &i, sizeof i);
+        }
+        for (i = 500; i < 600; ++i)
+        {
+            put_int(store, i, j);
+        }
+        upo_kvstore_compact_async(store);
+    }
+    upo_kvstore_close(store);
+
+    store = upo_kvstore_open(path);
+    assert( upo_kvstore_size(store) == 600 - 50 );
+    for (i = 0; i < 600; ++i)
+    {
+        if (i >= 500)
+            assert( get_int(store, i) == 2 );
+        else if (i % 2 == 0)
+            assert( get_int(store, i) == 102 );
+        else if (i % 10 == 1)
+            assert( get_int(store, i) == -1 );
+        else
+            assert( get_int(store, i) == 19 );
+    }
+    assert( upo_kvstore_compact(store) == 1 );
+    assert( upo_kvstore_log_size(store) == upo_kvstore_live_size(store) );
+    upo_kvstore_close(store);
+
+    remove(path);
+}
+
+void test_group_commit()
+{
+    char path[128];
+    upo_kvstore_t store = NULL;
+    pthread_t threads[NUM_WRITERS];
+    struct writer_s writers[NUM_WRITERS];
+    size_t syncs = 0;
+    int i = 0;
+
+    make_path(path, sizeof path, "group");
+
+    store = upo_kvstore_open(path);
+    upo_kvstore_set_sync(store, 1);
+
+    /* Each update returns once its record is durable */
+    put_int(store, -1, 0);
+    assert( upo_kvstore_syncs(store) == 1 );
+    upo_kvstore_sync(store);
+    assert( upo_kvstore_syncs(store) == 1 );
+
+    for (i = 0; i < NUM_WRITERS; ++i)
+    {
+        writers[i].store = store;
+        writers[i].first = i*NUM_WRITES;
+        assert( pthread_create(&threads[i], NULL, write_keys, &writers[i]) == 0 );
+    }
+    for (i = 0; i < NUM_WRITERS; ++i)
+    {
+        assert( pthread_join(threads[i], NULL) == 0 );
+    }
+
+    /* Concurrent updates may share syncs, but never need more than one each */
+    syncs = upo_kvstore_syncs(store);
+    assert( syncs > 1 && syncs <= 1 + NUM_WRITERS*NUM_WRITES );
+    upo_kvstore_close(store);
+
+    store = upo_kvstore_open(path);
+    assert( upo_kvstore_size(store) == 1 + NUM_WRITERS*NUM_WRITES );
+    for (i = 0; i < NUM_WRITERS*NUM_WRITES; ++i)
+    {
+        assert( get_int(store, i) == i % NUM_WRITES );
+    }
+    upo_kvstore_close(store);
+
+    remove(path);
+}
+
+
+int main()
+{
+    printf("Test case 'put/get/delete'... ");
+    fflush(stdout);
+    test_put_get_delete();
+    printf("OK\n");
+
+    printf("Test case 'reopen'... ");
+    fflush(stdout);
+    test_reopen();
+    printf("OK\n");
+
+    printf("Test case 'torn tail'... ");
+    fflush(stdout);
+    test_torn_tail();
+    printf("OK\n");
+
+    printf("Test case 'corrupted record'... ");
+    fflush(stdout);
+    test_corrupted_record();
+    printf("OK\n");
+
+    printf("Test case 'compact'... ");
+    fflush(stdout);
+    test_compact();
+    printf("OK\n");
+
+    printf("Test case 'background compact'... ");
+    fflush(stdout);
+    test_background_compact();
+    printf("OK\n");
+
+    printf("Test case 'group commit'... ");
+    fflush(stdout);
+    test_group_commit();
+    printf("OK\n");
+
+    return 0;
+}
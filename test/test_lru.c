@@ -0,0 +1,345 @@
+/*
+ * Copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ * This file is part of UPOalglib.
+ *
+ * UPOalglib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * UPOalglib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <upo/lru.h>
+
+
+static int int_compare(const void *a, const void *b);
+static void record_evict(void *key, void *value, void *info);
+static void sum_key_visit(void *key, void *value, void *info);
+
+static void test_create_destroy();
+static void test_put_get_delete();
+static void test_eviction();
+static void test_recency();
+static void test_evictor();
+static void test_destroy_data();
+static void test_null();
+
+
+int int_compare(const void *a, const void *b)
+{
+    const int *aa = a;
+    const int *bb = b;
+
+    assert( a != NULL );
+    assert( b != NULL );
+
+    return (*aa > *bb) - (*aa < *bb);
+}
+
+// Records the evicted key in the array of int pointers given as info
+void record_evict(void *key, void *value, void *info)
+{
+    int **evicted = info;
+    size_t i = 0;
+
+    assert( key != NULL );
+    assert( value != NULL );
+
+    while (evicted[i] != NULL)
+        ++i;
+    evicted[i] = key;
+}
+
+// Adds each key to the int given as info, weighting it by the visit order
+void sum_key_visit(void *key, void *value, void *info)
+{
+    int *state = info; // Weighted sum and number of visited keys
+
+    assert( key == value );
+
+    state[1]++;
+    state[0] += state[1] * *((int*) key);
+}
+
+void test_create_destroy()
+{
+    upo_lru_t lru = upo_lru_create(10, upo_ht_hash_int_div, int_compare);
+
+    assert( lru != NULL );
+    assert( upo_lru_is_empty(lru) );
+    assert( upo_lru_size(lru) == 0 );
+    assert( upo_lru_capacity(lru) == 10 );
+    assert( upo_lru_oldest(lru) == NULL );
+    assert( upo_lru_keys(lru) == NULL );
+    assert( upo_lru_get_comparator(lru) == int_compare );
+    assert( upo_lru_get_hasher(lru) == upo_ht_hash_int_div );
+
+    upo_lru_destroy(lru, 0);
+}
+
+void test_put_get_delete()
+{
+    int keys[] = {0, 10, 20, 1, 11, 2};
+    int values[] = {5, 6, 7, 8, 9, 10};
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t i = 0;
+    int missing = 30;
+    upo_lru_t lru = upo_lru_create(10, upo_ht_hash_int_div, int_compare);
+
+    for (i = 0; i < n; ++i)
+    {
+        assert( upo_lru_put(lru, &keys[i], &keys[i], 0) == NULL );
+        assert( upo_lru_size(lru) == i+1 );
+    }
+    for (i = 0; i < n; ++i)
+    {
+        assert( upo_lru_get(lru, &keys[i]) == &keys[i] );
+        assert( upo_lru_put(lru, &keys[i], &values[i], 0) == &keys[i] );
+        assert( upo_lru_peek(lru, &keys[i]) == &values[i] );
+        assert( upo_lru_contains(lru, &keys[i]) );
+    }
+    assert( upo_lru_size(lru) == n );
+    assert( upo_lru_get(lru, &missing) == NULL );
+    assert( upo_lru_peek(lru, &missing) == NULL );
+    assert( !upo_lru_contains(lru, &missing) );
+
+    /* Delete from the middle and from both ends of lists of collisions */
+    upo_lru_delete(lru, &keys[1], 0);
+    upo_lru_delete(lru, &keys[1], 0);
+    upo_lru_delete(lru, &missing, 0);
+    assert( upo_lru_size(lru) == n-1 );
+    assert( !upo_lru_contains(lru, &keys[1]) );
+    upo_lru_delete(lru, &keys[0], 0);
+    upo_lru_delete(lru, &keys[2], 0);
+    for (i = 3; i < n; ++i)
+    {
+        assert( upo_lru_get(lru, &keys[i]) == &values[i] );
+    }
+    assert( upo_lru_size(lru) == n-3 );
+
+    upo_lru_clear(lru, 0);
+    assert( upo_lru_is_empty(lru) );
+    assert( upo_lru_oldest(lru) == NULL );
+    for (i = 0; i < n; ++i)
+    {
+        assert( !upo_lru_contains(lru, &keys[i]) );
+        upo_lru_put(lru, &keys[i], &keys[i], 0);
+    }
+    assert( upo_lru_size(lru) == n );
+
+    upo_lru_destroy(lru, 0);
+}
+
+void test_eviction()
+{
+    int keys[100];
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t m = 8;
+    size_t i = 0;
+    upo_lru_t lru = upo_lru_create(m, upo_ht_hash_int_div, int_compare);
+
+    for (i = 0; i < n; ++i)
+    {
+        keys[i] = (int) (i % 3 == 0 ? i : 8*i); // Many collisions
+        upo_lru_put(lru, &keys[i], &keys[i], 0);
+
+        assert( upo_lru_size(lru) == (i < m ? i+1 : m) );
+        assert( upo_lru_oldest(lru) == &keys[i < m ? 0 : i-m+1] );
+    }
+    for (i = 0; i < n; ++i)
+    {
+        assert( upo_lru_contains(lru, &keys[i]) == (i >= n-m) );
+    }
+
+    assert( upo_lru_evict(lru, 0) == 1 );
+    assert( !upo_lru_contains(lru, &keys[n-m]) );
+    while (upo_lru_evict(lru, 0))
+        ;
+    assert( upo_lru_is_empty(lru) );
+    assert( upo_lru_evict(lru, 0) == 0 );
+
+    upo_lru_destroy(lru, 0);
+}
+
+void test_recency()
+{
+    int keys[] = {1, 2, 3, 4};
+    int key5 = 5;
+    int state[2] = {0, 0};
+    upo_lru_t lru = upo_lru_create(4, upo_ht_hash_int_div, int_compare);
+    upo_ht_key_list_t list = NULL;
+    upo_ht_key_list_t node = NULL;
+    size_t i = 0;
+
+    for (i = 0; i < 4; ++i)
+    {
+        upo_lru_put(lru, &keys[i], &keys[i], 0);
+    }
+
+    /* Recency: 1 (oldest), 2, 3, 4; get and put refresh, peek does not */
+    upo_lru_get(lru, &keys[0]);
+    upo_lru_put(lru, &keys[1], &keys[1], 0);
+    upo_lru_peek(lru, &keys[2]);
+    upo_lru_contains(lru, &keys[2]);
+    assert( upo_lru_oldest(lru) == &keys[2] );
+
+    /* From the newest: 2, 1, 4, 3 */
+    upo_lru_traverse(lru, sum_key_visit, state);
+    assert( state[1] == 4 );
+    assert( state[0] == 1*2 + 2*1 + 3*4 + 4*3 );
+
+    list = upo_lru_keys(lru);
+    assert( *((int*) list->key) == 2 );
+    assert( *((int*) list->next->next->next->key) == 3 );
+    while (list != NULL)
+    {
+        node = list->next;
+        free(list);
+        list = node;
+    }
+
+    upo_lru_put(lru, &key5, &key5, 0);
+    assert( !upo_lru_contains(lru, &keys[2]) );
+    assert( upo_lru_oldest(lru) == &keys[3] );
+
+    upo_lru_destroy(lru, 0);
+}
+
+void test_evictor()
+{
+    int keys[20];
+    int *evicted[21] = {NULL};
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t i = 0;
+    upo_lru_t lru = upo_lru_create(5, upo_ht_hash_int_div, int_compare);
+
+    upo_lru_set_evictor(lru, record_evict, evicted);
+
+    for (i = 0; i < n; ++i)
+    {
+        keys[i] = (int) i;
+        upo_lru_put(lru, &keys[i], &keys[i], 0);
+    }
+    for (i = 0; i < n-5; ++i)
+    {
+        assert( evicted[i] == &keys[i] );
+    }
+    assert( evicted[n-5] == NULL );
+
+    /* No eviction callback for explicit removals */
+    upo_lru_delete(lru, &keys[n-1], 0);
+    upo_lru_clear(lru, 0);
+    assert( evicted[n-5] == NULL );
+
+    upo_lru_set_evictor(lru, NULL, NULL);
+    for (i = 0; i < n; ++i)
+    {
+        upo_lru_put(lru, &keys[i], &keys[i], 0);
+    }
+    assert( evicted[n-5] == NULL );
+
+    upo_lru_destroy(lru, 0);
+}
+
+void test_destroy_data()
+{
+    size_t i = 0;
+    int *evicted[200] = {NULL};
+    upo_lru_t lru = upo_lru_create(16, upo_ht_hash_int_div, int_compare);
+
+    upo_lru_set_evictor(lru, record_evict, evicted);
+
+    for (i = 0; i < 100; ++i)
+    {
+        int *key = malloc(sizeof(int));
+
+        assert( key != NULL );
+
+        *key = (int) i;
+        upo_lru_put(lru, key, malloc(sizeof(int)), 1);
+        if (i % 10 == 0)
+            upo_lru_delete(lru, key, 1);
+        if (i == 50)
+            upo_lru_clear(lru, 1);
+    }
+    assert( upo_lru_size(lru) == 16 );
+    assert( upo_lru_evict(lru, 1) == 1 );
+    assert( upo_lru_size(lru) == 15 );
+
+    upo_lru_destroy(lru, 1);
+}
+
+void test_null()
+{
+    upo_lru_t lru = NULL;
+
+    assert( upo_lru_size(lru) == 0 );
+    assert( upo_lru_is_empty(lru) );
+    assert( upo_lru_capacity(lru) == 0 );
+    assert( !upo_lru_contains(lru, NULL) );
+    assert( upo_lru_get(lru, NULL) == NULL );
+    assert( upo_lru_peek(lru, NULL) == NULL );
+    assert( upo_lru_oldest(lru) == NULL );
+    assert( upo_lru_keys(lru) == NULL );
+    assert( upo_lru_evict(lru, 0) == 0 );
+
+    upo_lru_set_evictor(lru, NULL, NULL);
+    upo_lru_traverse(lru, sum_key_visit, NULL);
+    upo_lru_clear(lru, 0);
+    upo_lru_delete(lru, NULL, 0);
+    upo_lru_destroy(lru, 0);
+}
+
+
+int main()
+{
+    printf("Test case 'create/destroy'... ");
+    fflush(stdout);
+    test_create_destroy();
+    printf("OK\n");
+
+    printf("Test case 'put/get/delete'... ");
+    fflush(stdout);
+    test_put_get_delete();
+    printf("OK\n");
+
+    printf("Test case 'eviction'... ");
+    fflush(stdout);
+    test_eviction();
+    printf("OK\n");
+
+    printf("Test case 'recency'... ");
+    fflush(stdout);
+    test_recency();
+    printf("OK\n");
+
+    printf("Test case 'evictor'... ");
+    fflush(stdout);
+    test_evictor();
+    printf("OK\n");
+
+    printf("Test case 'destroy data'... ");
+    fflush(stdout);
+    test_destroy_data();
+    printf("OK\n");
+
+    printf("Test case 'null'... ");
+    fflush(stdout);
+    test_null();
+    printf("OK\n");
+
+
+    return 0;
+}
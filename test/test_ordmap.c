@@ -0,0 +1,414 @@
+/*
+ * Copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ * This file is part of UPOalglib.
+ *
+ * UPOalglib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * UPOalglib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <upo/ordmap.h>
+
+
+static int int_compare(const void *a, const void *b);
+static size_t int_hash_const(const void *x, size_t m);
+static void check_order_visit(void *key, void *value, void *info);
+
+static void test_create_destroy();
+static void test_put_get_delete();
+static void test_order();
+static void test_resize();
+static void test_collisions();
+static void test_destroy_data();
+static void test_null();
+static void test_churn();
+
+
+int int_compare(const void *a, const void *b)
+{
+    const int *aa = a;
+    const int *bb = b;
+
+    assert( a != NULL );
+    assert( b != NULL );
+
+    return (*aa > *bb) - (*aa < *bb);
+}
+
+// Hashes every key to the same value
+size_t int_hash_const(const void *x, size_t m)
+{
+    (void) x;
+    (void) m;
+
+    return 0;
+}
+
+// Checks that keys are visited in increasing order and counts them
+void check_order_visit(void *key, void *value, void *info)
+{
+    int *last = info;
+
+    assert( key != NULL );
+    assert( key == value );
+    assert( *((int*) key) > last[0] );
+
+    last[0] = *((int*) key);
+    last[1]++;
+}
+
+void test_create_destroy()
+{
+    upo_ordmap_t map = upo_ordmap_create(0, upo_ht_hash_int_div, int_compare);
+
+    assert( map != NULL );
+    assert( upo_ordmap_is_empty(map) );
+    assert( upo_ordmap_size(map) == 0 );
+    assert( upo_ordmap_capacity(map) > 0 );
+    assert( upo_ordmap_get_comparator(map) == int_compare );
+    assert( upo_ordmap_get_hasher(map) == upo_ht_hash_int_div );
+
+    upo_ordmap_destroy(map, 0);
+
+    map = upo_ordmap_create(1000, upo_ht_hash_int_div, int_compare);
+
+    assert( upo_ordmap_capacity(map) >= 1000 );
+
+    upo_ordmap_destroy(map, 0);
+}
+
+void test_put_get_delete()
+{
+    int keys[] = {3, 1, 4, 15, 9, 26, 5, 35, 8, 97};
+    int values[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t i = 0;
+    int missing = 2;
+    upo_ordmap_t map = upo_ordmap_create(4, upo_ht_hash_int_div, int_compare);
+
+    for (i = 0; i < n; ++i)
+    {
+        assert( upo_ordmap_put(map, &keys[i], &keys[i]) == NULL );
+        assert( upo_ordmap_size(map) == i+1 );
+    }
+    for (i = 0; i < n; ++i)
+    {
+        assert( upo_ordmap_get(map, &keys[i]) == &keys[i] );
+        assert( upo_ordmap_put(map, &keys[i], &values[i]) == &keys[i] );
+        assert( upo_ordmap_get(map, &keys[i]) == &values[i] );
+    }
+    assert( upo_ordmap_size(map) == n );
+    assert( !upo_ordmap_contains(map, &missing) );
+    assert( upo_ordmap_get(map, &missing) == NULL );
+
+    upo_ordmap_insert(map, &keys[0], &keys[0]);
+    assert( upo_ordmap_get(map, &keys[0]) == &values[0] );
+    upo_ordmap_insert(map, &missing, &missing);
+    assert( upo_ordmap_get(map, &missing) == &missing );
+
+    upo_ordmap_delete(map, &missing, 0);
+    upo_ordmap_delete(map, &missing, 0);
+    assert( !upo_ordmap_contains(map, &missing) );
+    for (i = 0; i < n; i += 2)
+    {
+        upo_ordmap_delete(map, &keys[i], 0);
+    }
+    assert( upo_ordmap_size(map) == n/2 );
+    for (i = 0; i < n; ++i)
+    {
+        assert( upo_ordmap_contains(map, &keys[i]) == (i % 2 == 1) );
+    }
+
+    upo_ordmap_clear(map, 0);
+    assert( upo_ordmap_is_empty(map) );
+    for (i = 0; i < n; ++i)
+    {
+        assert( !upo_ordmap_contains(map, &keys[i]) );
+    }
+
+    upo_ordmap_destroy(map, 0);
+}
+
+void test_order()
+{
+    int keys[100];
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t i = 0;
+    int state[2] = {-1, 0}; // Last visited key and number of visited keys
+    upo_ordmap_t map = upo_ordmap_create(0, upo_ht_hash_int_div, int_compare);
+    upo_ht_key_list_t list = NULL;
+    upo_ht_key_list_t node = NULL;
+
+    /* Insert keys in increasing order, but scattered over the index */
+    for (i = 0; i < n; ++i)
+    {
+        keys[i] = (int) (i*7919 % 100003);
+    }
+    for (i = 1; i < n; ++i)
+    {
+        keys[i] = keys[i-1] + 1 + keys[i] % 1000;
+    }
+    for (i = 0; i < n; ++i)
+    {
+        upo_ordmap_put(map, &keys[i], &keys[i]);
+    }
+
+    /* Removed keys leave holes, while overwritten keys keep their position */
+    for (i = 0; i < n; i += 3)
+    {
+        upo_ordmap_delete(map, &keys[i], 0);
+    }
+    for (i = 1; i < n; i += 3)
+    {
+        upo_ordmap_put(map, &keys[i], &keys[i]);
+    }
+
+    upo_ordmap_traverse(map, check_order_visit, state);
+    assert( (size_t) state[1] == upo_ordmap_size(map) );
+
+    list = upo_ordmap_keys(map);
+    state[0] = -1;
+    state[1] = 0;
+    for (node = list; node != NULL; node = node->next)
+    {
+        check_order_visit(node->key, node->key, state);
+    }
+    assert( (size_t) state[1] == upo_ordmap_size(map) );
+    while (list != NULL)
+    {
+        node = list->next;
+        free(list);
+        list = node;
+    }
+
+    /* A removed and reinserted key goes to the end */
+    upo_ordmap_delete(map, &keys[1], 0);
+    upo_ordmap_put(map, &keys[1], &keys[1]);
+    list = upo_ordmap_keys(map);
+    for (node = list; node->next != NULL; node = node->next)
+        ;
+    assert( node->key == &keys[1] );
+    while (list != NULL)
+    {
+        node = list->next;
+        free(list);
+        list = node;
+    }
+
+    upo_ordmap_destroy(map, 0);
+}
+
+void test_resize()
+{
+    size_t n = 70000; // Enough for 8-bit, 16-bit and 32-bit indices
+    int *keys = malloc(n*sizeof(int));
+    size_t i = 0;
+    size_t capacity = 0;
+    upo_ordmap_t map = upo_ordmap_create(0, upo_ht_hash_int_div, int_compare);
+    int state[2] = {-1, 0};
+
+    assert( keys != NULL );
+
+    for (i = 0; i < n; ++i)
+    {
+        keys[i] = (int) (3*i);
+        upo_ordmap_put(map, &keys[i], &keys[i]);
+        if (i == 100 || i == 20000)
+        {
+            size_t j = 0;
+
+            for (j = 0; j <= i; ++j)
+            {
+                assert( upo_ordmap_get(map, &keys[j]) == &keys[j] );
+            }
+        }
+    }
+    assert( upo_ordmap_size(map) == n );
+    assert( upo_ordmap_capacity(map) >= n );
+    for (i = 0; i < n; ++i)
+    {
+        assert( upo_ordmap_get(map, &keys[i]) == &keys[i] );
+        assert( upo_ordmap_get(map, &(int){3*(int) i + 1}) == NULL );
+    }
+    upo_ordmap_traverse(map, check_order_visit, state);
+    assert( (size_t) state[1] == n );
+
+    /* Removing does not shrink the ordered map */
+    capacity = upo_ordmap_capacity(map);
+    for (i = 0; i < n; ++i)
+    {
+        upo_ordmap_delete(map, &keys[i], 0);
+    }
+    assert( upo_ordmap_is_empty(map) );
+    assert( upo_ordmap_capacity(map) == capacity );
+
+    upo_ordmap_destroy(map, 0);
+    free(keys);
+}
+
+void test_collisions()
+{
+    int keys[50];
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t i = 0;
+    int state[2] = {-1, 0};
+    upo_ordmap_t map = upo_ordmap_create(0, int_hash_const, int_compare);
+
+    for (i = 0; i < n; ++i)
+    {
+        keys[i] = (int) i;
+        upo_ordmap_put(map, &keys[i], &keys[i]);
+    }
+    for (i = 0; i < n; i += 2)
+    {
+        upo_ordmap_delete(map, &keys[i], 0);
+    }
+    for (i = 0; i < n; ++i)
+    {
+        assert( upo_ordmap_get(map, &keys[i]) == ((i % 2 == 1) ? &keys[i] : NULL) );
+    }
+    upo_ordmap_traverse(map, check_order_visit, state);
+    assert( (size_t) state[1] == n/2 );
+
+    upo_ordmap_destroy(map, 0);
+}
+
+void test_destroy_data()
+{
+    size_t i = 0;
+    upo_ordmap_t map = upo_ordmap_create(0, upo_ht_hash_int_div, int_compare);
+
+    for (i = 0; i < 100; ++i)
+    {
+        int *key = malloc(sizeof(int));
+
+        assert( key != NULL );
+
+        *key = (int) i;
+        upo_ordmap_put(map, key, malloc(sizeof(int)));
+        if (i % 10 == 0)
+            upo_ordmap_delete(map, key, 1);
+        if (i == 50)
+            upo_ordmap_clear(map, 1);
+    }
+    assert( upo_ordmap_size(map) == 45 );
+
+    upo_ordmap_destroy(map, 1);
+}
+
+void test_null()
+{
+    upo_ordmap_t map = NULL;
+
+    assert( upo_ordmap_size(map) == 0 );
+    assert( upo_ordmap_is_empty(map) );
+    assert( upo_ordmap_capacity(map) == 0 );
+    assert( !upo_ordmap_contains(map, NULL) );
+    assert( upo_ordmap_get(map, NULL) == NULL );
+    assert( upo_ordmap_keys(map) == NULL );
+
+    upo_ordmap_insert(map, NULL, NULL);
+    upo_ordmap_traverse(map, check_order_visit, NULL);
+    upo_ordmap_clear(map, 0);
+    upo_ordmap_delete(map, NULL, 0);
+    upo_ordmap_destroy(map, 0);
+}
+
+void test_churn()
+{
+    int keys[1000];
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t live = 20;
+    size_t i = 0;
+    size_t capacity = 0;
+    upo_ordmap_t map = upo_ordmap_create(0, upo_ht_hash_int_div, int_compare);
+
+    for (i = 0; i < n; ++i)
+    {
+        keys[i] = (int) (7*i);
+    }
+
+    for (i = 0; i < live; ++i)
+    {
+        upo_ordmap_put(map, &keys[i], &keys[i]);
+    }
+    capacity = upo_ordmap_capacity(map);
+
+    /* The size stays constant, thus holes must be compacted in place */
+    for (i = live; i < n; ++i)
+    {
+        upo_ordmap_delete(map, &keys[i-live], 0);
+        assert( upo_ordmap_put(map, &keys[i], &keys[i]) == NULL );
+
+        assert( upo_ordmap_capacity(map) <= 2*capacity );
+        assert( upo_ordmap_size(map) == live );
+    }
+
+    for (i = 0; i < n; ++i)
+    {
+        assert( upo_ordmap_contains(map, &keys[i]) == (i >= n-live) );
+    }
+
+    upo_ordmap_destroy(map, 0);
+}
+
+
+int main()
+{
+    printf("Test case 'create/destroy'... ");
+    fflush(stdout);
+    test_create_destroy();
+    printf("OK\n");
+
+    printf("Test case 'put/get/delete'... ");
+    fflush(stdout);
+    test_put_get_delete();
+    printf("OK\n");
+
+    printf("Test case 'order'... ");
+    fflush(stdout);
+    test_order();
+    printf("OK\n");
+
+    printf("Test case 'resize'... ");
+    fflush(stdout);
+    test_resize();
+    printf("OK\n");
+
+    printf("Test case 'collisions'... ");
+    fflush(stdout);
+    test_collisions();
+    printf("OK\n");
+
+    printf("Test case 'destroy data'... ");
+    fflush(stdout);
+    test_destroy_data();
+    printf("OK\n");
+
+    printf("Test case 'null'... ");
+    fflush(stdout);
+    test_null();
+    printf("OK\n");
+
+    printf("Test case 'churn'... ");
+    fflush(stdout);
+    test_churn();
+    printf("OK\n");
+
+
+    return 0;
+}
@@ -0,0 +1,281 @@
+/*
+ * Copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ * This file is part of UPOalglib.
+ *
+ * UPOalglib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * UPOalglib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <upo/bst.h>
+#include <upo/hashtable.h>
+#include <upo/reclaimer.h>
+
+
+/** \brief A data structure with a number of elements freed one by one. */
+typedef struct
+{
+    size_t remaining; /**< The number of elements still to free. */
+    size_t steps; /**< The number of calls to the step function. */
+    size_t *freed; /**< Set to the number of steps once freed. */
+} counter_t;
+
+static int int_compare(const void *a, const void *b);
+static int* int_alloc(int x);
+static int counter_step(void *obj, int destroy_data, size_t *cursor, size_t batch);
+
+static void test_submit();
+static void test_bst();
+static void test_sepchain();
+static void test_linprob();
+
+
+int int_compare(const void *a, const void *b)
+{
+    const int *aa = a;
+    const int *bb = b;
+
+    assert( a != NULL );
+    assert( b != NULL );
+
+    return (*aa > *bb) - (*aa < *bb);
+}
+
+int* int_alloc(int x)
+{
+    int *p = malloc(sizeof(int));
+
+    assert( p != NULL );
+
+    *p = x;
+
+    return p;
+}
+
+// Frees at most 'batch' elements of the counter, checking the progress
+// kept in the cursor
+int counter_step(void *obj, int destroy_data, size_t *cursor, size_t batch)
+{
+    counter_t *c = obj;
+    size_t n = (batch < c->remaining) ? batch : c->remaining;
+
+    assert( destroy_data == 1 );
+    assert( *cursor == c->steps );
+
+    c->remaining -= n;
+    c->steps += 1;
+    *cursor += 1;
+
+    if (c->remaining > 0)
+        return 0;
+
+    *c->freed = c->steps;
+    free(c);
+
+    return 1;
+}
+
+void test_submit()
+{
+    size_t freed[3] = {0, 0, 0};
+    size_t sizes[3] = {10, 1000, 0};
+    size_t i = 0;
+
+    upo_reclaimer_set_batch_size(100);
+
+    for (i = 0; i < 3; ++i)
+    {
+        counter_t *c = malloc(sizeof(counter_t));
+
+        assert( c != NULL );
+
+        c->remaining = sizes[i];
+        c->steps = 0;
+        c->freed = &freed[i];
+        upo_reclaimer_submit(c, counter_step, 1);
+    }
+    upo_reclaimer_drain();
+    assert( upo_reclaimer_pending() == 0 );
+
+    /* Each step freed at most a batch */
+    assert( freed[0] == 1 );
+    assert( freed[1] == 10 );
+    assert( freed[2] == 1 );
+
+    /* Nothing is done for NULL data structures */
+    upo_reclaimer_submit(NULL, counter_step, 1);
+    assert( upo_reclaimer_pending() == 0 );
+
+    upo_reclaimer_set_batch_size(UPO_RECLAIMER_DEFAULT_BATCH_SIZE);
+}
+
+void test_bst()
+{
+    size_t n = 20000;
+    size_t i = 0;
+    upo_bst_t tree = NULL;
+
+    /* A degenerate tree (a list of right children) */
+    tree = upo_bst_create(int_compare);
+    for (i = 0; i < n; ++i)
+    {
+        upo_bst_put(tree, int_alloc((int) i), int_alloc((int) i));
+    }
+    upo_bst_destroy_async(tree, 1);
+
+    /* A degenerate tree of left children, without freeing data */
+    {
+        static int keys[2000];
+
+        tree = upo_bst_create(int_compare);
+        for (i = 0; i < sizeof keys/sizeof keys[0]; ++i)
+        {
+            keys[i] = (int) (sizeof keys/sizeof keys[0] - i);
+            upo_bst_put(tree, &keys[i], &keys[i]);
+        }
+        upo_bst_destroy_async(tree, 0);
+        upo_reclaimer_drain();
+    }
+
+    /* A random tree */
+    tree = upo_bst_create(int_compare);
+    for (i = 0; i < n; ++i)
+    {
+        int *key = int_alloc(rand());
+
+        if (upo_bst_contains(tree, key))
+            free(key);
+        else
+            upo_bst_put(tree, key, int_alloc((int) i));
+    }
+    upo_bst_destroy_async(tree, 1);
+
+    upo_bst_destroy_async(upo_bst_create(int_compare), 1);
+    upo_bst_destroy_async(NULL, 1);
+
+    upo_reclaimer_drain();
+    assert( upo_reclaimer_pending() == 0 );
+}
+
+void test_sepchain()
+{
+    static int keys[100];
+    size_t n = 20000;
+    size_t i = 0;
+    upo_ht_sepchain_t ht = NULL;
+
+    ht = upo_ht_sepchain_create(UPO_HT_SEPCHAIN_DEFAULT_CAPACITY, upo_ht_hash_int_div, int_compare);
+    for (i = 0; i < n; ++i)
+    {
+        upo_ht_sepchain_put(ht, int_alloc((int) i), int_alloc((int) i));
+    }
+    upo_ht_sepchain_enable_stats(ht);
+    upo_ht_sepchain_destroy_async(ht, 1);
+
+    /* Lists of past generations are freed too */
+    ht = upo_ht_sepchain_create(UPO_HT_SEPCHAIN_DEFAULT_CAPACITY, upo_ht_hash_int_div, int_compare);
+    upo_ht_sepchain_enable_generations(ht);
+    for (i = 0; i < sizeof keys/sizeof keys[0]; ++i)
+    {
+        keys[i] = (int) i;
+        upo_ht_sepchain_put(ht, &keys[i], &keys[i]);
+    }
+    upo_ht_sepchain_clear(ht, 0);
+    for (i = 0; i < sizeof keys/sizeof keys[0]; ++i)
+    {
+        upo_ht_sepchain_put(ht, int_alloc((int) i), int_alloc((int) i));
+    }
+    upo_ht_sepchain_destroy_async(ht, 1);
+
+    upo_ht_sepchain_destroy_async(NULL, 1);
+
+    upo_reclaimer_drain();
+    assert( upo_reclaimer_pending() == 0 );
+}
+
+void test_linprob()
+{
+    size_t n = 20000;
+    size_t i = 0;
+    upo_ht_linprob_t ht = NULL;
+
+    ht = upo_ht_linprob_create(UPO_HT_LINPROB_DEFAULT_CAPACITY, upo_ht_hash_int_div, int_compare);
+    for (i = 0; i < n; ++i)
+    {
+        upo_ht_linprob_put(ht, int_alloc((int) i), int_alloc((int) i));
+    }
+    for (i = 0; i < n; i += 2)
+    {
+        int key = (int) i;
+
+        upo_ht_linprob_delete(ht, &key, 1);
+    }
+    upo_ht_linprob_destroy_async(ht, 1);
+
+    /* Small tables */
+    ht = upo_ht_linprob_create_small(upo_ht_hash_int_div, int_compare);
+    for (i = 0; i < 3; ++i)
+    {
+        upo_ht_linprob_put(ht, int_alloc((int) i), int_alloc((int) i));
+    }
+    upo_ht_linprob_destroy_async(ht, 1);
+
+    /* Tables without data to free */
+    {
+        static int keys[1000];
+
+        ht = upo_ht_linprob_create(UPO_HT_LINPROB_DEFAULT_CAPACITY, upo_ht_hash_int_div, int_compare);
+        for (i = 0; i < sizeof keys/sizeof keys[0]; ++i)
+        {
+            keys[i] = (int) i;
+            upo_ht_linprob_put(ht, &keys[i], &keys[i]);
+        }
+        upo_ht_linprob_destroy_async(ht, 0);
+        upo_reclaimer_drain();
+    }
+
+    upo_ht_linprob_destroy_async(NULL, 1);
+
+    upo_reclaimer_drain();
+    assert( upo_reclaimer_pending() == 0 );
+}
+
+
+int main()
+{
+    printf("Test case 'submit'... ");
+    fflush(stdout);
+    test_submit();
+    printf("OK\n");
+
+    printf("Test case 'bst'... ");
+    fflush(stdout);
+    test_bst();
+    printf("OK\n");
+
+    printf("Test case 'sepchain'... ");
+    fflush(stdout);
+    test_sepchain();
+    printf("OK\n");
+
+    printf("Test case 'linprob'... ");
+    fflush(stdout);
+    test_linprob();
+    printf("OK\n");
+
+    return 0;
+}
@@ -0,0 +1,553 @@
+/*
+ * Copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ * This file is part of UPOalglib.
+ *
+ * UPOalglib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * UPOalglib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Needed for fork() and waitpid() */
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <upo/shmht.h>
+
+
+static void make_name(char *name, size_t n, const char *suffix);
+static int run_child(int (*child)(const char*), const char *name);
+static int check_keys(const char *name);
+static int check_updates(const char *name);
+static int churn_keys(const char *name);
+
+static void test_create_open();
+static void test_put_get_delete();
+static void test_full();
+static void test_purge();
+static void test_processes();
+static void test_concurrent_updates();
+static void test_dead_writer();
+
+
+// Makes a name of shared memory object unique to this process
+void make_name(char *name, size_t n, const char *suffix)
+{
+    snprintf(name, n, "/upo_shmht_%ld_%s", (long) getpid(), suffix);
+}
+
+// Runs the given function in a child process and returns its exit status
+int run_child(int (*child)(const char*), const char *name)
+{
+    pid_t pid = fork();
+    int status = 0;
+
+    assert( pid >= 0 );
+
+    if (pid == 0)
+    {
+        fflush(stdout);
+        _exit(child(name));
+    }
+
+    assert( waitpid(pid, &status, 0) == pid );
+    assert( WIFEXITED(status) );
+
+    return WEXITSTATUS(status);
+}
+
+// Checks, from another process, the keys stored by test_processes()
+int check_keys(const char *name)
+{
+    upo_shmht_t ht = upo_shmht_open(name);
+    int i = 0;
+
+    if (ht == NULL || upo_shmht_size(ht) != 1000)
+        return 1;
+
+    for (i = 0; i < 1000; ++i)
+    {
+        char key[32];
+        int value = -1;
+        size_t value_size = sizeof value;
+
+        snprintf(key, sizeof key, "key-%d", i);
+        if (!upo_shmht_get(ht, key, strlen(key), &value, &value_size) || value_size != sizeof value || value != i*i)
+            return 2;
+    }
+
+    /* Write back a key for the parent */
+    i = -1;
+    if (!upo_shmht_put(ht, "child", 5, &i, sizeof i))
+        return 3;
+
+    upo_shmht_close(ht);
+
+    return 0;
+}
+
+// Reads, from another process, the pairs updated by test_concurrent_updates()
+// until the parent stores the key "done", checking that no value is torn
+int check_updates(const char *name)
+{
+    upo_shmht_t ht = NULL;
+    size_t reads = 0;
+
+    while ((ht = upo_shmht_open(name)) == NULL)
+        ;
+
+    while (!upo_shmht_contains(ht, "done", 4) || reads == 0)
+    {
+        int k = 0;
+
+        for (k = 0; k < 16; ++k)
+        {
+            int value[4] = {0, 0, 0, 0};
+            size_t value_size = sizeof value;
+
+            if (upo_shmht_get(ht, &k, sizeof k, value, &value_size))
+            {
+                if (value_size != sizeof value || value[0] != k || value[1] != value[2] || value[3] != value[1] + k)
+                    return 1;
+                ++reads;
+            }
+        }
+    }
+
+    upo_shmht_close(ht);
+
+    return 0;
+}
+// Stores and removes keys, from another process, until it is killed by
+// test_dead_writer()
+int churn_keys(const char *name)
+{
+    upo_shmht_t ht = upo_shmht_open(name);
+    int i = 0;
+
+    if (ht == NULL)
+        return 1;
+
+    for (i = 0; ; ++i)
+    {
+        int k = i % 64;
+        int j = (i + 24) % 64;
+
+        upo_shmht_put(ht, &k, sizeof k, &i, sizeof i);
+        upo_shmht_delete(ht, &j, sizeof j);
+    }
+
+    return 0;
+}
+
+void test_create_open()
+{
+    char name[64];
+    upo_shmht_t ht = NULL;
+    upo_shmht_t ht2 = NULL;
+    int x = 42;
+    int y = 0;
+    size_t y_size = sizeof y;
+
+    make_name(name, sizeof name, "create");
+
+    assert( upo_shmht_open(name) == NULL );
+
+    ht = upo_shmht_create(name, 100, 4096);
+    assert( ht != NULL );
+    assert( upo_shmht_capacity(ht) == 128 );
+    assert( upo_shmht_is_empty(ht) );
+    assert( upo_shmht_heap_used(ht) == 0 );
+
+    /* The name is taken */
+    assert( upo_shmht_create(name, 100, 4096) == NULL );
+
+    /* A second mapping sees the same table */
+    ht2 = upo_shmht_open(name);
+    assert( ht2 != NULL );
+    assert( upo_shmht_capacity(ht2) == 128 );
+    assert( upo_shmht_put(ht, &x, sizeof x, &x, sizeof x) == 1 );
+    assert( upo_shmht_size(ht2) == 1 );
+    assert( upo_shmht_get(ht2, &x, sizeof x, &y, &y_size) == 1 );
+    assert( y == 42 && y_size == sizeof y );
+
+    upo_shmht_close(ht2);
+    upo_shmht_close(ht);
+
+    assert( upo_shmht_unlink(name) == 1 );
+    assert( upo_shmht_unlink(name) == 0 );
+    assert( upo_shmht_open(name) == NULL );
+
+    upo_shmht_close(NULL);
+    assert( upo_shmht_size(NULL) == 0 );
+    assert( upo_shmht_is_empty(NULL) );
+    assert( upo_shmht_capacity(NULL) == 0 );
+    assert( upo_shmht_get(NULL, &x, sizeof x, NULL, NULL) == 0 );
+}
+
+void test_put_get_delete()
+{
+    char name[64];
+    upo_shmht_t ht = NULL;
+    char buf[64];
+    size_t buf_size = 0;
+    int i = 0;
+
+    make_name(name, sizeof name, "putget");
+
+    ht = upo_shmht_create(name, 256, 64*1024);
+    assert( ht != NULL );
+
+    for (i = 0; i < 100; ++i)
+    {
+        char key[32];
+
+        snprintf(key, sizeof key, "key-%d", i);
+        snprintf(buf, sizeof buf, "value-%d", i);
+        assert( upo_shmht_put(ht, key, strlen(key), buf, strlen(buf) + 1) == 1 );
+    }
+    assert( upo_shmht_size(ht) == 100 );
+
+    for (i = 0; i < 100; ++i)
+    {
+        char key[32];
+        char expected[32];
+
+        snprintf(key, sizeof key, "key-%d", i);
+        snprintf(expected, sizeof expected, "value-%d", i);
+        buf_size = sizeof buf;
+        assert( upo_shmht_get(ht, key, strlen(key), buf, &buf_size) == 1 );
+        assert( buf_size == strlen(expected) + 1 );
+        assert( strcmp(buf, expected) == 0 );
+    }
+
+    /* Keys are compared by bytes: a prefix is another key */
+    assert( upo_shmht_contains(ht, "key-1", 4) == 0 );
+    assert( upo_shmht_contains(ht, "key-1", 5) == 1 );
+
+    /* Replace a value */
+    assert( upo_shmht_put(ht, "key-7", 5, "seven", 6) == 1 );
+    assert( upo_shmht_size(ht) == 100 );
+    buf_size = sizeof buf;
+    assert( upo_shmht_get(ht, "key-7", 5, buf, &buf_size) == 1 );
+    assert( buf_size == 6 && strcmp(buf, "seven") == 0 );
+
+    /* Copy only a prefix into a short buffer */
+    memset(buf, 0, sizeof buf);
+    buf_size = 3;
+    assert( upo_shmht_get(ht, "key-7", 5, buf, &buf_size) == 1 );
+    assert( buf_size == 6 && strcmp(buf, "sev") == 0 );
+
+    /* Empty keys and values */
+    assert( upo_shmht_put(ht, "", 0, NULL, 0) == 1 );
+    buf_size = sizeof buf;
+    assert( upo_shmht_get(ht, "", 0, buf, &buf_size) == 1 );
+    assert( buf_size == 0 );
+
+    /* Delete, then reuse the deleted slots */
+    for (i = 0; i < 100; i += 2)
+    {
+        char key[32];
+
+        snprintf(key, sizeof key, "key-%d", i);
+        assert( upo_shmht_delete(ht, key, strlen(key)) == 1 );
+        assert( upo_shmht_delete(ht, key, strlen(key)) == 0 );
+    }
+    assert( upo_shmht_size(ht) == 51 );
+    for (i = 0; i < 100; ++i)
+    {
+        char key[32];
+
+        snprintf(key, sizeof key, "key-%d", i);
+        assert( upo_shmht_contains(ht, key, strlen(key)) == (i % 2 != 0) );
+    }
+    for (i = 0; i < 100; i += 2)
+    {
+        char key[32];
+
+        snprintf(key, sizeof key, "key-%d", i);
+        assert( upo_shmht_put(ht, key, strlen(key), &i, sizeof i) == 1 );
+    }
+    assert( upo_shmht_size(ht) == 101 );
+
+    upo_shmht_close(ht);
+    assert( upo_shmht_unlink(name) == 1 );
+}
+
+void test_full()
+{
+    char name[64];
+    upo_shmht_t ht = NULL;
+    size_t used = 0;
+    int i = 0;
+
+    make_name(name, sizeof name, "full");
+
+    /* Full slots: one slot is always left empty */
+    ht = upo_shmht_create(name, 8, 4096);
+    assert( ht != NULL );
+    for (i = 0; i < 7; ++i)
+    {
+        assert( upo_shmht_put(ht, &i, sizeof i, &i, sizeof i) == 1 );
+    }
+    assert( upo_shmht_put(ht, &i, sizeof i, &i, sizeof i) == 0 );
+    assert( upo_shmht_size(ht) == 7 );
+    i = 3;
+    assert( upo_shmht_put(ht, &i, sizeof i, &i, sizeof i) == 1 ); // Replacing needs no slot
+    assert( upo_shmht_delete(ht, &i, sizeof i) == 1 );
+    i = 100;
+    assert( upo_shmht_put(ht, &i, sizeof i, &i, sizeof i) == 1 ); // Reuses the deleted slot
+    upo_shmht_close(ht);
+    assert( upo_shmht_unlink(name) == 1 );
+
+    /* Full heap: records take 8 bytes plus the data rounded up to 8 bytes */
+    ht = upo_shmht_create(name, 64, 64);
+    assert( ht != NULL );
+    for (i = 0; i < 2; ++i)
+    {
+        assert( upo_shmht_put(ht, &i, sizeof i, &i, sizeof i) == 1 );
+    }
+    used = upo_shmht_heap_used(ht);
+    assert( used == 64 );
+    assert( upo_shmht_put(ht, &i, sizeof i, &i, sizeof i) == 0 );
+    assert( upo_shmht_heap_used(ht) == used );
+    assert( upo_shmht_size(ht) == 2 );
+    upo_shmht_close(ht);
+    assert( upo_shmht_unlink(name) == 1 );
+
+    /* A pair whose value does not fit takes no room for its key either */
+    ht = upo_shmht_create(name, 64, 64);
+    assert( ht != NULL );
+    i = 0;
+    assert( upo_shmht_put(ht, &i, sizeof i, &i, sizeof i) == 1 );
+    used = upo_shmht_heap_used(ht);
+    i = 1;
+    assert( upo_shmht_put(ht, &i, sizeof i, name, 17) == 0 );
+    assert( upo_shmht_heap_used(ht) == used );
+    assert( upo_shmht_put(ht, &i, sizeof i, &i, sizeof i) == 1 );
+    assert( upo_shmht_heap_used(ht) == 64 );
+    upo_shmht_close(ht);
+    assert( upo_shmht_unlink(name) == 1 );
+}
+
+void test_purge()
+{
+    char name[64];
+    upo_shmht_t ht = NULL;
+    int i = 0;
+    int j = 0;
+
+    make_name(name, sizeof name, "purge");
+
+    /* A sliding window of 40 live keys in 64 slots fills the table with
+     * deleted slots, which are purged again and again */
+    ht = upo_shmht_create(name, 64, 256*1024);
+    assert( ht != NULL );
+    for (i = 0; i < 2000; ++i)
+    {
+        assert( upo_shmht_put(ht, &i, sizeof i, &i, sizeof i) == 1 );
+        if (i >= 40)
+        {
+            j = i - 40;
+            assert( upo_shmht_delete(ht, &j, sizeof j) == 1 );
+        }
+        if (i % 97 == 0)
+        {
+            for (j = 0; j <= i; ++j)
+            {
+                int value = -1;
+                size_t value_size = sizeof value;
+
+                assert( upo_shmht_get(ht, &j, sizeof j, &value, &value_size) == (j > i - 40) );
+                assert( j <= i - 40 || value == j );
+            }
+        }
+    }
+    assert( upo_shmht_size(ht) == 40 );
+    upo_shmht_close(ht);
+    assert( upo_shmht_unlink(name) == 1 );
+}
+
+void test_processes()
+{
+    char name[64];
+    upo_shmht_t ht = NULL;
+    int value = 0;
+    size_t value_size = sizeof value;
+    int i = 0;
+
+    make_name(name, sizeof name, "procs");
+
+    ht = upo_shmht_create(name, 4096, 64*1024);
+    assert( ht != NULL );
+    for (i = 0; i < 1000; ++i)
+    {
+        char key[32];
+        int square = i*i;
+
+        snprintf(key, sizeof key, "key-%d", i);
+        assert( upo_shmht_put(ht, key, strlen(key), &square, sizeof square) == 1 );
+    }
+
+    assert( run_child(check_keys, name) == 0 );
+
+    /* The key written by the child is visible here */
+    assert( upo_shmht_size(ht) == 1001 );
+    assert( upo_shmht_get(ht, "child", 5, &value, &value_size) == 1 );
+    assert( value == -1 );
+
+    upo_shmht_close(ht);
+    assert( upo_shmht_unlink(name) == 1 );
+}
+
+void test_concurrent_updates()
+{
+    char name[64];
+    upo_shmht_t ht = NULL;
+    pid_t pid = 0;
+    int status = 0;
+    int i = 0;
+
+    make_name(name, sizeof name, "updates");
+
+    pid = fork();
+    assert( pid >= 0 );
+    if (pid == 0)
+    {
+        _exit(check_updates(name));
+    }
+
+    ht = upo_shmht_create(name, 64, 4*1024*1024);
+    assert( ht != NULL );
+
+    /* Each value is made of four ints that a torn read would not match */
+    for (i = 0; i < 20000; ++i)
+    {
+        int k = i % 16;
+        int value[4];
+
+        value[0] = k;
+        value[1] = i;
+        value[2] = i;
+        value[3] = i + k;
+        assert( upo_shmht_put(ht, &k, sizeof k, value, sizeof value) == 1 );
+        if (i % 7 == 0)
+            upo_shmht_delete(ht, &k, sizeof k);
+    }
+    assert( upo_shmht_put(ht, "done", 4, NULL, 0) == 1 );
+
+    assert( waitpid(pid, &status, 0) == pid );
+    assert( WIFEXITED(status) && WEXITSTATUS(status) == 0 );
+
+    upo_shmht_close(ht);
+    assert( upo_shmht_unlink(name) == 1 );
+}
+
+void test_dead_writer()
+{
+    char name[64];
+    upo_shmht_t ht = NULL;
+    int round = 0;
+
+    make_name(name, sizeof name, "dead");
+
+    ht = upo_shmht_create(name, 128, 16*1024*1024);
+    assert( ht != NULL );
+
+    /* Writers killed at random points, likely while holding the lock */
+    for (round = 0; round < 20; ++round)
+    {
+        struct timespec delay = {0, 0};
+        pid_t pid = fork();
+        size_t count = 0;
+        int status = 0;
+        int k = 0;
+
+        assert( pid >= 0 );
+        if (pid == 0)
+            _exit(churn_keys(name));
+
+        delay.tv_nsec = 100000 + rand() % 1000000;
+        nanosleep(&delay, NULL);
+        assert( kill(pid, SIGKILL) == 0 );
+        assert( waitpid(pid, &status, 0) == pid );
+        assert( WIFSIGNALED(status) );
+
+        /* Readers do not hang if the writer died while updating slots */
+        for (k = 0; k < 64; ++k)
+        {
+            (void) upo_shmht_contains(ht, &k, sizeof k);
+        }
+
+        /* The table is usable, and its size matches the stored keys */
+        k = 64 + round;
+        assert( upo_shmht_delete(ht, &k, sizeof k) == 0 );
+        for (k = 0; k < 64; ++k)
+        {
+            count += (size_t) upo_shmht_contains(ht, &k, sizeof k);
+        }
+        assert( count == upo_shmht_size(ht) );
+    }
+
+    upo_shmht_close(ht);
+    assert( upo_shmht_unlink(name) == 1 );
+}
+
+
+int main()
+{
+    printf("Test case 'create/open'... ");
+    fflush(stdout);
+    test_create_open();
+    printf("OK\n");
+
+    printf("Test case 'put/get/delete'... ");
+    fflush(stdout);
+    test_put_get_delete();
+    printf("OK\n");
+
+    printf("Test case 'full'... ");
+    fflush(stdout);
+    test_full();
+    printf("OK\n");
+
+    printf("Test case 'purge'... ");
+    fflush(stdout);
+    test_purge();
+    printf("OK\n");
+
+    printf("Test case 'processes'... ");
+    fflush(stdout);
+    test_processes();
+    printf("OK\n");
+
+    printf("Test case 'concurrent updates'... ");
+    fflush(stdout);
+    test_concurrent_updates();
+    printf("OK\n");
+
+    printf("Test case 'dead writer'... ");
+    fflush(stdout);
+    test_dead_writer();
+    printf("OK\n");
+
+    return 0;
+}
@@ -0,0 +1,484 @@
+/*
+ * Copyright 2015 University of Piemonte Orientale, Computer Science Institute
+ *
+ * This file is part of UPOalglib.
+ *
+ * UPOalglib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * UPOalglib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UPOalglib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <upo/ttlmap.h>
+
+
+static int int_compare(const void *a, const void *b);
+static void check_expire(void *key, void *value, void *info);
+static void count_visit(void *key, void *value, void *info);
+
+static void test_create_destroy();
+static void test_put_get_delete();
+static void test_expiration();
+static void test_reschedule();
+static void test_long_ttl();
+static void test_destroy_data();
+static void test_null();
+static void test_churn();
+
+
+int int_compare(const void *a, const void *b)
+{
+    const int *aa = a;
+    const int *bb = b;
+
+    assert( a != NULL );
+    assert( b != NULL );
+
+    return (*aa > *bb) - (*aa < *bb);
+}
+
+// Checks that the value (the expected expiration tick) is not after the tick
+// given as info nor before the previous one, and counts the expired pair
+void check_expire(void *key, void *value, void *info)
+{
+    uint64_t *state = info; // Current tick, number of expired pairs and last expiration tick
+
+    assert( key != NULL );
+
+    if (value != NULL)
+    {
+        assert( *((uint64_t*) value) <= state[0] );
+        assert( *((uint64_t*) value) >= state[2] );
+        state[2] = *((uint64_t*) value);
+    }
+    state[1]++;
+}
+
+// Counts the visited pairs in the size_t given as info
+void count_visit(void *key, void *value, void *info)
+{
+    size_t *count = info;
+
+    assert( key != NULL );
+    (void) value;
+
+    (*count)++;
+}
+
+void test_create_destroy()
+{
+    upo_ttlmap_t map = upo_ttlmap_create(10, upo_ht_hash_int_div, int_compare);
+
+    assert( map != NULL );
+    assert( upo_ttlmap_is_empty(map) );
+    assert( upo_ttlmap_size(map) == 0 );
+    assert( upo_ttlmap_now(map) == 0 );
+    assert( upo_ttlmap_keys(map) == NULL );
+    assert( upo_ttlmap_get_comparator(map) == int_compare );
+    assert( upo_ttlmap_get_hasher(map) == upo_ht_hash_int_div );
+
+    /* An empty map moves its clock at once */
+    assert( upo_ttlmap_advance(map, 1000000000, 0) == 0 );
+    assert( upo_ttlmap_now(map) == 1000000000 );
+
+    upo_ttlmap_destroy(map, 0);
+}
+
+void test_put_get_delete()
+{
+    int keys[100];
+    int values[100];
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t i = 0;
+    size_t count = 0;
+    int missing = -1;
+    upo_ht_key_list_t list = NULL;
+    upo_ttlmap_t map = upo_ttlmap_create(2, upo_ht_hash_int_div, int_compare);
+
+    /* The table grows from 2 slots */
+    for (i = 0; i < n; ++i)
+    {
+        keys[i] = (int) (3*i);
+        values[i] = (int) i;
+        assert( upo_ttlmap_put(map, &keys[i], &keys[i], UPO_TTLMAP_NO_TTL) == NULL );
+        assert( upo_ttlmap_size(map) == i+1 );
+    }
+    for (i = 0; i < n; ++i)
+    {
+        assert( upo_ttlmap_get(map, &keys[i]) == &keys[i] );
+        assert( upo_ttlmap_put(map, &keys[i], &values[i], UPO_TTLMAP_NO_TTL) == &keys[i] );
+        assert( upo_ttlmap_get(map, &keys[i]) == &values[i] );
+        assert( upo_ttlmap_contains(map, &keys[i]) );
+        assert( upo_ttlmap_ttl(map, &keys[i]) == UPO_TTLMAP_NO_TTL );
+    }
+    assert( upo_ttlmap_size(map) == n );
+    assert( upo_ttlmap_get(map, &missing) == NULL );
+    assert( !upo_ttlmap_contains(map, &missing) );
+    assert( !upo_ttlmap_set_ttl(map, &missing, 10) );
+
+    upo_ttlmap_traverse(map, count_visit, &count);
+    assert( count == n );
+    count = 0;
+    list = upo_ttlmap_keys(map);
+    while (list != NULL)
+    {
+        upo_ht_key_list_t node = list->next;
+
+        ++count;
+        free(list);
+        list = node;
+    }
+    assert( count == n );
+
+    for (i = 0; i < n; i += 2)
+    {
+        upo_ttlmap_delete(map, &keys[i], 0);
+        upo_ttlmap_delete(map, &keys[i], 0);
+    }
+    upo_ttlmap_delete(map, &missing, 0);
+    assert( upo_ttlmap_size(map) == n/2 );
+    for (i = 0; i < n; ++i)
+    {
+        assert( upo_ttlmap_contains(map, &keys[i]) == (i % 2 == 1) );
+    }
+
+    /* Pairs with no time-to-live never expire */
+    assert( upo_ttlmap_advance(map, 100000, 0) == 0 );
+    assert( upo_ttlmap_size(map) == n/2 );
+
+    upo_ttlmap_clear(map, 0);
+    assert( upo_ttlmap_is_empty(map) );
+    assert( upo_ttlmap_now(map) == 100000 );
+    for (i = 0; i < n; ++i)
+    {
+        assert( !upo_ttlmap_contains(map, &keys[i]) );
+    }
+
+    upo_ttlmap_destroy(map, 0);
+}
+
+void test_expiration()
+{
+    /* Time-to-lives at the boundaries of the levels of the wheel */
+    uint64_t ttls[] = {1, 2, 63, 64, 65, 100, 127, 128, 4095, 4096, 4097, 5000, 262143, 262144, 262145, 300000};
+    uint64_t expires[sizeof ttls/sizeof ttls[0]];
+    int keys[sizeof ttls/sizeof ttls[0]];
+    size_t n = sizeof ttls/sizeof ttls[0];
+    size_t i = 0;
+    uint64_t state[3] = {0, 0, 0};
+    upo_ttlmap_t map = upo_ttlmap_create(16, upo_ht_hash_int_div, int_compare);
+
+    upo_ttlmap_set_expirer(map, check_expire, state);
+
+    /* Start from a clock that is not aligned to any level */
+    upo_ttlmap_advance(map, 12345, 0);
+    for (i = 0; i < n; ++i)
+    {
+        keys[i] = (int) i;
+        expires[i] = upo_ttlmap_now(map) + ttls[i];
+        upo_ttlmap_put(map, &keys[i], &expires[i], ttls[i]);
+        assert( upo_ttlmap_ttl(map, &keys[i]) == ttls[i] );
+    }
+
+    /* Each pair expires exactly at its tick, one tick at a time */
+    while (!upo_ttlmap_is_empty(map))
+    {
+        size_t expired = 0;
+
+        state[0] = upo_ttlmap_now(map) + 1;
+        expired = upo_ttlmap_advance(map, 1, 0);
+        for (i = 0; i < n; ++i)
+        {
+            assert( upo_ttlmap_contains(map, &keys[i]) == (expires[i] > state[0]) );
+            if (expires[i] > state[0])
+                assert( upo_ttlmap_ttl(map, &keys[i]) == expires[i] - state[0] );
+            if (expires[i] == state[0])
+                --expired;
+        }
+        assert( expired == 0 );
+    }
+    assert( state[1] == n );
+
+    /* The same in a single call */
+    state[1] = 0;
+    for (i = 0; i < n; ++i)
+    {
+        expires[i] = upo_ttlmap_now(map) + ttls[i];
+        upo_ttlmap_put(map, &keys[i], &expires[i], ttls[i]);
+    }
+    state[0] = upo_ttlmap_now(map) + 299999;
+    assert( upo_ttlmap_advance(map, 299999, 0) == n-1 );
+    assert( upo_ttlmap_contains(map, &keys[n-1]) );
+    state[0]++;
+    assert( upo_ttlmap_advance(map, 1, 0) == 1 );
+    assert( state[1] == n );
+
+    upo_ttlmap_destroy(map, 0);
+}
+
+void test_reschedule()
+{
+    int keys[] = {1, 2, 3, 4};
+    uint64_t state[3] = {0, 0, 0};
+    upo_ttlmap_t map = upo_ttlmap_create(4, upo_ht_hash_int_div, int_compare);
+
+    upo_ttlmap_set_expirer(map, check_expire, state);
+
+    upo_ttlmap_put(map, &keys[0], NULL, 10);
+    upo_ttlmap_put(map, &keys[1], NULL, 10);
+    upo_ttlmap_put(map, &keys[2], NULL, 10);
+    upo_ttlmap_put(map, &keys[3], NULL, 10);
+
+    /* Extend, shorten, persist and delete */
+    assert( upo_ttlmap_set_ttl(map, &keys[0], 1000) );
+    assert( upo_ttlmap_set_ttl(map, &keys[1], 5) );
+    assert( upo_ttlmap_set_ttl(map, &keys[2], UPO_TTLMAP_NO_TTL) );
+    upo_ttlmap_delete(map, &keys[3], 0);
+
+    assert( upo_ttlmap_advance(map, 5, 0) == 1 );
+    assert( !upo_ttlmap_contains(map, &keys[1]) );
+    assert( upo_ttlmap_advance(map, 100, 0) == 0 );
+    assert( upo_ttlmap_ttl(map, &keys[0]) == 895 );
+
+    /* Storing an existing key resets its time-to-live */
+    upo_ttlmap_put(map, &keys[0], NULL, 2);
+    upo_ttlmap_put(map, &keys[2], NULL, 3);
+    assert( upo_ttlmap_advance(map, 2, 0) == 1 );
+    assert( upo_ttlmap_advance(map, 1, 0) == 1 );
+    assert( upo_ttlmap_is_empty(map) );
+    assert( state[1] == 3 );
+
+    /* No expiration callback for explicit removals nor without expirer */
+    upo_ttlmap_put(map, &keys[0], NULL, 1);
+    upo_ttlmap_put(map, &keys[1], NULL, 1);
+    upo_ttlmap_delete(map, &keys[0], 0);
+    upo_ttlmap_clear(map, 0);
+    upo_ttlmap_set_expirer(map, NULL, NULL);
+    upo_ttlmap_put(map, &keys[0], NULL, 1);
+    assert( upo_ttlmap_advance(map, 1, 0) == 1 );
+    assert( state[1] == 3 );
+
+    upo_ttlmap_destroy(map, 0);
+}
+
+void test_long_ttl()
+{
+    /* Beyond the span of the wheel, pairs are rescheduled while waiting */
+    uint64_t span = ((uint64_t) 1) << 24;
+    uint64_t ttls[] = {span-1, span, span+1, 2*span+12345, UINT64_MAX};
+    int keys[sizeof ttls/sizeof ttls[0]];
+    size_t n = sizeof ttls/sizeof ttls[0];
+    size_t i = 0;
+    upo_ttlmap_t map = upo_ttlmap_create(4, upo_ht_hash_int_div, int_compare);
+
+    upo_ttlmap_advance(map, 777, 0);
+    for (i = 0; i < n; ++i)
+    {
+        keys[i] = (int) i;
+        upo_ttlmap_put(map, &keys[i], NULL, ttls[i]);
+    }
+
+    for (i = 0; i < n-1; ++i)
+    {
+        uint64_t elapsed = upo_ttlmap_now(map) - 777;
+
+        assert( upo_ttlmap_advance(map, ttls[i]-elapsed-1, 0) == 0 );
+        assert( upo_ttlmap_ttl(map, &keys[i]) == 1 );
+        assert( upo_ttlmap_advance(map, 1, 0) == 1 );
+        assert( !upo_ttlmap_contains(map, &keys[i]) );
+    }
+
+    /* The expiration time saturates rather than wrapping around */
+    assert( upo_ttlmap_ttl(map, &keys[n-1]) == UINT64_MAX - upo_ttlmap_now(map) );
+    assert( upo_ttlmap_size(map) == 1 );
+
+    upo_ttlmap_destroy(map, 0);
+}
+
+void test_destroy_data()
+{
+    size_t i = 0;
+    upo_ttlmap_t map = upo_ttlmap_create(8, upo_ht_hash_int_div, int_compare);
+
+    for (i = 0; i < 100; ++i)
+    {
+        int *key = malloc(sizeof(int));
+
+        assert( key != NULL );
+
+        *key = (int) i;
+        upo_ttlmap_put(map, key, malloc(sizeof(int)), (i % 3 == 0) ? UPO_TTLMAP_NO_TTL : i);
+        if (i % 10 == 0)
+            upo_ttlmap_delete(map, key, 1);
+        if (i == 50)
+            upo_ttlmap_clear(map, 1);
+    }
+    assert( upo_ttlmap_size(map) == 45 );
+    assert( upo_ttlmap_advance(map, 80, 1) == 18 );
+    assert( upo_ttlmap_size(map) == 27 );
+
+    upo_ttlmap_destroy(map, 1);
+}
+
+void test_null()
+{
+    upo_ttlmap_t map = NULL;
+
+    assert( upo_ttlmap_size(map) == 0 );
+    assert( upo_ttlmap_is_empty(map) );
+    assert( upo_ttlmap_now(map) == 0 );
+    assert( !upo_ttlmap_contains(map, NULL) );
+    assert( upo_ttlmap_get(map, NULL) == NULL );
+    assert( upo_ttlmap_ttl(map, NULL) == UPO_TTLMAP_NO_TTL );
+    assert( !upo_ttlmap_set_ttl(map, NULL, 1) );
+    assert( upo_ttlmap_advance(map, 1, 0) == 0 );
+    assert( upo_ttlmap_keys(map) == NULL );
+
+    upo_ttlmap_set_expirer(map, NULL, NULL);
+    upo_ttlmap_traverse(map, count_visit, NULL);
+    upo_ttlmap_clear(map, 0);
+    upo_ttlmap_delete(map, NULL, 0);
+    upo_ttlmap_destroy(map, 0);
+}
+
+void test_churn()
+{
+    int keys[500];
+    uint64_t expires[500]; // 0 for absent keys, UINT64_MAX for keys with no time-to-live
+    size_t n = sizeof keys/sizeof keys[0];
+    size_t i = 0;
+    size_t r = 0;
+    size_t size = 0;
+    uint64_t state[3] = {0, 0, 0};
+    upo_ttlmap_t map = upo_ttlmap_create(1, upo_ht_hash_int_div, int_compare);
+
+    upo_ttlmap_set_expirer(map, check_expire, state);
+
+    srand(42);
+
+    for (i = 0; i < n; ++i)
+    {
+        keys[i] = (int) i;
+        expires[i] = 0;
+    }
+
+    for (r = 0; r < 20000; ++r)
+    {
+        size_t k = (size_t) rand() % n;
+        int op = rand() % 8;
+
+        if (op < 4) // Store with a time-to-live from any level of the wheel
+        {
+            uint64_t ttl = ((uint64_t) rand() % 70) << (6*(rand() % 4));
+
+            size += (expires[k] == 0);
+            expires[k] = (ttl == UPO_TTLMAP_NO_TTL) ? UINT64_MAX : upo_ttlmap_now(map) + ttl;
+            upo_ttlmap_put(map, &keys[k], (ttl == UPO_TTLMAP_NO_TTL) ? NULL : &expires[k], ttl);
+        }
+        else if (op == 4)
+        {
+            size -= (expires[k] != 0);
+            expires[k] = 0;
+            upo_ttlmap_delete(map, &keys[k], 0);
+        }
+        else if (op == 5 && expires[k] != 0 && expires[k] != UINT64_MAX)
+        {
+            uint64_t ttl = 1 + (uint64_t) rand() % 5000;
+
+            expires[k] = upo_ttlmap_now(map) + ttl;
+            assert( upo_ttlmap_set_ttl(map, &keys[k], ttl) );
+        }
+        else // Move the clock one tick at a time
+        {
+            uint64_t ticks = (uint64_t) rand() % 300;
+
+            while (ticks-- > 0)
+            {
+                size_t expired = 0;
+
+                state[0] = upo_ttlmap_now(map) + 1;
+                expired = upo_ttlmap_advance(map, 1, 0);
+                for (i = 0; i < n; ++i)
+                {
+                    if (expires[i] == state[0])
+                    {
+                        expires[i] = 0;
+                        --expired;
+                        --size;
+                    }
+                }
+                assert( expired == 0 );
+            }
+        }
+
+        assert( upo_ttlmap_size(map) == size );
+    }
+
+    for (i = 0; i < n; ++i)
+    {
+        assert( upo_ttlmap_contains(map, &keys[i]) == (expires[i] != 0) );
+        if (expires[i] != 0 && expires[i] != UINT64_MAX)
+            assert( upo_ttlmap_ttl(map, &keys[i]) == expires[i] - upo_ttlmap_now(map) );
+    }
+
+    upo_ttlmap_destroy(map, 0);
+}
+
+
+int main()
+{
+    printf("Test case 'create/destroy'... ");
+    fflush(stdout);
+    test_create_destroy();
+    printf("OK\n");
+
+    printf("Test case 'put/get/delete'... ");
+    fflush(stdout);
+    test_put_get_delete();
+    printf("OK\n");
+
+    printf("Test case 'expiration'... ");
+    fflush(stdout);
+    test_expiration();
+    printf("OK\n");
+
+    printf("Test case 'reschedule'... ");
+    fflush(stdout);
+    test_reschedule();
+    printf("OK\n");
+
+    printf("Test case 'long ttl'... ");
+    fflush(stdout);
+    test_long_ttl();
+    printf("OK\n");
+
+    printf("Test case 'destroy data'... ");
+    fflush(stdout);
+    test_destroy_data();
+    printf("OK\n");
+
+    printf("Test case 'null'... ");
+    fflush(stdout);
+    test_null();
+    printf("OK\n");
+
+    printf("Test case 'churn'... ");
+    fflush(stdout);
+    test_churn();
+    printf("OK\n");
+
+    return 0;
+}